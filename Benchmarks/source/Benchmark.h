@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Defines.h>
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace Benchmark
+{
+    // Runs function a few times and prints the throughput of the fastest run.
+    // function has to return something that depends on its work so it can't be optimized away.
+    template<typename TFunction>
+    void Run(const QString& name, qint64 bytes, TFunction function, i32 iterations = 10)
+    {
+        auto fastestNanoseconds = std::numeric_limits<qint64>::max();
+        volatile qint64 sink = 0;
+        for (auto i = 0; i < iterations; i++)
+        {
+            QElapsedTimer timer;
+            timer.start();
+            sink = sink + static_cast<qint64>(function());
+            fastestNanoseconds = std::min(fastestNanoseconds, timer.nsecsElapsed());
+        }
+
+        const auto megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+        const auto seconds = std::max(static_cast<double>(fastestNanoseconds), 1.0) / 1e9;
+        std::cout << name.toStdString() << ": " << (megabytes / seconds) << " MB/s ("
+            << (static_cast<double>(fastestNanoseconds) / 1e6) << " ms)" << std::endl;
+    }
+}
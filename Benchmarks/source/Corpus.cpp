@@ -0,0 +1,69 @@
+#include "Corpus.h"
+
+#include <QDirIterator>
+#include <QFile>
+#include <QTextStream>
+
+#include <vector>
+
+namespace Benchmark
+{
+    QString ExamplesCorpus(i32 targetSize)
+    {
+        auto inputDir = QDir(QString("../../Tests/Data/Examples"));
+
+        QString examples{};
+        QDirIterator it(inputDir.absolutePath(), QStringList() << QString("*.kdl"), QDir::Filter::Files);
+        while (it.hasNext())
+        {
+            auto file = QFile(it.next());
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+                continue;
+
+            QTextStream reader(&file);
+            examples.append(reader.readAll());
+            examples.append(QChar(u'\n'));
+        }
+
+        if (examples.isEmpty())
+            return examples;
+
+        QString source{};
+        source.reserve(targetSize + examples.size());
+        while (source.size() < targetSize)
+            source.append(examples);
+
+        return source;
+    }
+
+    QStringList ReplicateDataFiles(const QString& directory, i32 fileCount)
+    {
+        auto dataDir = QDir(QString("../../Tests/Data"));
+
+        std::vector<QByteArray> contents{};
+        QDirIterator it(dataDir.absolutePath(), QStringList() << QString("*.kdl"), QDir::Filter::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            auto file = QFile(it.next());
+            if (file.open(QIODevice::ReadOnly))
+                contents.push_back(file.readAll());
+        }
+
+        QStringList paths{};
+        if (contents.empty())
+            return paths;
+
+        for (auto i = 0; i < fileCount; i++)
+        {
+            const auto path = QDir(directory).filePath(QString("%1.kdl").arg(i));
+            auto file = QFile(path);
+            if (!file.open(QIODevice::WriteOnly))
+                return paths;
+
+            file.write(contents[i % contents.size()]);
+            paths.append(path);
+        }
+
+        return paths;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Defines.h>
+
+#include <QString>
+#include <QStringList>
+
+namespace Benchmark
+{
+    // All example documents concatenated and repeated until the source is roughly targetSize characters long
+    [[nodiscard]] QString ExamplesCorpus(i32 targetSize);
+
+    // Copies the files of Tests/Data into directory, over and over until there are fileCount of them
+    [[nodiscard]] QStringList ReplicateDataFiles(const QString& directory, i32 fileCount);
+}
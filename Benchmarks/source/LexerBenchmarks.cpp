@@ -0,0 +1,282 @@
+#include "LexerBenchmarks.h"
+#include "Benchmark.h"
+#include "Corpus.h"
+
+#include <AllocationCounter.h>
+
+#include <KDL/Lexer.h>
+#include <KDL/Number.h>
+#include <KDL/StringValue.h>
+
+#include <QBuffer>
+#include <QDirIterator>
+#include <QFile>
+#include <QString>
+#include <QThread>
+
+namespace
+{
+    using namespace KDL;
+
+    // Base64 like payload without quotes or backslashes, the kind of content that dominates documents with embedded blobs
+    QString Payload(i32 length)
+    {
+        const auto alphabet = QString("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+        QString payload{};
+        payload.reserve(length);
+        for (auto i = 0; i < length; i++)
+            payload.append(alphabet[(i * 7) % alphabet.size()]);
+
+        return payload;
+    }
+
+    QString LongQuotedStrings()
+    {
+        const auto payload = Payload(64 * 1024);
+        QString source{};
+        for (auto i = 0; i < 256; i++)
+            source.append(QString("certificate \"%1\\n%1\"\n").arg(payload));
+
+        return source;
+    }
+
+    QString LongRawStrings()
+    {
+        const auto payload = Payload(64 * 1024);
+        QString source{};
+        for (auto i = 0; i < 256; i++)
+            source.append(QString("script #\"%1\"\\\"%1\"#\n").arg(payload));
+
+        return source;
+    }
+
+    // The old TokenBuffer reserved one kind and two i32 indexes per source code unit
+    void ReportTokenMemory(const QString& name, const QString& source)
+    {
+        const auto tokens = Lex(source);
+        const auto previousBytes = static_cast<double>(source.size()) * (sizeof(TokenKind) + 2 * sizeof(i32));
+        const auto currentBytes = static_cast<double>(tokens.allocatedBytes());
+
+        std::cout << name.toStdString() << " token memory: " << tokens.size() << " tokens, "
+            << (previousBytes / tokens.size()) << " bytes per token before, "
+            << (currentBytes / tokens.size()) << " bytes per token now" << std::endl;
+    }
+
+    void ReportAllocations(const QString& name, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+
+        auto allocationCount = AllocationCount();
+        const auto utf16TokenCount = Lex(source).size();
+        const auto utf16Allocations = AllocationCount() - allocationCount;
+
+        allocationCount = AllocationCount();
+        const auto utf8TokenCount = Lex(utf8Source).size();
+        const auto utf8Allocations = AllocationCount() - allocationCount;
+
+        std::cout << name.toStdString() << " allocations: "
+            << utf16Allocations << " for " << utf16TokenCount << " UTF-16 tokens, "
+            << utf8Allocations << " for " << utf8TokenCount << " UTF-8 tokens" << std::endl;
+    }
+
+    void LexLongStrings(const QString& name, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+
+        Benchmark::Run(name + QString(" UTF-16"), source.size() * sizeof(char16_t), [&]() { return Lex(source).size(); });
+        Benchmark::Run(name + QString(" UTF-8"), utf8Source.size(), [&]() { return Lex(utf8Source).size(); });
+    }
+
+    void LexStreamed(const QString& name, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+
+        Benchmark::Run(name + QString(" streamed"), utf8Source.size(), [&]()
+            {
+                auto device = QBuffer{};
+                device.setData(utf8Source);
+                device.open(QIODevice::ReadOnly);
+
+                auto lexer = Lexer{ device };
+                auto tokenCount = 0;
+                while (lexer.nextToken().kind != TokenKind::EndOfFile)
+                    tokenCount++;
+
+                return tokenCount;
+            });
+    }
+
+    // Typing and deleting a character in the middle of the source, once by lexing everything again and once with Relex
+    void LexKeystroke(const QString& name, const QString& source)
+    {
+        const auto position = i32(source.size() / 2);
+        auto editedSource = source;
+
+        Benchmark::Run(name + QString(" keystroke full lex"), source.size() * sizeof(char16_t), [&]()
+            {
+                editedSource.insert(position, QChar(u'x'));
+                const auto inserted = Lex(editedSource).size();
+                editedSource.remove(position, 1);
+                return inserted + Lex(editedSource).size();
+            });
+
+        auto tokens = Lex(source);
+        Benchmark::Run(name + QString(" keystroke relex"), source.size() * sizeof(char16_t), [&]()
+            {
+                Relex(tokens, position, position, QString("x"));
+                const auto inserted = tokens.size();
+                Relex(tokens, position, position + 1, QString());
+                return inserted + tokens.size();
+            });
+    }
+
+    void LexParallelScaling(const QString& name, const QString& source)
+    {
+        for (auto threadCount = 1; threadCount <= QThread::idealThreadCount(); threadCount *= 2)
+        {
+            Benchmark::Run(name + QString(" parallel %1 threads").arg(threadCount), source.size() * sizeof(char16_t),
+                [&]() { return LexParallel(source, threadCount).size(); });
+        }
+    }
+
+    // Every file in Tests/Data, the way a service loading many small configuration files would read them
+    void LexDataFiles()
+    {
+        QStringList paths{};
+        qint64 bytes = 0;
+        QDirIterator it(QDir(QString("../../Tests/Data")).absolutePath(), QStringList() << QString("*.kdl"), QDir::Filter::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            const auto file = it.nextFileInfo();
+            paths.append(file.absoluteFilePath());
+            bytes += file.size();
+        }
+
+        Benchmark::Run(QString("Data files read and lexed"), bytes, [&]()
+            {
+                auto tokenCount = 0;
+                for (const auto& path : paths)
+                {
+                    auto file = QFile(path);
+                    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+                        continue;
+
+                    QTextStream reader(&file);
+                    tokenCount += Lex(reader.readAll()).size();
+                }
+
+                return tokenCount;
+            });
+
+        Benchmark::Run(QString("Data files mapped and lexed"), bytes, [&]()
+            {
+                auto tokenCount = 0;
+                for (const auto& path : paths)
+                {
+                    if (const auto tokens = LexFile(path))
+                        tokenCount += tokens->size();
+                }
+
+                return tokenCount;
+            });
+    }
+
+    // Metric style nodes where nearly every token is a number
+    QString Metrics()
+    {
+        QString source{};
+        for (auto i = 0; i < 200000; i++)
+            source.append(QString("m %1 %2.%3 1_000_%4 -%5e-3\n").arg(i).arg(i % 977).arg(i % 10007).arg(i % 1000).arg(i % 89));
+
+        return source;
+    }
+
+    void DecodeNumbers(const QString& name, const QString& source)
+    {
+        const auto tokens = Lex(source);
+
+        Benchmark::Run(name + QString(" toDouble"), source.size() * sizeof(char16_t), [&]()
+            {
+                auto sum = 0.0;
+                for (auto i = 0; i < tokens.size(); i++)
+                {
+                    const auto token = tokens[i];
+                    if (token.kind == TokenKind::Number_Decimal)
+                        sum += token.stringView.toString().remove(QChar(u'_')).toDouble();
+                }
+
+                return sum;
+            });
+
+        Benchmark::Run(name + QString(" DecodeDouble"), source.size() * sizeof(char16_t), [&]()
+            {
+                auto sum = 0.0;
+                for (auto i = 0; i < tokens.size(); i++)
+                {
+                    const auto token = tokens[i];
+                    if (token.kind == TokenKind::Number_Decimal)
+                        sum += DecodeDouble(token).value;
+                }
+
+                return sum;
+            });
+    }
+
+    // Copying every string value against viewing the ones that need no decoding and decoding the rest into one buffer
+    void DecodeStrings(const QString& name, const QString& source)
+    {
+        const auto tokens = Lex(source);
+        const auto isString = [](TokenKind kind)
+            {
+                return kind == TokenKind::Identifier || kind == TokenKind::Identifier_QuotedString || kind == TokenKind::Identifier_RawString;
+            };
+
+        Benchmark::Run(name + QString(" toString"), source.size() * sizeof(char16_t), [&]()
+            {
+                auto length = qsizetype(0);
+                for (auto i = 0; i < tokens.size(); i++)
+                {
+                    const auto token = tokens[i];
+                    if (isString(token.kind))
+                        length += token.stringView.toString().size();
+                }
+
+                return length;
+            });
+
+        Benchmark::Run(name + QString(" StringValueView"), source.size() * sizeof(char16_t), [&]()
+            {
+                auto length = qsizetype(0);
+                auto buffer = QString{};
+                for (auto i = 0; i < tokens.size(); i++)
+                {
+                    const auto token = tokens[i];
+                    if (!isString(token.kind))
+                        continue;
+
+                    if (const auto view = StringValueView(token))
+                        length += view->size();
+                    else if (DecodeString(token, buffer) == StringStatus::Ok)
+                        length += buffer.size();
+                }
+
+                return length;
+            });
+    }
+}
+
+void RunLexerBenchmarks()
+{
+    const auto examplesCorpus = Benchmark::ExamplesCorpus(16 * 1024 * 1024);
+    ReportTokenMemory(QString("Examples corpus"), examplesCorpus);
+    ReportAllocations(QString("Examples corpus"), examplesCorpus);
+    LexLongStrings(QString("Examples corpus"), examplesCorpus);
+    LexStreamed(QString("Examples corpus"), examplesCorpus);
+    LexKeystroke(QString("Examples corpus"), examplesCorpus);
+    LexParallelScaling(QString("Examples corpus"), examplesCorpus);
+    LexDataFiles();
+    DecodeNumbers(QString("Metrics"), Metrics());
+    DecodeStrings(QString("Examples corpus"), examplesCorpus);
+    LexLongStrings(QString("Long quoted strings"), LongQuotedStrings());
+    LexLongStrings(QString("Long raw strings"), LongRawStrings());
+}
@@ -0,0 +1,505 @@
+#include "ParserBenchmarks.h"
+#include "Benchmark.h"
+#include "Corpus.h"
+
+#include <AllocationCounter.h>
+
+#include <KDL/AsyncParser.h>
+#include <KDL/Binary.h>
+#include <KDL/Binding.h>
+#include <KDL/Document.h>
+#include <KDL/EventParser.h>
+#include <KDL/Lexer.h>
+#include <KDL/ParseCache.h>
+#include <KDL/Query.h>
+#include <KDL/Schema.h>
+#include <KDL/Writer.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+
+#include <iostream>
+
+namespace
+{
+    struct Record
+    {
+        i64 id = 0;
+        QString name;
+        bool enabled = false;
+        std::vector<i32> position;
+        std::vector<QString> tags;
+    };
+
+    struct Records
+    {
+        std::vector<Record> records;
+    };
+}
+
+template<>
+struct KDL::Binding<Record>
+{
+    static constexpr auto fields = std::tuple{
+        KDL_REQUIRED_FIELD(Record, id),
+        KDL_FIELD(Record, name),
+        KDL_FIELD(Record, enabled),
+        KDL_FIELD(Record, position),
+        KDL_FIELD(Record, tags),
+    };
+};
+
+template<>
+struct KDL::Binding<Records>
+{
+    static constexpr auto fields = std::tuple{
+        KDL::Field<Records, std::vector<Record>>{ u"record", &Records::records },
+    };
+};
+
+namespace
+{
+    using namespace KDL;
+
+    // Looks for one node name the way a consumer that only needs a few nodes would
+    struct FindNodeHandler
+    {
+        QStringView name;
+        i32 matchCount = 0;
+
+        void beginNode(QStringView nodeName, std::optional<QStringView>, i32)
+        {
+            if (nodeName == name)
+                matchCount++;
+        }
+
+        void argument(const EventValue&)
+        {
+        }
+
+        void property(QStringView, const EventValue&, i32)
+        {
+        }
+
+        void beginChildren()
+        {
+        }
+
+        void endChildren()
+        {
+        }
+
+        void endNode()
+        {
+        }
+    };
+
+    [[nodiscard]] i32 CountMatches(const Document& document, NodeRange nodes, QStringView name)
+    {
+        auto matchCount = 0;
+        for (const auto node : nodes)
+        {
+            if (node.name() == name)
+                matchCount++;
+
+            matchCount += CountMatches(document, node.children(), name);
+        }
+
+        return matchCount;
+    }
+
+    [[nodiscard]] i32 CountMatches(BinaryNodeRange nodes, QStringView name)
+    {
+        auto matchCount = 0;
+        for (const auto node : nodes)
+        {
+            if (node.name() == name)
+                matchCount++;
+
+            matchCount += CountMatches(node.children(), name);
+        }
+
+        return matchCount;
+    }
+
+    void ReportAllocations(const QString& name, const TokenBuffer& tokens)
+    {
+        auto allocationCount = AllocationCount();
+        auto handler = FindNodeHandler{ .name = u"package" };
+        auto buffers = ParseBuffers{};
+        auto parser = EventParser{ tokens, handler, buffers };
+        const auto status = parser.parse();
+        const auto eventAllocations = AllocationCount() - allocationCount;
+
+        allocationCount = AllocationCount();
+        const auto result = Parse(tokens);
+        const auto documentAllocations = AllocationCount() - allocationCount;
+
+        std::cout << name.toStdString() << " parser allocations: "
+            << eventAllocations << " for events" << (status == ParseStatus::Ok ? "" : " (failed)") << ", "
+            << documentAllocations << " for a document of " << result.document.allocatedBytes() << " bytes" << std::endl;
+    }
+
+    // Both start from the same tokens, so only the cost of parsing is compared
+    void ParseEventsAndDocument(const QString& name, const QString& source)
+    {
+        const auto tokens = Lex(source);
+        ReportAllocations(name, tokens);
+
+        Benchmark::Run(name + QString(" events"), source.size() * sizeof(char16_t), [&]()
+            {
+                auto handler = FindNodeHandler{ .name = u"package" };
+                auto buffers = ParseBuffers{};
+                auto parser = EventParser{ tokens, handler, buffers };
+                (void)parser.parse();
+                return handler.matchCount;
+            });
+
+        Benchmark::Run(name + QString(" document"), source.size() * sizeof(char16_t), [&]()
+            {
+                const auto result = Parse(tokens);
+                return CountMatches(result.document, result.document.nodes(), u"package");
+            });
+    }
+
+    // Lexing into a token buffer first against pulling the tokens from the lexer while parsing
+    void ParseBufferedAndFused(const QString& name, const QString& source)
+    {
+        Benchmark::Run(name + QString(" lex then parse"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Parse(Lex(source)).document.nodeCount();
+            });
+
+        Benchmark::Run(name + QString(" fused lex and parse"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Parse(source).document.nodeCount();
+            });
+    }
+
+    // Machine generated ASCII with deep indentation, the input the structural scan is meant for
+    QString GeneratedRecords()
+    {
+        QString source{};
+        for (auto i = 0; i < 100000; i++)
+        {
+            source.append(QString("record id=%1 name=\"item-%1\" enabled=#true {\n").arg(i));
+            source.append(QString("            position %1 %2 %3\n").arg(i % 997).arg(i % 991).arg(i % 983));
+            source.append(QString("            tags \"alpha\" \"beta\" \"gamma-%1\"\n").arg(i % 17));
+            source.append(QString("}\n"));
+        }
+
+        return source;
+    }
+
+    // The hand written mapping the binding replaces, string compares on a parsed document
+    [[nodiscard]] Records ReadRecords(const Document& document)
+    {
+        Records records{};
+        for (const auto node : document.nodes())
+        {
+            if (node.name() != u"record")
+                continue;
+
+            auto& record = records.records.emplace_back();
+            for (auto i = 0; i < node.propertyCount(); i++)
+            {
+                const auto property = node.property(i);
+                if (property.name() == u"id")
+                    record.id = property.value().toInt64().value;
+                else if (property.name() == u"name")
+                    record.name = property.value().string().toString();
+                else if (property.name() == u"enabled")
+                    record.enabled = property.value().boolean();
+            }
+
+            for (const auto child : node.children())
+            {
+                if (child.name() == u"position")
+                {
+                    for (auto i = 0; i < child.argumentCount(); i++)
+                        record.position.push_back(static_cast<i32>(child.argument(i).toInt64().value));
+                }
+                else if (child.name() == u"tags")
+                {
+                    for (auto i = 0; i < child.argumentCount(); i++)
+                        record.tags.push_back(child.argument(i).string().toString());
+                }
+            }
+        }
+
+        return records;
+    }
+
+    void BindAndReadDocument(const QString& name, const QString& source)
+    {
+        Benchmark::Run(name + QString(" bind"), source.size() * sizeof(char16_t), [&]()
+            {
+                auto records = Records{};
+                (void)Bind(source, records);
+                return records.records.size();
+            });
+
+        Benchmark::Run(name + QString(" parse and read"), source.size() * sizeof(char16_t), [&]()
+            {
+                return ReadRecords(Parse(source).document).records.size();
+            });
+    }
+
+    // Checks every node, property and value of the records, against building a document of them
+    void ValidateAndParse(const QString& name, const QString& source)
+    {
+        const auto compiled = CompileSchema(QString(R"(
+            document {
+                node record {
+                    prop id { type number; format i64; required #true }
+                    prop name { type string; pattern "^item-[0-9]+$" }
+                    prop enabled { type boolean }
+                    children {
+                        node position { max 1; value { type number; ">=" 0; min 3; max 3 } }
+                        node tags { value { type string; min-length 1; max-length 16 } }
+                    }
+                }
+            })"));
+
+        Benchmark::Run(name + QString(" validate"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Validate(compiled.schema, source).violations.size();
+            });
+
+        Benchmark::Run(name + QString(" fused document"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Parse(source).document.nodeCount();
+            });
+    }
+
+    // Matching while parsing against building a document and walking it, and the walk on its own, which
+    // skips every subtree the query can't match in
+    void SelectStreamingAndDocument(const QString& name, const QString& source, const QString& selector)
+    {
+        const auto compiled = CompileQuery(selector);
+        const auto parsed = Parse(source);
+
+        Benchmark::Run(name + QString(" select while parsing"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Select(compiled.query, source).matches.size();
+            });
+
+        Benchmark::Run(name + QString(" parse and select"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Select(compiled.query, Parse(source).document).size();
+            });
+
+        Benchmark::Run(name + QString(" select in document"), source.size() * sizeof(char16_t), [&]()
+            {
+                return Select(compiled.query, parsed.document).size();
+            });
+    }
+
+    // Throughput is measured in bytes written. The output buffer is reused, as it would be for a stream of
+    // documents, and the same output is written once from the document and once from the parser's events.
+    void WriteDocumentAndEvents(const QString& name, const QString& source)
+    {
+        const auto parsed = Parse(source);
+        const auto tokens = Lex(source);
+        auto output = QByteArray();
+        Writer{ output }.write(parsed.document);
+        const auto outputSize = output.size();
+
+        Benchmark::Run(name + QString(" write document"), outputSize, [&]()
+            {
+                output.resize(0);
+                auto writer = Writer{ output };
+                writer.write(parsed.document);
+                return output.size();
+            });
+
+        Benchmark::Run(name + QString(" write events"), outputSize, [&]()
+            {
+                output.resize(0);
+                auto writer = Writer{ output };
+                auto buffers = ParseBuffers{};
+                auto parser = EventParser{ tokens, writer, buffers };
+                (void)parser.parse();
+                return output.size();
+            });
+    }
+
+    // Loads a file and finds nodes in it, the text has to be decoded and parsed while the binary form is
+    // mapped and read in place. Both files stay in the page cache, so only the work after reading is measured.
+    void LoadTextAndBinary(const QString& name, const QString& source, QStringView nodeName)
+    {
+        const auto text = source.toUtf8();
+        const auto encoded = EncodeBinary(source);
+        auto textFile = QTemporaryFile();
+        auto binaryFile = QTemporaryFile();
+        if (encoded.status != ParseStatus::Ok || !textFile.open() || !binaryFile.open())
+            return;
+
+        textFile.write(text);
+        textFile.close();
+        binaryFile.write(encoded.bytes);
+        binaryFile.close();
+        std::cout << name.toStdString() << " binary size: " << encoded.bytes.size() << " bytes for "
+            << text.size() << " bytes of text" << std::endl;
+
+        Benchmark::Run(name + QString(" load text"), text.size(), [&]()
+            {
+                auto file = QFile(textFile.fileName());
+                if (!file.open(QIODevice::ReadOnly))
+                    return 0;
+
+                const auto result = Parse(QString::fromUtf8(file.readAll()));
+                return CountMatches(result.document, result.document.nodes(), nodeName);
+            });
+
+        Benchmark::Run(name + QString(" load binary"), text.size(), [&]()
+            {
+                auto file = QFile(binaryFile.fileName());
+                if (!file.open(QIODevice::ReadOnly))
+                    return 0;
+
+                const auto data = file.map(0, file.size());
+                if (!data)
+                    return 0;
+
+                const auto opened = OpenBinary(QByteArrayView(reinterpret_cast<const char*>(data), file.size()));
+                return CountMatches(opened.document.nodes(), nodeName);
+            });
+    }
+
+    // A hit hashes the source and maps its entry, a miss parses it as a cache without entries would
+    void ParseCachedAndUncached(const QString& name, const QString& source)
+    {
+        const auto text = source.toUtf8();
+        auto directory = QTemporaryDir();
+        if (!directory.isValid())
+            return;
+
+        auto cache = ParseCache{ directory.path() };
+        (void)cache.parse(text);
+
+        Benchmark::Run(name + QString(" hash"), text.size(), [&]()
+            {
+                return HashBytes(text);
+            });
+
+        Benchmark::Run(name + QString(" uncached"), text.size(), [&]()
+            {
+                return EncodeBinary(QString::fromUtf8(text)).bytes.size();
+            });
+
+        Benchmark::Run(name + QString(" cached"), text.size(), [&]()
+            {
+                return cache.parse(text).document.nodeCount();
+            });
+    }
+
+    // Parsing the whole source against feeding it to an async parse in pieces the size of a TCP segment,
+    // which copies every token to UTF-16 for the push parser as it is lexed
+    void ParseAtOnceAndAsync(const QString& name, const QString& source)
+    {
+        const auto text = source.toUtf8();
+        Benchmark::Run(name + QString(" at once"), text.size(), [&]()
+            {
+                const auto tokens = Lex(QString::fromUtf8(text));
+                auto handler = FindNodeHandler{ .name = u"package" };
+                auto buffers = ParseBuffers{};
+                auto parser = EventParser{ tokens, handler, buffers };
+                (void)parser.parse();
+                return handler.matchCount;
+            });
+
+        constexpr auto PieceSize = qsizetype(1460);
+        Benchmark::Run(name + QString(" async"), text.size(), [&]()
+            {
+                auto handler = FindNodeHandler{ .name = u"package" };
+                auto input = AsyncInput{};
+                const auto task = ParseAsync(input, handler);
+                for (auto start = qsizetype(0); start < text.size(); start += PieceSize)
+                    input.feed(QByteArrayView(text).sliced(start, std::min(PieceSize, text.size() - start)));
+                input.finish();
+                return handler.matchCount;
+            });
+    }
+
+    // Startup over many small files, one after another against all of them on a thread pool
+    void LoadManyFiles(i32 fileCount)
+    {
+        auto directory = QTemporaryDir();
+        if (!directory.isValid())
+            return;
+
+        const auto paths = Benchmark::ReplicateDataFiles(directory.path(), fileCount);
+        auto bytes = qint64(0);
+        for (const auto& path : paths)
+            bytes += QFileInfo(path).size();
+
+        const auto name = QString("%1 files").arg(paths.size());
+        Benchmark::Run(name + QString(" LexFile"), bytes, [&]()
+            {
+                auto tokenCount = qint64(0);
+                for (const auto& path : paths)
+                {
+                    if (const auto tokens = LexFile(path))
+                        tokenCount += tokens->size();
+                }
+                return tokenCount;
+            });
+
+        Benchmark::Run(name + QString(" LexFiles"), bytes, [&]()
+            {
+                auto tokenCount = qint64(0);
+                for (const auto& tokens : LexFiles(paths))
+                {
+                    if (tokens)
+                        tokenCount += tokens->size();
+                }
+                return tokenCount;
+            });
+
+        Benchmark::Run(name + QString(" Parse"), bytes, [&]()
+            {
+                auto nodeCount = qint64(0);
+                for (const auto& path : paths)
+                {
+                    auto file = QFile(path);
+                    if (file.open(QIODevice::ReadOnly))
+                        nodeCount += Parse(QString::fromUtf8(file.readAll())).document.nodeCount();
+                }
+                return nodeCount;
+            });
+
+        Benchmark::Run(name + QString(" ParseFiles"), bytes, [&]()
+            {
+                auto nodeCount = qint64(0);
+                for (const auto& result : ParseFiles(paths))
+                    nodeCount += result.document.nodeCount();
+                return nodeCount;
+            });
+    }
+}
+
+void RunParserBenchmarks()
+{
+    const auto examplesCorpus = Benchmark::ExamplesCorpus(16 * 1024 * 1024);
+    ParseEventsAndDocument(QString("Examples corpus"), examplesCorpus);
+    ParseBufferedAndFused(QString("Examples corpus"), examplesCorpus);
+    ParseBufferedAndFused(QString("Large examples corpus"), Benchmark::ExamplesCorpus(128 * 1024 * 1024));
+    const auto generatedRecords = GeneratedRecords();
+    BindAndReadDocument(QString("Generated records"), generatedRecords);
+    ValidateAndParse(QString("Generated records"), generatedRecords);
+    WriteDocumentAndEvents(QString("Examples corpus"), examplesCorpus);
+    WriteDocumentAndEvents(QString("Generated records"), generatedRecords);
+    SelectStreamingAndDocument(QString("Generated records"), generatedRecords, QString("record[id >= 50000] > tags[val(2) = gamma-3]"));
+    SelectStreamingAndDocument(QString("Generated records top-level"), generatedRecords, QString("top() > record[enabled = #true]"));
+    LoadTextAndBinary(QString("Examples corpus"), examplesCorpus, u"package");
+    LoadTextAndBinary(QString("Generated records"), generatedRecords, u"tags");
+    ParseCachedAndUncached(QString("Examples corpus"), examplesCorpus);
+    ParseCachedAndUncached(QString("Generated records"), generatedRecords);
+    ParseAtOnceAndAsync(QString("Examples corpus"), examplesCorpus);
+    ParseAtOnceAndAsync(QString("Generated records"), generatedRecords);
+    LoadManyFiles(5000);
+}
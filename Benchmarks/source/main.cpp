@@ -0,0 +1,10 @@
+#include "LexerBenchmarks.h"
+#include "ParserBenchmarks.h"
+
+int main(int argc, char* argv[])
+{
+    RunLexerBenchmarks();
+    RunParserBenchmarks();
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <KDL/AsyncParser.h>
+
+namespace KDL
+{
+    void AsyncInput::feed(QByteArrayView bytes)
+    {
+        if (bytes.isEmpty())
+            return;
+
+        m_pending.append(bytes);
+        resume();
+    }
+
+    void AsyncInput::finish()
+    {
+        m_isFinished = true;
+        resume();
+    }
+
+    bool AsyncInput::isFinished() const noexcept
+    {
+        return m_isFinished;
+    }
+
+    void AsyncInput::resume()
+    {
+        if (!m_waiting)
+            return;
+
+        // Cleared first, the parse may wait on this input again before resume returns
+        std::exchange(m_waiting, nullptr).resume();
+    }
+
+    ParseTask::ParseTask(ParseTask&& other) noexcept
+        : m_coroutine{ std::exchange(other.m_coroutine, nullptr) }
+    {
+    }
+
+    ParseTask& ParseTask::operator=(ParseTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_coroutine)
+                m_coroutine.destroy();
+            m_coroutine = std::exchange(other.m_coroutine, nullptr);
+        }
+        return *this;
+    }
+
+    ParseTask::~ParseTask()
+    {
+        if (m_coroutine)
+            m_coroutine.destroy();
+    }
+
+    bool ParseTask::isDone() const noexcept
+    {
+        return m_coroutine.done();
+    }
+
+    AsyncParseResult ParseTask::result() const noexcept
+    {
+        return m_coroutine.promise().result;
+    }
+
+    bool ParseTask::await_ready() const noexcept
+    {
+        return isDone();
+    }
+
+    void ParseTask::await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_coroutine.promise().awaiting = awaiting;
+    }
+
+    AsyncParseResult ParseTask::await_resume() const noexcept
+    {
+        return result();
+    }
+
+    ParseTask::ParseTask(std::coroutine_handle<promise_type> coroutine) noexcept
+        : m_coroutine{ coroutine }
+    {
+    }
+}
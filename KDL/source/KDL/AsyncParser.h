@@ -0,0 +1,680 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/EventParser.h>
+#include <KDL/Lexer.h>
+#include <Defines.h>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace KDL
+{
+    // Hands bytes from a producer, like the readyRead handler of a socket, to the parse that waits for them.
+    // The parse is resumed on the thread that feeds it and runs until it needs more.
+    class KDL_API AsyncInput
+    {
+    public:
+        AsyncInput() = default;
+        AsyncInput(const AsyncInput&) = delete;
+        AsyncInput& operator=(const AsyncInput&) = delete;
+
+        void feed(QByteArrayView bytes);
+        // No more bytes will be fed, the parse finishes with what it has
+        void finish();
+        [[nodiscard]] bool isFinished() const noexcept;
+
+        class Awaiter
+        {
+        public:
+            explicit Awaiter(AsyncInput& input) noexcept
+                : m_input{ input }
+            {
+            }
+
+            // A parse that is destroyed while it waits must not be resumed anymore
+            ~Awaiter()
+            {
+                if (m_isSuspended)
+                    m_input.m_waiting = nullptr;
+            }
+
+            [[nodiscard]] bool await_ready() const noexcept
+            {
+                return !m_input.m_pending.isEmpty() || m_input.m_isFinished;
+            }
+
+            void await_suspend(std::coroutine_handle<> waiting) noexcept
+            {
+                m_input.m_waiting = waiting;
+                m_isSuspended = true;
+            }
+
+            // The bytes fed since the last await, empty once the input is finished and all of them were taken
+            [[nodiscard]] QByteArray await_resume() noexcept
+            {
+                m_isSuspended = false;
+                return std::exchange(m_input.m_pending, QByteArray());
+            }
+
+        private:
+            AsyncInput& m_input;
+            bool m_isSuspended = false;
+        };
+
+        [[nodiscard]] Awaiter operator co_await() noexcept
+        {
+            return Awaiter{ *this };
+        }
+
+    private:
+        void resume();
+
+        QByteArray m_pending{};
+        std::coroutine_handle<> m_waiting{};
+        bool m_isFinished = false;
+    };
+
+    struct KDL_API AsyncParseResult
+    {
+        ParseStatus status = ParseStatus::Ok;
+        // Offset in UTF-16 code units from the start of the input of the token the error was found at
+        i32 errorOffset = 0;
+    };
+
+    // The coroutine of ParseAsync. It starts right away and stays suspended while it waits for input,
+    // destroying the task ends a parse that isn't done. Another coroutine can co_await the task for its result.
+    class KDL_API ParseTask
+    {
+    public:
+        struct promise_type
+        {
+            struct FinalAwaiter
+            {
+                [[nodiscard]] bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coroutine) const noexcept
+                {
+                    const auto awaiting = coroutine.promise().awaiting;
+                    return awaiting ? awaiting : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept
+                {
+                }
+            };
+
+            [[nodiscard]] ParseTask get_return_object() noexcept
+            {
+                return ParseTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+
+            [[nodiscard]] std::suspend_never initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            // Stays suspended at the end so the result can be read until the task is destroyed
+            [[nodiscard]] FinalAwaiter final_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void return_value(AsyncParseResult value) noexcept
+            {
+                result = value;
+            }
+
+            // Like the rest of the parser, a parse doesn't throw
+            void unhandled_exception() const noexcept
+            {
+                std::terminate();
+            }
+
+            AsyncParseResult result{};
+            std::coroutine_handle<> awaiting{};
+        };
+
+        ParseTask(ParseTask&& other) noexcept;
+        ParseTask& operator=(ParseTask&& other) noexcept;
+        ~ParseTask();
+
+        [[nodiscard]] bool isDone() const noexcept;
+        // Only valid once the task is done
+        [[nodiscard]] AsyncParseResult result() const noexcept;
+
+        [[nodiscard]] bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept;
+        [[nodiscard]] AsyncParseResult await_resume() const noexcept;
+
+    private:
+        explicit ParseTask(std::coroutine_handle<promise_type> coroutine) noexcept;
+
+        std::coroutine_handle<promise_type> m_coroutine{};
+    };
+
+    // Parses tokens handed to it one at a time, for input that arrives in pieces. It accepts, rejects and
+    // reports exactly what EventParser does, but keeps its place in the grammar and the open children blocks
+    // in members instead of on the call stack, so it can stop after any token and pick up with the next one.
+    // Besides the buffers only the current token, the one after it and whether each open children block
+    // follows a slash-dash are kept, the stack of blocks is a fixed array of MaxNestingDepth.
+    template<typename THandler>
+    class PushParser
+    {
+    public:
+        PushParser(THandler& handler, ParseBuffers& buffers) noexcept
+            : m_handler{ handler }
+            , m_buffers{ buffers }
+        {
+        }
+
+        // token only has to be valid during the call, offset is where it starts in the source. Tokens after
+        // EndOfFile have to be EndOfFile as well, the parse is done after at most two of them.
+        void push(const Token& token, i32 offset)
+        {
+            if (m_state == State::Done)
+                return;
+
+            auto& slot = m_hasCurrent ? m_next : m_current;
+            slot.kind = token.kind;
+            slot.text.resize(0);
+            slot.text.append(token.stringView);
+            slot.hasEscapes = token.hasEscapes;
+            slot.offset = offset;
+            if (!m_hasCurrent)
+            {
+                m_hasCurrent = true;
+                return;
+            }
+
+            // Every step either consumes the current token, which makes the next one current, or moves on
+            // in the grammar without it
+            m_hasNext = true;
+            while (m_hasNext && m_state != State::Done)
+                step();
+        }
+
+        [[nodiscard]] bool isDone() const noexcept
+        {
+            return m_state == State::Done;
+        }
+
+        [[nodiscard]] ParseStatus status() const noexcept
+        {
+            return m_status;
+        }
+
+        // Source offset of the token the error was found at
+        [[nodiscard]] i32 errorOffset() const noexcept
+        {
+            return m_errorOffset;
+        }
+
+    private:
+        // Where the parse is in the functions of EventParser
+        enum class State : u8
+        {
+            Start,
+            // The loop of parseNodes
+            Nodes,
+            NodesAfterSlashDash,
+            // parseNode
+            NodeStart,
+            NodeName,
+            // The loop of parseNode
+            NodeBody,
+            NodeBodyAfterSlashDash,
+            NodeItem,
+            // parseEntry and parseValue
+            Entry,
+            PropertyEqual,
+            Value,
+            ValueToken,
+            // parseTypeAnnotation, of a node or a value
+            TypeAnnotation,
+            TypeAnnotationClose,
+            Done
+        };
+
+        struct PendingToken
+        {
+            TokenKind kind = TokenKind::EndOfFile;
+            QString text;
+            bool hasEscapes = false;
+            i32 offset = 0;
+        };
+
+        // The node that owns a children block and the nodes around it, restored when the block ends
+        struct OpenBlock
+        {
+            bool isNodesDiscarded;
+            bool isNodeDiscarded;
+            bool hasChildren;
+            bool hasDiscardedChildren;
+            bool isSlashDashed;
+        };
+
+        [[nodiscard]] Token token() const noexcept
+        {
+            return { .kind = m_current.kind, .stringView = m_current.text, .hasEscapes = m_current.hasEscapes };
+        }
+
+        [[nodiscard]] bool hasSpace() const noexcept
+        {
+            return m_current.offset > m_previousEnd;
+        }
+
+        void advance() noexcept
+        {
+            m_previousEnd = m_current.offset + static_cast<i32>(m_current.text.size());
+            std::swap(m_current, m_next);
+            m_hasNext = false;
+        }
+
+        void fail(ParseStatus status) noexcept
+        {
+            m_status = status;
+            m_errorOffset = m_current.offset;
+            m_state = State::Done;
+        }
+
+        // The value of the current string token, decoded into buffer if it can't be viewed in the token.
+        // Strings that are needed after the token is gone are always copied into buffer.
+        [[nodiscard]] bool readString(QStringView& value, QString& buffer, bool isKept)
+        {
+            const auto current = token();
+            if (current.kind == TokenKind::Identifier && !IsValidIdentifier(current.stringView))
+            {
+                fail(ParseStatus::InvalidIdentifier);
+                return false;
+            }
+
+            if (const auto view = StringValueView(current))
+            {
+                if (!isKept)
+                {
+                    value = *view;
+                    return true;
+                }
+
+                buffer.resize(0);
+                buffer.append(*view);
+            }
+            else if (DecodeString(current, buffer) != StringStatus::Ok)
+            {
+                fail(ParseStatus::InvalidString);
+                return false;
+            }
+
+            value = buffer;
+            return true;
+        }
+
+        [[nodiscard]] std::optional<QStringView> typeAnnotation() const noexcept
+        {
+            if (!m_hasTypeAnnotation)
+                return std::nullopt;
+
+            return QStringView(m_buffers.typeAnnotation);
+        }
+
+        void endNode()
+        {
+            if (!m_isNodeDiscarded)
+                m_handler.endNode();
+
+            m_state = State::Nodes;
+        }
+
+        void step()
+        {
+            const auto kind = m_current.kind;
+            switch (m_state)
+            {
+            case State::Start:
+                // A byte order mark is only allowed in front of everything else
+                if (kind == TokenKind::Error && m_current.offset == 0 && m_current.text.startsWith(QChar(0xFEFF)))
+                    advance();
+
+                m_state = State::Nodes;
+                return;
+
+            case State::Nodes:
+                if (kind == TokenKind::Newline)
+                {
+                    advance();
+                }
+                else if (kind == TokenKind::EndOfFile)
+                {
+                    if (m_depth > 0)
+                        fail(ParseStatus::UnterminatedChildren);
+                    else
+                        m_state = State::Done;
+                }
+                else if (kind == TokenKind::CloseBracket)
+                {
+                    if (m_depth == 0)
+                        fail(ParseStatus::UnexpectedToken);
+                    else
+                        endChildren();
+                }
+                else if (kind == TokenKind::SlashDash)
+                {
+                    advance();
+                    m_isSlashDashed = true;
+                    m_state = State::NodesAfterSlashDash;
+                }
+                else
+                {
+                    m_isSlashDashed = false;
+                    beginNode();
+                }
+                return;
+
+            case State::NodesAfterSlashDash:
+                if (kind == TokenKind::Newline)
+                    advance();
+                else
+                    beginNode();
+                return;
+
+            case State::NodeStart:
+                if (kind == TokenKind::OpenParenthesis)
+                {
+                    advance();
+                    m_isValueAnnotation = false;
+                    m_state = State::TypeAnnotation;
+                    return;
+                }
+
+                m_state = State::NodeName;
+                return;
+
+            case State::NodeName:
+            {
+                if (!IsStringKind(kind))
+                    return fail(ParseStatus::UnexpectedToken);
+
+                auto name = QStringView{};
+                if (!readString(name, m_buffers.name, false))
+                    return;
+
+                if (!m_isNodeDiscarded)
+                    m_handler.beginNode(name, typeAnnotation(), m_current.offset);
+
+                advance();
+                m_hasChildren = false;
+                m_hasDiscardedChildren = false;
+                m_state = State::NodeBody;
+                return;
+            }
+
+            case State::NodeBody:
+                if (kind == TokenKind::Newline || kind == TokenKind::Terminator)
+                {
+                    advance();
+                    return endNode();
+                }
+                if (kind == TokenKind::EndOfFile || kind == TokenKind::CloseBracket)
+                    return endNode();
+
+                if (!hasSpace() && !(kind == TokenKind::SlashDash && (m_hasChildren || m_hasDiscardedChildren)))
+                    return fail(ParseStatus::MissingSpace);
+
+                m_isSlashDashed = kind == TokenKind::SlashDash;
+                if (m_isSlashDashed)
+                    advance();
+
+                m_state = m_isSlashDashed ? State::NodeBodyAfterSlashDash : State::NodeItem;
+                return;
+
+            case State::NodeBodyAfterSlashDash:
+                if (kind == TokenKind::Newline)
+                    advance();
+                else
+                    m_state = State::NodeItem;
+                return;
+
+            case State::NodeItem:
+                if (kind == TokenKind::OpenBracket)
+                {
+                    if (m_hasChildren && !m_isSlashDashed)
+                        return fail(ParseStatus::UnexpectedToken);
+
+                    return beginChildren();
+                }
+
+                if (m_hasChildren || m_hasDiscardedChildren)
+                    return fail(ParseStatus::UnexpectedToken);
+
+                m_isEntryDiscarded = m_isNodeDiscarded || m_isSlashDashed;
+                m_state = State::Entry;
+                return;
+
+            case State::Entry:
+            {
+                m_hasTypeAnnotation = false;
+                m_isProperty = IsStringKind(kind) && m_next.kind == TokenKind::Equal;
+                m_state = State::Value;
+                if (!m_isProperty)
+                    return;
+
+                m_propertyOffset = m_current.offset;
+                auto name = QStringView{};
+                if (!readString(name, m_buffers.name, true))
+                    return;
+
+                advance();
+                m_state = State::PropertyEqual;
+                return;
+            }
+
+            case State::PropertyEqual:
+                advance();
+                m_state = State::Value;
+                return;
+
+            case State::Value:
+                if (kind == TokenKind::OpenParenthesis)
+                {
+                    advance();
+                    m_isValueAnnotation = true;
+                    m_state = State::TypeAnnotation;
+                    return;
+                }
+
+                m_state = State::ValueToken;
+                return;
+
+            case State::ValueToken:
+                return value();
+
+            case State::TypeAnnotation:
+            {
+                if (!IsStringKind(kind))
+                    return fail(ParseStatus::UnexpectedToken);
+
+                auto annotation = QStringView{};
+                if (!readString(annotation, m_buffers.typeAnnotation, true))
+                    return;
+
+                advance();
+                m_state = State::TypeAnnotationClose;
+                return;
+            }
+
+            case State::TypeAnnotationClose:
+                if (kind != TokenKind::CloseParenthesis)
+                    return fail(ParseStatus::UnexpectedToken);
+
+                advance();
+                m_hasTypeAnnotation = true;
+                m_state = m_isValueAnnotation ? State::ValueToken : State::NodeName;
+                return;
+
+            case State::Done:
+                return;
+            }
+        }
+
+        void beginNode() noexcept
+        {
+            m_isNodeDiscarded = m_isNodesDiscarded || m_isSlashDashed;
+            m_hasTypeAnnotation = false;
+            m_state = State::NodeStart;
+        }
+
+        void beginChildren()
+        {
+            if (m_depth == MaxNestingDepth)
+                return fail(ParseStatus::TooDeep);
+
+            advance();
+            const auto isDiscarded = m_isNodeDiscarded || m_isSlashDashed;
+            if (!isDiscarded)
+                m_handler.beginChildren();
+
+            m_blocks[m_depth++] = {
+                .isNodesDiscarded = m_isNodesDiscarded,
+                .isNodeDiscarded = m_isNodeDiscarded,
+                .hasChildren = m_hasChildren,
+                .hasDiscardedChildren = m_hasDiscardedChildren,
+                .isSlashDashed = m_isSlashDashed
+            };
+            m_isNodesDiscarded = isDiscarded;
+            m_state = State::Nodes;
+        }
+
+        void endChildren()
+        {
+            const auto block = m_blocks[--m_depth];
+            advance();
+            if (!m_isNodesDiscarded)
+                m_handler.endChildren();
+
+            m_isNodesDiscarded = block.isNodesDiscarded;
+            m_isNodeDiscarded = block.isNodeDiscarded;
+            m_hasChildren = block.hasChildren || !block.isSlashDashed;
+            m_hasDiscardedChildren = block.hasDiscardedChildren || block.isSlashDashed;
+            m_state = State::NodeBody;
+        }
+
+        void value()
+        {
+            const auto current = token();
+            auto value = EventValue{};
+            value.typeAnnotation = typeAnnotation();
+            value.kind = current.kind;
+            value.offset = m_current.offset;
+            if (IsStringKind(current.kind))
+            {
+                // A type annotation in front of a property key
+                if (m_hasTypeAnnotation && m_next.kind == TokenKind::Equal)
+                    return fail(ParseStatus::UnexpectedToken);
+
+                value.type = ValueType::String;
+                if (!readString(value.text, m_buffers.value, false))
+                    return;
+            }
+            else
+            {
+                if (IsNumberKind(current.kind) && !IsValidNumber(current.stringView, current.kind))
+                    return fail(ParseStatus::InvalidNumber);
+
+                if (!IsNumberKind(current.kind) && !IsKeywordKind(current.kind))
+                    return fail(ParseStatus::UnexpectedToken);
+
+                value.type = ValueTypeOf(current.kind, current.stringView);
+                value.text = current.stringView;
+            }
+
+            if (!m_isEntryDiscarded && m_isProperty)
+                m_handler.property(m_buffers.name, value, m_propertyOffset);
+            else if (!m_isEntryDiscarded)
+                m_handler.argument(value);
+
+            advance();
+            m_state = State::NodeBody;
+        }
+
+        THandler& m_handler;
+        ParseBuffers& m_buffers;
+        PendingToken m_current{};
+        PendingToken m_next{};
+        bool m_hasCurrent = false;
+        bool m_hasNext = false;
+        i32 m_previousEnd = -1;
+
+        State m_state = State::Start;
+        ParseStatus m_status = ParseStatus::Ok;
+        i32 m_errorOffset = 0;
+
+        std::array<OpenBlock, MaxNestingDepth> m_blocks{};
+        i32 m_depth = 0;
+        // Whether the nodes of the innermost children block, or the top level, aren't reported
+        bool m_isNodesDiscarded = false;
+        bool m_isNodeDiscarded = false;
+        bool m_hasChildren = false;
+        bool m_hasDiscardedChildren = false;
+        // Whether the node, children block or entry being parsed follows a slash-dash
+        bool m_isSlashDashed = false;
+        bool m_isEntryDiscarded = false;
+        bool m_isProperty = false;
+        i32 m_propertyOffset = 0;
+        bool m_hasTypeAnnotation = false;
+        bool m_isValueAnnotation = false;
+    };
+
+    inline constexpr i64 DefaultMaxTokenBytes = 64 * 1024 * 1024;
+
+    // Parses UTF-8 source as it is fed to input and reports it to handler like EventParser, with the same
+    // events and offsets as parsing all of the input at once. Whenever the lexer runs out of input the parse
+    // is suspended, so a connection that is still sending doesn't keep a thread waiting.
+    //
+    // Every token is handed to a PushParser as soon as it is lexed, so events are reported as the input
+    // arrives, inside of nodes as well, and a suspended parse keeps nothing of the input but the token that
+    // was cut off. That token is the only part that grows with the input: if it takes more than maxTokenBytes,
+    // the parse fails with ParseStatus::TokenTooLarge at its start. input and handler have to outlive the task.
+    template<typename THandler>
+    [[nodiscard]] ParseTask ParseAsync(AsyncInput& input, THandler& handler, i64 maxTokenBytes = DefaultMaxTokenBytes)
+    {
+        auto lexer = PushLexer{};
+        auto buffers = ParseBuffers{};
+        auto parser = PushParser<THandler>{ handler, buffers };
+        while (!parser.isDone())
+        {
+            const auto token = lexer.nextToken();
+            if (!token)
+            {
+                if (lexer.keptBytes() > maxTokenBytes)
+                {
+                    const auto errorOffset = static_cast<i32>(lexer.utf16Offset(lexer.keptOffset()));
+                    co_return AsyncParseResult{ .status = ParseStatus::TokenTooLarge, .errorOffset = errorOffset };
+                }
+
+                const auto bytes = co_await input;
+                if (bytes.isEmpty())
+                    lexer.finish();
+                else
+                    lexer.append(bytes);
+                continue;
+            }
+
+            const auto text = QString::fromUtf8(token->stringView.data(), token->stringView.size());
+            const auto offset = static_cast<i32>(lexer.tokenUtf16Offset());
+            parser.push(Token{ .kind = token->kind, .stringView = text, .hasEscapes = token->hasEscapes }, offset);
+        }
+
+        co_return AsyncParseResult{ .status = parser.status(), .errorOffset = parser.errorOffset() };
+    }
+}
@@ -0,0 +1,165 @@
+#include <KDL/AtomTable.h>
+#include <KDL/StringValue.h>
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+    using namespace KDL;
+
+    [[nodiscard]] static std::u16string_view ToStdView(QStringView name) noexcept
+    {
+        return { name.utf16(), static_cast<std::size_t>(name.size()) };
+    }
+
+    // Names are compared as UTF-16, so UTF-8 names are converted on the stack before the lookup
+    template<qsizetype Prealloc>
+    static void AppendUtf16(QVarLengthArray<char16_t, Prealloc>& buffer, QUtf8StringView name)
+    {
+        const auto* data = reinterpret_cast<const u8*>(name.data());
+        const auto size = static_cast<i32>(name.size());
+        auto index = 0;
+        while (index < size)
+        {
+            const auto lead = data[index];
+            auto length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+            auto codePoint = static_cast<char32_t>(lead & (0x7F >> (length == 1 ? 0 : length)));
+            if (index + length > size)
+            {
+                codePoint = QChar::ReplacementCharacter;
+                length = size - index;
+            }
+            else
+            {
+                for (auto i = 1; i < length; i++)
+                    codePoint = (codePoint << 6) | (data[index + i] & 0x3F);
+            }
+
+            if (QChar::requiresSurrogates(codePoint))
+            {
+                buffer.append(QChar::highSurrogate(codePoint));
+                buffer.append(QChar::lowSurrogate(codePoint));
+            }
+            else
+            {
+                buffer.append(static_cast<char16_t>(codePoint));
+            }
+
+            index += length;
+        }
+    }
+}
+
+namespace KDL
+{
+    Atom AtomTable::intern(QStringView name)
+    {
+        const auto key = ToStdView(name);
+        {
+            std::shared_lock lock{ m_mutex };
+            if (const auto atom = m_atoms.find(key); atom != m_atoms.end())
+                return atom->second;
+        }
+
+        std::unique_lock lock{ m_mutex };
+        if (const auto atom = m_atoms.find(key); atom != m_atoms.end())
+            return atom->second;
+
+        return add(key);
+    }
+
+    Atom AtomTable::intern(QUtf8StringView name)
+    {
+        QVarLengthArray<char16_t, 256> utf16{};
+        AppendUtf16(utf16, name);
+        return intern(QStringView(utf16.data(), utf16.size()));
+    }
+
+    std::optional<Atom> AtomTable::intern(const Token& token)
+    {
+        if (const auto view = StringValueView(token))
+            return intern(*view);
+
+        QString value{};
+        if (DecodeString(token, value) != StringStatus::Ok)
+            return std::nullopt;
+
+        return intern(QStringView(value));
+    }
+
+    std::optional<Atom> AtomTable::intern(const Utf8Token& token)
+    {
+        if (const auto view = StringValueView(token))
+            return intern(*view);
+
+        QByteArray value{};
+        if (DecodeString(token, value) != StringStatus::Ok)
+            return std::nullopt;
+
+        return intern(QUtf8StringView(value));
+    }
+
+    std::optional<Atom> AtomTable::find(QStringView name) const
+    {
+        std::shared_lock lock{ m_mutex };
+        if (const auto atom = m_atoms.find(ToStdView(name)); atom != m_atoms.end())
+            return atom->second;
+
+        return std::nullopt;
+    }
+
+    QStringView AtomTable::name(Atom atom) const
+    {
+        std::shared_lock lock{ m_mutex };
+        const auto name = m_names.at(static_cast<u32>(atom));
+        return QStringView(name.data(), static_cast<qsizetype>(name.size()));
+    }
+
+    i32 AtomTable::size() const
+    {
+        std::shared_lock lock{ m_mutex };
+        return static_cast<i32>(m_names.size());
+    }
+
+    i64 AtomTable::allocatedBytes() const
+    {
+        std::shared_lock lock{ m_mutex };
+        return m_allocatedBytes;
+    }
+
+    Atom AtomTable::add(std::u16string_view name)
+    {
+        const auto size = static_cast<i32>(name.size());
+        char16_t* storage = nullptr;
+        if (size >= BlockSize)
+        {
+            // Long names get a block of their own so the current block stays open for the next names
+            m_blocks.push_back(std::make_unique_for_overwrite<char16_t[]>(size));
+            m_allocatedBytes += static_cast<i64>(size) * static_cast<i64>(sizeof(char16_t));
+            storage = m_blocks.back().get();
+        }
+        else
+        {
+            if (m_block == nullptr || size > BlockSize - m_blockUsed)
+            {
+                m_blocks.push_back(std::make_unique_for_overwrite<char16_t[]>(BlockSize));
+                m_allocatedBytes += static_cast<i64>(BlockSize) * static_cast<i64>(sizeof(char16_t));
+                m_block = m_blocks.back().get();
+                m_blockUsed = 0;
+            }
+
+            storage = m_block + m_blockUsed;
+            m_blockUsed += size;
+        }
+
+        std::copy(name.begin(), name.end(), storage);
+        const auto atom = static_cast<Atom>(m_names.size());
+        const auto stored = std::u16string_view{ storage, name.size() };
+        m_names.push_back(stored);
+        m_atoms.emplace(stored, atom);
+        return atom;
+    }
+}
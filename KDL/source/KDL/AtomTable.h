@@ -0,0 +1,68 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/Token.h>
+#include <KDL/Utf8Token.h>
+#include <Defines.h>
+
+#include <QString>
+#include <QUtf8StringView>
+
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace KDL
+{
+    // Dense ID of an interned name, the first name added to a table gets 0, the next 1 and so on
+    enum class KDL_API Atom : u32
+    {
+    };
+
+    // Interns node names and property keys so they are stored once and compare as integers.
+    // Names never move once added, so views returned by name stay valid as long as the table lives.
+    // All functions may be called from several threads at once, which lets documents lexed or parsed
+    // in parallel share one table through a std::shared_ptr.
+    class KDL_API AtomTable
+    {
+    public:
+        AtomTable() = default;
+        AtomTable(const AtomTable&) = delete;
+        AtomTable& operator=(const AtomTable&) = delete;
+
+        // Atom of name, adding it if it isn't in the table yet
+        [[nodiscard]] Atom intern(QStringView name);
+        [[nodiscard]] Atom intern(QUtf8StringView name);
+
+        // Atom of the value of an identifier, quoted or raw string token, or nothing if the token
+        // isn't one of those or its value can't be decoded
+        [[nodiscard]] std::optional<Atom> intern(const Token& token);
+        [[nodiscard]] std::optional<Atom> intern(const Utf8Token& token);
+
+        // Atom of name if it has been interned, never adds anything
+        [[nodiscard]] std::optional<Atom> find(QStringView name) const;
+
+        [[nodiscard]] QStringView name(Atom atom) const;
+        [[nodiscard]] i32 size() const;
+
+        // Bytes allocated for names, including unused block capacity, but not for the lookup table
+        [[nodiscard]] i64 allocatedBytes() const;
+
+    private:
+        [[nodiscard]] Atom add(std::u16string_view name);
+
+        // Names are copied into blocks of this many code units, longer names get a block of their own
+        static constexpr i32 BlockSize = 16 * 1024;
+
+        mutable std::shared_mutex m_mutex;
+        std::vector<std::unique_ptr<char16_t[]>> m_blocks;
+        char16_t* m_block = nullptr;
+        i32 m_blockUsed = 0;
+        i64 m_allocatedBytes = 0;
+        std::vector<std::u16string_view> m_names;
+        std::unordered_map<std::u16string_view, Atom> m_atoms;
+    };
+}
@@ -0,0 +1,405 @@
+#include <KDL/Binary.h>
+#include <KDL/BinaryBuilder.h>
+#include <KDL/LexToken.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+    using namespace KDL;
+
+    [[nodiscard]] bool IsUnsignedInteger(const BinaryFormat::ValueRecord& record) noexcept
+    {
+        return (record.flags & BinaryFormat::IsUnsigned) != 0;
+    }
+
+    // The top level nodes or the children of a node, while validating them
+    struct NodeBlock
+    {
+        u64 offset;
+        u64 end;
+        u32 remaining;
+    };
+
+    template<typename T>
+    [[nodiscard]] T Read(const char* data, u64 offset) noexcept
+    {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    [[nodiscard]] bool IsValidString(const BinaryFormat::Header& header, u32 index, bool isOptional) noexcept
+    {
+        return index < header.stringCount || (isOptional && index == BinaryFormat::NoString);
+    }
+
+    [[nodiscard]] bool IsValidValue(const BinaryFormat::Header& header, const BinaryFormat::ValueRecord& record) noexcept
+    {
+        return record.type <= static_cast<u8>(ValueType::Null) && record.kind <= static_cast<u8>(TokenKind::EndOfFile)
+            && IsValidString(header, record.text, false) && IsValidString(header, record.typeAnnotation, true);
+    }
+
+    [[nodiscard]] bool AreValidStrings(const char* data, const BinaryFormat::Header& header) noexcept
+    {
+        for (auto i = u32(0); i < header.stringCount; i++)
+        {
+            // The units are viewed in place, so they have to be aligned
+            const auto offset = static_cast<u64>(Read<u32>(data, header.stringTable + static_cast<u64>(i) * sizeof(u32)));
+            if (offset % sizeof(char16_t) != 0 || offset + sizeof(u32) > header.size)
+                return false;
+
+            const auto length = static_cast<u64>(Read<u32>(data, offset));
+            if (offset + sizeof(u32) + length * sizeof(char16_t) > header.size)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Every node has to fit in the block of its parent, with its values in front of its children
+    [[nodiscard]] bool AreValidNodes(const char* data, const BinaryFormat::Header& header) noexcept
+    {
+        // Documents are encoded by parsing them, which limits how deep they are nested
+        std::array<NodeBlock, MaxNestingDepth + 1> blocks;
+        blocks[0] = { .offset = header.firstNode, .end = header.nodesEnd, .remaining = header.nodeCount };
+        auto depth = size_t(0);
+        while (true)
+        {
+            auto& block = blocks[depth];
+            if (block.offset == block.end)
+            {
+                if (block.remaining != 0)
+                    return false;
+
+                if (depth == 0)
+                    return true;
+
+                depth--;
+                continue;
+            }
+
+            if (block.remaining == 0 || block.offset + sizeof(BinaryFormat::NodeRecord) > block.end)
+                return false;
+
+            const auto record = Read<BinaryFormat::NodeRecord>(data, block.offset);
+            const auto values = block.offset + sizeof(BinaryFormat::NodeRecord);
+            const auto properties = values + static_cast<u64>(record.argumentCount) * sizeof(BinaryFormat::ValueRecord);
+            const auto children = properties + static_cast<u64>(record.propertyCount) * sizeof(BinaryFormat::PropertyRecord);
+            if (children > record.end || record.end > block.end || !IsValidString(header, record.name, false)
+                || !IsValidString(header, record.typeAnnotation, true))
+                return false;
+
+            for (auto offset = values; offset < properties; offset += sizeof(BinaryFormat::ValueRecord))
+            {
+                if (!IsValidValue(header, Read<BinaryFormat::ValueRecord>(data, offset)))
+                    return false;
+            }
+
+            for (auto offset = properties; offset < children; offset += sizeof(BinaryFormat::PropertyRecord))
+            {
+                const auto property = Read<BinaryFormat::PropertyRecord>(data, offset);
+                if (!IsValidString(header, property.name, false) || !IsValidValue(header, property.value))
+                    return false;
+            }
+
+            block.offset = record.end;
+            block.remaining--;
+            if (children == record.end && record.childCount == 0)
+                continue;
+
+            if (depth + 1 == blocks.size())
+                return false;
+
+            blocks[++depth] = { .offset = children, .end = record.end, .remaining = record.childCount };
+        }
+    }
+
+    [[nodiscard]] BinaryStatus CheckHeader(QByteArrayView bytes) noexcept
+    {
+        if (bytes.size() < static_cast<qsizetype>(sizeof(BinaryFormat::Header)))
+            return BinaryStatus::InvalidHeader;
+
+        const auto header = Read<BinaryFormat::Header>(bytes.data(), 0);
+        if (header.magic != BinaryFormat::Magic)
+            return BinaryStatus::InvalidHeader;
+
+        if (header.version != BinaryFormat::Version)
+            return BinaryStatus::UnsupportedVersion;
+
+        const auto size = static_cast<u64>(bytes.size());
+        if (header.size > size || header.nodesEnd > header.size || header.firstNode > header.nodesEnd
+            || header.stringTable + static_cast<u64>(header.stringCount) * sizeof(u32) > header.size)
+            return BinaryStatus::Truncated;
+
+        return BinaryStatus::Ok;
+    }
+}
+
+namespace KDL
+{
+    // Only BinaryDocument has access to m_data, so OpenBinary goes through this
+    class BinaryLoader
+    {
+    public:
+        [[nodiscard]] static BinaryDocument open(const char* data) noexcept
+        {
+            BinaryDocument document;
+            document.m_data = data;
+            return document;
+        }
+    };
+
+    ValueType BinaryValue::type() const noexcept
+    {
+        return static_cast<ValueType>(m_document->read<BinaryFormat::ValueRecord>(m_offset).type);
+    }
+
+    std::optional<QStringView> BinaryValue::typeAnnotation() const noexcept
+    {
+        const auto index = m_document->read<BinaryFormat::ValueRecord>(m_offset).typeAnnotation;
+        if (index == BinaryFormat::NoString)
+            return std::nullopt;
+
+        return m_document->string(index);
+    }
+
+    QStringView BinaryValue::string() const noexcept
+    {
+        return m_document->string(m_document->read<BinaryFormat::ValueRecord>(m_offset).text);
+    }
+
+    bool BinaryValue::boolean() const noexcept
+    {
+        return static_cast<TokenKind>(m_document->read<BinaryFormat::ValueRecord>(m_offset).kind) == TokenKind::Keyword_True;
+    }
+
+    NumberResult<i64> BinaryValue::toInt64() const noexcept
+    {
+        const auto record = m_document->read<BinaryFormat::ValueRecord>(m_offset);
+        if ((record.flags & BinaryFormat::HasNumber) == 0 || record.type != static_cast<u8>(ValueType::Integer))
+            return DecodeInt64(Token{ .kind = static_cast<TokenKind>(record.kind), .stringView = string() });
+
+        if (IsUnsignedInteger(record))
+            return { .status = NumberStatus::Overflow };
+
+        return { .value = static_cast<i64>(record.number), .status = NumberStatus::Ok };
+    }
+
+    NumberResult<u64> BinaryValue::toUInt64() const noexcept
+    {
+        const auto record = m_document->read<BinaryFormat::ValueRecord>(m_offset);
+        if ((record.flags & BinaryFormat::HasNumber) == 0 || record.type != static_cast<u8>(ValueType::Integer))
+            return DecodeUInt64(Token{ .kind = static_cast<TokenKind>(record.kind), .stringView = string() });
+
+        if (!IsUnsignedInteger(record) && static_cast<i64>(record.number) < 0)
+            return { .status = NumberStatus::Overflow };
+
+        return { .value = record.number, .status = NumberStatus::Ok };
+    }
+
+    NumberResult<double> BinaryValue::toDouble() const noexcept
+    {
+        const auto record = m_document->read<BinaryFormat::ValueRecord>(m_offset);
+        if ((record.flags & BinaryFormat::HasNumber) == 0)
+            return DecodeDouble(Token{ .kind = static_cast<TokenKind>(record.kind), .stringView = string() });
+
+        if (record.type == static_cast<u8>(ValueType::Float))
+            return { .value = std::bit_cast<double>(record.number), .status = NumberStatus::Ok };
+
+        if (IsUnsignedInteger(record))
+            return { .value = static_cast<double>(record.number), .status = NumberStatus::Ok };
+
+        return { .value = static_cast<double>(static_cast<i64>(record.number)), .status = NumberStatus::Ok };
+    }
+
+    BinaryValue::BinaryValue(const BinaryDocument& document, u32 offset) noexcept
+        : m_document{ &document }
+        , m_offset{ offset }
+    {
+    }
+
+    QStringView BinaryProperty::name() const noexcept
+    {
+        return m_document->string(m_document->read<u32>(m_offset + offsetof(BinaryFormat::PropertyRecord, name)));
+    }
+
+    BinaryValue BinaryProperty::value() const noexcept
+    {
+        return BinaryValue{ *m_document, static_cast<u32>(m_offset + offsetof(BinaryFormat::PropertyRecord, value)) };
+    }
+
+    BinaryProperty::BinaryProperty(const BinaryDocument& document, u32 offset) noexcept
+        : m_document{ &document }
+        , m_offset{ offset }
+    {
+    }
+
+    BinaryNode BinaryNodeRange::Iterator::operator*() const noexcept
+    {
+        return BinaryNode{ *m_document, m_offset };
+    }
+
+    BinaryNodeRange::Iterator& BinaryNodeRange::Iterator::operator++() noexcept
+    {
+        m_offset = m_document->read<u32>(m_offset + offsetof(BinaryFormat::NodeRecord, end));
+        return *this;
+    }
+
+    BinaryNodeRange::Iterator::Iterator(const BinaryDocument* document, u32 offset) noexcept
+        : m_document{ document }
+        , m_offset{ offset }
+    {
+    }
+
+    BinaryNodeRange::Iterator BinaryNodeRange::begin() const noexcept
+    {
+        return Iterator{ m_document, m_first };
+    }
+
+    BinaryNodeRange::Iterator BinaryNodeRange::end() const noexcept
+    {
+        return Iterator{ m_document, m_end };
+    }
+
+    BinaryNodeRange::BinaryNodeRange(const BinaryDocument& document, u32 first, u32 end) noexcept
+        : m_document{ &document }
+        , m_first{ first }
+        , m_end{ end }
+    {
+    }
+
+    QStringView BinaryNode::name() const noexcept
+    {
+        return m_document->string(m_document->read<BinaryFormat::NodeRecord>(m_offset).name);
+    }
+
+    std::optional<QStringView> BinaryNode::typeAnnotation() const noexcept
+    {
+        const auto index = m_document->read<BinaryFormat::NodeRecord>(m_offset).typeAnnotation;
+        if (index == BinaryFormat::NoString)
+            return std::nullopt;
+
+        return m_document->string(index);
+    }
+
+    i32 BinaryNode::argumentCount() const noexcept
+    {
+        return static_cast<i32>(m_document->read<u32>(m_offset + offsetof(BinaryFormat::NodeRecord, argumentCount)));
+    }
+
+    BinaryValue BinaryNode::argument(i32 index) const noexcept
+    {
+        return BinaryValue{ *m_document, static_cast<u32>(m_offset + sizeof(BinaryFormat::NodeRecord) + index * sizeof(BinaryFormat::ValueRecord)) };
+    }
+
+    i32 BinaryNode::propertyCount() const noexcept
+    {
+        return static_cast<i32>(m_document->read<u32>(m_offset + offsetof(BinaryFormat::NodeRecord, propertyCount)));
+    }
+
+    BinaryProperty BinaryNode::property(i32 index) const noexcept
+    {
+        const auto first = m_offset + sizeof(BinaryFormat::NodeRecord) + argumentCount() * sizeof(BinaryFormat::ValueRecord);
+        return BinaryProperty{ *m_document, static_cast<u32>(first + index * sizeof(BinaryFormat::PropertyRecord)) };
+    }
+
+    std::optional<BinaryValue> BinaryNode::property(QStringView name) const noexcept
+    {
+        for (auto i = 0; i < propertyCount(); i++)
+        {
+            const auto property = this->property(i);
+            if (property.name() == name)
+                return property.value();
+        }
+
+        return std::nullopt;
+    }
+
+    i32 BinaryNode::childCount() const noexcept
+    {
+        return static_cast<i32>(m_document->read<u32>(m_offset + offsetof(BinaryFormat::NodeRecord, childCount)));
+    }
+
+    BinaryNodeRange BinaryNode::children() const noexcept
+    {
+        const auto record = m_document->read<BinaryFormat::NodeRecord>(m_offset);
+        const auto first = m_offset + sizeof(BinaryFormat::NodeRecord)
+            + record.argumentCount * sizeof(BinaryFormat::ValueRecord)
+            + record.propertyCount * sizeof(BinaryFormat::PropertyRecord);
+        return BinaryNodeRange{ *m_document, static_cast<u32>(first), record.end };
+    }
+
+    BinaryNode::BinaryNode(const BinaryDocument& document, u32 offset) noexcept
+        : m_document{ &document }
+        , m_offset{ offset }
+    {
+    }
+
+    i32 BinaryDocument::nodeCount() const noexcept
+    {
+        if (!m_data)
+            return 0;
+
+        return static_cast<i32>(read<BinaryFormat::Header>(0).nodeCount);
+    }
+
+    BinaryNodeRange BinaryDocument::nodes() const noexcept
+    {
+        if (!m_data)
+            return BinaryNodeRange{ *this, 0, 0 };
+
+        const auto header = read<BinaryFormat::Header>(0);
+        return BinaryNodeRange{ *this, header.firstNode, header.nodesEnd };
+    }
+
+    template<typename T>
+    T BinaryDocument::read(u32 offset) const noexcept
+    {
+        // The bytes may come from anywhere, so they aren't accessed as a T in place
+        T value;
+        std::memcpy(&value, m_data + offset, sizeof(T));
+        return value;
+    }
+
+    QStringView BinaryDocument::string(u32 index) const noexcept
+    {
+        const auto offset = read<u32>(read<u32>(offsetof(BinaryFormat::Header, stringTable)) + index * sizeof(u32));
+        const auto length = read<u32>(offset);
+        return QStringView{ reinterpret_cast<const char16_t*>(m_data + offset + sizeof(u32)), static_cast<qsizetype>(length) };
+    }
+
+    BinaryOpenResult OpenBinary(QByteArrayView bytes) noexcept
+    {
+        if (const auto status = CheckHeader(bytes); status != BinaryStatus::Ok)
+            return { .status = status };
+
+        const auto header = Read<BinaryFormat::Header>(bytes.data(), 0);
+        if (header.firstNode < sizeof(BinaryFormat::Header) || !AreValidStrings(bytes.data(), header)
+            || !AreValidNodes(bytes.data(), header))
+            return { .status = BinaryStatus::Corrupted };
+
+        return { .document = BinaryLoader::open(bytes.data()), .status = BinaryStatus::Ok };
+    }
+
+    BinaryOpenResult OpenBinaryUnchecked(QByteArrayView bytes) noexcept
+    {
+        if (const auto status = CheckHeader(bytes); status != BinaryStatus::Ok)
+            return { .status = status };
+
+        return { .document = BinaryLoader::open(bytes.data()), .status = BinaryStatus::Ok };
+    }
+
+    BinaryEncodeResult EncodeBinary(const QString& source)
+    {
+        return EncodeDocument(LexerDetail::LexingTokens{ source });
+    }
+
+    BinaryEncodeResult EncodeBinary(const TokenBuffer& tokens)
+    {
+        return EncodeDocument(BufferedTokens{ tokens });
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/EventParser.h>
+#include <KDL/Number.h>
+#include <KDL/TokenBuffer.h>
+#include <Defines.h>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+#include <optional>
+
+namespace KDL
+{
+    class BinaryDocument;
+    class BinaryNode;
+
+    class KDL_API BinaryValue
+    {
+    public:
+        [[nodiscard]] ValueType type() const noexcept;
+        [[nodiscard]] std::optional<QStringView> typeAnnotation() const noexcept;
+
+        // The decoded value of a string, numbers and keywords keep the text they were written as
+        [[nodiscard]] QStringView string() const noexcept;
+        [[nodiscard]] bool boolean() const noexcept;
+
+        // Numbers are decoded when they are encoded, only integers beyond 64 bits are decoded on every call
+        [[nodiscard]] NumberResult<i64> toInt64() const noexcept;
+        [[nodiscard]] NumberResult<u64> toUInt64() const noexcept;
+        [[nodiscard]] NumberResult<double> toDouble() const noexcept;
+
+    private:
+        friend class BinaryNode;
+        friend class BinaryProperty;
+
+        BinaryValue(const BinaryDocument& document, u32 offset) noexcept;
+
+        const BinaryDocument* m_document;
+        u32 m_offset;
+    };
+
+    class KDL_API BinaryProperty
+    {
+    public:
+        [[nodiscard]] QStringView name() const noexcept;
+        [[nodiscard]] BinaryValue value() const noexcept;
+
+    private:
+        friend class BinaryNode;
+
+        BinaryProperty(const BinaryDocument& document, u32 offset) noexcept;
+
+        const BinaryDocument* m_document;
+        u32 m_offset;
+    };
+
+    // Iterates a node and its following siblings
+    class KDL_API BinaryNodeRange
+    {
+    public:
+        class KDL_API Iterator
+        {
+        public:
+            [[nodiscard]] BinaryNode operator*() const noexcept;
+            // Jumps over the children of the current node
+            Iterator& operator++() noexcept;
+            [[nodiscard]] bool operator==(const Iterator& other) const noexcept = default;
+
+        private:
+            friend class BinaryNodeRange;
+
+            Iterator(const BinaryDocument* document, u32 offset) noexcept;
+
+            const BinaryDocument* m_document;
+            u32 m_offset;
+        };
+
+        [[nodiscard]] Iterator begin() const noexcept;
+        [[nodiscard]] Iterator end() const noexcept;
+
+    private:
+        friend class BinaryNode;
+        friend class BinaryDocument;
+
+        BinaryNodeRange(const BinaryDocument& document, u32 first, u32 end) noexcept;
+
+        const BinaryDocument* m_document;
+        u32 m_first;
+        u32 m_end;
+    };
+
+    class KDL_API BinaryNode
+    {
+    public:
+        [[nodiscard]] QStringView name() const noexcept;
+        [[nodiscard]] std::optional<QStringView> typeAnnotation() const noexcept;
+
+        [[nodiscard]] i32 argumentCount() const noexcept;
+        [[nodiscard]] BinaryValue argument(i32 index) const noexcept;
+
+        // Duplicate properties are removed when encoding, only the rightmost one is kept
+        [[nodiscard]] i32 propertyCount() const noexcept;
+        [[nodiscard]] BinaryProperty property(i32 index) const noexcept;
+        [[nodiscard]] std::optional<BinaryValue> property(QStringView name) const noexcept;
+
+        [[nodiscard]] i32 childCount() const noexcept;
+        [[nodiscard]] BinaryNodeRange children() const noexcept;
+
+    private:
+        friend class BinaryNodeRange;
+
+        BinaryNode(const BinaryDocument& document, u32 offset) noexcept;
+
+        const BinaryDocument* m_document;
+        u32 m_offset;
+    };
+
+    // A document in the binary form of EncodeBinary, read in place. Nodes are stored in document order with
+    // the offset of their end, so children are skipped with a single jump. Strings are interned into one
+    // table of length-prefixed UTF-16 strings and viewed where they are, numbers are stored decoded.
+    // Nothing is copied or allocated when opening or reading, the bytes have to outlive the document.
+    class KDL_API BinaryDocument
+    {
+    public:
+        BinaryDocument() = default;
+
+        // Top level nodes
+        [[nodiscard]] i32 nodeCount() const noexcept;
+        [[nodiscard]] BinaryNodeRange nodes() const noexcept;
+
+    private:
+        friend class BinaryValue;
+        friend class BinaryProperty;
+        friend class BinaryNodeRange;
+        friend class BinaryNode;
+        friend class BinaryLoader;
+
+        template<typename T>
+        [[nodiscard]] T read(u32 offset) const noexcept;
+        [[nodiscard]] QStringView string(u32 index) const noexcept;
+
+        const char* m_data = nullptr;
+    };
+
+    enum class KDL_API BinaryStatus
+    {
+        Ok,
+        // Too short for a header or a header that isn't of the binary form
+        InvalidHeader,
+        UnsupportedVersion,
+        // The header refers to more bytes than there are
+        Truncated,
+        // A record or a string refers to bytes outside of where it belongs, or to a string that doesn't exist
+        Corrupted
+    };
+
+    struct KDL_API BinaryOpenResult
+    {
+        // Empty unless status is BinaryStatus::Ok
+        BinaryDocument document;
+        BinaryStatus status = BinaryStatus::Ok;
+    };
+
+    // Checks that every offset and string index stays inside the bytes, in one pass over the records without
+    // allocating, so damaged or hostile bytes are rejected instead of read out of bounds. The bytes have to be
+    // of the same byte order. Opening a memory mapped file is the fastest way to load a document.
+    KDL_API [[nodiscard]] BinaryOpenResult OpenBinary(QByteArrayView bytes) noexcept;
+    // Only checks the header, for bytes EncodeBinary just returned. Reading a document opened from any other
+    // bytes this way may read out of bounds.
+    KDL_API [[nodiscard]] BinaryOpenResult OpenBinaryUnchecked(QByteArrayView bytes) noexcept;
+
+    struct KDL_API BinaryEncodeResult
+    {
+        // Empty unless status is ParseStatus::Ok
+        QByteArray bytes;
+        ParseStatus status = ParseStatus::Ok;
+        // Source offset of the token the error was found at
+        i32 errorOffset = 0;
+    };
+
+    // Parses KDL text straight into the binary form, without building a document. The text of numbers and
+    // keywords is kept, so writing the binary document with a Writer gives the same text as writing the
+    // parsed one. Documents are limited to 4 GiB.
+    KDL_API [[nodiscard]] BinaryEncodeResult EncodeBinary(const QString& source);
+    KDL_API [[nodiscard]] BinaryEncodeResult EncodeBinary(const TokenBuffer& tokens);
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <KDL/AtomTable.h>
+#include <KDL/Binary.h>
+#include <KDL/BinaryFormat.h>
+#include <KDL/DuplicateProperties.h>
+#include <KDL/EventParser.h>
+
+#include <bit>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+namespace KDL
+{
+    // Writes the binary form while the parser reports the nodes. A node record is written when the node
+    // begins and its counts and end are filled in when it ends. Properties are held back until all arguments
+    // are written, so they can follow them. Strings are interned in an AtomTable, whose dense atoms are the
+    // string indexes, and the string table is written once all nodes are.
+    class BinaryBuilder
+    {
+    public:
+        explicit BinaryBuilder(QByteArray& bytes)
+            : m_bytes{ bytes }
+        {
+            m_bytes.resize(sizeof(BinaryFormat::Header));
+        }
+
+        void beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32)
+        {
+            if (m_openNodes.empty())
+                m_nodeCount++;
+            else
+                m_openNodes.back().childCount++;
+
+            m_openNodes.push_back({ .offset = static_cast<u32>(m_bytes.size()) });
+            append(BinaryFormat::NodeRecord{
+                .name = intern(name),
+                .typeAnnotation = intern(typeAnnotation),
+                .argumentCount = 0,
+                .propertyCount = 0,
+                .childCount = 0,
+                .end = 0
+                });
+            m_isInEntries = true;
+        }
+
+        void argument(const EventValue& value)
+        {
+            append(record(value));
+            m_openNodes.back().argumentCount++;
+        }
+
+        // Duplicates are dropped when the properties are written, as in a parsed document
+        void property(QStringView name, const EventValue& value, i32)
+        {
+            m_properties.push_back({ .name = intern(name), .reserved = 0, .value = record(value) });
+        }
+
+        void beginChildren()
+        {
+            endEntries();
+        }
+
+        void endChildren()
+        {
+        }
+
+        void endNode()
+        {
+            if (m_isInEntries)
+                endEntries();
+
+            const auto node = m_openNodes.back();
+            m_openNodes.pop_back();
+
+            auto record = BinaryFormat::NodeRecord{};
+            std::memcpy(&record, m_bytes.constData() + node.offset, sizeof(record));
+            record.argumentCount = node.argumentCount;
+            record.propertyCount = node.propertyCount;
+            record.childCount = node.childCount;
+            record.end = static_cast<u32>(m_bytes.size());
+            std::memcpy(m_bytes.data() + node.offset, &record, sizeof(record));
+        }
+
+        // Appends the string table and writes the header
+        void finish()
+        {
+            const auto nodesEnd = static_cast<u32>(m_bytes.size());
+            const auto stringCount = static_cast<u32>(m_strings.size());
+
+            // Offsets first, then the strings, each padded to keep the next one aligned
+            const auto offsetsStart = m_bytes.size();
+            m_bytes.resize(offsetsStart + static_cast<qsizetype>(stringCount) * sizeof(u32));
+            for (auto index = u32(0); index < stringCount; index++)
+            {
+                const auto offset = static_cast<u32>(m_bytes.size());
+                std::memcpy(m_bytes.data() + offsetsStart + index * sizeof(u32), &offset, sizeof(offset));
+
+                const auto name = m_strings.name(static_cast<Atom>(index));
+                const auto length = static_cast<u32>(name.size());
+                append(length);
+                m_bytes.append(reinterpret_cast<const char*>(name.utf16()), static_cast<qsizetype>(length) * sizeof(char16_t));
+                pad();
+            }
+
+            const auto header = BinaryFormat::Header{
+                .magic = BinaryFormat::Magic,
+                .version = BinaryFormat::Version,
+                .reserved = 0,
+                .size = static_cast<u32>(m_bytes.size()),
+                .nodeCount = m_nodeCount,
+                .firstNode = sizeof(BinaryFormat::Header),
+                .nodesEnd = nodesEnd,
+                .stringTable = static_cast<u32>(offsetsStart),
+                .stringCount = stringCount
+            };
+            std::memcpy(m_bytes.data(), &header, sizeof(header));
+        }
+
+    private:
+        struct OpenNode
+        {
+            u32 offset;
+            u32 argumentCount = 0;
+            u32 propertyCount = 0;
+            u32 childCount = 0;
+        };
+
+        template<typename T>
+        void append(const T& value)
+        {
+            m_bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void pad()
+        {
+            const auto size = m_bytes.size();
+            m_bytes.resize((size + 3) & ~qsizetype(3));
+            std::memset(m_bytes.data() + size, 0, static_cast<size_t>(m_bytes.size() - size));
+        }
+
+        [[nodiscard]] u32 intern(QStringView text)
+        {
+            return static_cast<u32>(m_strings.intern(text));
+        }
+
+        [[nodiscard]] u32 intern(std::optional<QStringView> text)
+        {
+            return text ? intern(*text) : BinaryFormat::NoString;
+        }
+
+        [[nodiscard]] BinaryFormat::ValueRecord record(const EventValue& value)
+        {
+            auto record = BinaryFormat::ValueRecord{
+                .type = static_cast<u8>(value.type),
+                .kind = static_cast<u8>(value.kind),
+                .flags = 0,
+                .reserved = 0,
+                .text = intern(value.text),
+                .typeAnnotation = intern(value.typeAnnotation),
+                .reserved2 = 0,
+                .number = 0
+            };
+
+            const auto token = Token{ .kind = value.kind, .stringView = value.text };
+            if (value.type == ValueType::Integer)
+            {
+                if (const auto signedValue = DecodeInt64(token); signedValue.status == NumberStatus::Ok)
+                {
+                    record.flags = BinaryFormat::HasNumber;
+                    record.number = static_cast<u64>(signedValue.value);
+                }
+                else if (const auto unsignedValue = DecodeUInt64(token); unsignedValue.status == NumberStatus::Ok)
+                {
+                    record.flags = BinaryFormat::HasNumber | BinaryFormat::IsUnsigned;
+                    record.number = unsignedValue.value;
+                }
+            }
+            else if (value.type == ValueType::Float)
+            {
+                if (const auto floatValue = DecodeDouble(token); floatValue.status == NumberStatus::Ok)
+                {
+                    record.flags = BinaryFormat::HasNumber;
+                    record.number = std::bit_cast<u64>(floatValue.value);
+                }
+            }
+
+            return record;
+        }
+
+        void endEntries()
+        {
+            m_isInEntries = false;
+            const auto kept = DropDuplicateProperties(m_properties.begin(), m_properties.end(), m_propertyNames,
+                [](const BinaryFormat::PropertyRecord& property) { return property.name; });
+            for (auto property = kept; property != m_properties.end(); ++property)
+                append(*property);
+
+            m_openNodes.back().propertyCount = static_cast<u32>(m_properties.end() - kept);
+            m_properties.clear();
+        }
+
+        QByteArray& m_bytes;
+        AtomTable m_strings;
+        u32 m_nodeCount = 0;
+        std::vector<OpenNode> m_openNodes;
+        bool m_isInEntries = false;
+        std::vector<BinaryFormat::PropertyRecord> m_properties;
+        std::unordered_set<u32> m_propertyNames;
+    };
+
+    // Parses the tokens into the binary form, shared by the buffered and the fused encoding
+    template<typename TTokens>
+    [[nodiscard]] BinaryEncodeResult EncodeDocument(TTokens tokens)
+    {
+        BinaryEncodeResult result{};
+        ParseBuffers buffers{};
+        BinaryBuilder builder{ result.bytes };
+        EventParser<BinaryBuilder, TTokens> parser{ tokens, builder, buffers };
+        result.status = parser.parse();
+        if (result.status != ParseStatus::Ok)
+        {
+            result.errorOffset = parser.errorOffset();
+            result.bytes = QByteArray();
+            return result;
+        }
+
+        builder.finish();
+        return result;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Defines.h>
+
+namespace KDL::BinaryFormat
+{
+    // "KDLB" read as a little-endian u32
+    inline constexpr u32 Magic = 0x424C444B;
+    inline constexpr u16 Version = 1;
+    // String index of an absent type annotation
+    inline constexpr u32 NoString = 0xFFFFFFFF;
+
+    // All offsets are in bytes from the start of the header. Records are 8 byte aligned, so the numbers in
+    // them can be read in place.
+    struct Header
+    {
+        u32 magic;
+        u16 version;
+        u16 reserved;
+        // Of the whole document, header included
+        u32 size;
+        u32 nodeCount;
+        u32 firstNode;
+        u32 nodesEnd;
+        // An array of stringCount u32 offsets, each pointing to a u32 length followed by as many UTF-16 units
+        u32 stringTable;
+        u32 stringCount;
+    };
+
+    // Followed by its argument values, its properties and its children
+    struct NodeRecord
+    {
+        u32 name;
+        u32 typeAnnotation;
+        u32 argumentCount;
+        u32 propertyCount;
+        u32 childCount;
+        // Offset right after the last child, where the next sibling starts
+        u32 end;
+    };
+
+    enum ValueFlag : u8
+    {
+        // number holds the decoded value, only integers beyond 64 bits and decimals out of the double range
+        // have to be decoded from their text
+        HasNumber = 1 << 0,
+        // number holds a u64 above the i64 range
+        IsUnsigned = 1 << 1
+    };
+
+    struct ValueRecord
+    {
+        u8 type;
+        u8 kind;
+        u8 flags;
+        u8 reserved;
+        // The decoded string, or the text of a number or keyword
+        u32 text;
+        u32 typeAnnotation;
+        u32 reserved2;
+        // An i64, a u64 or the bits of a double, depending on type and flags
+        u64 number;
+    };
+
+    struct PropertyRecord
+    {
+        u32 name;
+        u32 reserved;
+        ValueRecord value;
+    };
+
+    static_assert(sizeof(Header) == 32);
+    static_assert(sizeof(NodeRecord) == 24);
+    static_assert(sizeof(ValueRecord) == 24);
+    static_assert(sizeof(PropertyRecord) == 32);
+}
@@ -0,0 +1,16 @@
+#include <KDL/Binding.h>
+#include <KDL/BindingDecoder.h>
+#include <KDL/LexToken.h>
+
+namespace KDL::BindingDetail
+{
+    BindResult BindDocument(const QString& source, BindTarget root)
+    {
+        return DecodeDocument(LexerDetail::LexingTokens{ source }, static_cast<i32>(source.size()), root);
+    }
+
+    BindResult BindDocument(const TokenBuffer& tokens, BindTarget root)
+    {
+        return DecodeDocument(BufferedTokens{ tokens }, static_cast<i32>(tokens.source().size()), root);
+    }
+}
@@ -0,0 +1,413 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/EventParser.h>
+#include <KDL/Number.h>
+#include <KDL/TokenBuffer.h>
+#include <Defines.h>
+
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace KDL
+{
+    enum class KDL_API BindStatus
+    {
+        // A node or property without a field of that name, or a child or property of a node holding a value
+        UnknownField,
+        // A required field that no node or property was given for
+        MissingField,
+        // A value of the wrong type, a number that doesn't fit into the field, a value node without exactly
+        // one argument or an argument on a node that holds a struct
+        TypeMismatch
+    };
+
+    struct KDL_API BindError
+    {
+        BindStatus status;
+        // Name of the field, or of the unknown node or property
+        QString name;
+        // Source offset of the offending name or value token. Missing fields are reported at the name of the
+        // node that lacks them, or at the end of the source for the top level. LineIndex turns it into a line.
+        i32 offset = 0;
+    };
+
+    struct KDL_API BindResult
+    {
+        // Binding stops at a syntax error, fields read before it keep their values
+        ParseStatus status = ParseStatus::Ok;
+        // Source offset of the token the syntax error was found at
+        i32 errorOffset = 0;
+        // Binding errors don't stop the decoder, so all of them are reported in document order
+        std::vector<BindError> errors;
+    };
+
+    template<typename TObject, typename TMember>
+    struct Field
+    {
+        // The node or property name the member is read from
+        std::u16string_view name;
+        TMember TObject::* member;
+        bool isRequired = false;
+    };
+
+    // Makes T bindable when specialized with a constexpr tuple of its fields:
+    //
+    //     template<>
+    //     struct KDL::Binding<Server>
+    //     {
+    //         static constexpr auto fields = std::tuple{
+    //             KDL_REQUIRED_FIELD(Server, host),
+    //             KDL_FIELD(Server, port),
+    //             KDL::Field<Server, i32>{ u"max-connections", &Server::maxConnections },
+    //         };
+    //     };
+    //
+    // A field is read from a property of the node of its struct or from a child node with its name:
+    //  - bool, integers, floating point numbers and QString take one value, numbers have to fit into the member
+    //  - std::optional of these is set when the field is present
+    //  - std::vector of these takes all arguments of its node, and grows with every repeated node or property
+    //  - a bound struct reads its fields from the properties and children of its node, std::optional and
+    //    std::vector of it take one node and one node per element
+    // Nodes and properties are looked up with a perfect hash of the field names built at compile time.
+    template<typename T>
+    struct Binding;
+
+#define KDL_FIELD(Type, member) ::KDL::Field<Type, decltype(Type::member)>{ u"" #member, &Type::member }
+#define KDL_REQUIRED_FIELD(Type, member) ::KDL::Field<Type, decltype(Type::member)>{ u"" #member, &Type::member, true }
+
+    namespace BindingDetail
+    {
+        struct StructOps;
+
+        // Where the decoder puts what it finds in a node: the fields of a struct, the arguments of a value
+        // node, or nowhere for nodes that are skipped
+        struct BindTarget
+        {
+            void* object = nullptr;
+            const StructOps* ops = nullptr;
+            // Assigns one value to object, false on a type mismatch
+            bool (*assign)(void* object, const EventValue& value) = nullptr;
+            // Vectors take any number of arguments, other values exactly one
+            bool isRepeated = false;
+        };
+
+        // The decoder generated for a bound struct, shared by all bindings so the parser is instantiated once
+        struct StructOps
+        {
+            // Index of the field with this name, -1 if there is none
+            i32 (*find)(QStringView name) noexcept;
+            // Assigns a property value to a field, false on a type mismatch and for struct fields
+            bool (*assign)(void* object, i32 field, const EventValue& value);
+            // Where a child node named after the field goes
+            BindTarget (*child)(void* object, i32 field);
+            const std::u16string_view* names;
+            // Bit i is set if field i is required
+            u64 required;
+        };
+
+        template<typename T>
+        concept Bound = requires { Binding<T>::fields; };
+
+        template<typename T>
+        struct ElementOf
+        {
+            using Type = T;
+        };
+        template<typename T>
+        struct ElementOf<std::optional<T>>
+        {
+            using Type = T;
+        };
+        template<typename T>
+        struct ElementOf<std::vector<T>>
+        {
+            using Type = T;
+        };
+
+        // Fields that are read from a node with children, never from a property
+        template<typename T>
+        inline constexpr bool IsStructField = Bound<typename ElementOf<T>::Type>;
+
+        template<typename T>
+        inline constexpr bool IsOptional = false;
+        template<typename T>
+        inline constexpr bool IsOptional<std::optional<T>> = true;
+
+        template<typename T>
+        inline constexpr bool IsVector = false;
+        template<typename T>
+        inline constexpr bool IsVector<std::vector<T>> = true;
+
+        // Seeded FNV-1a over the code units
+        [[nodiscard]] constexpr u32 HashName(const char16_t* data, std::size_t size, u32 seed) noexcept
+        {
+            auto hash = u32(2166136261u) ^ seed;
+            for (std::size_t i = 0; i < size; i++)
+            {
+                hash ^= data[i];
+                hash *= 16777619u;
+            }
+
+            return hash ^ (hash >> 16);
+        }
+
+        // Maps every name to its own slot of a table of about N * N slots, the seed is searched for at compile
+        // time. Lookups hash the name once and compare it with the single name that can match.
+        template<std::size_t N>
+        struct PerfectHash
+        {
+            static constexpr std::size_t Size = std::bit_ceil(std::max<std::size_t>(N * N, 1));
+
+            u32 seed = 0;
+            std::array<i8, Size> slots{};
+
+            consteval explicit PerfectHash(const std::array<std::u16string_view, N>& names)
+            {
+                while (!tryPlace(names))
+                    seed++;
+            }
+
+            [[nodiscard]] constexpr i32 find(QStringView name, const std::array<std::u16string_view, N>& names) const noexcept
+            {
+                const auto slot = slots[HashName(name.utf16(), name.size(), seed) & (Size - 1)];
+                if (slot < 0 || names[slot] != std::u16string_view(name.utf16(), name.size()))
+                    return -1;
+
+                return slot;
+            }
+
+        private:
+            [[nodiscard]] constexpr bool tryPlace(const std::array<std::u16string_view, N>& names) noexcept
+            {
+                slots.fill(-1);
+                for (std::size_t i = 0; i < N; i++)
+                {
+                    auto& slot = slots[HashName(names[i].data(), names[i].size(), seed) & (Size - 1)];
+                    if (slot >= 0)
+                        return false;
+
+                    slot = static_cast<i8>(i);
+                }
+
+                return true;
+            }
+        };
+
+        template<std::size_t N>
+        [[nodiscard]] constexpr bool HasUniqueNames(const std::array<std::u16string_view, N>& names) noexcept
+        {
+            for (std::size_t i = 0; i < N; i++)
+            {
+                for (auto j = i + 1; j < N; j++)
+                {
+                    if (names[i] == names[j])
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Converts straight from the token text, nothing is allocated except for strings
+        template<typename T>
+        [[nodiscard]] bool AssignValue(T& target, const EventValue& value)
+        {
+            const auto token = Token{ .kind = value.kind, .stringView = value.text };
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                if (value.type != ValueType::Boolean)
+                    return false;
+
+                target = value.kind == TokenKind::Keyword_True;
+                return true;
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                if (value.type != ValueType::Integer)
+                    return false;
+
+                if constexpr (std::is_signed_v<T>)
+                {
+                    const auto result = DecodeInt64(token);
+                    if (result.status != NumberStatus::Ok || !std::in_range<T>(result.value))
+                        return false;
+
+                    target = static_cast<T>(result.value);
+                }
+                else
+                {
+                    const auto result = DecodeUInt64(token);
+                    if (result.status != NumberStatus::Ok || !std::in_range<T>(result.value))
+                        return false;
+
+                    target = static_cast<T>(result.value);
+                }
+
+                return true;
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                if (value.type != ValueType::Integer && value.type != ValueType::Float)
+                    return false;
+
+                const auto result = DecodeDouble(token);
+                if (result.status != NumberStatus::Ok)
+                    return false;
+
+                target = static_cast<T>(result.value);
+                return true;
+            }
+            else if constexpr (std::is_same_v<T, QString>)
+            {
+                if (value.type != ValueType::String)
+                    return false;
+
+                target = value.text.toString();
+                return true;
+            }
+            else if constexpr (IsOptional<T>)
+            {
+                auto element = typename T::value_type{};
+                if (!AssignValue(element, value))
+                    return false;
+
+                target = std::move(element);
+                return true;
+            }
+            else if constexpr (IsVector<T>)
+            {
+                auto element = typename T::value_type{};
+                if (!AssignValue(element, value))
+                    return false;
+
+                target.push_back(std::move(element));
+                return true;
+            }
+            else
+            {
+                static_assert(IsVector<T>, "Fields have to be bool, a number, QString, a bound struct or std::optional or std::vector of these");
+                return false;
+            }
+        }
+
+        template<typename T>
+        [[nodiscard]] bool AssignErased(void* object, const EventValue& value)
+        {
+            return AssignValue(*static_cast<T*>(object), value);
+        }
+
+        template<typename T>
+        [[nodiscard]] BindTarget TargetOf(T& member);
+
+        template<typename T>
+        struct StructBinder
+        {
+            static constexpr auto FieldCount = std::tuple_size_v<std::remove_cvref_t<decltype(Binding<T>::fields)>>;
+            static_assert(FieldCount <= 64, "A bound struct can have at most 64 fields");
+
+            static constexpr auto Names = []<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return std::array<std::u16string_view, FieldCount>{ std::get<I>(Binding<T>::fields).name... };
+            }(std::make_index_sequence<FieldCount>{});
+            static_assert(HasUniqueNames(Names), "Two fields of a bound struct have the same name");
+
+            static constexpr auto Hash = PerfectHash<FieldCount>{ Names };
+
+            static constexpr auto Required = []<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return ((std::get<I>(Binding<T>::fields).isRequired ? u64(1) << I : u64(0)) | ... | u64(0));
+            }(std::make_index_sequence<FieldCount>{});
+
+            // Calls function with the field at a runtime index, the fold compiles to a jump table
+            template<typename TResult, typename TFunction>
+            [[nodiscard]] static TResult withField(i32 field, TFunction function)
+            {
+                return [&]<std::size_t... I>(std::index_sequence<I...>)
+                {
+                    auto result = TResult{};
+                    static_cast<void>(((field == static_cast<i32>(I) && (result = function(std::get<I>(Binding<T>::fields)), true)) || ...));
+                    return result;
+                }(std::make_index_sequence<FieldCount>{});
+            }
+
+            [[nodiscard]] static i32 find(QStringView name) noexcept
+            {
+                return Hash.find(name, Names);
+            }
+
+            [[nodiscard]] static bool assign(void* object, i32 field, const EventValue& value)
+            {
+                return withField<bool>(field, [&](const auto& description)
+                {
+                    auto& member = static_cast<T*>(object)->*description.member;
+                    using TMember = std::remove_cvref_t<decltype(member)>;
+                    if constexpr (IsStructField<TMember>)
+                        return false;
+                    else
+                        return AssignValue(member, value);
+                });
+            }
+
+            [[nodiscard]] static BindTarget child(void* object, i32 field)
+            {
+                return withField<BindTarget>(field, [&](const auto& description)
+                {
+                    return TargetOf(static_cast<T*>(object)->*description.member);
+                });
+            }
+
+            static constexpr StructOps Ops{ &find, &assign, &child, Names.data(), Required };
+        };
+
+        // The node of a field: a struct to fill, a new element of a vector of structs, or a value node
+        template<typename T>
+        BindTarget TargetOf(T& member)
+        {
+            using TElement = typename ElementOf<T>::Type;
+            if constexpr (!IsStructField<T>)
+            {
+                return { .object = &member, .assign = &AssignErased<T>, .isRepeated = IsVector<T> };
+            }
+            else if constexpr (IsOptional<T>)
+            {
+                return { .object = &member.emplace(), .ops = &StructBinder<TElement>::Ops };
+            }
+            else if constexpr (IsVector<T>)
+            {
+                // The element stays in place while its node is decoded, siblings are only added after it ends
+                return { .object = &member.emplace_back(), .ops = &StructBinder<TElement>::Ops };
+            }
+            else
+            {
+                return { .object = &member, .ops = &StructBinder<T>::Ops };
+            }
+        }
+
+        KDL_API [[nodiscard]] BindResult BindDocument(const QString& source, BindTarget root);
+        KDL_API [[nodiscard]] BindResult BindDocument(const TokenBuffer& tokens, BindTarget root);
+    }
+
+    // Decodes the top-level nodes of the source into the fields of object while parsing,
+    // without building a document
+    template<BindingDetail::Bound T>
+    [[nodiscard]] BindResult Bind(const QString& source, T& object)
+    {
+        return BindingDetail::BindDocument(source, BindingDetail::TargetOf(object));
+    }
+
+    template<BindingDetail::Bound T>
+    [[nodiscard]] BindResult Bind(const TokenBuffer& tokens, T& object)
+    {
+        return BindingDetail::BindDocument(tokens, BindingDetail::TargetOf(object));
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <KDL/Binding.h>
+#include <KDL/EventParser.h>
+
+#include <bit>
+#include <vector>
+
+namespace KDL::BindingDetail
+{
+    // Assigns the parsed values to the fields of the bound structs in the order the parser reports them
+    class BindingDecoder
+    {
+    public:
+        BindingDecoder(BindTarget root, i32 sourceSize, std::vector<BindError>& errors)
+            : m_errors{ errors }
+        {
+            m_frames.push_back({ .target = root, .offset = sourceSize });
+        }
+
+        void beginNode(QStringView name, std::optional<QStringView>, i32 offset)
+        {
+            auto frame = Frame{ .offset = offset };
+            auto& parent = m_frames.back();
+            if (parent.target.ops != nullptr)
+            {
+                const auto field = parent.target.ops->find(name);
+                if (field >= 0)
+                {
+                    parent.seen |= u64(1) << field;
+                    frame.target = parent.target.ops->child(parent.target.object, field);
+                    frame.name = fieldName(*parent.target.ops, field);
+                }
+                else
+                {
+                    error(BindStatus::UnknownField, name, offset);
+                }
+            }
+            else if (parent.target.assign != nullptr)
+            {
+                error(BindStatus::UnknownField, name, offset);
+            }
+
+            // Unknown nodes get an empty target, so everything in them is skipped without further errors
+            m_frames.push_back(frame);
+        }
+
+        void endNode()
+        {
+            finish(m_frames.back());
+            m_frames.pop_back();
+        }
+
+        void beginChildren()
+        {
+        }
+
+        void endChildren()
+        {
+        }
+
+        void argument(const EventValue& value)
+        {
+            auto& frame = m_frames.back();
+            if (frame.target.assign != nullptr)
+            {
+                if ((frame.valueCount > 0 && !frame.target.isRepeated) || !frame.target.assign(frame.target.object, value))
+                    error(BindStatus::TypeMismatch, frame.name, value.offset);
+
+                frame.valueCount++;
+            }
+            else if (frame.target.ops != nullptr)
+            {
+                error(BindStatus::TypeMismatch, frame.name, value.offset);
+            }
+        }
+
+        void property(QStringView name, const EventValue& value, i32 offset)
+        {
+            auto& frame = m_frames.back();
+            if (frame.target.ops != nullptr)
+            {
+                const auto field = frame.target.ops->find(name);
+                if (field < 0)
+                {
+                    error(BindStatus::UnknownField, name, offset);
+                    return;
+                }
+
+                frame.seen |= u64(1) << field;
+                if (!frame.target.ops->assign(frame.target.object, field, value))
+                    error(BindStatus::TypeMismatch, fieldName(*frame.target.ops, field), value.offset);
+            }
+            else if (frame.target.assign != nullptr)
+            {
+                error(BindStatus::UnknownField, name, offset);
+            }
+        }
+
+        // Checks the required fields of the top level once the whole source is parsed
+        void finish()
+        {
+            finish(m_frames.front());
+        }
+
+    private:
+        struct Frame
+        {
+            BindTarget target;
+            // Name of the field the node is read into, empty for the top level and skipped nodes
+            QStringView name;
+            // Fields given so far, bit i stands for field i
+            u64 seen = 0;
+            i32 valueCount = 0;
+            // Start of the node name
+            i32 offset;
+        };
+
+        [[nodiscard]] static QStringView fieldName(const StructOps& ops, i32 field) noexcept
+        {
+            const auto name = ops.names[field];
+            return QStringView(name.data(), static_cast<qsizetype>(name.size()));
+        }
+
+        void error(BindStatus status, QStringView name, i32 offset)
+        {
+            m_errors.push_back({ .status = status, .name = name.toString(), .offset = offset });
+        }
+
+        void finish(const Frame& frame)
+        {
+            if (frame.target.ops != nullptr)
+            {
+                for (auto missing = frame.target.ops->required & ~frame.seen; missing != 0; missing &= missing - 1)
+                    error(BindStatus::MissingField, fieldName(*frame.target.ops, std::countr_zero(missing)), frame.offset);
+            }
+            else if (frame.target.assign != nullptr && !frame.target.isRepeated && frame.valueCount == 0)
+            {
+                error(BindStatus::TypeMismatch, frame.name, frame.offset);
+            }
+        }
+
+        std::vector<BindError>& m_errors;
+        // The top level and the nodes that are open
+        std::vector<Frame> m_frames;
+    };
+
+    // Parses the tokens into root, shared by the buffered and the fused binding
+    template<typename TTokens>
+    [[nodiscard]] BindResult DecodeDocument(TTokens tokens, i32 sourceSize, BindTarget root)
+    {
+        BindResult result{};
+        ParseBuffers buffers{};
+        BindingDecoder decoder{ root, sourceSize, result.errors };
+        EventParser<BindingDecoder, TTokens> parser{ tokens, decoder, buffers };
+        result.status = parser.parse();
+        if (result.status != ParseStatus::Ok)
+            result.errorOffset = parser.errorOffset();
+        else
+            decoder.finish();
+
+        return result;
+    }
+}
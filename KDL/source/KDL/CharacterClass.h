@@ -0,0 +1,163 @@
+#pragma once
+
+#include <Defines.h>
+
+#include <array>
+
+namespace KDL
+{
+    enum class CharacterClass : u8
+    {
+        None = 0,
+        Space = 1 << 0,
+        Newline = 1 << 1,
+        Equal = 1 << 2,
+        DisallowedIdentifierChar = 1 << 3,
+        DisallowedLiteralCodePoint = 1 << 4,
+        Digit = 1 << 5,
+        Letter = 1 << 6,
+        Hexadecimal = 1 << 7,
+
+        // A character that can't be part of an identifier
+        IdentifierTerminator = Space | Newline | Equal | DisallowedIdentifierChar | DisallowedLiteralCodePoint
+    };
+
+    [[nodiscard]] constexpr CharacterClass operator|(CharacterClass left, CharacterClass right) noexcept
+    {
+        return static_cast<CharacterClass>(static_cast<u8>(left) | static_cast<u8>(right));
+    }
+
+    [[nodiscard]] constexpr bool HasAny(CharacterClass value, CharacterClass mask) noexcept
+    {
+        return (static_cast<u8>(value) & static_cast<u8>(mask)) != 0;
+    }
+
+    namespace CharacterClassTable
+    {
+        struct Range
+        {
+            char32_t First;
+            char32_t Last;
+            CharacterClass Class;
+        };
+
+        // Every code point with a class, everything else in the BMP is CharacterClass::None.
+        // Digit and Letter only cover ASCII, other code points fall back to QChar.
+        inline constexpr Range Ranges[] = {
+            { U'\u0009', U'\u0009', CharacterClass::Space },    // Character Tabulation
+            { U'\u000b', U'\u000b', CharacterClass::Space },    // Line Tabulation
+            { U'\u0020', U'\u0020', CharacterClass::Space },    // Space
+            { U'\u00a0', U'\u00a0', CharacterClass::Space },    // No-Break Space
+            { U'\u1680', U'\u1680', CharacterClass::Space },    // Ogham Space Mark
+            { U'\u2000', U'\u200a', CharacterClass::Space },    // En Quad to Hair Space
+            { U'\u202f', U'\u202f', CharacterClass::Space },    // Narrow No-Break Space
+            { U'\u205f', U'\u205f', CharacterClass::Space },    // Medium Mathematical Space
+            { U'\u3000', U'\u3000', CharacterClass::Space },    // Ideographic Space
+
+            { U'\r', U'\r', CharacterClass::Newline },          // Carriage Return
+            { U'\n', U'\n', CharacterClass::Newline },          // Line Feed
+            { U'\f', U'\f', CharacterClass::Newline },          // Form Feed
+            { U'\u0085', U'\u0085', CharacterClass::Newline },  // Next Line
+            { U'\u2028', U'\u2028', CharacterClass::Newline },  // Line Separator
+            { U'\u2029', U'\u2029', CharacterClass::Newline },  // Paragraph Separator
+
+            { U'=', U'=', CharacterClass::Equal },
+            { U'\ufe66', U'\ufe66', CharacterClass::Equal },    // Small Equal Sign
+            { U'\uff1d', U'\uff1d', CharacterClass::Equal },    // Fullwidth Equal Sign
+
+            { U'\\', U'\\', CharacterClass::DisallowedIdentifierChar },
+            { U'/', U'/', CharacterClass::DisallowedIdentifierChar },
+            { U'(', U')', CharacterClass::DisallowedIdentifierChar },
+            { U'{', U'{', CharacterClass::DisallowedIdentifierChar },
+            { U'}', U'}', CharacterClass::DisallowedIdentifierChar },
+            { U';', U';', CharacterClass::DisallowedIdentifierChar },
+            { U'[', U'[', CharacterClass::DisallowedIdentifierChar },
+            { U']', U']', CharacterClass::DisallowedIdentifierChar },
+            { U'\"', U'\"', CharacterClass::DisallowedIdentifierChar },
+            { U'#', U'#', CharacterClass::DisallowedIdentifierChar },
+
+            { U'\u0000', U'\u0008', CharacterClass::DisallowedLiteralCodePoint },   // various control characters
+            { U'\u000e', U'\u001f', CharacterClass::DisallowedLiteralCodePoint },   // various control characters
+            { U'\u007f', U'\u007f', CharacterClass::DisallowedLiteralCodePoint },   // delete control character
+            { U'\u200e', U'\u200f', CharacterClass::DisallowedLiteralCodePoint },   // unicode "direction control" characters
+            { U'\u202a', U'\u202e', CharacterClass::DisallowedLiteralCodePoint },   // unicode "direction control" characters
+            { U'\u2066', U'\u2069', CharacterClass::DisallowedLiteralCodePoint },   // unicode "direction control" characters
+            { U'\ufeff', U'\ufeff', CharacterClass::DisallowedLiteralCodePoint },   // zero-width non-breaking space / byte order mark
+
+            { U'0', U'9', CharacterClass::Digit | CharacterClass::Hexadecimal },
+            { U'a', U'f', CharacterClass::Letter | CharacterClass::Hexadecimal },
+            { U'A', U'F', CharacterClass::Letter | CharacterClass::Hexadecimal },
+            { U'g', U'z', CharacterClass::Letter },
+            { U'G', U'Z', CharacterClass::Letter },
+        };
+
+        inline constexpr char32_t HeavyEqualSign = U'\U0001f7f0';
+
+        // The BMP is split into 256 blocks of 256 code points. Blocks without any classified
+        // code point share block 0, so only a handful of blocks are actually stored.
+        [[nodiscard]] consteval i32 CountUsedBlocks() noexcept
+        {
+            std::array<bool, 256> used{};
+            for (const auto& range : Ranges)
+            {
+                for (auto codePoint = range.First; codePoint <= range.Last; codePoint++)
+                    used[codePoint >> 8] = true;
+            }
+
+            auto count = 1;
+            for (const auto isUsed : used)
+            {
+                if (isUsed)
+                    count++;
+            }
+
+            return count;
+        }
+
+        inline constexpr i32 UsedBlockCount = CountUsedBlocks();
+
+        struct Table
+        {
+            std::array<CharacterClass, 256> Latin1;
+            std::array<u8, 256> BlockIndexes;
+            std::array<std::array<CharacterClass, 256>, UsedBlockCount> Blocks;
+        };
+
+        [[nodiscard]] consteval Table Generate() noexcept
+        {
+            Table table{};
+
+            auto nextBlock = 1;
+            for (const auto& range : Ranges)
+            {
+                for (auto codePoint = range.First; codePoint <= range.Last; codePoint++)
+                {
+                    auto& blockIndex = table.BlockIndexes[codePoint >> 8];
+                    if (blockIndex == 0)
+                        blockIndex = u8(nextBlock++);
+
+                    auto& characterClass = table.Blocks[blockIndex][codePoint & 0xFF];
+                    characterClass = characterClass | range.Class;
+                }
+            }
+
+            table.Latin1 = table.Blocks[table.BlockIndexes[0]];
+            return table;
+        }
+
+        inline constexpr Table Classes = Generate();
+    }
+
+    [[nodiscard]] constexpr CharacterClass ClassOf(char32_t codePoint) noexcept
+    {
+        using namespace CharacterClassTable;
+
+        if (codePoint < 0x100)
+            return Classes.Latin1[codePoint];
+
+        if (codePoint < 0x10000)
+            return Classes.Blocks[Classes.BlockIndexes[codePoint >> 8]][codePoint & 0xFF];
+
+        return codePoint == HeavyEqualSign ? CharacterClass::Equal : CharacterClass::None;
+    }
+}
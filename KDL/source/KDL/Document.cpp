@@ -0,0 +1,247 @@
+#include <KDL/Document.h>
+#include <KDL/DocumentBuilder.h>
+#include <KDL/FileBatch.h>
+#include <KDL/LexToken.h>
+
+#include <QFile>
+
+
+namespace KDL
+{
+    ValueType Value::type() const noexcept
+    {
+        return m_data->type;
+    }
+
+    std::optional<QStringView> Value::typeAnnotation() const noexcept
+    {
+        if (m_data->typeAnnotation.length < 0)
+            return std::nullopt;
+
+        return m_document->string(m_data->typeAnnotation);
+    }
+
+    QStringView Value::string() const noexcept
+    {
+        return m_document->string(m_data->text);
+    }
+
+    bool Value::boolean() const noexcept
+    {
+        return m_data->kind == TokenKind::Keyword_True;
+    }
+
+    NumberResult<i64> Value::toInt64() const noexcept
+    {
+        return DecodeInt64(token());
+    }
+
+    NumberResult<u64> Value::toUInt64() const noexcept
+    {
+        return DecodeUInt64(token());
+    }
+
+    NumberResult<double> Value::toDouble() const noexcept
+    {
+        return DecodeDouble(token());
+    }
+
+    Value::Value(const Document& document, const Data& data) noexcept
+        : m_document{ &document }
+        , m_data{ &data }
+    {
+    }
+
+    Token Value::token() const noexcept
+    {
+        return { .kind = m_data->kind, .stringView = string() };
+    }
+
+    QStringView Property::name() const noexcept
+    {
+        return m_document->string(m_data->name);
+    }
+
+    std::optional<Atom> Property::nameAtom() const noexcept
+    {
+        if (m_data->nameAtom == Document::NoAtom)
+            return std::nullopt;
+
+        return static_cast<Atom>(m_data->nameAtom);
+    }
+
+    Value Property::value() const noexcept
+    {
+        return { *m_document, m_data->value };
+    }
+
+    Property::Property(const Document& document, const Data& data) noexcept
+        : m_document{ &document }
+        , m_data{ &data }
+    {
+    }
+
+    Node NodeRange::Iterator::operator*() const noexcept
+    {
+        return { *m_document, m_index };
+    }
+
+    NodeRange::Iterator& NodeRange::Iterator::operator++() noexcept
+    {
+        m_index = m_document->m_nodes[m_index].nextSibling;
+        return *this;
+    }
+
+    NodeRange::Iterator::Iterator(const Document* document, i32 index) noexcept
+        : m_document{ document }
+        , m_index{ index }
+    {
+    }
+
+    NodeRange::Iterator NodeRange::begin() const noexcept
+    {
+        return { m_document, m_first };
+    }
+
+    NodeRange::Iterator NodeRange::end() const noexcept
+    {
+        return { m_document, -1 };
+    }
+
+    NodeRange::NodeRange(const Document& document, i32 first) noexcept
+        : m_document{ &document }
+        , m_first{ first }
+    {
+    }
+
+    QStringView Node::name() const noexcept
+    {
+        return m_document->string(data().name);
+    }
+
+    std::optional<Atom> Node::nameAtom() const noexcept
+    {
+        if (data().nameAtom == Document::NoAtom)
+            return std::nullopt;
+
+        return static_cast<Atom>(data().nameAtom);
+    }
+
+    std::optional<QStringView> Node::typeAnnotation() const noexcept
+    {
+        if (data().typeAnnotation.length < 0)
+            return std::nullopt;
+
+        return m_document->string(data().typeAnnotation);
+    }
+
+    i32 Node::argumentCount() const noexcept
+    {
+        return data().argumentCount;
+    }
+
+    Value Node::argument(i32 index) const noexcept
+    {
+        return { *m_document, m_document->m_arguments[data().firstArgument + index] };
+    }
+
+    i32 Node::propertyCount() const noexcept
+    {
+        return data().propertyCount;
+    }
+
+    Property Node::property(i32 index) const noexcept
+    {
+        return { *m_document, m_document->m_properties[data().firstProperty + index] };
+    }
+
+    std::optional<Value> Node::property(QStringView name) const noexcept
+    {
+        for (auto i = 0; i < propertyCount(); i++)
+        {
+            const auto& property = m_document->m_properties[data().firstProperty + i];
+            if (m_document->string(property.name) == name)
+                return Value{ *m_document, property.value };
+        }
+
+        return std::nullopt;
+    }
+
+    i32 Node::childCount() const noexcept
+    {
+        return data().childCount;
+    }
+
+    NodeRange Node::children() const noexcept
+    {
+        return { *m_document, data().firstChild };
+    }
+
+    Node::Node(const Document& document, i32 index) noexcept
+        : m_document{ &document }
+        , m_index{ index }
+    {
+    }
+
+    const Node::Data& Node::data() const noexcept
+    {
+        return m_document->m_nodes[m_index];
+    }
+
+    i32 Document::nodeCount() const noexcept
+    {
+        return m_nodeCount;
+    }
+
+    NodeRange Document::nodes() const noexcept
+    {
+        return { *this, m_firstNode };
+    }
+
+    i64 Document::allocatedBytes() const noexcept
+    {
+        return static_cast<i64>(m_nodes.capacity() * sizeof(Node::Data)
+            + m_arguments.capacity() * sizeof(Value::Data)
+            + m_properties.capacity() * sizeof(Property::Data)
+            + m_strings.capacity() * sizeof(QChar));
+    }
+
+    QStringView Document::string(StringSpan span) const noexcept
+    {
+        if ((span.offset & DecodedBit) != 0)
+            return QStringView(m_strings).sliced(span.offset & ~DecodedBit, span.length);
+
+        return QStringView(m_source).sliced(span.offset, span.length);
+    }
+
+    // Lexes while it parses, the lexer's state machine is inlined into the parser
+    ParseResult Parse(const QString& source, AtomTable* atoms)
+    {
+        return BuildDocument(LexerDetail::LexingTokens{ source }, source, atoms);
+    }
+
+    ParseResult Parse(const TokenBuffer& tokens, AtomTable* atoms)
+    {
+        return BuildDocument(BufferedTokens{ tokens }, tokens.source(), atoms);
+    }
+
+    std::vector<FileParseResult> ParseFiles(const QStringList& paths, const BatchOptions& options, AtomTable* atoms)
+    {
+        return ProcessFiles<FileParseResult>(paths, options, [atoms](const QString& path)
+            {
+                auto file = QFile(path);
+                if (!file.open(QIODevice::ReadOnly))
+                    return FileParseResult{};
+
+                const auto bytes = file.readAll();
+                const auto source = bytes.startsWith("\xEF\xBB\xBF") ? QByteArrayView(bytes).sliced(3) : QByteArrayView(bytes);
+                auto parsed = Parse(QString::fromUtf8(source), atoms);
+                return FileParseResult{
+                    .document = std::move(parsed.document),
+                    .status = parsed.status,
+                    .errorOffset = parsed.errorOffset,
+                    .isRead = true
+                };
+            });
+    }
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/AtomTable.h>
+#include <KDL/EventParser.h>
+#include <KDL/Lexer.h>
+#include <KDL/Number.h>
+#include <KDL/TokenBuffer.h>
+#include <KDL/TokenKind.h>
+#include <Defines.h>
+
+#include <QString>
+
+#include <optional>
+#include <vector>
+
+namespace KDL
+{
+    class Document;
+    class Node;
+
+    class KDL_API Value
+    {
+    public:
+        [[nodiscard]] ValueType type() const noexcept;
+        [[nodiscard]] std::optional<QStringView> typeAnnotation() const noexcept;
+
+        // The decoded value of a string, numbers and keywords keep the text they were written as
+        [[nodiscard]] QStringView string() const noexcept;
+        [[nodiscard]] bool boolean() const noexcept;
+
+        // Numbers are decoded on every call, see Number.h
+        [[nodiscard]] NumberResult<i64> toInt64() const noexcept;
+        [[nodiscard]] NumberResult<u64> toUInt64() const noexcept;
+        [[nodiscard]] NumberResult<double> toDouble() const noexcept;
+
+    private:
+        friend class Node;
+        friend class Property;
+        friend class Document;
+        friend class DocumentBuilder;
+
+        struct Data;
+
+        Value(const Document& document, const Data& data) noexcept;
+        [[nodiscard]] Token token() const noexcept;
+
+        const Document* m_document;
+        const Data* m_data;
+    };
+
+    class KDL_API Property
+    {
+    public:
+        [[nodiscard]] QStringView name() const noexcept;
+        [[nodiscard]] std::optional<Atom> nameAtom() const noexcept;
+        [[nodiscard]] Value value() const noexcept;
+
+    private:
+        friend class Node;
+        friend class Document;
+        friend class DocumentBuilder;
+
+        struct Data;
+
+        Property(const Document& document, const Data& data) noexcept;
+
+        const Document* m_document;
+        const Data* m_data;
+    };
+
+    // Iterates a node and its following siblings
+    class KDL_API NodeRange
+    {
+    public:
+        class KDL_API Iterator
+        {
+        public:
+            [[nodiscard]] Node operator*() const noexcept;
+            Iterator& operator++() noexcept;
+            [[nodiscard]] bool operator==(const Iterator& other) const noexcept = default;
+
+        private:
+            friend class NodeRange;
+
+            Iterator(const Document* document, i32 index) noexcept;
+
+            const Document* m_document;
+            i32 m_index;
+        };
+
+        [[nodiscard]] Iterator begin() const noexcept;
+        [[nodiscard]] Iterator end() const noexcept;
+
+    private:
+        friend class Node;
+        friend class Document;
+
+        NodeRange(const Document& document, i32 first) noexcept;
+
+        const Document* m_document;
+        i32 m_first;
+    };
+
+    class KDL_API Node
+    {
+    public:
+        [[nodiscard]] QStringView name() const noexcept;
+        // Only set if the document was parsed with an AtomTable
+        [[nodiscard]] std::optional<Atom> nameAtom() const noexcept;
+        [[nodiscard]] std::optional<QStringView> typeAnnotation() const noexcept;
+
+        [[nodiscard]] i32 argumentCount() const noexcept;
+        [[nodiscard]] Value argument(i32 index) const noexcept;
+
+        // Duplicate properties are removed while parsing, only the rightmost one is kept
+        [[nodiscard]] i32 propertyCount() const noexcept;
+        [[nodiscard]] Property property(i32 index) const noexcept;
+        [[nodiscard]] std::optional<Value> property(QStringView name) const noexcept;
+
+        [[nodiscard]] i32 childCount() const noexcept;
+        [[nodiscard]] NodeRange children() const noexcept;
+
+    private:
+        friend class NodeRange;
+        friend class Document;
+        friend class DocumentBuilder;
+
+        struct Data;
+
+        Node(const Document& document, i32 index) noexcept;
+        [[nodiscard]] const Data& data() const noexcept;
+
+        const Document* m_document;
+        i32 m_index;
+    };
+
+    // Nodes, arguments and properties live in one array each and refer to each other by index.
+    // Strings that need no decoding point into the source, the others share one buffer, so a
+    // document is built with a handful of allocations and freed in constant time.
+    class KDL_API Document
+    {
+    public:
+        Document() = default;
+
+        // Top level nodes
+        [[nodiscard]] i32 nodeCount() const noexcept;
+        [[nodiscard]] NodeRange nodes() const noexcept;
+
+        // Bytes allocated for nodes, arguments, properties and decoded strings, not counting the source
+        [[nodiscard]] i64 allocatedBytes() const noexcept;
+
+    private:
+        friend class Value;
+        friend class Property;
+        friend class Node;
+        friend class NodeRange;
+        friend class DocumentBuilder;
+
+        // Offset and length of a string in the source, or in m_strings if the offset has DecodedBit set.
+        // A negative length marks a missing string, such as an absent type annotation.
+        struct StringSpan
+        {
+            u32 offset = 0;
+            i32 length = -1;
+        };
+
+        static constexpr u32 DecodedBit = 1u << 31;
+        static constexpr u32 NoAtom = 0xFFFFFFFF;
+
+        [[nodiscard]] QStringView string(StringSpan span) const noexcept;
+
+        QString m_source;
+        QString m_strings;
+        std::vector<Node::Data> m_nodes;
+        std::vector<Value::Data> m_arguments;
+        std::vector<Property::Data> m_properties;
+        i32 m_firstNode = -1;
+        i32 m_nodeCount = 0;
+    };
+
+    struct Value::Data
+    {
+        Document::StringSpan text;
+        Document::StringSpan typeAnnotation;
+        ValueType type;
+        // Kind of the token a number or keyword was lexed as, needed to decode it
+        TokenKind kind;
+    };
+
+    struct Property::Data
+    {
+        Document::StringSpan name;
+        u32 nameAtom;
+        Value::Data value;
+    };
+
+    struct Node::Data
+    {
+        Document::StringSpan name;
+        Document::StringSpan typeAnnotation;
+        u32 nameAtom;
+        i32 firstArgument;
+        i32 argumentCount = 0;
+        i32 firstProperty;
+        i32 propertyCount = 0;
+        i32 firstChild = -1;
+        i32 nextSibling = -1;
+        i32 childCount = 0;
+    };
+
+    struct KDL_API ParseResult
+    {
+        // Empty unless status is ParseStatus::Ok
+        Document document;
+        ParseStatus status = ParseStatus::Ok;
+        // Source offset of the token the error was found at
+        i32 errorOffset = 0;
+    };
+
+    // Parses a KDL 2.0 document, names and property keys are interned into atoms if a table is given.
+    // The source overload lexes while it parses and never stores the tokens, its result is the same as
+    // parsing the buffer of Lex(source), which is the better choice if the tokens are needed anyway.
+    KDL_API [[nodiscard]] ParseResult Parse(const QString& source, AtomTable* atoms = nullptr);
+    KDL_API [[nodiscard]] ParseResult Parse(const TokenBuffer& tokens, AtomTable* atoms = nullptr);
+
+    struct KDL_API FileParseResult
+    {
+        // Empty unless the file was read and status is ParseStatus::Ok
+        Document document;
+        ParseStatus status = ParseStatus::Ok;
+        // Offset in UTF-16 code units of the token the error was found at
+        i32 errorOffset = 0;
+        // False if the file couldn't be opened, status and errorOffset are left at their defaults then
+        bool isRead = false;
+    };
+
+    // Reads and parses every UTF-8 file, skipping a leading byte order mark, on a pool of threads like
+    // LexFiles. The results are in the order of paths. Only the bytes read are limited by
+    // options.maxBytesInFlight, the documents keep their source as UTF-16.
+    KDL_API [[nodiscard]] std::vector<FileParseResult> ParseFiles(const QStringList& paths, const BatchOptions& options = {}, AtomTable* atoms = nullptr);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <KDL/AtomTable.h>
+#include <KDL/Document.h>
+#include <KDL/DuplicateProperties.h>
+#include <KDL/EventParser.h>
+
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace KDL
+{
+    // Appends the parsed nodes to the arenas of a document
+    class DocumentBuilder
+    {
+    public:
+        DocumentBuilder(Document& document, const QString& source, AtomTable* atoms)
+            : m_document{ document }
+            , m_source{ source }
+            , m_atoms{ atoms }
+        {
+            m_document.m_source = source;
+            m_openNodes.push_back(-1);
+            m_lastChildren.push_back(-1);
+        }
+
+        void beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32)
+        {
+            const auto index = static_cast<i32>(m_document.m_nodes.size());
+            m_document.m_nodes.push_back({
+                .name = store(name),
+                .typeAnnotation = typeAnnotation ? store(*typeAnnotation) : Document::StringSpan{},
+                .nameAtom = intern(name),
+                .firstArgument = static_cast<i32>(m_document.m_arguments.size()),
+                .firstProperty = static_cast<i32>(m_document.m_properties.size()),
+            });
+
+            const auto parent = m_openNodes.back();
+            auto& previousSibling = m_lastChildren.back();
+            if (previousSibling >= 0)
+                m_document.m_nodes[previousSibling].nextSibling = index;
+            else if (parent >= 0)
+                m_document.m_nodes[parent].firstChild = index;
+            else
+                m_document.m_firstNode = index;
+
+            previousSibling = index;
+            if (parent >= 0)
+                m_document.m_nodes[parent].childCount++;
+            else
+                m_document.m_nodeCount++;
+
+            m_openNodes.push_back(index);
+            m_lastChildren.push_back(-1);
+            m_isInEntries = true;
+        }
+
+        void endNode()
+        {
+            if (m_isInEntries)
+                endEntries();
+
+            m_openNodes.pop_back();
+            m_lastChildren.pop_back();
+        }
+
+        void beginChildren()
+        {
+            endEntries();
+        }
+
+        void endChildren()
+        {
+        }
+
+        void argument(const EventValue& value)
+        {
+            m_document.m_arguments.push_back(store(value));
+            m_document.m_nodes[m_openNodes.back()].argumentCount++;
+        }
+
+        // Duplicates are dropped once all properties of the node are known
+        void property(QStringView name, const EventValue& value, i32)
+        {
+            m_document.m_properties.push_back({ .name = store(name), .nameAtom = intern(name), .value = store(value) });
+            m_document.m_nodes[m_openNodes.back()].propertyCount++;
+        }
+
+    private:
+        // Properties of the open node are at the end of the array until its children begin
+        void endEntries()
+        {
+            m_isInEntries = false;
+            auto& node = m_document.m_nodes[m_openNodes.back()];
+            auto& properties = m_document.m_properties;
+            const auto first = properties.begin() + node.firstProperty;
+            const auto kept = DropDuplicateProperties(first, properties.end(), m_propertyNames,
+                [this](const Property::Data& property)
+                {
+                    const auto name = m_document.string(property.name);
+                    return std::u16string_view(name.utf16(), static_cast<std::size_t>(name.size()));
+                });
+            node.propertyCount = static_cast<i32>(properties.end() - kept);
+            properties.erase(first, kept);
+        }
+
+        // Views into the source are kept as offsets, decoded strings are copied into the string buffer
+        [[nodiscard]] Document::StringSpan store(QStringView text)
+        {
+            if (text.data() >= m_source.data() && text.data() + text.size() <= m_source.data() + m_source.size())
+                return { .offset = static_cast<u32>(text.data() - m_source.data()), .length = static_cast<i32>(text.size()) };
+
+            const auto offset = static_cast<u32>(m_document.m_strings.size()) | Document::DecodedBit;
+            m_document.m_strings.append(text);
+            return { .offset = offset, .length = static_cast<i32>(text.size()) };
+        }
+
+        [[nodiscard]] Value::Data store(const EventValue& value)
+        {
+            return {
+                .text = store(value.text),
+                .typeAnnotation = value.typeAnnotation ? store(*value.typeAnnotation) : Document::StringSpan{},
+                .type = value.type,
+                .kind = value.kind
+            };
+        }
+
+        [[nodiscard]] u32 intern(QStringView name)
+        {
+            return m_atoms != nullptr ? static_cast<u32>(m_atoms->intern(name)) : Document::NoAtom;
+        }
+
+        Document& m_document;
+        // The source the parser's views point into, the document keeps its own reference to the same text
+        QStringView m_source;
+        AtomTable* m_atoms;
+        // Nodes whose children are being parsed and the last child added to each, -1 stands for the document
+        std::vector<i32> m_openNodes;
+        std::vector<i32> m_lastChildren;
+        bool m_isInEntries = false;
+        std::unordered_set<std::u16string_view> m_propertyNames;
+    };
+
+    // Parses the tokens into a new document, shared by the buffered and the fused parse
+    template<typename TTokens>
+    [[nodiscard]] ParseResult BuildDocument(TTokens tokens, const QString& source, AtomTable* atoms)
+    {
+        ParseResult result{};
+        ParseBuffers buffers{};
+        DocumentBuilder builder{ result.document, source, atoms };
+        EventParser<DocumentBuilder, TTokens> parser{ tokens, builder, buffers };
+        result.status = parser.parse();
+        if (result.status != ParseStatus::Ok)
+        {
+            result.errorOffset = parser.errorOffset();
+            result.document = Document{};
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Defines.h>
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+namespace KDL
+{
+    // Drops all but the last property of each name from [first, last), shared by the builders once a node's
+    // properties are all known. The kept ones are moved to the end of the range in their order, the returned
+    // iterator is where they start. A few properties are compared with each other, more are looked up in
+    // names, which is cleared first so its storage is reused from node to node.
+    template<typename TIterator, typename TName, typename TNameOf>
+    [[nodiscard]] TIterator DropDuplicateProperties(TIterator first, TIterator last, std::unordered_set<TName>& names, TNameOf nameOf)
+    {
+        constexpr auto MaxComparedCount = 8;
+        const auto isCompared = std::distance(first, last) <= MaxComparedCount;
+        if (!isCompared)
+            names.clear();
+
+        auto kept = last;
+        for (auto property = last; property != first;)
+        {
+            --property;
+            const auto name = nameOf(*property);
+            const auto isDuplicate = isCompared
+                ? std::any_of(kept, last, [&](const auto& other) { return nameOf(other) == name; })
+                : !names.insert(name).second;
+            if (!isDuplicate)
+                *--kept = *property;
+        }
+
+        return kept;
+    }
+}
@@ -0,0 +1,112 @@
+#include <KDL/EventParser.h>
+
+namespace
+{
+    using namespace KDL;
+
+    [[nodiscard]] static bool IsDecimalDigit(QChar c) noexcept
+    {
+        return c >= u'0' && c <= u'9';
+    }
+
+    template<typename TIsDigit>
+    [[nodiscard]] static bool SkipDigits(QStringView text, qsizetype& index, TIsDigit isDigit) noexcept
+    {
+        if (index >= text.size() || !isDigit(text[index]))
+            return false;
+
+        while (index < text.size() && (isDigit(text[index]) || text[index] == u'_'))
+            index++;
+
+        return true;
+    }
+}
+
+namespace KDL
+{
+    bool IsValidIdentifier(QStringView text) noexcept
+    {
+        static constexpr QStringView ReservedWords[] = { u"true", u"false", u"null", u"inf", u"-inf", u"nan" };
+        for (const auto word : ReservedWords)
+        {
+            if (text == word)
+                return false;
+        }
+
+        auto index = 0;
+        if (index < text.size() && (text[index] == u'+' || text[index] == u'-'))
+            index++;
+        if (index < text.size() && text[index] == u'.')
+            index++;
+
+        return index >= text.size() || !IsDecimalDigit(text[index]);
+    }
+
+    bool IsValidNumber(QStringView text, TokenKind kind) noexcept
+    {
+        qsizetype index = 0;
+        if (index < text.size() && (text[index] == u'+' || text[index] == u'-'))
+            index++;
+
+        switch (kind)
+        {
+        case TokenKind::Number_Binary:
+            index += 2;
+            return SkipDigits(text, index, [](QChar c) { return c == u'0' || c == u'1'; }) && index == text.size();
+        case TokenKind::Number_Octal:
+            index += 2;
+            return SkipDigits(text, index, [](QChar c) { return c >= u'0' && c <= u'7'; }) && index == text.size();
+        case TokenKind::Number_Hexadecimal:
+            index += 2;
+            return SkipDigits(text, index, [](QChar c) { return IsDecimalDigit(c) || (c >= u'a' && c <= u'f') || (c >= u'A' && c <= u'F'); })
+                && index == text.size();
+        default:
+            break;
+        }
+
+        if (!SkipDigits(text, index, IsDecimalDigit))
+            return false;
+
+        if (index < text.size() && text[index] == u'.')
+        {
+            index++;
+            if (!SkipDigits(text, index, IsDecimalDigit))
+                return false;
+        }
+
+        if (index < text.size() && (text[index] == u'e' || text[index] == u'E'))
+        {
+            index++;
+            if (index < text.size() && (text[index] == u'+' || text[index] == u'-'))
+                index++;
+            if (!SkipDigits(text, index, IsDecimalDigit))
+                return false;
+        }
+
+        return index == text.size();
+    }
+
+    ValueType ValueTypeOf(TokenKind kind, QStringView text) noexcept
+    {
+        switch (kind)
+        {
+        case TokenKind::Keyword_True:
+        case TokenKind::Keyword_False:
+            return ValueType::Boolean;
+        case TokenKind::Keyword_Null:
+            return ValueType::Null;
+        case TokenKind::Keyword_NaN:
+        case TokenKind::Keyword_Infinity:
+        case TokenKind::Keyword_NegativeInfinity:
+            return ValueType::Float;
+        case TokenKind::Number_Decimal:
+            return text.contains(u'.') || text.contains(u'e') || text.contains(u'E') ? ValueType::Float : ValueType::Integer;
+        case TokenKind::Number_Binary:
+        case TokenKind::Number_Octal:
+        case TokenKind::Number_Hexadecimal:
+            return ValueType::Integer;
+        default:
+            return ValueType::String;
+        }
+    }
+}
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/StringValue.h>
+#include <KDL/TokenBuffer.h>
+#include <KDL/TokenKind.h>
+#include <Defines.h>
+
+#include <QString>
+
+#include <algorithm>
+#include <optional>
+
+namespace KDL
+{
+    enum class KDL_API ValueType : u8
+    {
+        String,
+        Integer,
+        // Decimals with a fraction or an exponent and the #inf, #-inf and #nan keywords
+        Float,
+        Boolean,
+        Null
+    };
+
+    enum class KDL_API ParseStatus
+    {
+        Ok,
+        // A token that can't appear where it was found
+        UnexpectedToken,
+        // Node names, arguments, properties and children have to be separated by whitespace
+        MissingSpace,
+        // A bare identifier that looks like a number or a keyword
+        InvalidIdentifier,
+        InvalidNumber,
+        // A string with an invalid escape, a wrong multi-line indentation or no closing quote
+        InvalidString,
+        // The end of the source was reached inside of a children block
+        UnterminatedChildren,
+        // Children blocks are nested deeper than MaxNestingDepth
+        TooDeep,
+        // Only reported by ParseAsync, a single token took more memory than it allows
+        TokenTooLarge
+    };
+
+    // Children blocks are parsed recursively, so their nesting is limited to keep a parse on a worker thread
+    // with a small stack from running out of it. Slash-dashed children blocks count as well.
+    constexpr i32 MaxNestingDepth = 256;
+
+    // Bare identifiers must not be mistakable for a number or a keyword without its hash
+    KDL_API [[nodiscard]] bool IsValidIdentifier(QStringView text) noexcept;
+    // The lexer ends a number at the first character that can't continue it, so a number token can still be
+    // malformed, for example a base prefix without digits or a second exponent
+    KDL_API [[nodiscard]] bool IsValidNumber(QStringView text, TokenKind kind) noexcept;
+    KDL_API [[nodiscard]] ValueType ValueTypeOf(TokenKind kind, QStringView text) noexcept;
+
+    // An argument or property value as the parser reports it, text is the string value or the number or keyword text
+    struct EventValue
+    {
+        QStringView text;
+        std::optional<QStringView> typeAnnotation;
+        ValueType type;
+        TokenKind kind;
+        // Source offset of the value token, after its type annotation
+        i32 offset = 0;
+    };
+
+    // Strings with escapes or multiple lines are decoded into these, so views of them are only valid until the
+    // handler returns. Reusing the same buffers for many parses keeps the parser from allocating at all.
+    struct KDL_API ParseBuffers
+    {
+        QString name;
+        QString typeAnnotation;
+        QString value;
+    };
+
+    // Reads the tokens of a TokenBuffer for EventParser
+    class BufferedTokens
+    {
+    public:
+        BufferedTokens(const TokenBuffer& tokens) noexcept
+            : m_tokens{ tokens.storage() }
+            , m_source{ tokens.source() }
+        {
+        }
+
+        [[nodiscard]] TokenKind kind() const noexcept
+        {
+            return m_index < m_tokens.size() ? m_tokens.kind(m_index) : TokenKind::EndOfFile;
+        }
+
+        [[nodiscard]] TokenKind nextKind() const noexcept
+        {
+            return m_index + 1 < m_tokens.size() ? m_tokens.kind(m_index + 1) : TokenKind::EndOfFile;
+        }
+
+        [[nodiscard]] Token token() const noexcept
+        {
+            return {
+                .kind = m_tokens.kind(m_index),
+                .stringView = m_source.sliced(m_tokens.start(m_index), m_tokens.length(m_index)),
+                .hasEscapes = m_tokens.hasEscapes(m_index)
+            };
+        }
+
+        // Whether there was whitespace or a comment between the previous and the current token
+        [[nodiscard]] bool hasSpace() const noexcept
+        {
+            return m_index == 0 || m_tokens.start(m_index) > m_tokens.end(m_index - 1);
+        }
+
+        // Start of the current token, or of the last one once the end has been passed
+        [[nodiscard]] i32 offset() const noexcept
+        {
+            if (m_tokens.size() == 0)
+                return 0;
+
+            return m_tokens.start(std::min(m_index, m_tokens.size() - 1));
+        }
+
+        void advance() noexcept
+        {
+            if (m_index < m_tokens.size())
+                m_index++;
+        }
+
+    private:
+        const TokenStorage& m_tokens;
+        QStringView m_source;
+        i32 m_index = 0;
+    };
+
+    // Recursive descent parser for KDL 2.0 that reports what it finds to THandler instead of building a tree.
+    // THandler has to provide these functions, which are called in document order:
+    //
+    //     void beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32 offset);
+    //     void argument(const EventValue& value);
+    //     void property(QStringView name, const EventValue& value, i32 offset);
+    //     void beginChildren();
+    //     void endChildren();
+    //     void endNode();
+    //
+    // Nodes, entries and children blocks commented out with a slash-dash are parsed and checked but not reported.
+    // Names and values are views into the source, or into buffers if they contain escapes, offset is where the
+    // name token starts in the source. Whitespace and comments never become tokens, so the gap between two
+    // tokens is where node-space was.
+    // TTokens hands out the tokens one at a time with the same functions as BufferedTokens, the lexer uses
+    // this to parse while it lexes.
+    template<typename THandler, typename TTokens = BufferedTokens>
+    class EventParser
+    {
+    public:
+        EventParser(TTokens tokens, THandler& handler, ParseBuffers& buffers) noexcept
+            : m_tokens{ tokens }
+            , m_handler{ handler }
+            , m_buffers{ buffers }
+        {
+        }
+
+        [[nodiscard]] ParseStatus parse()
+        {
+            // A byte order mark is only allowed in front of everything else
+            if (kind() == TokenKind::Error && m_tokens.offset() == 0 && token().stringView.startsWith(QChar(0xFEFF)))
+                advance();
+
+            parseNodes(false, false);
+            return m_status;
+        }
+
+        // Source offset of the token the error was found at
+        [[nodiscard]] i32 errorOffset() const noexcept
+        {
+            return m_tokens.offset();
+        }
+
+    private:
+        [[nodiscard]] TokenKind kind() const noexcept
+        {
+            return m_tokens.kind();
+        }
+
+        [[nodiscard]] TokenKind nextKind() noexcept
+        {
+            return m_tokens.nextKind();
+        }
+
+        [[nodiscard]] Token token() const noexcept
+        {
+            return m_tokens.token();
+        }
+
+        [[nodiscard]] bool hasSpace() const noexcept
+        {
+            return m_tokens.hasSpace();
+        }
+
+        void advance() noexcept
+        {
+            m_tokens.advance();
+        }
+
+        void skipNewlines() noexcept
+        {
+            while (kind() == TokenKind::Newline)
+                advance();
+        }
+
+        bool fail(ParseStatus status) noexcept
+        {
+            if (m_status == ParseStatus::Ok)
+                m_status = status;
+
+            return false;
+        }
+
+        // Decodes the current string token into buffer if it can't be viewed in the source
+        [[nodiscard]] bool parseString(QStringView& value, QString& buffer)
+        {
+            const auto current = token();
+            if (current.kind == TokenKind::Identifier && !IsValidIdentifier(current.stringView))
+                return fail(ParseStatus::InvalidIdentifier);
+
+            if (const auto view = StringValueView(current))
+            {
+                value = *view;
+            }
+            else
+            {
+                if (DecodeString(current, buffer) != StringStatus::Ok)
+                    return fail(ParseStatus::InvalidString);
+
+                value = buffer;
+            }
+
+            advance();
+            return true;
+        }
+
+        // '(' string ')' with optional space in between
+        [[nodiscard]] bool parseTypeAnnotation(std::optional<QStringView>& typeAnnotation)
+        {
+            advance();
+            if (!IsStringKind(kind()))
+                return fail(ParseStatus::UnexpectedToken);
+
+            auto value = QStringView{};
+            if (!parseString(value, m_buffers.typeAnnotation))
+                return false;
+
+            if (kind() != TokenKind::CloseParenthesis)
+                return fail(ParseStatus::UnexpectedToken);
+
+            advance();
+            typeAnnotation = value;
+            return true;
+        }
+
+        [[nodiscard]] bool parseValue(EventValue& value)
+        {
+            if (kind() == TokenKind::OpenParenthesis && !parseTypeAnnotation(value.typeAnnotation))
+                return false;
+
+            const auto current = token();
+            value.kind = current.kind;
+            value.offset = m_tokens.offset();
+            if (IsStringKind(current.kind))
+            {
+                // A type annotation in front of a property key
+                if (value.typeAnnotation && nextKind() == TokenKind::Equal)
+                    return fail(ParseStatus::UnexpectedToken);
+
+                value.type = ValueType::String;
+                return parseString(value.text, m_buffers.value);
+            }
+
+            if (IsNumberKind(current.kind) && !IsValidNumber(current.stringView, current.kind))
+                return fail(ParseStatus::InvalidNumber);
+
+            if (!IsNumberKind(current.kind) && !IsKeywordKind(current.kind))
+                return fail(ParseStatus::UnexpectedToken);
+
+            value.type = ValueTypeOf(current.kind, current.stringView);
+            value.text = current.stringView;
+            advance();
+            return true;
+        }
+
+        // An argument or a property
+        [[nodiscard]] bool parseEntry(bool isDiscarded)
+        {
+            if (IsStringKind(kind()) && nextKind() == TokenKind::Equal)
+            {
+                const auto offset = m_tokens.offset();
+                auto name = QStringView{};
+                if (!parseString(name, m_buffers.name))
+                    return false;
+
+                advance();
+                auto value = EventValue{};
+                if (!parseValue(value))
+                    return false;
+
+                if (!isDiscarded)
+                    m_handler.property(name, value, offset);
+
+                return true;
+            }
+
+            auto value = EventValue{};
+            if (!parseValue(value))
+                return false;
+
+            if (!isDiscarded)
+                m_handler.argument(value);
+
+            return true;
+        }
+
+        [[nodiscard]] bool parseChildren(bool isDiscarded)
+        {
+            if (m_depth == MaxNestingDepth)
+                return fail(ParseStatus::TooDeep);
+
+            advance();
+            if (!isDiscarded)
+                m_handler.beginChildren();
+
+            m_depth++;
+            if (!parseNodes(true, isDiscarded))
+                return false;
+
+            m_depth--;
+            advance();
+            if (!isDiscarded)
+                m_handler.endChildren();
+
+            return true;
+        }
+
+        [[nodiscard]] bool parseNode(bool isDiscarded)
+        {
+            auto typeAnnotation = std::optional<QStringView>{};
+            if (kind() == TokenKind::OpenParenthesis && !parseTypeAnnotation(typeAnnotation))
+                return false;
+
+            if (!IsStringKind(kind()))
+                return fail(ParseStatus::UnexpectedToken);
+
+            const auto offset = m_tokens.offset();
+            auto name = QStringView{};
+            if (!parseString(name, m_buffers.name))
+                return false;
+
+            if (!isDiscarded)
+                m_handler.beginNode(name, typeAnnotation, offset);
+
+            // Only slash-dashed children blocks may follow the children, and nothing but children blocks may follow those
+            auto hasChildren = false;
+            auto hasDiscardedChildren = false;
+            while (true)
+            {
+                const auto current = kind();
+                if (current == TokenKind::Newline || current == TokenKind::Terminator)
+                {
+                    advance();
+                    break;
+                }
+                if (current == TokenKind::EndOfFile || current == TokenKind::CloseBracket)
+                    break;
+
+                if (!hasSpace() && !(current == TokenKind::SlashDash && (hasChildren || hasDiscardedChildren)))
+                    return fail(ParseStatus::MissingSpace);
+
+                auto isSlashDashed = false;
+                if (current == TokenKind::SlashDash)
+                {
+                    advance();
+                    skipNewlines();
+                    isSlashDashed = true;
+                }
+
+                if (kind() == TokenKind::OpenBracket)
+                {
+                    if (hasChildren && !isSlashDashed)
+                        return fail(ParseStatus::UnexpectedToken);
+                    if (!parseChildren(isDiscarded || isSlashDashed))
+                        return false;
+
+                    hasChildren = hasChildren || !isSlashDashed;
+                    hasDiscardedChildren = hasDiscardedChildren || isSlashDashed;
+                    continue;
+                }
+
+                if (hasChildren || hasDiscardedChildren)
+                    return fail(ParseStatus::UnexpectedToken);
+                if (!parseEntry(isDiscarded || isSlashDashed))
+                    return false;
+            }
+
+            if (!isDiscarded)
+                m_handler.endNode();
+
+            return true;
+        }
+
+        bool parseNodes(bool isChildren, bool isDiscarded)
+        {
+            while (true)
+            {
+                skipNewlines();
+                const auto current = kind();
+                if (current == TokenKind::EndOfFile)
+                    return !isChildren || fail(ParseStatus::UnterminatedChildren);
+                if (current == TokenKind::CloseBracket)
+                    return isChildren || fail(ParseStatus::UnexpectedToken);
+
+                auto isSlashDashed = false;
+                if (current == TokenKind::SlashDash)
+                {
+                    advance();
+                    skipNewlines();
+                    isSlashDashed = true;
+                }
+
+                if (!parseNode(isDiscarded || isSlashDashed))
+                    return false;
+            }
+        }
+
+        TTokens m_tokens;
+        THandler& m_handler;
+        ParseBuffers& m_buffers;
+        ParseStatus m_status = ParseStatus::Ok;
+        i32 m_depth = 0;
+    };
+
+    template<typename THandler>
+    EventParser(const TokenBuffer&, THandler&, ParseBuffers&) -> EventParser<THandler, BufferedTokens>;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <KDL/Lexer.h>
+
+#include <QFileInfo>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace KDL
+{
+    // Bounds the bytes of the files being processed at once
+    class ByteBudget
+    {
+    public:
+        explicit ByteBudget(i64 maxBytes) noexcept
+            : m_maxBytes{ maxBytes }
+        {
+        }
+
+        // Waits until bytes fit, or until nothing else is in flight if they never will
+        void acquire(i64 bytes)
+        {
+            std::unique_lock lock{ m_mutex };
+            m_released.wait(lock, [this, bytes]() { return m_bytes == 0 || m_bytes + bytes <= m_maxBytes; });
+            m_bytes += bytes;
+        }
+
+        void release(i64 bytes)
+        {
+            {
+                std::unique_lock lock{ m_mutex };
+                m_bytes -= bytes;
+            }
+            m_released.notify_all();
+        }
+
+    private:
+        const i64 m_maxBytes;
+        i64 m_bytes = 0;
+        std::mutex m_mutex;
+        std::condition_variable m_released;
+    };
+
+    // Calls process for every path on up to options.threadCount threads, the calling thread being one of
+    // them. Each thread takes the next path nobody has taken yet, so a thread that drew small files keeps
+    // going while another works on a large one, and the files are started in the order of paths.
+    template<typename TResult, typename TProcess>
+    [[nodiscard]] std::vector<TResult> ProcessFiles(const QStringList& paths, const BatchOptions& options, TProcess process)
+    {
+        const auto pathCount = static_cast<i32>(paths.size());
+        std::vector<TResult> results(pathCount);
+
+        auto threadCount = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+        threadCount = std::clamp(threadCount, 1, std::max(pathCount, 1));
+
+        // One file at a time is always within the budget
+        if (threadCount == 1)
+        {
+            for (auto index = 0; index < pathCount; index++)
+                results[index] = process(paths[index]);
+            return results;
+        }
+
+        std::atomic<i32> nextIndex = 0;
+        ByteBudget budget{ options.maxBytesInFlight };
+        const auto work = [&]()
+            {
+                for (auto index = nextIndex++; index < pathCount; index = nextIndex++)
+                {
+                    const auto& path = paths[index];
+                    const auto bytes = QFileInfo(path).size();
+                    budget.acquire(bytes);
+                    results[index] = process(path);
+                    budget.release(bytes);
+                }
+            };
+
+        QThreadPool threadPool{};
+        threadPool.setMaxThreadCount(threadCount - 1);
+        for (auto thread = 1; thread < threadCount; thread++)
+            threadPool.start(work);
+        work();
+        threadPool.waitForDone();
+
+        return results;
+    }
+}
@@ -0,0 +1,73 @@
+#include <KDL/FileMapping.h>
+
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    using namespace KDL;
+
+    [[nodiscard]] const char* MapHandle(int handle, i64 size) noexcept
+    {
+#ifdef Q_OS_WIN
+        const auto fileHandle = reinterpret_cast<HANDLE>(_get_osfhandle(handle));
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return nullptr;
+
+        // The view keeps the mapping object alive after its handle is closed
+        const auto mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+            return nullptr;
+
+        const auto* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(size));
+        CloseHandle(mapping);
+        return static_cast<const char*>(data);
+#else
+        // The mapping keeps its own reference to the file, closing the descriptor doesn't end it
+        auto* data = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, handle, 0);
+        return data == MAP_FAILED ? nullptr : static_cast<const char*>(data);
+#endif
+    }
+}
+
+namespace KDL
+{
+    FileMapping::FileMapping(const char* data, i64 size) noexcept
+        : m_data{ data }
+        , m_size{ size }
+    {
+    }
+
+    FileMapping::~FileMapping()
+    {
+#ifdef Q_OS_WIN
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<char*>(m_data), static_cast<size_t>(m_size));
+#endif
+    }
+
+    QByteArrayView FileMapping::bytes() const noexcept
+    {
+        return QByteArrayView(m_data, m_size);
+    }
+
+    std::shared_ptr<const FileMapping> MapFile(const QFile& file, i64 size)
+    {
+        const auto handle = file.handle();
+        if (handle < 0 || size <= 0)
+            return nullptr;
+
+        const auto* data = MapHandle(handle, size);
+        if (data == nullptr)
+            return nullptr;
+
+        return std::make_shared<const FileMapping>(data, size);
+    }
+}
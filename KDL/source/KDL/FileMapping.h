@@ -0,0 +1,34 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <Defines.h>
+
+#include <QByteArrayView>
+#include <QFile>
+
+#include <memory>
+
+namespace KDL
+{
+    // A read-only mapping of a file that doesn't need the file to stay open. Mappings made by QFile are
+    // unmapped when it is closed, so keeping those alive keeps a file descriptor open for each of them.
+    class KDL_API FileMapping
+    {
+    public:
+        FileMapping(const char* data, i64 size) noexcept;
+        ~FileMapping();
+
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+
+        [[nodiscard]] QByteArrayView bytes() const noexcept;
+
+    private:
+        const char* m_data;
+        i64 m_size;
+    };
+
+    // Maps the first size bytes of file, which must be open for reading. Returns nullptr if they can't be
+    // mapped, the file can be closed as soon as this returns.
+    KDL_API [[nodiscard]] std::shared_ptr<const FileMapping> MapFile(const QFile& file, i64 size);
+}
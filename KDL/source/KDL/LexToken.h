@@ -0,0 +1,983 @@
+#pragma once
+
+#include <KDL/CharacterClass.h>
+#include <KDL/StringScan.h>
+#include <KDL/Token.h>
+#include <KDL/TokenKind.h>
+#include <Defines.h>
+
+#include <QString>
+
+#include <string_view>
+
+// The lexer's state machine, shared by the lexers and the fused parses.
+// LexToken hands each token it finds to TBuffer::addToken(kind, start, end, hasEscapes). It lives in a namespace
+// of its own so its many small helpers don't clash with those of the modules that include it.
+namespace KDL::LexerDetail
+{
+    struct BoolSizePair
+    {
+        bool Bool;
+        uint Size;
+    };
+
+    struct CodePoint
+    {
+        char32_t Value;
+        i32 Size;
+    };
+
+    // ReachedEnd is set whenever the lexer looks at or past Size, the streaming lexer uses it
+    // to tell whether a token could continue in data that hasn't been read yet
+    struct Utf16Source
+    {
+        const char16_t* Data;
+        i32 Size;
+        mutable bool ReachedEnd = false;
+    };
+
+    struct Utf8Source
+    {
+        const u8* Data;
+        i32 Size;
+        mutable bool ReachedEnd = false;
+    };
+
+    [[nodiscard]] static inline CodePoint Decode(const Utf16Source& source, i32 charIndex) noexcept
+    {
+        const char16_t current = source.Data[charIndex];
+        if (QChar::isHighSurrogate(current))
+        {
+            if (charIndex + 1 >= source.Size)
+            {
+                source.ReachedEnd = true;
+                return { .Value = current, .Size = 1 };
+            }
+
+            const char16_t next = source.Data[charIndex + 1];
+            if (QChar::isLowSurrogate(next))
+                return { .Value = QChar::surrogateToUcs4(current, next), .Size = 2 };
+        }
+
+        return { .Value = current, .Size = 1 };
+    }
+
+    [[nodiscard]] static inline CodePoint Decode(const Utf8Source& source, i32 charIndex) noexcept
+    {
+        const u8 lead = source.Data[charIndex];
+        if (lead < 0x80)
+            return { .Value = lead, .Size = 1 };
+
+        i32 size = 0;
+        char32_t value = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            size = 2;
+            value = lead & 0x1F;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            size = 3;
+            value = lead & 0x0F;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            size = 4;
+            value = lead & 0x07;
+        }
+        else
+        {
+            return { .Value = QChar::ReplacementCharacter, .Size = 1 };
+        }
+
+        if (charIndex + size > source.Size)
+        {
+            source.ReachedEnd = true;
+            return { .Value = QChar::ReplacementCharacter, .Size = 1 };
+        }
+
+        for (auto i = 1; i < size; i++)
+        {
+            const u8 continuation = source.Data[charIndex + i];
+            if ((continuation & 0xC0) != 0x80)
+                return { .Value = QChar::ReplacementCharacter, .Size = 1 };
+
+            value = (value << 6) | (continuation & 0x3F);
+        }
+
+        return { .Value = value, .Size = size };
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto PeekChar(const TSource& source, i32 currentIndex, i32 offset) noexcept
+    {
+        const auto charIndex = currentIndex + offset;
+        if (charIndex >= source.Size)
+        {
+            source.ReachedEnd = true;
+            return U'\0';
+        }
+
+        return Decode(source, charIndex).Value;
+    };
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto PeekCurrentChar(const TSource& source, i32 currentIndex) noexcept { return PeekChar(source, currentIndex, 0); };
+    template<typename TSource>
+    [[nodiscard]] static inline auto PeekNextChar(const TSource& source, i32 currentIndex) noexcept { return PeekChar(source, currentIndex, 1); };
+
+    // Number of code units the character at currentIndex occupies, so multi-unit
+    // characters are always stepped over as a whole
+    template<typename TSource>
+    [[nodiscard]] static inline auto CharSize(const TSource& source, i32 currentIndex) noexcept
+    {
+        if (currentIndex >= source.Size)
+        {
+            source.ReachedEnd = true;
+            return 1;
+        }
+
+        return Decode(source, currentIndex).Size;
+    }
+
+    template<typename TSource>
+    static inline auto AdvanceChar(const TSource& source, i32& currentIndex) noexcept
+    {
+        currentIndex += CharSize(source, currentIndex);
+    }
+
+    // Jumps to the next character inside a string body that the string lexers have to look at
+    template<typename TSource>
+    static inline auto SkipStringBody(const TSource& source, i32& currentIndex, bool stopAtBackslash) noexcept
+    {
+        currentIndex = FindStringDelimiter(source.Data, currentIndex, source.Size, stopAtBackslash);
+        if (currentIndex == source.Size)
+            source.ReachedEnd = true;
+    }
+
+    [[nodiscard]] static inline auto IsBinary(const char32_t nextChar) noexcept
+    {
+        return (nextChar == U'0' || nextChar == U'1');
+    }
+
+    [[nodiscard]] static inline auto IsOctal(const char32_t nextChar) noexcept
+    {
+        return (nextChar >= U'0' && nextChar <= U'7');
+    }
+
+    [[nodiscard]] static inline auto IsHexadecimal(const char32_t nextChar) noexcept
+    {
+        return HasAny(ClassOf(nextChar), CharacterClass::Hexadecimal);
+    }
+
+    // ASCII is answered by the character class table, only other code points need Qt's Unicode tables
+    [[nodiscard]] static inline auto IsNumber(const char32_t current) noexcept
+    {
+        if (current < 0x80)
+            return HasAny(ClassOf(current), CharacterClass::Digit);
+
+        return QChar::isNumber(current);
+    }
+
+    [[nodiscard]] static inline auto IsLetter(const char32_t current) noexcept
+    {
+        if (current < 0x80)
+            return HasAny(ClassOf(current), CharacterClass::Letter);
+
+        return QChar::isLetter(current);
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsHash(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return current == U'#';
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsQuote(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return current == U'\"';
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsSign(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return (current == U'-' || current == U'+');
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsDot(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return (current == U'.');
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsEOF(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return (current == U'\0');
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsDigit(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return IsNumber(current);
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsSpace(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return HasAny(ClassOf(current), CharacterClass::Space);
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline BoolSizePair IsEscapeSequence(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        const auto next = PeekNextChar(source, currentIndex);
+
+        if (current != U'\\')
+            return { .Bool = false, .Size = 1 };
+
+        switch (next)
+        {
+            case U'n': // Line Feed
+            case U'r': // Carriage Return
+            case U't': // Character Tabulation (Tab)
+            case U'\\': // Reverse Solidus (Backslash)
+            case U'\"': // Quotation Mark (Double Quote)
+            case U'b': // Backspace
+            case U'f': // Form Feed
+            case U's': // Space
+            {
+                return { .Bool = true, .Size = 2 };
+            }
+            case U'u':  // Unicode Escape
+            {
+                auto escapeIndex = currentIndex + 2;
+                if (PeekCurrentChar(source, escapeIndex) != U'{')
+                    break;
+                escapeIndex++;
+
+                auto hexCharCount = 0;
+                while (hexCharCount != 6 && IsHexadecimal(PeekCurrentChar(source, escapeIndex)))
+                {
+                    escapeIndex++;
+                    hexCharCount++;
+                }
+
+                if (PeekCurrentChar(source, escapeIndex) != U'}')
+                    break;
+                escapeIndex++;
+
+                uint length = (escapeIndex - currentIndex);
+                return { .Bool = true, .Size = length };
+            }
+            default:
+                if (IsSpace(source, currentIndex + 1))  // Whitespace Escape
+                {
+                    auto escapeIndex = currentIndex + 1;
+                    AdvanceChar(source, escapeIndex);
+                    while (IsSpace(source, escapeIndex))
+                    {
+                        AdvanceChar(source, escapeIndex);
+                    }
+
+                    uint length = (escapeIndex - currentIndex);
+                    return { .Bool = true, .Size = length };
+                }
+                break;  // TODO \ followed by any other character isnt allowed, handle error
+        }
+
+        return { .Bool = false, .Size = 1 };
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline BoolSizePair IsNewline(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        if (!HasAny(ClassOf(current), CharacterClass::Newline))
+            return { .Bool = false, .Size = 0 };
+
+        if (current == U'\r' && PeekNextChar(source, currentIndex) == U'\n')   // Carriage Return Line Feed
+            return { .Bool = true, .Size = 2 };
+
+        return { .Bool = true, .Size = uint(CharSize(source, currentIndex)) };
+    }
+
+    template<typename TSource>
+    [[nodiscard]] static inline auto IsIdentifierChar(const TSource& source, const i32& currentIndex) noexcept
+    {
+        const auto current = PeekCurrentChar(source, currentIndex);
+        return !HasAny(ClassOf(current), CharacterClass::IdentifierTerminator);
+    }
+
+    template<typename TSource>
+    static inline auto SkipIdentifierChars(const TSource& source, i32& currentIndex) noexcept
+    {
+        while (currentIndex < source.Size)
+        {
+            const auto current = Decode(source, currentIndex);
+            if (HasAny(ClassOf(current.Value), CharacterClass::IdentifierTerminator))
+                return;
+
+            currentIndex += current.Size;
+        }
+
+        source.ReachedEnd = true;
+    }
+
+    struct Keyword
+    {
+        std::string_view Text;
+        TokenKind Kind;
+    };
+
+    inline constexpr Keyword Keywords[] = {
+        { "#true", TokenKind::Keyword_True },
+        { "#false", TokenKind::Keyword_False },
+        { "#nan", TokenKind::Keyword_NaN },
+        { "#inf", TokenKind::Keyword_Infinity },
+        { "#-inf", TokenKind::Keyword_NegativeInfinity },
+        { "#null", TokenKind::Keyword_Null },
+    };
+
+    // Compares the code units of a lexed word against the keyword table, words of the wrong length
+    // are rejected without looking at their characters
+    template<typename TSource>
+    [[nodiscard]] static inline auto MatchKeyword(const TSource& source, i32 startIndex, i32 length) noexcept
+    {
+        for (const auto& keyword : Keywords)
+        {
+            if (i32(keyword.Text.size()) != length)
+                continue;
+
+            auto isMatch = true;
+            for (auto i = 1; i < length && isMatch; i++)
+                isMatch = source.Data[startIndex + i] == keyword.Text[i];
+
+            if (isMatch)
+                return keyword.Kind;
+        }
+
+        return TokenKind::Unknown;
+    }
+
+    static inline auto NumberType(const char32_t c, const char32_t n) noexcept
+    {
+        if (c == U'0')
+        {
+            if (n == U'b')
+                return TokenKind::Number_Binary;
+            if (n == U'o')
+                return TokenKind::Number_Octal;
+            if (n == U'x')
+                return TokenKind::Number_Hexadecimal;
+        }
+        return TokenKind::Number_Decimal;
+    }
+
+    struct BinaryDigits
+    {
+        [[nodiscard]] static inline auto Matches(const char32_t c) noexcept { return IsBinary(c); }
+    };
+
+    struct OctalDigits
+    {
+        [[nodiscard]] static inline auto Matches(const char32_t c) noexcept { return IsOctal(c); }
+    };
+
+    struct HexadecimalDigits
+    {
+        [[nodiscard]] static inline auto Matches(const char32_t c) noexcept { return IsHexadecimal(c); }
+    };
+
+    struct DecimalDigits
+    {
+        [[nodiscard]] static inline auto Matches(const char32_t c) noexcept { return IsNumber(c); }
+    };
+
+    // Skips digits and the underscores after the first digit, returns the first character after them
+    template<typename TDigits, typename TSource>
+    static inline auto SkipDigits(const TSource& source, i32& currentIndex) noexcept
+    {
+        auto currentChar = PeekCurrentChar(source, currentIndex);
+        if (!TDigits::Matches(currentChar))
+            return currentChar;
+
+        // Decimal digits include non-ASCII ones, which take more than one code unit
+        while (TDigits::Matches(currentChar) || currentChar == U'_')
+        {
+            AdvanceChar(source, currentIndex);
+            currentChar = PeekCurrentChar(source, currentIndex);
+        }
+
+        return currentChar;
+    }
+
+    template<typename TBuffer, typename TSource>
+    static inline auto LexKeyword(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+        currentIndex++;
+
+        if (PeekCurrentChar(source, currentIndex) == U'-')
+            currentIndex++;
+
+        while (IsLetter(PeekCurrentChar(source, currentIndex)))
+            AdvanceChar(source, currentIndex);
+
+        const auto keywordKind = MatchKeyword(source, startIndex, currentIndex - startIndex);
+        if (keywordKind == TokenKind::Unknown)
+        {
+            currentIndex = startIndex;
+            return false;
+        }
+
+        tokenBuffer.addToken(keywordKind, startIndex, currentIndex);
+        return true;
+    };
+
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexNumber(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+
+        auto currentChar = PeekCurrentChar(source, currentIndex);
+        auto nextChar = PeekNextChar(source, currentIndex);
+        if (IsSign(source, currentIndex))
+        {
+            if (!IsNumber(nextChar))
+                return false;
+
+            currentIndex++;
+        }
+
+        currentChar = PeekCurrentChar(source, currentIndex);
+        if (!IsNumber(currentChar))
+            return false;
+
+        nextChar = PeekNextChar(source, currentIndex);
+        const auto numberType = NumberType(currentChar, nextChar);
+        switch (numberType)
+        {
+            case TokenKind::Number_Binary:
+                currentIndex += 2;
+                SkipDigits<BinaryDigits>(source, currentIndex);
+                break;
+            case TokenKind::Number_Octal:
+                currentIndex += 2;
+                SkipDigits<OctalDigits>(source, currentIndex);
+                break;
+            case TokenKind::Number_Hexadecimal:
+                currentIndex += 2;
+                SkipDigits<HexadecimalDigits>(source, currentIndex);
+                break;
+            default:
+            {
+                currentChar = SkipDigits<DecimalDigits>(source, currentIndex);
+
+                if (currentChar == U'.' && IsNumber(PeekNextChar(source, currentIndex)))
+                {
+                    currentIndex++;
+
+                    currentChar = SkipDigits<DecimalDigits>(source, currentIndex);
+                }
+
+                nextChar = PeekNextChar(source, currentIndex);
+                while (QChar::toLower(currentChar) == U'e' && (nextChar == U'+' || nextChar == U'-' || IsNumber(nextChar)))
+                {
+                    if (nextChar == U'+' || nextChar == U'-')
+                    {
+                        currentIndex += 2;
+                    }
+                    else
+                    {
+                        currentIndex++;
+                    }
+
+                    currentChar = SkipDigits<DecimalDigits>(source, currentIndex);
+                    nextChar = PeekNextChar(source, currentIndex);
+                }
+                break;
+            }
+        }
+
+        tokenBuffer.addToken(numberType, startIndex, currentIndex);
+        return true;
+    }
+
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexQuotedString(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+        if (!IsQuote(source, currentIndex))
+            return false;
+
+        currentIndex++;
+
+        auto hasEscapes = false;
+        while (true)
+        {
+            SkipStringBody(source, currentIndex, true);
+
+            // Invalid escapes count too, decoding the value is what reports them
+            if (PeekCurrentChar(source, currentIndex) == U'\\')
+                hasEscapes = true;
+
+            if (auto result = IsEscapeSequence(source, currentIndex); result.Bool)
+            {
+                currentIndex += result.Size;
+                continue;
+            }
+
+            if (!IsQuote(source, currentIndex) && !IsEOF(source, currentIndex))
+            {
+                AdvanceChar(source, currentIndex);
+                continue;
+            }
+
+            if (!IsEOF(source, currentIndex))
+                currentIndex++;
+
+            break;
+        }
+
+        tokenBuffer.addToken(TokenKind::Identifier_QuotedString, startIndex, currentIndex, hasEscapes);
+        return true;
+    }
+
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexRawString(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+        auto startHashCount = 0;
+        while (IsHash(source, currentIndex))
+        {
+            currentIndex++;
+            startHashCount++;
+        }
+
+        if (!IsQuote(source, currentIndex))
+        {
+            currentIndex = startIndex;
+            return false;
+        }
+        currentIndex++;
+
+        while (true)
+        {
+            SkipStringBody(source, currentIndex, false);
+
+            if (!IsQuote(source, currentIndex) && !IsEOF(source, currentIndex))
+            {
+                AdvanceChar(source, currentIndex);
+                continue;
+            }
+
+            if (IsQuote(source, currentIndex))
+            {
+                currentIndex++;
+                auto endHasCount = 0;
+
+                while (IsHash(source, currentIndex))
+                {
+                    currentIndex++;
+                    endHasCount++;
+                }
+
+                if (startHashCount == endHasCount)
+                    break;
+
+                continue;
+            }
+            else if (!IsEOF(source, currentIndex))
+                currentIndex++;
+
+            break;
+        }
+
+        tokenBuffer.addToken(TokenKind::Identifier_RawString, startIndex, currentIndex);
+        return true;
+    }
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexDottedIdentifier(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+        if (IsSign(source, currentIndex))
+            currentIndex++;
+
+        if (!IsDot(source, currentIndex))
+            return false;
+
+        currentIndex++;
+
+        if (IsIdentifierChar(source, currentIndex) && !IsDigit(source, currentIndex))
+            AdvanceChar(source, currentIndex);
+
+        SkipIdentifierChars(source, currentIndex);
+
+        tokenBuffer.addToken(TokenKind::Identifier, startIndex, currentIndex);
+        return true;
+    }
+
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexSignedIdentifier(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+        if (!IsSign(source, currentIndex))
+            return false;
+
+        currentIndex++;
+
+        if (IsIdentifierChar(source, currentIndex) && !IsDigit(source, currentIndex) && !IsDot(source, currentIndex))
+            AdvanceChar(source, currentIndex);
+
+        SkipIdentifierChars(source, currentIndex);
+
+        tokenBuffer.addToken(TokenKind::Identifier, startIndex, currentIndex);
+        return true;
+    }
+
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexUnambiguousIdentifier(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        const auto startIndex = currentIndex;
+        if (IsIdentifierChar(source, currentIndex) && !IsDigit(source, currentIndex) && !IsSign(source, currentIndex) && !IsDot(source, currentIndex))
+            AdvanceChar(source, currentIndex);
+        else
+            return false;
+
+        SkipIdentifierChars(source, currentIndex);
+
+        tokenBuffer.addToken(TokenKind::Identifier, startIndex, currentIndex);
+        return true;
+    }
+
+    template<typename TBuffer, typename TSource>
+    static inline auto TryLexIdentifier(TBuffer& tokenBuffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        if (IsHash(source, currentIndex))
+        {
+            if (!IsHash(source, currentIndex + 1) && !IsQuote(source, currentIndex + 1))
+            {
+                return LexKeyword(tokenBuffer, source, currentIndex);
+            }
+            return TryLexRawString(tokenBuffer, source, currentIndex);
+        }
+        else if (IsQuote(source, currentIndex))
+        {
+            return TryLexQuotedString(tokenBuffer, source, currentIndex);
+        }
+        else if ((IsSign(source, currentIndex) && IsDot(source, currentIndex))
+            || IsDot(source, currentIndex))
+        {
+            return TryLexDottedIdentifier(tokenBuffer, source, currentIndex);
+        }
+        else if (IsSign(source, currentIndex))
+        {
+            return TryLexSignedIdentifier(tokenBuffer, source, currentIndex);
+        }
+        else
+        {
+            return TryLexUnambiguousIdentifier(tokenBuffer, source, currentIndex);
+        }
+
+        return false;
+    }
+
+    // Stops in front of the newline, which terminates the node like any other newline
+    template<typename TSource>
+    static inline auto EatLineComment(const TSource& source, i32& currentIndex) noexcept
+    {
+        currentIndex += 2;
+        while (!IsNewline(source, currentIndex).Bool && !IsEOF(source, currentIndex))
+            currentIndex++;
+    }
+
+    template<typename TSource>
+    static inline auto EatBlockComment(const TSource& source, i32& currentIndex) noexcept
+    {
+        currentIndex += 2;
+        auto nestingLevel = 1;
+        while (currentIndex < source.Size)
+        {
+            if (PeekCurrentChar(source, currentIndex) == U'*' && PeekNextChar(source, currentIndex) == U'/')
+            {
+                currentIndex += 2;
+                nestingLevel--;
+            }
+            else if (PeekCurrentChar(source, currentIndex) == U'/' && PeekNextChar(source, currentIndex) == U'*')
+            {
+                currentIndex += 2;
+                nestingLevel++;
+            }
+            else
+            {
+                currentIndex++;
+            }
+
+            if (nestingLevel == 0)
+                return;
+        }
+
+        // An unterminated comment runs to the end of the source
+        source.ReachedEnd = true;
+        currentIndex = source.Size;
+    }
+
+    // Lexes whatever starts at currentIndex, which adds at most one token to the buffer.
+    // Returns false once the end of the source has been reached.
+    template<typename TBuffer, typename TSource>
+    static inline bool LexToken(TBuffer& buffer, const TSource& source, i32& currentIndex) noexcept
+    {
+        auto current = PeekCurrentChar(source, currentIndex);
+        switch (current)
+        {
+            case U'(':
+            {
+                buffer.addToken(TokenKind::OpenParenthesis, currentIndex, currentIndex + 1);
+                currentIndex++;
+                break;
+            }
+            case U')':
+            {
+                buffer.addToken(TokenKind::CloseParenthesis, currentIndex, currentIndex + 1);
+                currentIndex++;
+                break;
+            }
+            case U'{':
+            {
+                buffer.addToken(TokenKind::OpenBracket, currentIndex, currentIndex + 1);
+                currentIndex++;
+                break;
+            }
+            case U'}':
+            {
+                buffer.addToken(TokenKind::CloseBracket, currentIndex, currentIndex + 1);
+                currentIndex++;
+                break;
+            }
+            case U';':
+            {
+                buffer.addToken(TokenKind::Terminator, currentIndex, currentIndex + 1);
+                currentIndex++;
+                break;
+            }
+            case U'\0':
+            {
+                buffer.addToken(TokenKind::EndOfFile, currentIndex, currentIndex);
+                return false;
+            }
+            case U'/':
+            {
+                if (PeekNextChar(source, currentIndex) == U'-') // Slash dash
+                {
+                    buffer.addToken(TokenKind::SlashDash, currentIndex, currentIndex + 2);
+                    currentIndex += 2;
+                    break;
+                }
+                else if (PeekNextChar(source, currentIndex) == U'/') // Line comments
+                {
+                    EatLineComment(source, currentIndex);
+                    break;
+                }
+                else if (PeekNextChar(source, currentIndex) == U'*') // Block comments
+                {
+                    EatBlockComment(source, currentIndex);
+                    break;
+                }
+                [[fallthrough]];
+            }
+            case U'\\': // Line continuation
+            {
+                // we need to check current again for the fallthrough
+                if (current == U'\\' &&
+                        (IsEOF(source, currentIndex + 1)
+                        || IsSpace(source, currentIndex + 1)
+                        || (PeekNextChar(source, currentIndex) == U'/' && PeekNextChar(source, currentIndex + 1) == U'/')
+                        || (PeekNextChar(source, currentIndex) == U'/' && PeekNextChar(source, currentIndex + 1) == U'*')
+                        || IsNewline(source, currentIndex + 1).Bool))
+                {
+                    currentIndex++;
+
+                    while (IsSpace(source, currentIndex))
+                    {
+                        AdvanceChar(source, currentIndex);
+                    }
+
+                    if (PeekCurrentChar(source, currentIndex) == U'/' && PeekNextChar(source, currentIndex) == U'/')
+                    {
+                        EatLineComment(source, currentIndex);
+                    }
+                    else if (PeekCurrentChar(source, currentIndex) == U'/' && PeekNextChar(source, currentIndex) == U'*')
+                    {
+                        EatBlockComment(source, currentIndex);
+                    }
+
+                    while (IsSpace(source, currentIndex))
+                    {
+                        AdvanceChar(source, currentIndex);
+                    }
+
+                    if (const auto result = IsNewline(source, currentIndex); result.Bool || IsEOF(source, currentIndex))
+                    {
+                        currentIndex += result.Size;
+                        break;
+                    }
+                    else
+                    {
+                        const auto size = CharSize(source, currentIndex);
+                        buffer.addToken(TokenKind::Error, currentIndex, currentIndex + size);
+                        currentIndex += size;
+                        break;
+                    }
+                    break;
+                }
+                [[fallthrough]];
+            }
+            default:
+            {
+                const auto characterClass = ClassOf(current);
+                if (HasAny(characterClass, CharacterClass::Newline))
+                {
+                    const auto result = IsNewline(source, currentIndex);
+                    buffer.addToken(TokenKind::Newline, currentIndex, currentIndex + result.Size);
+                    currentIndex += result.Size;
+                    break;
+                }
+                else if (HasAny(characterClass, CharacterClass::Space))
+                {
+                    AdvanceChar(source, currentIndex);
+                    break;
+                }
+                else if (HasAny(characterClass, CharacterClass::Equal))
+                {
+                    const auto size = CharSize(source, currentIndex);
+                    buffer.addToken(TokenKind::Equal, currentIndex, currentIndex + size);
+                    currentIndex += size;
+                    break;
+                }
+                else if (TryLexNumber(buffer, source, currentIndex))
+                {
+                    break;
+                }
+                else if (TryLexIdentifier(buffer, source, currentIndex))
+                {
+                    break;
+                }
+                else if (HasAny(characterClass, CharacterClass::DisallowedIdentifierChar | CharacterClass::DisallowedLiteralCodePoint))
+                {
+                    const auto size = CharSize(source, currentIndex);
+                    buffer.addToken(TokenKind::Error, currentIndex, currentIndex + size);
+                    currentIndex += size;
+                    break;
+                }
+
+                const auto size = CharSize(source, currentIndex);
+                buffer.addToken(TokenKind::Unknown, currentIndex, currentIndex + size);
+                currentIndex += size;
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    // Holds the token of a single LexToken call for the streaming lexer
+    struct SingleTokenBuffer
+    {
+        TokenKind Kind = TokenKind::Unknown;
+        i32 Start = 0;
+        i32 End = 0;
+        bool HasEscapes = false;
+        bool HasToken = false;
+
+        void addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes = false) noexcept
+        {
+            Kind = kind;
+            Start = start;
+            End = end;
+            HasEscapes = hasEscapes;
+            HasToken = true;
+        }
+    };
+
+    // Lexes one token ahead of the parser instead of storing them, the parser only ever looks at
+    // the current and the next token
+    class LexingTokens
+    {
+    public:
+        explicit LexingTokens(const QString& source) noexcept
+            : m_source{ .Data = source.utf16(), .Size = i32(source.size()) }
+            , m_text{ source }
+        {
+            lexNext(m_current);
+            lexNext(m_next);
+        }
+
+        [[nodiscard]] TokenKind kind() const noexcept
+        {
+            return m_current.Kind;
+        }
+
+        [[nodiscard]] TokenKind nextKind() const noexcept
+        {
+            return m_next.Kind;
+        }
+
+        [[nodiscard]] Token token() const noexcept
+        {
+            return {
+                .kind = m_current.Kind,
+                .stringView = m_text.sliced(m_current.Start, m_current.End - m_current.Start),
+                .hasEscapes = m_current.HasEscapes
+            };
+        }
+
+        [[nodiscard]] bool hasSpace() const noexcept
+        {
+            return m_current.Start > m_previousEnd;
+        }
+
+        [[nodiscard]] i32 offset() const noexcept
+        {
+            return m_current.Start;
+        }
+
+        void advance() noexcept
+        {
+            if (m_current.Kind == TokenKind::EndOfFile)
+                return;
+
+            m_previousEnd = m_current.End;
+            m_current = m_next;
+            lexNext(m_next);
+        }
+
+    private:
+        void lexNext(SingleTokenBuffer& token) noexcept
+        {
+            token.HasToken = false;
+            while (!m_isFinished && !token.HasToken)
+                m_isFinished = !LexToken(token, m_source, m_currentIndex);
+
+            if (!token.HasToken)
+                token.addToken(TokenKind::EndOfFile, m_source.Size, m_source.Size);
+        }
+
+        Utf16Source m_source;
+        QStringView m_text;
+        i32 m_currentIndex = 0;
+        i32 m_previousEnd = -1;
+        bool m_isFinished = false;
+        SingleTokenBuffer m_current{};
+        SingleTokenBuffer m_next{};
+    };
+}
@@ -1,779 +1,554 @@
 #include <KDL/Lexer.h>
-#include <functional>
+#include <KDL/FileBatch.h>
+#include <KDL/LexToken.h>
+#include <QThread>
+#include <QThreadPool>
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace
 {
     using namespace KDL;
+    using namespace KDL::LexerDetail;
 
-    struct BoolSizePair
+    template<typename TBuffer, typename TSource>
+    static void LexSource(TBuffer& buffer, const TSource& source) noexcept
     {
-        bool Bool;
-        uint Size;
-    };
+        i32 currentIndex = 0;
+        while (LexToken(buffer, source, currentIndex))
+        {
+        }
+    }
 
-    [[nodiscard]] static auto PeekChar(const QString& source, i32 currentIndex, i32 offset) noexcept
+    // Part of the source lexed on its own thread under the assumption that Begin is not inside a string or comment.
+    // Lexing goes on until Limit, the start of the next chunk, has been reached, End is where it actually stopped.
+    struct SpeculativeChunk
     {
-        const auto charIndex = currentIndex + offset;
-        if (charIndex >= source.length())
-            return QChar(u'\0');
-
-        return source[charIndex];
+        i32 Begin;
+        i32 Limit;
+        i32 End = 0;
+        TokenStorage Tokens{};
     };
 
-    [[nodiscard]] static auto PeekCurrentChar(const QString& source, i32 currentIndex) noexcept { return PeekChar(source, currentIndex, 0); };
-    [[nodiscard]] static auto PeekNextChar(const QString& source, i32 currentIndex) noexcept { return PeekChar(source, currentIndex, 1); };
+    static constexpr i64 MinimumMappedFileSize = 64 * 1024;
+    static constexpr i32 MinimumParallelChunkSize = 64 * 1024;
+    static constexpr i32 ChunksPerThread = 4;
 
-    [[nodiscard]] static auto IsBinary(const QChar& nextChar) noexcept
+    template<typename TSource>
+    [[nodiscard]] static std::vector<SpeculativeChunk> SplitAtNewlines(const TSource& source, i32 chunkCount)
     {
-        return (nextChar == QChar(u'0') || nextChar == QChar(u'1'));
-    }
-
-    [[nodiscard]] static auto IsOctal(const QChar& nextChar) noexcept
-    {
-        return (nextChar >= QChar(u'0') && nextChar <= QChar(u'7'));
-    }
-
-    [[nodiscard]] static auto IsHexadecimal(const QChar& nextChar) noexcept
-    {
-        return (nextChar >= QChar(u'0') && nextChar <= QChar(u'9'))
-            || (nextChar >= QChar(u'a') && nextChar <= QChar(u'f'))
-            || (nextChar >= QChar(u'A') && nextChar <= QChar(u'F'));
-    }
+        std::vector<SpeculativeChunk> chunks{};
+        auto begin = 0;
+        for (auto i = 1; i <= chunkCount && begin < source.Size; i++)
+        {
+            auto limit = std::max(i32(i64(source.Size) * i / chunkCount), begin + 1);
+            while (limit < source.Size && source.Data[limit - 1] != '\n')
+                limit++;
 
-    [[nodiscard]] static auto IsHash(const QString& source, const i32& currentIndex) noexcept
-    {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        return current == QChar(u'#');
-    }
+            chunks.push_back({ .Begin = begin, .Limit = limit });
+            begin = limit;
+        }
 
-    [[nodiscard]] static auto IsQuote(const QString& source, const i32& currentIndex) noexcept
-    {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        return current == QChar(u'\"');
+        return chunks;
     }
 
-    [[nodiscard]] static auto IsSign(const QString& source, const i32& currentIndex) noexcept
+    template<typename TSource>
+    static void LexChunk(SpeculativeChunk& chunk, const TSource& source) noexcept
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        return (current == QChar(u'-') || current == QChar(u'+'));
-    }
+        const auto isLast = chunk.Limit == source.Size;
+        chunk.Tokens = TokenStorage{ chunk.Limit - chunk.Begin };
 
-    [[nodiscard]] static auto IsDot(const QString& source, const i32& currentIndex) noexcept
-    {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        return (current == QChar(u'.'));
-    }
+        auto currentIndex = chunk.Begin;
+        while ((isLast || currentIndex < chunk.Limit) && LexToken(chunk.Tokens, source, currentIndex))
+        {
+        }
 
-    [[nodiscard]] static auto IsEOF(const QString& source, const i32& currentIndex) noexcept
-    {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        return (current == QChar(u'\0'));
+        chunk.End = currentIndex;
     }
 
-    [[nodiscard]] static auto IsDigit(const QString& source, const i32& currentIndex) noexcept
+    // Collects re-lexed tokens until one of them starts at the same place as an old token after the edit,
+    // from there on the old tokens are still valid
+    struct RelexBuffer
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        return current.isNumber();
-    }
+        TokenStorage Tokens;
+        const TokenStorage& OldTokens;
+        i32 EditEnd;
+        i32 TailDelta;
+        i32 SyncIndex = -1;
 
-    [[nodiscard]] static auto IsSpace(const QString& source, const i32& currentIndex) noexcept
-    {
-        const auto current = PeekCurrentChar(source, currentIndex);
+        void addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes = false) noexcept
+        {
+            if (start >= EditEnd)
+            {
+                const auto oldStart = start - TailDelta;
+                const auto index = OldTokens.findToken(oldStart);
+                if (index < OldTokens.size()
+                    && OldTokens.start(index) == oldStart
+                    && OldTokens.kind(index) == kind
+                    && OldTokens.length(index) == end - start)
+                {
+                    SyncIndex = index;
+                    return;
+                }
+            }
 
-        return current == QChar(u'\u0009')
-            || current == QChar(u'\u000b')
-            || current == QChar(u'\u0020')
-            || current == QChar(u'\u00a0')
-            || current == QChar(u'\u1680')
-            || current == QChar(u'\u2000')
-            || current == QChar(u'\u2001')
-            || current == QChar(u'\u2002')
-            || current == QChar(u'\u2003')
-            || current == QChar(u'\u2004')
-            || current == QChar(u'\u2005')
-            || current == QChar(u'\u2006')
-            || current == QChar(u'\u2007')
-            || current == QChar(u'\u2008')
-            || current == QChar(u'\u2009')
-            || current == QChar(u'\u200a')
-            || current == QChar(u'\u202f')
-            || current == QChar(u'\u205f')
-            || current == QChar(u'\u3000');
-    }
+            Tokens.addToken(kind, start, end, hasEscapes);
+        }
+    };
 
-    [[nodiscard]] static BoolSizePair IsEscapeSequence(const QString& source, const i32& currentIndex) noexcept
+    // Same as EatBlockComment but resumable, it stops one unit before the end
+    // because a "*/" or "/*" might be split across two chunks
+    static auto SkipBlockCommentBody(const Utf8Source& source, i32& currentIndex, i32& nestingLevel) noexcept
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        const auto next = PeekNextChar(source, currentIndex);
-
-        if (current != QChar(u'\\'))
-            return { .Bool = false, .Size = 1 };
-
-        switch (next.unicode())
+        while (nestingLevel > 0 && currentIndex + 1 < source.Size)
         {
-            case u'n': // Line Feed
-            case u'r': // Carriage Return
-            case u't': // Character Tabulation (Tab)
-            case u'\\': // Reverse Solidus (Backslash)
-            case u'\"': // Quotation Mark (Double Quote)
-            case u'b': // Backspace
-            case u'f': // Form Feed
-            case u's': // Space
+            const auto current = source.Data[currentIndex];
+            const auto next = source.Data[currentIndex + 1];
+            if (current == '*' && next == '/')
             {
-                return { .Bool = true, .Size = 2 };
+                currentIndex += 2;
+                nestingLevel--;
             }
-            case u'u':  // Unicode Escape
+            else if (current == '/' && next == '*')
             {
-                auto escapeIndex = currentIndex + 2;
-                if (PeekCurrentChar(source, escapeIndex) != QChar('{'))
-                    break;
-                escapeIndex++;
-
-                auto hexCharCount = 0;
-                while (hexCharCount != 6 && IsHexadecimal(PeekCurrentChar(source, escapeIndex)))
-                {
-                    escapeIndex++;
-                    hexCharCount++;
-                }
-
-                if (PeekCurrentChar(source, escapeIndex) != QChar('}'))
-                    break;
-                escapeIndex++;
-
-                uint length = (escapeIndex - currentIndex);
-                return { .Bool = true, .Size = length };
+                currentIndex += 2;
+                nestingLevel++;
+            }
+            else
+            {
+                currentIndex++;
             }
-            default:
-                if (IsSpace(source, currentIndex + 1))  // Whitespace Escape
-                {
-                    auto escapeIndex = currentIndex + 2;
-                    while (IsSpace(source, escapeIndex))
-                    {
-                        escapeIndex++;
-                    }
-
-                    uint length = (escapeIndex - currentIndex);
-                    return { .Bool = true, .Size = length };
-                }
-                break;  // TODO \ followed by any other character isnt allowed, handle error
         }
-
-        return { .Bool = false, .Size = 1 };
     }
 
-    [[nodiscard]] static BoolSizePair IsNewline(const QString& source, const i32& currentIndex) noexcept
+    // Same as EatLineComment but resumable, returns true once the comment has ended
+    static auto SkipLineCommentBody(const Utf8Source& source, i32& currentIndex, bool isLastChunk) noexcept
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        const auto next = PeekCurrentChar(source, currentIndex + 1);
+        while (currentIndex < source.Size)
+        {
+            source.ReachedEnd = false;
+            const auto result = IsNewline(source, currentIndex);
+            if (source.ReachedEnd && !isLastChunk)
+                return false;
 
-        if (current == QChar(u'\r') && next == QChar(u'\n'))    // Carriage Return Line Feed
-            return { .Bool = true, .Size = 2 };
+            if (result.Bool || source.Data[currentIndex] == '\0')
+                return true;
 
-        if (current == QChar(u'\r')                             // Carriage Return
-            || current == QChar(u'\n')                          // Line Feed
-            || current == QChar(u'\f')                          // Form Feed
-            || current == QChar(u'\u0085')                      // Next Line
-            || current == QChar(u'\u2028')                      // Line Separator
-            || current == QChar(u'\u2029'))                     // Paragraph Separator
-            return { .Bool = true, .Size = 1 };
+            currentIndex++;
+        }
 
-        return { .Bool = false, .Size = 0 };
+        return isLastChunk;
     }
 
-    [[nodiscard]] static BoolSizePair IsEqual(const QString& source, const i32& currentIndex) noexcept
+    // Every byte but continuation bytes starts a code point, those of four bytes take a surrogate pair
+    [[nodiscard]] static i64 Utf16Length(QByteArrayView bytes) noexcept
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
-        const auto next = PeekCurrentChar(source, currentIndex + 1);
-
-        if (current == QChar(u'=')
-            || current == QChar(u'\ufe66')                      // Small Equal Sign
-            || current == QChar(u'\uff1d'))                     // Fullwidth Equal Sign
-            return { .Bool = true, .Size = 1 };
-
-        if (current == QChar(0xD83D) && next == QChar(0xDFF0))  // Heavy Equal Sign
-            return { .Bool = true, .Size = 2 };
+        auto length = i64(0);
+        for (auto index = qsizetype(0); index < bytes.size(); index++)
+        {
+            const auto byte = static_cast<u8>(bytes[index]);
+            length += (byte & 0xC0) != 0x80;
+            length += byte >= 0xF0;
+        }
 
-        return { .Bool = false, .Size = 0 };
+        return length;
     }
+}
 
-    [[nodiscard]] static auto IsDisallowedIdentifierChar(const QString& source, const i32& currentIndex) noexcept
+namespace KDL
+{
+    TokenBuffer Lex(const QString& source) noexcept
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
+        TokenBuffer buffer{ source };
+        const auto utf16Source = Utf16Source{ .Data = source.utf16(), .Size = i32(source.size()) };
+        LexSource(buffer, utf16Source);
 
-        return current == QChar(u'\\')
-            || current == QChar(u'/')
-            || current == QChar(u'(')
-            || current == QChar(u')')
-            || current == QChar(u'{')
-            || current == QChar(u'}')
-            || current == QChar(u';')
-            || current == QChar(u'[')
-            || current == QChar(u']')
-            || current == QChar(u'\"')
-            || current == QChar(u'#');
+        return buffer;
     }
 
-    [[nodiscard]] static auto IsDisallowedLiteralCodePoints(const QString& source, const i32& currentIndex) noexcept
+    TokenBuffer Lex(const char* source) noexcept
     {
-        const auto current = PeekCurrentChar(source, currentIndex);
-
-        return (current >= QChar(u'\u0000') && current <= QChar(u'\u0008'))
-            || (current >= QChar(u'\u000e') && current <= QChar(u'\u001f')) // various control characters
-            || current == QChar(u'\u007f')                                  // delete control character
-            || (current >= QChar(u'\u200e') && current <= QChar(u'\u200f')) // unicode "direction control" characters
-            || (current >= QChar(u'\u202a') && current <= QChar(u'\u202e')) // unicode "direction control" characters
-            || (current >= QChar(u'\u2066') && current <= QChar(u'\u2069')) // unicode "direction control" characters
-            || current == QChar(u'\ufeff');                                 // zero-width non-breaking space / byte order mark 
+        return Lex(QString::fromUtf8(source));
     }
 
-    [[nodiscard]] static auto IsIdentifierChar(const QString& source, const i32& currentIndex) noexcept
+    std::optional<Utf8TokenBuffer> LexFile(const QString& path) noexcept
     {
-        return !IsSpace(source, currentIndex)
-            && !IsNewline(source, currentIndex).Bool
-            && !IsDisallowedIdentifierChar(source, currentIndex)
-            && !IsDisallowedLiteralCodePoints(source, currentIndex)
-            && !IsEqual(source, currentIndex).Bool;
-    }
+        auto file = QFile(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return std::nullopt;
 
-    static auto NumberType(const QChar c, const QChar n) noexcept
-    {
-        if (c == QChar(u'0'))
-        {
-            if (n == QChar(u'b'))
-                return TokenKind::Number_Binary;
-            if (n == QChar(u'o'))
-                return TokenKind::Number_Octal;
-            if (n == QChar(u'x'))
-                return TokenKind::Number_Hexadecimal;
-        }
-        return TokenKind::Number_Decimal;
-    }
+        const auto fileSize = file.size();
+        if (fileSize > std::numeric_limits<i32>::max())
+            return std::nullopt;
 
-    static std::function<bool(const QChar)> NumberPredicate(TokenKind type)
-    {
-        switch (type)
+        // Mapping costs more than reading for small files, those are read into a single buffer instead
+        auto mapping = fileSize >= MinimumMappedFileSize ? MapFile(file, fileSize) : nullptr;
+        if (mapping == nullptr)
         {
-            case TokenKind::Number_Binary:
-                return [](const QChar c) {return IsBinary(c); };
-            case TokenKind::Number_Octal:
-                return [](const QChar c) {return IsOctal(c); };
-            case TokenKind::Number_Hexadecimal:
-                return [](const QChar c) {return IsHexadecimal(c); };
-            case TokenKind::Number_Decimal:
-                return [](const QChar c) {return c.isNumber(); };
-            default:
-                __debugbreak();
+            auto source = file.readAll();
+            if (source.startsWith("\xEF\xBB\xBF"))
+                source.remove(0, 3);
+
+            return Lex(source);
         }
-    }
 
-    static auto LexKeyword(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
-    {
-        const auto startIndex = currentIndex;
-        currentIndex++;
+        // Batches keep many buffers at once, they shouldn't each keep a file descriptor open
+        file.close();
 
-        if (PeekCurrentChar(source, currentIndex) == QChar(u'-'))
-            currentIndex++;
+        const auto mapped = mapping->bytes();
+        const auto byteOrderMarkSize = mapped.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+        const auto source = QByteArray::fromRawData(mapped.data() + byteOrderMarkSize, mapped.size() - byteOrderMarkSize);
 
-        while (PeekCurrentChar(source, currentIndex).isLetter())
-            currentIndex++;
+        Utf8TokenBuffer buffer{ source, std::move(mapping) };
+        const auto utf8Source = Utf8Source{ .Data = reinterpret_cast<const u8*>(source.constData()), .Size = i32(source.size()) };
+        LexSource(buffer, utf8Source);
 
-        const auto length = currentIndex - startIndex;
-        const auto keyword = source.sliced(startIndex, length);
-        if (keyword == QString("#true"))
-        {
-            tokenBuffer.addToken(TokenKind::Keyword_True, startIndex, currentIndex);
-        }
-        else if (keyword == QString("#false"))
-        {
-            tokenBuffer.addToken(TokenKind::Keyword_False, startIndex, currentIndex);
-        }
-        else if (keyword == QString("#nan"))
-        {
-            tokenBuffer.addToken(TokenKind::Keyword_NaN, startIndex, currentIndex);
-        }
-        else if (keyword == QString("#inf"))
-        {
-            tokenBuffer.addToken(TokenKind::Keyword_Infinity, startIndex, currentIndex);
-        }
-        else if (keyword == QString("#-inf"))
-        {
-            tokenBuffer.addToken(TokenKind::Keyword_NegativeInfinity, startIndex, currentIndex);
-        }
-        else if (keyword == QString("#null"))
-        {
-            tokenBuffer.addToken(TokenKind::Keyword_Null, startIndex, currentIndex);
-        }
-        else
-        {
-            currentIndex = startIndex;
-            return false;
-        }
-
-        return true;
-    };
+        return buffer;
+    }
 
-    static auto TryLexNumber(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
+    std::vector<std::optional<Utf8TokenBuffer>> LexFiles(const QStringList& paths, const BatchOptions& options)
     {
-        const auto startIndex = currentIndex;
+        return ProcessFiles<std::optional<Utf8TokenBuffer>>(paths, options, [](const QString& path) { return LexFile(path); });
+    }
 
-        auto currentChar = PeekCurrentChar(source, currentIndex);
-        auto nextChar = PeekNextChar(source, currentIndex);
-        if (IsSign(source, currentIndex))
+    TokenBuffer LexParallel(const QString& source, i32 threadCount) noexcept
+    {
+        if (threadCount <= 0)
+            threadCount = QThread::idealThreadCount();
+
+        const auto chunkCount = std::min(threadCount * ChunksPerThread, i32(source.size() / MinimumParallelChunkSize));
+        if (threadCount == 1 || chunkCount <= 1)
+            return Lex(source);
+
+        const auto utf16Source = Utf16Source{ .Data = source.utf16(), .Size = i32(source.size()) };
+        auto chunks = SplitAtNewlines(utf16Source, chunkCount);
+
+        QThreadPool threadPool{};
+        threadPool.setMaxThreadCount(threadCount);
+        for (auto& chunk : chunks)
+            threadPool.start([&chunk, &utf16Source]() { LexChunk(chunk, utf16Source); });
+        threadPool.waitForDone();
+
+        // The lexer carries no state between tokens and ends each call at the end of the token it added, so
+        // once the real lexer is where a chunk started, or has added the same token as the chunk, the rest of
+        // that chunk is correct. A token that merely starts at the same place isn't enough, a line continuation
+        // followed by something else reports an error token that lexing from its start would not. Otherwise the
+        // chunk began inside a string or comment and is lexed again until the two line up.
+        TokenBuffer buffer{ source };
+        auto currentIndex = 0;
+        for (const auto& chunk : chunks)
         {
-            if (nextChar.isNumber())
-            {
-                currentIndex += 2;
-            }
-            else
+            while (true)
             {
-                return false;
-            }
-        }
-
-        currentChar = PeekCurrentChar(source, currentIndex);
-        if (!currentChar.isNumber())
-            return false;
-
-        nextChar = PeekNextChar(source, currentIndex);
-        const auto numberType = NumberType(currentChar, nextChar);
-        const auto predicate = NumberPredicate(numberType);
-
-        auto matchNumbersAndUnderscores = [&]()
-            {
-                currentChar = PeekCurrentChar(source, currentIndex);
-                while (predicate(currentChar))
+                if (currentIndex == chunk.Begin)
                 {
-                    currentIndex++;
-                    currentChar = PeekCurrentChar(source, currentIndex);
-
-                    nextChar = PeekNextChar(source, currentIndex);
-                    while (currentChar == QChar(u'_') && predicate(nextChar))
-                    {
-                        currentIndex += 2;
-                        currentChar = PeekCurrentChar(source, currentIndex);
-                        nextChar = PeekNextChar(source, currentIndex);
-                    }
+                    buffer.appendTokens(chunk.Tokens, 0);
+                    currentIndex = chunk.End;
+                    break;
                 }
-            };
 
-        if (numberType != TokenKind::Number_Decimal)
-        {
-            currentIndex += 2;
-
-            matchNumbersAndUnderscores();
-
-            tokenBuffer.addToken(numberType, startIndex, currentIndex);
-            return true;
-        }
-        else  // Decimal
-        {
-            matchNumbersAndUnderscores();
+                if (currentIndex >= chunk.End)
+                    break;
 
-            if (currentChar == QChar(u'.') && PeekNextChar(source, currentIndex).isNumber())
-            {
-                currentIndex++;
+                const auto& tokens = buffer.storage();
+                const auto tokenCount = tokens.size();
+                if (!LexToken(buffer, utf16Source, currentIndex))
+                    return buffer;
 
-                matchNumbersAndUnderscores();
-            }
+                if (tokens.size() == tokenCount)
+                    continue;
 
-            nextChar = PeekNextChar(source, currentIndex);
-            while (currentChar.toLower() == QChar(u'e') && (nextChar == QChar(u'+') || nextChar == QChar(u'-') || nextChar.isNumber()))
-            {
-                if (nextChar == QChar(u'+') || nextChar == QChar(u'-'))
-                {
-                    currentIndex += 2;
-                }
-                else
+                const auto last = tokens.size() - 1;
+                const auto first = chunk.Tokens.findToken(tokens.start(last));
+                if (first < chunk.Tokens.size()
+                    && chunk.Tokens.start(first) == tokens.start(last)
+                    && chunk.Tokens.kind(first) == tokens.kind(last)
+                    && chunk.Tokens.length(first) == tokens.length(last))
                 {
-                    currentIndex++;
+                    buffer.appendTokens(chunk.Tokens, first + 1);
+                    currentIndex = chunk.End;
+                    break;
                 }
-
-                matchNumbersAndUnderscores();
             }
 
-            tokenBuffer.addToken(TokenKind::Number_Decimal, startIndex, currentIndex);
-            return true;
+            const auto& tokens = buffer.storage();
+            if (tokens.size() > 0 && tokens.kind(tokens.size() - 1) == TokenKind::EndOfFile)
+                return buffer;
         }
 
-        return false;
+        // A token that ran past the last chunk, the end of file token is still missing
+        while (LexToken(buffer, utf16Source, currentIndex))
+        {
+        }
+
+        return buffer;
     }
 
-    static auto TryLexQuotedString(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
+    void Relex(TokenBuffer& tokens, i32 editStart, i32 editEnd, QStringView newText) noexcept
     {
-        const auto startIndex = currentIndex;
-        if (!IsQuote(source, currentIndex))
-            return false;
+        const auto& oldTokens = tokens.storage();
 
-        currentIndex++;
+        // Newline tokens are never part of a string or comment, so the lexer is in
+        // its initial state at their start
+        auto first = oldTokens.findToken(editStart);
+        while (first > 0 && oldTokens.kind(first - 1) != TokenKind::Newline)
+            first--;
 
-        while (true)
+        auto currentIndex = 0;
+        if (first > 0)
         {
-            if (auto result = IsEscapeSequence(source, currentIndex); result.Bool)
-            {
-                currentIndex += result.Size;
-                continue;
-            }
-
-            if (!IsQuote(source, currentIndex) && !IsEOF(source, currentIndex))
-            {
-                currentIndex++;
-                continue;
-            }
+            first--;
+            currentIndex = oldTokens.start(first);
+        }
 
-            if (!IsEOF(source, currentIndex))
-                currentIndex++;
+        const auto tailDelta = i32(newText.size()) - (editEnd - editStart);
+        tokens.replaceSource(editStart, editEnd, newText);
 
-            break;
+        const auto& source = tokens.source();
+        const auto utf16Source = Utf16Source{ .Data = source.utf16(), .Size = i32(source.size()) };
+        RelexBuffer buffer{ .Tokens = {}, .OldTokens = oldTokens, .EditEnd = editStart + i32(newText.size()), .TailDelta = tailDelta };
+        while (LexToken(buffer, utf16Source, currentIndex) && buffer.SyncIndex < 0)
+        {
         }
 
-        tokenBuffer.addToken(TokenKind::Identifier_QuotedString, startIndex, currentIndex);
-        return true;
+        const auto last = buffer.SyncIndex < 0 ? oldTokens.size() : buffer.SyncIndex;
+        tokens.replaceTokens(first, last, buffer.Tokens, tailDelta);
     }
 
-    static auto TryLexRawString(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
+    Utf8TokenBuffer Lex(const QByteArray& source) noexcept
     {
-        const auto startIndex = currentIndex;
-        auto startHashCount = 0;
-        while (IsHash(source, currentIndex))
-        {
-            currentIndex++;
-            startHashCount++;
-        }
+        Utf8TokenBuffer buffer{ source };
+        const auto utf8Source = Utf8Source{ .Data = reinterpret_cast<const u8*>(source.constData()), .Size = i32(source.size()) };
+        LexSource(buffer, utf8Source);
+
+        return buffer;
+    }
 
-        if (!IsQuote(source, currentIndex))
+    Utf8TokenBuffer Lex(QByteArrayView source) noexcept
+    {
+        return Lex(QByteArray::fromRawData(source.constData(), source.size()));
+    }
+
+    void PushLexer::append(QByteArrayView bytes)
+    {
+        const auto dropCount = i32(keptOffset() - m_bufferOffset);
+        m_bufferUtf16Offset += Utf16Length(QByteArrayView(m_buffer.constData(), dropCount));
+        if (m_countedIndex < dropCount)
         {
-            currentIndex = startIndex;
-            return false;
+            m_countedUtf16Offset += Utf16Length(QByteArrayView(m_buffer.constData() + m_countedIndex, dropCount - m_countedIndex));
+            m_countedIndex = dropCount;
         }
-        currentIndex++;
 
+        m_buffer.remove(0, dropCount);
+        m_bufferOffset += dropCount;
+        m_currentIndex -= dropCount;
+        m_countedIndex -= dropCount;
+        m_buffer.append(bytes);
+    }
+
+    void PushLexer::finish() noexcept
+    {
+        m_isFinished = true;
+    }
+
+    bool PushLexer::isFinished() const noexcept
+    {
+        return m_isFinished;
+    }
+
+    std::optional<Utf8Token> PushLexer::nextToken() noexcept
+    {
         while (true)
         {
-            if (!IsQuote(source, currentIndex) && !IsEOF(source, currentIndex))
+            const auto source = Utf8Source{ .Data = reinterpret_cast<const u8*>(m_buffer.constData()), .Size = i32(m_buffer.size()) };
+            auto currentIndex = m_currentIndex;
+
+            if (m_blockCommentNestingLevel > 0)
             {
-                currentIndex++;
+                SkipBlockCommentBody(source, currentIndex, m_blockCommentNestingLevel);
+                m_currentIndex = currentIndex;
+                if (m_blockCommentNestingLevel > 0)
+                {
+                    if (!m_isFinished)
+                        return std::nullopt;
+
+                    // Unterminated, the comment runs to the end of the source
+                    m_blockCommentNestingLevel = 0;
+                    m_currentIndex = source.Size;
+                }
                 continue;
             }
 
-            if (IsQuote(source, currentIndex))
+            if (m_isInLineComment)
             {
-                currentIndex++;
-                auto endHasCount = 0;
+                m_isInLineComment = !SkipLineCommentBody(source, currentIndex, m_isFinished);
+                m_currentIndex = currentIndex;
+                if (m_isInLineComment)
+                    return std::nullopt;
+                continue;
+            }
 
-                while (IsHash(source, currentIndex))
+            if (m_quoteSearchOffset >= 0 && !m_isFinished)
+            {
+                const auto searchIndex = m_quoteSearchOffset - m_bufferOffset;
+                if (std::memchr(source.Data + searchIndex, '"', static_cast<size_t>(source.Size - searchIndex)) == nullptr)
                 {
-                    currentIndex++;
-                    endHasCount++;
+                    m_quoteSearchOffset = m_bufferOffset + source.Size;
+                    return std::nullopt;
                 }
+            }
+            m_quoteSearchOffset = -1;
 
-                if (startHashCount == endHasCount)
-                    break;
+            // Comments are skipped here instead of by LexToken so they never have to fit into memory
+            if (currentIndex < source.Size && source.Data[currentIndex] == '/')
+            {
+                if (currentIndex + 1 == source.Size && !m_isFinished)
+                    return std::nullopt;
 
-                continue;
+                const auto next = PeekNextChar(source, currentIndex);
+                if (next == U'*' || next == U'/')
+                {
+                    m_currentIndex = currentIndex + 2;
+                    m_blockCommentNestingLevel = next == U'*' ? 1 : 0;
+                    m_isInLineComment = next == U'/';
+                    continue;
+                }
             }
-            else if (!IsEOF(source, currentIndex))
-                currentIndex++;
-
-            break;
-        }
 
-        tokenBuffer.addToken(TokenKind::Identifier_RawString, startIndex, currentIndex);
-        return true;
-    }
-    static auto TryLexDottedIdentifier(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
-    {
-        const auto startIndex = currentIndex;
-        if (IsSign(source, currentIndex))
-            currentIndex++;
+            // The token might continue in input that hasn't arrived yet, lex it again once there is more
+            SingleTokenBuffer token{};
+            source.ReachedEnd = false;
+            LexToken(token, source, currentIndex);
+            if (source.ReachedEnd && !m_isFinished)
+            {
+                // Lexing a long string again for every piece of it would take quadratic time
+                auto index = m_currentIndex;
+                while (index < source.Size && source.Data[index] == '#')
+                    index++;
 
-        if (!IsDot(source, currentIndex))
-            return false;
+                const auto last = source.Data[source.Size - 1];
+                if (index + 1 < source.Size && source.Data[index] == '"' && last != '"' && last != '#')
+                    m_quoteSearchOffset = m_bufferOffset + source.Size;
 
-        currentIndex++;
+                return std::nullopt;
+            }
 
-        if (IsIdentifierChar(source, currentIndex) && !IsDigit(source, currentIndex))
-            currentIndex++;
+            const auto lexIndex = std::exchange(m_currentIndex, currentIndex);
+            if (!token.HasToken)
+                continue;
 
-        while (IsIdentifierChar(source, currentIndex))
-        {
-            currentIndex++;
+            m_tokenOffset = m_bufferOffset + token.Start;
+            m_lexOffset = m_bufferOffset + lexIndex;
+            m_countedUtf16Offset += Utf16Length(QByteArrayView(m_buffer.constData() + m_countedIndex, token.Start - m_countedIndex));
+            m_countedIndex = token.Start;
+            const auto stringView = QUtf8StringView(m_buffer.constData() + token.Start, token.End - token.Start);
+            return Utf8Token{ .kind = token.Kind, .stringView = stringView, .hasEscapes = token.HasEscapes };
         }
+    }
 
-        tokenBuffer.addToken(TokenKind::Identifier, startIndex, currentIndex);
-        return true;
+    i64 PushLexer::tokenOffset() const noexcept
+    {
+        return m_tokenOffset;
     }
 
-    static auto TryLexSignedIdentifier(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
+    i64 PushLexer::tokenUtf16Offset() const noexcept
     {
-        const auto startIndex = currentIndex;
-        if (!IsSign(source, currentIndex))
-            return false;
+        return m_countedUtf16Offset;
+    }
 
-        currentIndex++;
+    i64 PushLexer::lexOffset() const noexcept
+    {
+        return m_lexOffset;
+    }
 
-        if (IsIdentifierChar(source, currentIndex) && !IsDigit(source, currentIndex) && !IsDot(source, currentIndex))
-            currentIndex++;
+    void PushLexer::retain(std::optional<i64> offset) noexcept
+    {
+        m_retainedOffset = offset.value_or(-1);
+    }
 
-        while (IsIdentifierChar(source, currentIndex))
-        {
-            currentIndex++;
-        }
+    QByteArrayView PushLexer::bytes(i64 start, i64 end) const noexcept
+    {
+        return QByteArrayView(m_buffer.constData() + (start - m_bufferOffset), end - start);
+    }
 
-        tokenBuffer.addToken(TokenKind::Identifier, startIndex, currentIndex);
-        return true;
+    i64 PushLexer::utf16Offset(i64 offset) const noexcept
+    {
+        return m_bufferUtf16Offset + Utf16Length(QByteArrayView(m_buffer.constData(), offset - m_bufferOffset));
     }
 
-    static auto TryLexUnambiguousIdentifier(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
+    i64 PushLexer::pendingBytes() const noexcept
     {
-        const auto startIndex = currentIndex;
-        if (IsIdentifierChar(source, currentIndex) && !IsDigit(source, currentIndex) && !IsSign(source, currentIndex) && !IsDot(source, currentIndex))
-            currentIndex++;
-        else
-            return false;
+        return m_buffer.size() - m_currentIndex;
+    }
 
-        while (IsIdentifierChar(source, currentIndex))
-        {
-            currentIndex++;
-        }
+    i64 PushLexer::keptOffset() const noexcept
+    {
+        // Everything before the current index has been handed out already, unless it is retained
+        const auto offset = m_bufferOffset + m_currentIndex;
+        return m_retainedOffset >= 0 ? std::min(offset, m_retainedOffset) : offset;
+    }
 
-        tokenBuffer.addToken(TokenKind::Identifier, startIndex, currentIndex);
-        return true;
+    i64 PushLexer::keptBytes() const noexcept
+    {
+        return m_bufferOffset + m_buffer.size() - keptOffset();
     }
 
-    static auto TryLexIdentifier(TokenBuffer& tokenBuffer, const QString& source, i32& currentIndex) noexcept
+    i64 PushLexer::allocatedBytes() const noexcept
     {
-        if (IsHash(source, currentIndex))
-        {
-            if (!IsHash(source, currentIndex + 1) && !IsQuote(source, currentIndex + 1))
-            {
-                return LexKeyword(tokenBuffer, source, currentIndex);
-            }
-            return TryLexRawString(tokenBuffer, source, currentIndex);
-        }
-        else if (IsQuote(source, currentIndex))
-        {
-            return TryLexQuotedString(tokenBuffer, source, currentIndex);
-        }
-        else if ((IsSign(source, currentIndex) && IsDot(source, currentIndex))
-            || IsDot(source, currentIndex))
-        {
-            return TryLexDottedIdentifier(tokenBuffer, source, currentIndex);
-        }
-        else if (IsSign(source, currentIndex))
-        {
-            return TryLexSignedIdentifier(tokenBuffer, source, currentIndex);
-        }
-        else
-        {
-            return TryLexUnambiguousIdentifier(tokenBuffer, source, currentIndex);
-        }
+        return m_buffer.capacity();
+    }
 
-        return false;
+    Lexer::Lexer(QIODevice& device, i32 chunkSize)
+        : m_device{ device }
+        , m_chunkSize{ std::max(chunkSize, 1) }
+    {
     }
 
-    static auto EatLineComment(const QString& source, i32& currentIndex) noexcept
+    Utf8Token Lexer::nextToken() noexcept
     {
-        currentIndex += 2;
         while (true)
         {
-            if (const auto result = IsNewline(source, currentIndex); !result.Bool)
-            {
-                if (IsEOF(source, currentIndex))
-                    return;
+            if (const auto token = m_lexer.nextToken())
+                return *token;
 
-                currentIndex++;
-            }
-            else
-            {
-                currentIndex += result.Size;
-                return;
-            }
+            readMore();
         }
     }
 
-    static auto EatBlockComment(const QString& source, i32& currentIndex) noexcept
+    i64 Lexer::tokenOffset() const noexcept
     {
-        currentIndex += 2;
-        auto nestingLevel = 1;
-        while (true)
-        {
-            if (PeekCurrentChar(source, currentIndex) == QChar(u'*') && PeekNextChar(source, currentIndex) == QChar(u'/'))
-            {
-                currentIndex += 2;
-                nestingLevel--;
-            }
-            else if (PeekCurrentChar(source, currentIndex) == QChar(u'/') && PeekNextChar(source, currentIndex) == QChar(u'*'))
-            {
-                currentIndex += 2;
-                nestingLevel++;
-            }
-            else
-            {
-                currentIndex++;
-            }
-
-            if (nestingLevel == 0)
-                return;
-        }
+        return m_lexer.tokenOffset();
     }
-}
 
-namespace KDL
-{
-    TokenBuffer Lex(const QString& source) noexcept
+    i64 Lexer::allocatedBytes() const noexcept
     {
-        TokenBuffer buffer{ source };
-        i32 currentIndex = 0;
+        return m_lexer.allocatedBytes() + m_chunk.capacity();
+    }
 
+    void Lexer::readMore() noexcept
+    {
+        // Grow geometrically so a token spanning many chunks is only lexed again a logarithmic number of times
+        const auto readSize = std::max(qint64(m_chunkSize), m_lexer.pendingBytes());
+        m_chunk.resize(readSize);
         while (true)
         {
-            auto current = PeekCurrentChar(source, currentIndex);
-            switch (current.unicode())
+            const auto bytesRead = m_device.read(m_chunk.data(), readSize);
+            if (bytesRead > 0)
             {
-                case u'(':
-                {
-                    buffer.addToken(TokenKind::OpenParenthesis, currentIndex, currentIndex + 1);
-                    currentIndex++;
-                    break;
-                }
-                case u')':
-                {
-                    buffer.addToken(TokenKind::CloseParenthesis, currentIndex, currentIndex + 1);
-                    currentIndex++;
-                    break;
-                }
-                case u'{':
-                {
-                    buffer.addToken(TokenKind::OpenBracket, currentIndex, currentIndex + 1);
-                    currentIndex++;
-                    break;
-                }
-                case u'}':
-                {
-                    buffer.addToken(TokenKind::CloseBracket, currentIndex, currentIndex + 1);
-                    currentIndex++;
-                    break;
-                }
-                case u';':
-                {
-                    buffer.addToken(TokenKind::Terminator, currentIndex, currentIndex + 1);
-                    currentIndex++;
-                    break;
-                }
-                case u'\0':
-                {
-                    buffer.addToken(TokenKind::EndOfFile, currentIndex, currentIndex);
-                    return buffer;
-                }
-                case u'/':
-                {
-                    if (PeekNextChar(source, currentIndex) == QChar(u'-')) // Slash dash
-                    {
-                        buffer.addToken(TokenKind::SlashDash, currentIndex, currentIndex + 2);
-                        currentIndex += 2;
-                        break;
-                    }
-                    else if (PeekNextChar(source, currentIndex) == QChar(u'/')) // Line comments
-                    {
-                        EatLineComment(source, currentIndex);
-                        break;
-                    }
-                    else if (PeekNextChar(source, currentIndex) == QChar(u'*')) // Block comments
-                    {
-                        EatBlockComment(source, currentIndex);
-                        break;
-                    }
-                    [[fallthrough]];
-                }
-                case u'\\': // Line continuation
-                {
-                    // we need to check current again for the fallthrough
-                    if (current == QChar(u'\\') &&
-                            (IsEOF(source, currentIndex + 1)
-                            || IsSpace(source, currentIndex + 1)
-                            || (PeekNextChar(source, currentIndex) == QChar(u'/') && PeekNextChar(source, currentIndex + 1) == QChar(u'/'))
-                            || (PeekNextChar(source, currentIndex) == QChar(u'/') && PeekNextChar(source, currentIndex + 1) == QChar(u'*'))
-                            || IsNewline(source, currentIndex + 1).Bool))
-                    {
-                        currentIndex++;
-
-                        while (IsSpace(source, currentIndex))
-                        {
-                            currentIndex++;
-                        }
-
-                        if (PeekCurrentChar(source, currentIndex) == QChar(u'/') && PeekNextChar(source, currentIndex) == QChar(u'/'))
-                        {
-                            EatLineComment(source, currentIndex);
-                            break;
-                            // eat newline
-                        }
-                        else if (PeekCurrentChar(source, currentIndex) == QChar(u'/') && PeekNextChar(source, currentIndex) == QChar(u'*'))
-                        {
-                            EatBlockComment(source, currentIndex);
-                        }
-                        
-                        while (IsSpace(source, currentIndex))
-                        {
-                            currentIndex++;
-                        }
-
-                        if (const auto result = IsNewline(source, currentIndex); result.Bool || IsEOF(source, currentIndex))
-                        {
-                            currentIndex += result.Size;
-                            break;
-                        }
-                        else
-                        {
-                            buffer.addToken(TokenKind::Error, currentIndex, currentIndex + 1);
-                            currentIndex++;
-                            break;
-                        }
-                        break;
-                    }
-                    [[fallthrough]];
-                }
-                default:
-                {
-                    if (auto result = IsNewline(source, currentIndex); result.Bool)
-                    {
-                        buffer.addToken(TokenKind::Newline, currentIndex, currentIndex + result.Size);
-                        currentIndex += result.Size;
-                        break;
-                    }
-                    else if (IsSpace(source, currentIndex))
-                    {
-                        currentIndex++;
-                        break;
-                    }
-                    else if (auto result = IsEqual(source, currentIndex); result.Bool)
-                    {
-                        buffer.addToken(TokenKind::Equal, currentIndex, currentIndex + result.Size);
-                        currentIndex += result.Size;
-                        break;
-                    }
-                    else if (TryLexNumber(buffer, source, currentIndex))
-                    {
-                        break;
-                    }
-                    else if (TryLexIdentifier(buffer, source, currentIndex))
-                    {
-                        break;
-                    }
-                    else if (IsDisallowedIdentifierChar(source, currentIndex) || IsDisallowedLiteralCodePoints(source, currentIndex))
-                    {
-                        buffer.addToken(TokenKind::Error, currentIndex, currentIndex + 1);
-                        currentIndex++;
-                        break;
-                    }
-
-                    buffer.addToken(TokenKind::Unknown, currentIndex, currentIndex + 1);
-                    currentIndex++;
-                    break;
-                }
+                m_lexer.append(QByteArrayView(m_chunk.constData(), bytesRead));
+                return;
             }
-        }
 
-        return buffer;
+            // Sequential devices like sockets and pipes may just not have received more data yet
+            if (bytesRead < 0 || !m_device.isSequential() || !m_device.waitForReadyRead(-1))
+            {
+                m_lexer.finish();
+                return;
+            }
+        }
     }
 }
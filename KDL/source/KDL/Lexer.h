@@ -2,9 +2,140 @@
 
 #include <KDL/API.h>
 #include <KDL/TokenBuffer.h>
+#include <KDL/Utf8TokenBuffer.h>
+#include <KDL/Utf8Token.h>
+#include <Defines.h>
 #include <QString>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+#include <QStringList>
+
+#include <optional>
+#include <vector>
 
 namespace KDL
 {
     KDL_API [[nodiscard]] TokenBuffer Lex(const QString& source) noexcept;
+    // Picks the QString overload for string literals, which would be ambiguous with the UTF-8 ones below
+    KDL_API [[nodiscard]] TokenBuffer Lex(const char* source) noexcept;
+
+    // Memory maps the file and lexes the UTF-8 bytes in place, a leading byte order mark is skipped.
+    // The tokens view the mapping, which stays alive as long as the returned buffer.
+    // Files below 64 KiB are read into memory instead since mapping them is slower than reading.
+    // Returns nothing if the file can't be opened or is too large for 32 bit token offsets.
+    KDL_API [[nodiscard]] std::optional<Utf8TokenBuffer> LexFile(const QString& path) noexcept;
+
+    struct KDL_API BatchOptions
+    {
+        // 0 uses QThread::idealThreadCount()
+        i32 threadCount = 0;
+        // A file is only started while the files being read and processed take up less than this together,
+        // a larger file waits until it is the only one
+        i64 maxBytesInFlight = 64 * 1024 * 1024;
+    };
+
+    // LexFile for every path, on a pool of threads that each take the next file as soon as they are done
+    // with one. The results are in the order of paths, with nothing for files that can't be read.
+    KDL_API [[nodiscard]] std::vector<std::optional<Utf8TokenBuffer>> LexFiles(const QStringList& paths, const BatchOptions& options = {});
+
+    // Splits source at newlines and lexes the parts on up to threadCount threads, the result is the same as Lex.
+    // A threadCount of 0 uses QThread::idealThreadCount(), small sources are lexed on the calling thread.
+    KDL_API [[nodiscard]] TokenBuffer LexParallel(const QString& source, i32 threadCount = 0) noexcept;
+
+    // Updates tokens after the source range [editStart, editEnd) has been replaced by newText.
+    // Lexing restarts at the last newline token before the edit and stops as soon as a token lines up
+    // with an old token after the edit, the tokens after that point are only moved.
+    KDL_API void Relex(TokenBuffer& tokens, i32 editStart, i32 editEnd, QStringView newText) noexcept;
+
+    // Lexes UTF-8 encoded source directly, token offsets are byte offsets into source
+    KDL_API [[nodiscard]] Utf8TokenBuffer Lex(const QByteArray& source) noexcept;
+    // Same as above but without taking a reference on the bytes, source has to outlive the returned buffer
+    KDL_API [[nodiscard]] Utf8TokenBuffer Lex(QByteArrayView source) noexcept;
+
+    // Lexes UTF-8 encoded source that is handed to it piece by piece, without ever waiting for more. Once it
+    // runs out of input, in the middle of a token, a string, an escape or a comment, nextToken returns nothing
+    // and continues where it stopped after the next append. A token that was cut off is lexed again from its
+    // start, comments are skipped without being buffered.
+    class KDL_API PushLexer
+    {
+    public:
+        void append(QByteArrayView bytes);
+        // No more input will be appended, what is left is lexed as the end of the source
+        void finish() noexcept;
+        [[nodiscard]] bool isFinished() const noexcept;
+
+        // The returned token views memory owned by the lexer, it is only valid until the next call.
+        // Returns nothing while more input is needed and EndOfFile tokens once finished.
+        [[nodiscard]] std::optional<Utf8Token> nextToken() noexcept;
+
+        // Byte offset of the last returned token from the start of the input
+        [[nodiscard]] i64 tokenOffset() const noexcept;
+        // The same offset in UTF-16 code units, exact for valid UTF-8. Unlike utf16Offset it is counted on from
+        // the token before, so asking for it for every token takes linear time.
+        [[nodiscard]] i64 tokenUtf16Offset() const noexcept;
+        // Byte offset the last returned token was lexed from. Lexing the input again from there gives the same
+        // tokens, which isn't the case from tokenOffset for the error the lexer reports after a line continuation.
+        [[nodiscard]] i64 lexOffset() const noexcept;
+        // Keeps the input from offset on in memory until this is called again, nothing only keeps what hasn't
+        // been lexed yet. The offset can't be before lexOffset.
+        void retain(std::optional<i64> offset) noexcept;
+        // Input between two byte offsets that is still in memory
+        [[nodiscard]] QByteArrayView bytes(i64 start, i64 end) const noexcept;
+        // Offset in UTF-16 code units of a byte offset that is still in memory, exact for valid UTF-8
+        [[nodiscard]] i64 utf16Offset(i64 offset) const noexcept;
+
+        // Bytes of the token that was cut off at the end of the input
+        [[nodiscard]] i64 pendingBytes() const noexcept;
+        // Byte offset of the first byte the next append keeps in memory, the retained offset or the start of
+        // what hasn't been lexed yet
+        [[nodiscard]] i64 keptOffset() const noexcept;
+        // Bytes the next append keeps in memory before it adds the new ones
+        [[nodiscard]] i64 keptBytes() const noexcept;
+        [[nodiscard]] i64 allocatedBytes() const noexcept;
+
+    private:
+        QByteArray m_buffer{};
+        i32 m_currentIndex = 0;
+        i64 m_bufferOffset = 0;
+        i64 m_bufferUtf16Offset = 0;
+        i64 m_tokenOffset = 0;
+        i64 m_lexOffset = 0;
+        i64 m_retainedOffset = -1;
+        // The UTF-16 offset of the input up to m_countedIndex in the buffer
+        i32 m_countedIndex = 0;
+        i64 m_countedUtf16Offset = 0;
+        // A string that was cut off can't end before another quote arrives, until then it isn't lexed again
+        i64 m_quoteSearchOffset = -1;
+        i32 m_blockCommentNestingLevel = 0;
+        bool m_isInLineComment = false;
+        bool m_isFinished = false;
+    };
+
+    // Pulls UTF-8 encoded source from a device one chunk at a time and hands out tokens one by one.
+    // Only the unread part of the current chunk and the token being lexed are kept in memory,
+    // comments are skipped without being buffered.
+    class KDL_API Lexer
+    {
+    public:
+        static constexpr i32 DefaultChunkSize = 64 * 1024;
+
+        explicit Lexer(QIODevice& device, i32 chunkSize = DefaultChunkSize);
+
+        // The returned token views memory owned by the lexer, it is only valid until the next call.
+        // Returns EndOfFile tokens once the device has no more data.
+        [[nodiscard]] Utf8Token nextToken() noexcept;
+
+        // Byte offset of the last returned token from the start of the device
+        [[nodiscard]] i64 tokenOffset() const noexcept;
+        [[nodiscard]] i64 allocatedBytes() const noexcept;
+
+    private:
+        void readMore() noexcept;
+
+        QIODevice& m_device;
+        i32 m_chunkSize;
+        QByteArray m_chunk{};
+        PushLexer m_lexer{};
+    };
 }
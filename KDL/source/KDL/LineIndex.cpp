@@ -0,0 +1,132 @@
+#include <KDL/LineIndex.h>
+#include <KDL/CharacterClass.h>
+
+#include <algorithm>
+
+namespace
+{
+    using namespace KDL;
+
+    // Size of the newline at index, or 0 if there is none
+    [[nodiscard]] static i32 NewlineSize(const char16_t* data, i32 index, i32 size) noexcept
+    {
+        const auto current = data[index];
+        if (current == u'\r' && index + 1 < size && data[index + 1] == u'\n')
+            return 2;
+
+        return HasAny(ClassOf(current), CharacterClass::Newline) ? 1 : 0;
+    }
+
+    // The only newlines outside of ASCII are NEL (C2 85), LS (E2 80 A8) and PS (E2 80 A9)
+    [[nodiscard]] static i32 NewlineSize(const u8* data, i32 index, i32 size) noexcept
+    {
+        const auto current = data[index];
+        if (current < 0x80)
+        {
+            if (current == '\r' && index + 1 < size && data[index + 1] == '\n')
+                return 2;
+
+            return HasAny(ClassOf(current), CharacterClass::Newline) ? 1 : 0;
+        }
+
+        if (current == 0xC2 && index + 1 < size && data[index + 1] == 0x85)
+            return 2;
+
+        if (current == 0xE2 && index + 2 < size && data[index + 1] == 0x80 && (data[index + 2] == 0xA8 || data[index + 2] == 0xA9))
+            return 3;
+
+        return 0;
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static std::vector<i32> FindLineStarts(const TUnit* data, i32 size)
+    {
+        std::vector<i32> lineStarts{ 0 };
+        auto index = 0;
+        while (index < size)
+        {
+            const auto newlineSize = NewlineSize(data, index, size);
+            if (newlineSize == 0)
+            {
+                index++;
+                continue;
+            }
+
+            index += newlineSize;
+            lineStarts.push_back(index);
+        }
+
+        return lineStarts;
+    }
+}
+
+namespace KDL
+{
+    LineIndex::LineIndex(QStringView source)
+        : m_lineStarts{ FindLineStarts(source.utf16(), static_cast<i32>(source.size())) }
+    {
+    }
+
+    LineIndex::LineIndex(QUtf8StringView source)
+        : m_lineStarts{ FindLineStarts(reinterpret_cast<const u8*>(source.data()), static_cast<i32>(source.size())) }
+    {
+    }
+
+    SourceLocation LineIndex::location(i32 offset) const noexcept
+    {
+        const auto nextLine = std::upper_bound(m_lineStarts.begin() + 1, m_lineStarts.end(), offset);
+        const auto line = static_cast<i32>(nextLine - m_lineStarts.begin());
+        return { .line = line, .column = offset - m_lineStarts[line - 1] + 1 };
+    }
+
+    i32 LineIndex::lineCount() const noexcept
+    {
+        return static_cast<i32>(m_lineStarts.size());
+    }
+
+    i32 LineIndex::lineStart(i32 line) const noexcept
+    {
+        return m_lineStarts.at(line - 1);
+    }
+
+    LazyLineIndex::LazyLineIndex(const LazyLineIndex& other) noexcept
+        : m_index{ other.m_index.load(std::memory_order_acquire) }
+    {
+    }
+
+    LazyLineIndex& LazyLineIndex::operator=(const LazyLineIndex& other) noexcept
+    {
+        m_index.store(other.m_index.load(std::memory_order_acquire), std::memory_order_release);
+        return *this;
+    }
+
+    std::shared_ptr<const LineIndex> LazyLineIndex::get(QStringView source) const
+    {
+        return build(source);
+    }
+
+    std::shared_ptr<const LineIndex> LazyLineIndex::get(QUtf8StringView source) const
+    {
+        return build(source);
+    }
+
+    void LazyLineIndex::reset() noexcept
+    {
+        m_index.store(nullptr, std::memory_order_release);
+    }
+
+    template<typename TSource>
+    std::shared_ptr<const LineIndex> LazyLineIndex::build(TSource source) const
+    {
+        auto index = m_index.load(std::memory_order_acquire);
+        if (index)
+            return index;
+
+        // Threads that get here at once each build one, the first to finish is kept and the others use it
+        auto built = std::make_shared<const LineIndex>(source);
+        if (m_index.compare_exchange_strong(index, built, std::memory_order_acq_rel, std::memory_order_acquire))
+            return built;
+
+        return index;
+    }
+}
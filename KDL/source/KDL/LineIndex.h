@@ -0,0 +1,61 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <Defines.h>
+
+#include <QStringView>
+#include <QUtf8StringView>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace KDL
+{
+    // One-based line and column, the column counts code units of the source encoding
+    struct KDL_API SourceLocation
+    {
+        i32 line = 1;
+        i32 column = 1;
+    };
+
+    // Start offsets of all lines of a source, so an offset turns into a line and column by binary search.
+    // Lines are broken by every newline the lexer knows: CR, LF, CRLF, NEL, FF, LS and PS.
+    class KDL_API LineIndex
+    {
+    public:
+        explicit LineIndex(QStringView source);
+        explicit LineIndex(QUtf8StringView source);
+
+        [[nodiscard]] SourceLocation location(i32 offset) const noexcept;
+
+        [[nodiscard]] i32 lineCount() const noexcept;
+        // Offset of the first code unit of the one-based line
+        [[nodiscard]] i32 lineStart(i32 line) const noexcept;
+
+    private:
+        std::vector<i32> m_lineStarts;
+    };
+
+    // A LineIndex built on the first call to get. Any number of threads can call it at once, they all get the
+    // same index. Copies share the index built so far.
+    class KDL_API LazyLineIndex
+    {
+    public:
+        LazyLineIndex() = default;
+        LazyLineIndex(const LazyLineIndex& other) noexcept;
+        LazyLineIndex& operator=(const LazyLineIndex& other) noexcept;
+
+        [[nodiscard]] std::shared_ptr<const LineIndex> get(QStringView source) const;
+        [[nodiscard]] std::shared_ptr<const LineIndex> get(QUtf8StringView source) const;
+
+        // For when the source changes, which can't happen while another thread calls get
+        void reset() noexcept;
+
+    private:
+        template<typename TSource>
+        [[nodiscard]] std::shared_ptr<const LineIndex> build(TSource source) const;
+
+        mutable std::atomic<std::shared_ptr<const LineIndex>> m_index;
+    };
+}
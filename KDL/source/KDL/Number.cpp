@@ -0,0 +1,264 @@
+#include <KDL/Number.h>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace
+{
+    using namespace KDL;
+
+    struct Digits
+    {
+        bool IsNegative;
+        u64 Base;
+        // Index of the first digit after the sign and base prefix
+        i32 Start;
+    };
+
+    template<typename TUnit>
+    [[nodiscard]] static Digits SplitPrefix(TokenKind kind, const TUnit* data, i32 size) noexcept
+    {
+        auto start = 0;
+        auto isNegative = false;
+        if (size > 0 && (data[0] == TUnit('-') || data[0] == TUnit('+')))
+        {
+            isNegative = data[0] == TUnit('-');
+            start++;
+        }
+
+        switch (kind)
+        {
+            case TokenKind::Number_Binary:
+                return { .IsNegative = isNegative, .Base = 2, .Start = start + 2 };
+            case TokenKind::Number_Octal:
+                return { .IsNegative = isNegative, .Base = 8, .Start = start + 2 };
+            case TokenKind::Number_Hexadecimal:
+                return { .IsNegative = isNegative, .Base = 16, .Start = start + 2 };
+            default:
+                return { .IsNegative = isNegative, .Base = 10, .Start = start };
+        }
+    }
+
+    [[nodiscard]] static auto DigitValue(char32_t unit) noexcept
+    {
+        if (unit >= U'0' && unit <= U'9')
+            return u64(unit - U'0');
+        if (unit >= U'a' && unit <= U'f')
+            return u64(unit - U'a' + 10);
+        if (unit >= U'A' && unit <= U'F')
+            return u64(unit - U'A' + 10);
+
+        return std::numeric_limits<u64>::max();
+    }
+
+    // Magnitude of an integer token, fractions and exponents make it Invalid
+    template<typename TUnit>
+    [[nodiscard]] static NumberResult<u64> DecodeMagnitude(TokenKind kind, const TUnit* data, i32 size, const Digits& digits) noexcept
+    {
+        if (!IsNumberKind(kind) || digits.Start >= size)
+            return { .value = 0, .status = NumberStatus::Invalid };
+
+        u64 value = 0;
+        auto status = NumberStatus::Ok;
+        auto hasDigits = false;
+        for (auto i = digits.Start; i < size; i++)
+        {
+            if (data[i] == TUnit('_'))
+                continue;
+
+            const auto digit = DigitValue(data[i]);
+            if (digit >= digits.Base)
+                return { .value = 0, .status = NumberStatus::Invalid };
+
+            hasDigits = true;
+            if (value > (std::numeric_limits<u64>::max() - digit) / digits.Base)
+                status = NumberStatus::Overflow;
+
+            value = value * digits.Base + digit;
+        }
+
+        // A base prefix followed by nothing but separators, like 0x_
+        if (!hasDigits)
+            return { .value = 0, .status = NumberStatus::Invalid };
+
+        return { .value = value, .status = status };
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static NumberResult<i64> DecodeSigned(TokenKind kind, const TUnit* data, i32 size) noexcept
+    {
+        const auto digits = SplitPrefix(kind, data, size);
+        const auto magnitude = DecodeMagnitude(kind, data, size, digits);
+        if (magnitude.status != NumberStatus::Ok)
+            return { .value = 0, .status = magnitude.status };
+
+        constexpr auto maxMagnitude = u64(std::numeric_limits<i64>::max());
+        if (digits.IsNegative)
+        {
+            if (magnitude.value > maxMagnitude + 1)
+                return { .value = 0, .status = NumberStatus::Overflow };
+
+            return { .value = i64(0 - magnitude.value), .status = NumberStatus::Ok };
+        }
+
+        if (magnitude.value > maxMagnitude)
+            return { .value = 0, .status = NumberStatus::Overflow };
+
+        return { .value = i64(magnitude.value), .status = NumberStatus::Ok };
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static NumberResult<u64> DecodeUnsigned(TokenKind kind, const TUnit* data, i32 size) noexcept
+    {
+        const auto digits = SplitPrefix(kind, data, size);
+        const auto magnitude = DecodeMagnitude(kind, data, size, digits);
+        if (magnitude.status != NumberStatus::Ok)
+            return { .value = 0, .status = magnitude.status };
+
+        if (digits.IsNegative && magnitude.value != 0)
+            return { .value = 0, .status = NumberStatus::Overflow };
+
+        return magnitude;
+    }
+
+    // Whether a decimal number that std::from_chars found out of range is too close to zero rather than too large,
+    // judged by the power of ten of its first significant digit
+    [[nodiscard]] static bool IsTooSmall(const char* begin, const char* end) noexcept
+    {
+        const auto isNotZero = [](char character) { return character != '0'; };
+        const auto* start = begin != end && *begin == '-' ? begin + 1 : begin;
+        const auto* exponentStart = std::find_if(start, end, [](char character) { return character == 'e' || character == 'E'; });
+        const auto* point = std::find(start, exponentStart, '.');
+        const auto* integerStart = std::find_if(start, point, isNotZero);
+        auto power = i64(point - integerStart) - 1;
+        if (integerStart == point)
+        {
+            const auto* fractionStart = point == exponentStart ? point : point + 1;
+            power = -i64(std::find_if(fractionStart, exponentStart, isNotZero) - fractionStart) - 1;
+        }
+
+        auto exponent = i64(0);
+        const auto* i = exponentStart == end ? end : exponentStart + 1;
+        const auto isNegativeExponent = i != end && *i == '-';
+        if (i != end && (*i == '-' || *i == '+'))
+            i++;
+
+        // Saturated far beyond the range of double so it can't overflow
+        for (; i != end; i++)
+            exponent = std::min(exponent * 10 + (*i - '0'), i64(1) << 40);
+
+        return power + (isNegativeExponent ? -exponent : exponent) < 0;
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static NumberResult<double> DecodeFloatingPoint(TokenKind kind, const TUnit* data, i32 size) noexcept
+    {
+        switch (kind)
+        {
+            case TokenKind::Keyword_Infinity:
+                return { .value = std::numeric_limits<double>::infinity(), .status = NumberStatus::Ok };
+            case TokenKind::Keyword_NegativeInfinity:
+                return { .value = -std::numeric_limits<double>::infinity(), .status = NumberStatus::Ok };
+            case TokenKind::Keyword_NaN:
+                return { .value = std::numeric_limits<double>::quiet_NaN(), .status = NumberStatus::Ok };
+            case TokenKind::Number_Decimal:
+                break;
+            default:
+            {
+                // Integers in other bases are exact up to 2^53 and rounded beyond that
+                const auto digits = SplitPrefix(kind, data, size);
+                const auto magnitude = DecodeMagnitude(kind, data, size, digits);
+                if (magnitude.status == NumberStatus::Invalid)
+                    return { .value = 0, .status = NumberStatus::Invalid };
+
+                auto value = double(magnitude.value);
+                if (magnitude.status == NumberStatus::Overflow)
+                {
+                    value = 0;
+                    for (auto i = digits.Start; i < size; i++)
+                    {
+                        if (data[i] != TUnit('_'))
+                            value = value * double(digits.Base) + double(DigitValue(data[i]));
+                    }
+                }
+
+                return { .value = digits.IsNegative ? -value : value, .status = NumberStatus::Ok };
+            }
+        }
+
+        // std::from_chars wants narrow characters without separators and without a plus sign
+        QVarLengthArray<char, 256> characters{};
+        for (auto i = 0; i < size; i++)
+        {
+            if (data[i] == TUnit('_') || (i == 0 && data[i] == TUnit('+')))
+                continue;
+
+            // The lexer accepts all Unicode digits, only ASCII ones have a value here
+            if (data[i] >= 0x80)
+                return { .value = 0, .status = NumberStatus::Invalid };
+
+            characters.append(char(data[i]));
+        }
+
+        auto value = 0.0;
+        const auto* end = characters.data() + characters.size();
+        const auto [pointer, error] = std::from_chars(characters.data(), end, value);
+        if (error == std::errc::result_out_of_range && pointer == end)
+        {
+            // Like the nearest double, a value too small for one rounds to zero
+            if (IsTooSmall(characters.data(), end))
+                return { .value = characters[0] == '-' ? -0.0 : 0.0, .status = NumberStatus::Ok };
+
+            return { .value = 0, .status = NumberStatus::Overflow };
+        }
+        if (error != std::errc{} || pointer != end)
+            return { .value = 0, .status = NumberStatus::Invalid };
+
+        return { .value = value, .status = NumberStatus::Ok };
+    }
+
+    [[nodiscard]] static auto Utf16Data(const Token& token) noexcept
+    {
+        return reinterpret_cast<const char16_t*>(token.stringView.utf16());
+    }
+
+    [[nodiscard]] static auto Utf8Data(const Utf8Token& token) noexcept
+    {
+        return reinterpret_cast<const u8*>(token.stringView.data());
+    }
+}
+
+namespace KDL
+{
+    NumberResult<i64> DecodeInt64(const Token& token) noexcept
+    {
+        return DecodeSigned(token.kind, Utf16Data(token), i32(token.stringView.size()));
+    }
+
+    NumberResult<i64> DecodeInt64(const Utf8Token& token) noexcept
+    {
+        return DecodeSigned(token.kind, Utf8Data(token), i32(token.stringView.size()));
+    }
+
+    NumberResult<u64> DecodeUInt64(const Token& token) noexcept
+    {
+        return DecodeUnsigned(token.kind, Utf16Data(token), i32(token.stringView.size()));
+    }
+
+    NumberResult<u64> DecodeUInt64(const Utf8Token& token) noexcept
+    {
+        return DecodeUnsigned(token.kind, Utf8Data(token), i32(token.stringView.size()));
+    }
+
+    NumberResult<double> DecodeDouble(const Token& token) noexcept
+    {
+        return DecodeFloatingPoint(token.kind, Utf16Data(token), i32(token.stringView.size()));
+    }
+
+    NumberResult<double> DecodeDouble(const Utf8Token& token) noexcept
+    {
+        return DecodeFloatingPoint(token.kind, Utf8Data(token), i32(token.stringView.size()));
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/Token.h>
+#include <KDL/Utf8Token.h>
+#include <Defines.h>
+
+namespace KDL
+{
+    enum class KDL_API NumberStatus
+    {
+        Ok,
+        // The number is valid but doesn't fit into the requested type
+        Overflow,
+        // The token isn't a number or, for integers, has a fraction or an exponent
+        Invalid
+    };
+
+    template<typename T>
+    struct NumberResult
+    {
+        T value{};
+        NumberStatus status = NumberStatus::Invalid;
+    };
+
+    // Decode the value of a Number_* token, underscores are skipped and a leading sign is allowed.
+    // Nothing is allocated for numbers of up to 256 code units.
+    KDL_API [[nodiscard]] NumberResult<i64> DecodeInt64(const Token& token) noexcept;
+    KDL_API [[nodiscard]] NumberResult<i64> DecodeInt64(const Utf8Token& token) noexcept;
+    KDL_API [[nodiscard]] NumberResult<u64> DecodeUInt64(const Token& token) noexcept;
+    KDL_API [[nodiscard]] NumberResult<u64> DecodeUInt64(const Utf8Token& token) noexcept;
+
+    // Also decodes the #inf, #-inf and #nan keywords. Integers that don't fit
+    // into 64 bits are rounded, decimals too large for a double overflow and
+    // decimals too close to zero for one decode as zero.
+    KDL_API [[nodiscard]] NumberResult<double> DecodeDouble(const Token& token) noexcept;
+    KDL_API [[nodiscard]] NumberResult<double> DecodeDouble(const Utf8Token& token) noexcept;
+}
@@ -0,0 +1,262 @@
+#include <KDL/ParseCache.h>
+#include <KDL/BinaryFormat.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <bit>
+#include <cstring>
+
+namespace
+{
+    using namespace KDL;
+
+    constexpr u64 Prime1 = 0x9E3779B185EBCA87;
+    constexpr u64 Prime2 = 0xC2B2AE3D27D4EB4F;
+    constexpr u64 Prime3 = 0x165667B19E3779F9;
+    constexpr u64 Prime4 = 0x85EBCA77C2B2AE63;
+    constexpr u64 Prime5 = 0x27D4EB2F165667C5;
+
+    const auto EntrySuffix = QString(".kdlb");
+    // Entries end with the hash of the document in front of it
+    constexpr qsizetype ChecksumSize = sizeof(u64);
+
+    template<typename T>
+    [[nodiscard]] T Read(const char* data) noexcept
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    [[nodiscard]] u64 Round(u64 accumulator, u64 input) noexcept
+    {
+        accumulator += input * Prime2;
+        return std::rotl(accumulator, 31) * Prime1;
+    }
+
+    [[nodiscard]] u64 MergeRound(u64 hash, u64 accumulator) noexcept
+    {
+        hash ^= Round(0, accumulator);
+        return hash * Prime1 + Prime4;
+    }
+}
+
+namespace KDL
+{
+    ParseCache::ParseCache(const QString& directory, i64 maxBytes)
+        : m_directory{ directory }
+        , m_maxBytes{ maxBytes }
+    {
+        QDir().mkpath(m_directory);
+
+        auto size = i64(0);
+        for (const auto& entry : QDir(m_directory).entryInfoList({ QString("*") + EntrySuffix }, QDir::Files, QDir::Unsorted))
+            size += entry.size();
+        m_size = size;
+    }
+
+    std::optional<ParseCacheResult> ParseCache::parseFile(const QString& path)
+    {
+        auto file = QFile(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return std::nullopt;
+
+        const auto fileSize = file.size();
+        const auto* mapping = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+        auto bytes = QByteArray();
+        auto source = QByteArrayView();
+        if (mapping == nullptr)
+        {
+            bytes = file.readAll();
+            source = bytes;
+        }
+        else
+        {
+            source = QByteArrayView(reinterpret_cast<const char*>(mapping), fileSize);
+        }
+
+        if (source.startsWith("\xEF\xBB\xBF"))
+            source = source.sliced(3);
+
+        return parse(source);
+    }
+
+    ParseCacheResult ParseCache::parse(QByteArrayView source)
+    {
+        const auto path = entryPath(source);
+        if (auto cached = load(path))
+            return *cached;
+
+        auto encoded = EncodeBinary(QString::fromUtf8(source));
+        auto result = ParseCacheResult{};
+        result.status = encoded.status;
+        result.errorOffset = encoded.errorOffset;
+        if (encoded.status != ParseStatus::Ok)
+            return result;
+
+        store(path, encoded.bytes);
+        result.bytes = std::move(encoded.bytes);
+        result.document = OpenBinaryUnchecked(result.bytes).document;
+        return result;
+    }
+
+    void ParseCache::trim()
+    {
+        std::lock_guard lock{ m_trimMutex };
+
+        // Oldest first, loading an entry updates its modification time
+        const auto entries = QDir(m_directory).entryInfoList({ QString("*") + EntrySuffix }, QDir::Files, QDir::Time | QDir::Reversed);
+        auto size = i64(0);
+        for (const auto& entry : entries)
+            size += entry.size();
+
+        const auto targetSize = m_maxBytes / 4 * 3;
+        for (const auto& entry : entries)
+        {
+            if (size <= targetSize)
+                break;
+
+            // Another process may have removed it already, or still have it open where that prevents removal
+            const auto entrySize = entry.size();
+            if (QFile::remove(entry.absoluteFilePath()))
+                size -= entrySize;
+        }
+
+        m_size = size;
+    }
+
+    const QString& ParseCache::directory() const noexcept
+    {
+        return m_directory;
+    }
+
+    i64 ParseCache::size() const noexcept
+    {
+        return m_size;
+    }
+
+    // Entries of another format version get another name, so caches of both versions can share a directory
+    QString ParseCache::entryPath(QByteArrayView source) const
+    {
+        const auto hash = HashBytes(source);
+        return m_directory + QString("/v") + QString::number(u64(BinaryFormat::Version)) + QString("-")
+            + QString::number(hash, 16) + QString("-") + QString::number(u64(source.size()), 16) + EntrySuffix;
+    }
+
+    std::optional<ParseCacheResult> ParseCache::load(const QString& entryPath) const
+    {
+        auto file = QFile(entryPath);
+        if (!file.open(QIODevice::ReadOnly))
+            return std::nullopt;
+
+        const auto fileSize = file.size();
+        auto mapping = fileSize > ChecksumSize ? MapFile(file, fileSize) : nullptr;
+        if (mapping == nullptr)
+            return std::nullopt;
+
+        // OpenBinary only catches damage that points outside of the document, not damage to its values
+        const auto* data = mapping->bytes().data();
+        const auto documentSize = fileSize - ChecksumSize;
+        if (HashBytes(QByteArrayView(data, documentSize)) != Read<u64>(data + documentSize))
+            return std::nullopt;
+
+        auto result = ParseCacheResult{};
+        result.bytes = QByteArray::fromRawData(data, documentSize);
+        const auto opened = OpenBinary(result.bytes);
+        if (opened.status != BinaryStatus::Ok)
+            return std::nullopt;
+
+        // Marks the entry as used for trimming, failing to only makes it more likely to be removed
+        (void)file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+        result.document = opened.document;
+        result.isCached = true;
+        result.mapping = std::move(mapping);
+        return result;
+    }
+
+    void ParseCache::store(const QString& entryPath, const QByteArray& bytes)
+    {
+        // A cache that can't be written only makes every parse a miss
+        auto file = QSaveFile(entryPath);
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+
+        const auto checksum = HashBytes(bytes);
+        if (file.write(bytes) != bytes.size()
+            || file.write(reinterpret_cast<const char*>(&checksum), ChecksumSize) != ChecksumSize)
+        {
+            file.cancelWriting();
+            return;
+        }
+
+        if (!file.commit())
+            return;
+
+        if ((m_size += bytes.size() + ChecksumSize) > m_maxBytes)
+            trim();
+    }
+
+    u64 HashBytes(QByteArrayView bytes, u64 seed) noexcept
+    {
+        const auto* data = bytes.data();
+        const auto* end = data + bytes.size();
+        auto hash = u64(0);
+
+        if (bytes.size() >= 32)
+        {
+            auto accumulator1 = seed + Prime1 + Prime2;
+            auto accumulator2 = seed + Prime2;
+            auto accumulator3 = seed;
+            auto accumulator4 = seed - Prime1;
+            for (; end - data >= 32; data += 32)
+            {
+                accumulator1 = Round(accumulator1, Read<u64>(data));
+                accumulator2 = Round(accumulator2, Read<u64>(data + 8));
+                accumulator3 = Round(accumulator3, Read<u64>(data + 16));
+                accumulator4 = Round(accumulator4, Read<u64>(data + 24));
+            }
+
+            hash = std::rotl(accumulator1, 1) + std::rotl(accumulator2, 7) + std::rotl(accumulator3, 12) + std::rotl(accumulator4, 18);
+            hash = MergeRound(hash, accumulator1);
+            hash = MergeRound(hash, accumulator2);
+            hash = MergeRound(hash, accumulator3);
+            hash = MergeRound(hash, accumulator4);
+        }
+        else
+        {
+            hash = seed + Prime5;
+        }
+
+        hash += static_cast<u64>(bytes.size());
+        for (; end - data >= 8; data += 8)
+        {
+            hash ^= Round(0, Read<u64>(data));
+            hash = std::rotl(hash, 27) * Prime1 + Prime4;
+        }
+
+        if (end - data >= 4)
+        {
+            hash ^= static_cast<u64>(Read<u32>(data)) * Prime1;
+            hash = std::rotl(hash, 23) * Prime2 + Prime3;
+            data += 4;
+        }
+
+        for (; data < end; data++)
+        {
+            hash ^= static_cast<u64>(static_cast<u8>(*data)) * Prime5;
+            hash = std::rotl(hash, 11) * Prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= Prime2;
+        hash ^= hash >> 29;
+        hash *= Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
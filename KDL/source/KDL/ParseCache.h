@@ -0,0 +1,84 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/Binary.h>
+#include <KDL/EventParser.h>
+#include <KDL/FileMapping.h>
+#include <Defines.h>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace KDL
+{
+    struct KDL_API ParseCacheResult
+    {
+        // Views bytes, empty unless status is ParseStatus::Ok
+        BinaryDocument document;
+        ParseStatus status = ParseStatus::Ok;
+        // Offset in UTF-16 code units of the token the error was found at
+        i32 errorOffset = 0;
+        // Whether the document was loaded from the cache instead of being parsed
+        bool isCached = false;
+
+        // The encoded document, or the mapped cache entry it was loaded from. The mapping is kept alive as
+        // long as any copy of the result, without keeping the entry open.
+        QByteArray bytes;
+        std::shared_ptr<const FileMapping> mapping;
+    };
+
+    // Keeps parsed documents in a directory, in the binary form of EncodeBinary, keyed by a 64 bit hash and
+    // the size of their UTF-8 source. A source that hasn't changed is loaded by hashing it and mapping its
+    // entry, without lexing or parsing. A changed source has a different key, so entries never have to be
+    // invalidated, the old one is evicted once it is the least recently used. Sources that fail to parse
+    // aren't cached.
+    //
+    // Entries are written to a temporary file and renamed into place, so any number of threads and processes
+    // can share a directory: readers never see a partial entry and writers of the same key write the same
+    // bytes. Entries end with a hash of their document, which is checked with the document on every load, so
+    // entries that are damaged or can't be opened, for example from an older format version, are parsed again.
+    class KDL_API ParseCache
+    {
+    public:
+        static constexpr i64 DefaultMaxBytes = 256 * 1024 * 1024;
+
+        // Creates directory if it doesn't exist. Once the entries take more than maxBytes, the cache is
+        // trimmed after writing the next one.
+        explicit ParseCache(const QString& directory, i64 maxBytes = DefaultMaxBytes);
+
+        ParseCache(const ParseCache&) = delete;
+        ParseCache& operator=(const ParseCache&) = delete;
+
+        // Returns nothing if the file can't be read, a leading byte order mark is skipped
+        [[nodiscard]] std::optional<ParseCacheResult> parseFile(const QString& path);
+        // UTF-8 source
+        [[nodiscard]] ParseCacheResult parse(QByteArrayView source);
+
+        // Removes the least recently used entries until they take at most three quarters of maxBytes, so the
+        // next few writes don't trim again. Loading an entry counts as using it.
+        void trim();
+
+        [[nodiscard]] const QString& directory() const noexcept;
+        // Bytes taken by entries when the cache was created or last trimmed, plus those it wrote since
+        [[nodiscard]] i64 size() const noexcept;
+
+    private:
+        [[nodiscard]] QString entryPath(QByteArrayView source) const;
+        [[nodiscard]] std::optional<ParseCacheResult> load(const QString& entryPath) const;
+        void store(const QString& entryPath, const QByteArray& bytes);
+
+        QString m_directory;
+        i64 m_maxBytes;
+        std::atomic<i64> m_size = 0;
+        std::mutex m_trimMutex;
+    };
+
+    // 64 bit xxHash of bytes, fast but not cryptographic
+    KDL_API [[nodiscard]] u64 HashBytes(QByteArrayView bytes, u64 seed = 0) noexcept;
+}
@@ -0,0 +1,806 @@
+#include <KDL/Query.h>
+#include <KDL/LexToken.h>
+#include <KDL/Lexer.h>
+#include <KDL/Number.h>
+#include <KDL/QueryMatching.h>
+#include <KDL/StringValue.h>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace
+{
+    using namespace KDL;
+
+    constexpr auto MaxBits = 64;
+
+    [[nodiscard]] bool IsSpace(QChar c) noexcept
+    {
+        return c == u' ' || c == u'\t' || c == u'\n' || c == u'\r';
+    }
+
+    [[nodiscard]] bool IsDecimalDigit(QChar c) noexcept
+    {
+        return c >= u'0' && c <= u'9';
+    }
+
+    // Characters that end a bare name or value in a selector
+    [[nodiscard]] bool EndsBareText(QChar c) noexcept
+    {
+        return IsSpace(c) || c == u'[' || c == u']' || c == u'(' || c == u')' || c == u',' || c == u'>' || c == u'=';
+    }
+
+    // Characters that end the property name of a bare accessor, as they start an operator
+    [[nodiscard]] bool EndsAccessor(QChar c) noexcept
+    {
+        return EndsBareText(c) || c == u'!' || c == u'<' || c == u'^' || c == u'$' || c == u'*';
+    }
+
+    [[nodiscard]] bool IsNumber(ValueType type) noexcept
+    {
+        return type == ValueType::Integer || type == ValueType::Float;
+    }
+
+    [[nodiscard]] std::optional<double> NumberOf(const Token& token) noexcept
+    {
+        const auto result = DecodeDouble(token);
+        if (result.status != NumberStatus::Ok)
+            return std::nullopt;
+
+        return result.value;
+    }
+
+    [[nodiscard]] std::optional<double> NumberOf(const EventValue& value) noexcept
+    {
+        if (!IsNumber(value.type))
+            return std::nullopt;
+
+        return NumberOf(Token{ .kind = value.kind, .stringView = value.text });
+    }
+
+    [[nodiscard]] std::optional<double> NumberOf(const Value& value) noexcept
+    {
+        if (!IsNumber(value.type()))
+            return std::nullopt;
+
+        const auto result = value.toDouble();
+        if (result.status != NumberStatus::Ok)
+            return std::nullopt;
+
+        return result.value;
+    }
+
+    // The bits that follow the given ones in their selector
+    [[nodiscard]] u64 Advance(u64 bits, u64 first) noexcept
+    {
+        return (bits << 1) & ~first;
+    }
+}
+
+namespace KDL
+{
+    class QueryCompiler
+    {
+    public:
+        explicit QueryCompiler(QStringView selector) noexcept
+            : m_selector{ selector }
+        {
+        }
+
+        [[nodiscard]] QueryResult compile()
+        {
+            QueryResult result{};
+            auto isValid = parseSelector();
+            while (isValid && consume(u","))
+                isValid = parseSelector();
+
+            if (isValid && m_index < m_selector.size())
+                fail(QueryStatus::UnexpectedCharacter);
+
+            if (m_status != QueryStatus::Ok)
+            {
+                result.status = m_status;
+                result.errorOffset = m_errorOffset;
+                return result;
+            }
+
+            result.query = std::move(m_query);
+            return result;
+        }
+
+    private:
+        using Combinator = Query::Combinator;
+        using Accessor = Query::Accessor;
+        using Operator = Query::Operator;
+
+        struct Literal
+        {
+            ValueType type = ValueType::Null;
+            Query::StringSpan text;
+            std::optional<double> number;
+        };
+
+        struct OperatorName
+        {
+            QStringView text;
+            Operator op;
+        };
+
+        bool fail(QueryStatus status) noexcept
+        {
+            return fail(status, m_index);
+        }
+
+        bool fail(QueryStatus status, i32 offset) noexcept
+        {
+            if (m_status == QueryStatus::Ok)
+            {
+                m_status = status;
+                m_errorOffset = offset;
+            }
+
+            return false;
+        }
+
+        [[nodiscard]] bool isAtEnd() const noexcept
+        {
+            return m_index >= m_selector.size();
+        }
+
+        [[nodiscard]] QChar peek() const noexcept
+        {
+            return isAtEnd() ? QChar{} : m_selector[m_index];
+        }
+
+        [[nodiscard]] bool consume(QStringView text) noexcept
+        {
+            if (!m_selector.sliced(m_index).startsWith(text))
+                return false;
+
+            m_index += static_cast<i32>(text.size());
+            return true;
+        }
+
+        // Returns whether there was any space
+        bool skipSpace() noexcept
+        {
+            const auto start = m_index;
+            while (!isAtEnd() && IsSpace(peek()))
+                m_index++;
+
+            return m_index > start;
+        }
+
+        [[nodiscard]] Query::StringSpan addString(QStringView text)
+        {
+            const auto span = Query::StringSpan{ .offset = static_cast<i32>(m_query.m_strings.size()), .length = static_cast<i32>(text.size()) };
+            m_query.m_strings += text;
+            return span;
+        }
+
+        // [top() >] compound (combinator compound)*
+        [[nodiscard]] bool parseSelector()
+        {
+            skipSpace();
+            auto isTopLevel = false;
+            if (consume(u"top()"))
+            {
+                skipSpace();
+                if (!consume(u">"))
+                    return fail(QueryStatus::UnexpectedCharacter);
+
+                skipSpace();
+                isTopLevel = true;
+            }
+
+            auto isFirst = true;
+            auto combinator = Combinator::Descendant;
+            while (true)
+            {
+                if (!parseCompound(isFirst, isTopLevel, combinator))
+                    return false;
+
+                isFirst = false;
+                const auto hasSpace = skipSpace();
+                if (isAtEnd() || peek() == u',')
+                    break;
+
+                if (consume(u">"))
+                    combinator = Combinator::Child;
+                else if (consume(u"+"))
+                    combinator = Combinator::NextSibling;
+                else if (consume(u"~"))
+                    combinator = Combinator::Sibling;
+                else if (hasSpace)
+                    combinator = Combinator::Descendant;
+                else
+                    return fail(QueryStatus::UnexpectedCharacter);
+
+                skipSpace();
+            }
+
+            m_query.m_last |= u64(1) << (m_query.m_compounds.size() - 1);
+            return true;
+        }
+
+        // [(type) | ()] [name] [condition]*, with at least one of them
+        [[nodiscard]] bool parseCompound(bool isFirst, bool isTopLevel, Combinator combinator)
+        {
+            if (m_query.m_compounds.size() == MaxBits)
+                return fail(QueryStatus::TooComplex);
+
+            const auto start = m_index;
+            auto compound = Query::Compound{};
+            if (consume(u"("))
+            {
+                skipSpace();
+                if (consume(u")"))
+                {
+                    compound.typeMatch = Query::TypeMatch::Annotated;
+                }
+                else
+                {
+                    if (!parseString(compound.typeAnnotation))
+                        return false;
+
+                    skipSpace();
+                    if (!consume(u")"))
+                        return fail(QueryStatus::UnexpectedCharacter);
+
+                    compound.typeMatch = Query::TypeMatch::Equal;
+                }
+            }
+
+            if (!isAtEnd() && !EndsBareText(peek()) && !parseString(compound.name))
+                return false;
+
+            while (consume(u"["))
+            {
+                if (!parseCondition(compound))
+                    return false;
+            }
+
+            if (m_index == start)
+                return fail(QueryStatus::UnexpectedCharacter);
+
+            const auto bit = u64(1) << m_query.m_compounds.size();
+            if (isFirst)
+            {
+                m_query.m_first |= bit;
+                if (isTopLevel)
+                    m_query.m_top |= bit;
+            }
+            else
+            {
+                switch (combinator)
+                {
+                case Combinator::Descendant:
+                    m_query.m_descendant |= bit;
+                    break;
+                case Combinator::Child:
+                    m_query.m_child |= bit;
+                    break;
+                case Combinator::NextSibling:
+                    m_query.m_nextSibling |= bit;
+                    break;
+                case Combinator::Sibling:
+                    m_query.m_sibling |= bit;
+                    break;
+                }
+            }
+
+            m_query.m_compounds.push_back(compound);
+            return true;
+        }
+
+        // accessor [operator literal] ']', the '[' is consumed already
+        [[nodiscard]] bool parseCondition(Query::Compound& compound)
+        {
+            if (m_query.m_conditions.size() == MaxBits)
+                return fail(QueryStatus::TooComplex);
+
+            skipSpace();
+            auto condition = Query::Condition{ .accessor = Accessor::Property, .op = Operator::Exists };
+            if (!parseAccessor(condition))
+                return false;
+
+            skipSpace();
+            if (!consume(u"]"))
+            {
+                static constexpr OperatorName Operators[] = {
+                    { u"!=", Operator::NotEqual },
+                    { u"<=", Operator::LessOrEqual },
+                    { u">=", Operator::GreaterOrEqual },
+                    { u"^=", Operator::StartsWith },
+                    { u"$=", Operator::EndsWith },
+                    { u"*=", Operator::Contains },
+                    { u"=", Operator::Equal },
+                    { u"<", Operator::Less },
+                    { u">", Operator::Greater }
+                };
+
+                const auto found = std::find_if(std::begin(Operators), std::end(Operators), [this](const OperatorName& name) { return consume(name.text); });
+                if (found == std::end(Operators))
+                    return fail(QueryStatus::UnexpectedCharacter);
+
+                condition.op = found->op;
+                skipSpace();
+                const auto valueOffset = m_index;
+                auto literal = Literal{};
+                if (!parseLiteral(literal))
+                    return false;
+
+                const auto isOrdering = condition.op >= Operator::Less && condition.op <= Operator::GreaterOrEqual;
+                const auto isSubstring = condition.op >= Operator::StartsWith;
+                if ((isOrdering && !IsNumber(literal.type)) || (isSubstring && literal.type != ValueType::String))
+                    return fail(QueryStatus::InvalidValue, valueOffset);
+
+                condition.type = literal.type;
+                condition.text = literal.text;
+                condition.number = literal.number;
+                skipSpace();
+                if (!consume(u"]"))
+                    return fail(QueryStatus::UnexpectedCharacter);
+            }
+
+            compound.conditions |= u64(1) << m_query.m_conditions.size();
+            m_query.m_conditions.push_back(condition);
+            return true;
+        }
+
+        // val(), val(n), prop(name), name(), tag() or a property name on its own
+        [[nodiscard]] bool parseAccessor(Query::Condition& condition)
+        {
+            const auto start = m_index;
+            if (peek() == u'"' || peek() == u'#')
+                return parseString(condition.name);
+
+            while (!isAtEnd() && !EndsAccessor(peek()))
+                m_index++;
+
+            const auto word = m_selector.sliced(start, m_index - start);
+            if (word.isEmpty())
+                return fail(QueryStatus::UnexpectedCharacter);
+
+            if (!consume(u"("))
+            {
+                if (!IsValidIdentifier(word))
+                    return fail(QueryStatus::InvalidValue, start);
+
+                condition.name = addString(word);
+                return true;
+            }
+
+            skipSpace();
+            if (word == u"val")
+            {
+                condition.accessor = Accessor::Value;
+                if (!isAtEnd() && IsDecimalDigit(peek()))
+                {
+                    auto index = i64(0);
+                    while (!isAtEnd() && IsDecimalDigit(peek()) && index <= std::numeric_limits<i32>::max())
+                        index = index * 10 + (m_selector[m_index++].unicode() - u'0');
+
+                    if (index > std::numeric_limits<i32>::max())
+                        return fail(QueryStatus::InvalidValue);
+
+                    condition.index = static_cast<i32>(index);
+                }
+            }
+            else if (word == u"prop")
+            {
+                if (!parseString(condition.name))
+                    return false;
+            }
+            else if (word == u"name")
+            {
+                condition.accessor = Accessor::Name;
+            }
+            else if (word == u"tag")
+            {
+                condition.accessor = Accessor::Tag;
+            }
+            else
+            {
+                return fail(QueryStatus::UnsupportedAccessor, start);
+            }
+
+            skipSpace();
+            if (!consume(u")"))
+                return fail(QueryStatus::UnexpectedCharacter);
+
+            return true;
+        }
+
+        [[nodiscard]] bool parseString(Query::StringSpan& span)
+        {
+            const auto start = m_index;
+            auto literal = Literal{};
+            if (!parseLiteral(literal))
+                return false;
+
+            if (literal.type != ValueType::String)
+                return fail(QueryStatus::InvalidValue, start);
+
+            span = literal.text;
+            return true;
+        }
+
+        // A quoted string, a raw string or a bare run up to a space or a bracket, decoded by the lexer
+        [[nodiscard]] bool parseLiteral(Literal& literal)
+        {
+            const auto start = m_index;
+            if (peek() == u'"')
+            {
+                m_index++;
+                while (!isAtEnd() && peek() != u'"')
+                    m_index += peek() == u'\\' ? 2 : 1;
+
+                if (isAtEnd())
+                    return fail(QueryStatus::InvalidValue, start);
+
+                m_index++;
+            }
+            else if (peek() == u'#' && (m_selector.sliced(m_index).startsWith(u"##") || m_selector.sliced(m_index).startsWith(u"#\"")))
+            {
+                while (consume(u"#"))
+                {
+                }
+
+                const auto hashes = m_selector.sliced(start, m_index - start);
+                if (!consume(u"\""))
+                    return fail(QueryStatus::InvalidValue, start);
+
+                // Up to a quote followed by as many hashes as the string starts with
+                while (true)
+                {
+                    if (isAtEnd())
+                        return fail(QueryStatus::InvalidValue, start);
+                    if (!consume(u"\""))
+                        m_index++;
+                    else if (consume(hashes))
+                        break;
+                }
+            }
+            else
+            {
+                while (!isAtEnd() && !EndsBareText(peek()))
+                    m_index++;
+            }
+
+            const auto text = m_selector.sliced(start, m_index - start).toString();
+            const auto tokens = Lex(text);
+            auto count = tokens.size();
+            if (count > 0 && tokens[count - 1].kind == TokenKind::EndOfFile)
+                count--;
+            if (count != 1)
+                return fail(QueryStatus::InvalidValue, start);
+
+            const auto token = tokens[0];
+            if (IsStringKind(token.kind))
+            {
+                if (token.kind == TokenKind::Identifier && !IsValidIdentifier(token.stringView))
+                    return fail(QueryStatus::InvalidValue, start);
+
+                auto value = QString{};
+                if (DecodeString(token, value) != StringStatus::Ok)
+                    return fail(QueryStatus::InvalidValue, start);
+
+                literal.type = ValueType::String;
+                literal.text = addString(value);
+                return true;
+            }
+
+            if ((IsNumberKind(token.kind) && !IsValidNumber(token.stringView, token.kind)) || (!IsNumberKind(token.kind) && !IsKeywordKind(token.kind)))
+                return fail(QueryStatus::InvalidValue, start);
+
+            literal.type = ValueTypeOf(token.kind, token.stringView);
+            literal.text = addString(token.stringView);
+            if (IsNumber(literal.type))
+                literal.number = NumberOf(token);
+
+            return true;
+        }
+
+        QStringView m_selector;
+        i32 m_index = 0;
+        QueryStatus m_status = QueryStatus::Ok;
+        i32 m_errorOffset = 0;
+        Query m_query;
+    };
+
+    // Matches the nodes of a document, visiting only the subtrees in which a node can still match
+    class QueryWalker
+    {
+    public:
+        explicit QueryWalker(const Query& query) noexcept
+            : m_query{ query }
+        {
+        }
+
+        void walk(NodeRange nodes, bool isTopLevel, u64 parent, u64 ancestors)
+        {
+            auto previousChild = u64(0);
+            auto previousChildren = u64(0);
+            for (const auto node : nodes)
+            {
+                auto matched = u64(0);
+                for (auto bits = m_query.reachable(isTopLevel, parent, ancestors, previousChild, previousChildren); bits != 0; bits &= bits - 1)
+                {
+                    const auto compound = std::countr_zero(bits);
+                    if (matches(compound, node))
+                        matched |= u64(1) << compound;
+                }
+
+                if ((matched & m_query.m_last) != 0)
+                    m_nodes.push_back(node);
+
+                previousChild = matched;
+                previousChildren |= matched;
+                if (node.childCount() > 0 && m_query.isReachableBelow(matched, parent | ancestors))
+                    walk(node.children(), false, matched, parent | ancestors);
+            }
+        }
+
+        [[nodiscard]] std::vector<Node>& nodes() noexcept
+        {
+            return m_nodes;
+        }
+
+    private:
+        [[nodiscard]] bool matches(i32 compound, const Node& node) const noexcept
+        {
+            if (!m_query.matchesNameAndType(compound, node.name(), node.typeAnnotation()))
+                return false;
+
+            for (auto bits = m_query.m_compounds[compound].conditions; bits != 0; bits &= bits - 1)
+            {
+                if (!isMet(m_query.m_conditions[std::countr_zero(bits)], node))
+                    return false;
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] bool isMet(const Query::Condition& condition, const Node& node) const noexcept
+        {
+            switch (condition.accessor)
+            {
+            case Query::Accessor::Name:
+                return m_query.test(condition, ValueType::String, node.name(), std::nullopt);
+            case Query::Accessor::Tag:
+            {
+                const auto typeAnnotation = node.typeAnnotation();
+                return typeAnnotation && m_query.test(condition, ValueType::String, *typeAnnotation, std::nullopt);
+            }
+            case Query::Accessor::Value:
+                return condition.index < node.argumentCount() && isMet(condition, node.argument(condition.index));
+            case Query::Accessor::Property:
+            {
+                const auto value = node.property(m_query.string(condition.name));
+                return value && isMet(condition, *value);
+            }
+            }
+
+            return false;
+        }
+
+        [[nodiscard]] bool isMet(const Query::Condition& condition, const Value& value) const noexcept
+        {
+            return m_query.test(condition, value.type(), value.string(), NumberOf(value));
+        }
+
+        const Query& m_query;
+        std::vector<Node> m_nodes;
+    };
+
+    QStringView Query::string(StringSpan span) const noexcept
+    {
+        return QStringView(m_strings).sliced(span.offset, span.length);
+    }
+
+    u64 Query::reachable(bool isTopLevel, u64 parent, u64 ancestors, u64 previousSibling, u64 previousSiblings) const noexcept
+    {
+        const auto start = isTopLevel ? m_first : m_first & ~m_top;
+        return start | (Advance(parent, m_first) & m_child) | (Advance(parent | ancestors, m_first) & m_descendant)
+            | (Advance(previousSibling, m_first) & m_nextSibling) | (Advance(previousSiblings, m_first) & m_sibling);
+    }
+
+    bool Query::isReachableBelow(u64 matched, u64 ancestors) const noexcept
+    {
+        // Sibling bits need a match among the children first, so only the start and the child and descendant
+        // bits can begin a match below
+        return (m_first & ~m_top) != 0 || (Advance(matched, m_first) & m_child) != 0
+            || (Advance(matched | ancestors, m_first) & m_descendant) != 0;
+    }
+
+    bool Query::matchesNameAndType(i32 compound, QStringView name, std::optional<QStringView> typeAnnotation) const noexcept
+    {
+        const auto& matcher = m_compounds[compound];
+        if (matcher.name.length >= 0 && string(matcher.name) != name)
+            return false;
+
+        switch (matcher.typeMatch)
+        {
+        case TypeMatch::Any:
+            return true;
+        case TypeMatch::Annotated:
+            return typeAnnotation.has_value();
+        case TypeMatch::Equal:
+            return typeAnnotation && *typeAnnotation == string(matcher.typeAnnotation);
+        }
+
+        return false;
+    }
+
+    bool Query::test(const Condition& condition, ValueType type, QStringView text, std::optional<double> number) const noexcept
+    {
+        const auto isNumeric = IsNumber(type) && IsNumber(condition.type) && number && condition.number;
+        switch (condition.op)
+        {
+        case Operator::Exists:
+            return true;
+        case Operator::Equal:
+        case Operator::NotEqual:
+        {
+            const auto isEqual = isNumeric ? *number == *condition.number : type == condition.type && text == string(condition.text);
+            return isEqual == (condition.op == Operator::Equal);
+        }
+        case Operator::Less:
+            return isNumeric && *number < *condition.number;
+        case Operator::LessOrEqual:
+            return isNumeric && *number <= *condition.number;
+        case Operator::Greater:
+            return isNumeric && *number > *condition.number;
+        case Operator::GreaterOrEqual:
+            return isNumeric && *number >= *condition.number;
+        case Operator::StartsWith:
+            return type == ValueType::String && text.startsWith(string(condition.text));
+        case Operator::EndsWith:
+            return type == ValueType::String && text.endsWith(string(condition.text));
+        case Operator::Contains:
+            return type == ValueType::String && text.contains(string(condition.text));
+        }
+
+        return false;
+    }
+
+    QueryResult CompileQuery(QStringView selector)
+    {
+        return QueryCompiler{ selector }.compile();
+    }
+
+    QueryMatcher::QueryMatcher(const Query& query)
+        : m_query{ query }
+    {
+        m_frames.push_back({});
+    }
+
+    void QueryMatcher::beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32 offset)
+    {
+        const auto& parent = m_frames.back();
+        auto candidates = m_query.reachable(m_frames.size() == 1, parent.matched, parent.ancestors, parent.previousChild, parent.previousChildren);
+        m_pendingConditions = 0;
+        m_metConditions = 0;
+        m_argumentIndex = 0;
+        m_isInEntries = true;
+        for (auto bits = candidates; bits != 0; bits &= bits - 1)
+        {
+            const auto compound = std::countr_zero(bits);
+            if (m_query.matchesNameAndType(compound, name, typeAnnotation))
+                m_pendingConditions |= m_query.m_compounds[compound].conditions;
+            else
+                candidates &= ~(u64(1) << compound);
+        }
+
+        m_candidates = candidates;
+        if ((candidates & m_query.m_last) != 0)
+        {
+            // The name may be a decoded view that is gone once the node is matched
+            m_name = name.toString();
+            m_offset = offset;
+        }
+
+        for (auto bits = m_pendingConditions; bits != 0; bits &= bits - 1)
+        {
+            const auto index = std::countr_zero(bits);
+            const auto& condition = m_query.m_conditions[index];
+            if (condition.accessor == Query::Accessor::Name)
+                setCondition(index, m_query.test(condition, ValueType::String, name, std::nullopt));
+            else if (condition.accessor == Query::Accessor::Tag)
+                setCondition(index, typeAnnotation && m_query.test(condition, ValueType::String, *typeAnnotation, std::nullopt));
+        }
+    }
+
+    void QueryMatcher::argument(const EventValue& value)
+    {
+        for (auto bits = m_pendingConditions; bits != 0; bits &= bits - 1)
+        {
+            const auto index = std::countr_zero(bits);
+            const auto& condition = m_query.m_conditions[index];
+            if (condition.accessor == Query::Accessor::Value && condition.index == m_argumentIndex)
+                setCondition(index, m_query.test(condition, value.type, value.text, NumberOf(value)));
+        }
+
+        m_argumentIndex++;
+    }
+
+    void QueryMatcher::property(QStringView name, const EventValue& value, i32)
+    {
+        // A later property with the same name replaces the result of an earlier one
+        for (auto bits = m_pendingConditions; bits != 0; bits &= bits - 1)
+        {
+            const auto index = std::countr_zero(bits);
+            const auto& condition = m_query.m_conditions[index];
+            if (condition.accessor == Query::Accessor::Property && m_query.string(condition.name) == name)
+                setCondition(index, m_query.test(condition, value.type, value.text, NumberOf(value)));
+        }
+    }
+
+    void QueryMatcher::beginChildren()
+    {
+        endEntries();
+    }
+
+    void QueryMatcher::endChildren()
+    {
+    }
+
+    void QueryMatcher::endNode()
+    {
+        if (m_isInEntries)
+            endEntries();
+
+        m_frames.pop_back();
+    }
+
+    const std::vector<QueryMatch>& QueryMatcher::matches() const noexcept
+    {
+        return m_matches;
+    }
+
+    void QueryMatcher::setCondition(i32 condition, bool isMet) noexcept
+    {
+        const auto bit = u64(1) << condition;
+        m_metConditions = isMet ? m_metConditions | bit : m_metConditions & ~bit;
+    }
+
+    void QueryMatcher::endEntries()
+    {
+        m_isInEntries = false;
+        auto matched = u64(0);
+        for (auto bits = m_candidates; bits != 0; bits &= bits - 1)
+        {
+            const auto compound = std::countr_zero(bits);
+            if ((m_query.m_compounds[compound].conditions & ~m_metConditions) == 0)
+                matched |= u64(1) << compound;
+        }
+
+        if ((matched & m_query.m_last) != 0)
+            m_matches.push_back({ .name = std::move(m_name), .offset = m_offset });
+
+        auto& parent = m_frames.back();
+        const auto ancestors = parent.matched | parent.ancestors;
+        parent.previousChild = matched;
+        parent.previousChildren |= matched;
+        m_frames.push_back({ .matched = matched, .ancestors = ancestors });
+    }
+
+    SelectResult Select(const Query& query, const QString& source)
+    {
+        return SelectDocument(LexerDetail::LexingTokens{ source }, query);
+    }
+
+    SelectResult Select(const Query& query, const TokenBuffer& tokens)
+    {
+        return SelectDocument(BufferedTokens{ tokens }, query);
+    }
+
+    std::vector<Node> Select(const Query& query, const Document& document)
+    {
+        QueryWalker walker{ query };
+        walker.walk(document.nodes(), true, 0, 0);
+        return std::move(walker.nodes());
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/Document.h>
+#include <KDL/EventParser.h>
+#include <KDL/TokenBuffer.h>
+#include <Defines.h>
+
+#include <QString>
+
+#include <optional>
+#include <vector>
+
+namespace KDL
+{
+    enum class KDL_API QueryStatus
+    {
+        Ok,
+        // A character that can't appear where it was found
+        UnexpectedCharacter,
+        // A name or value that isn't a single KDL string, number or keyword
+        InvalidValue,
+        // values() and props() aren't supported
+        UnsupportedAccessor,
+        // More than 64 node matchers or 64 accessor matchers in one query
+        TooComplex
+    };
+
+    // A KQL selector list compiled into bit masks. Every node matcher of every selector gets one bit, a node
+    // matches the bits whose matcher accepts it and whose predecessor matched its parent, an ancestor or a
+    // previous sibling, as the combinator requires. Matching a node is a few mask operations plus the
+    // matchers of the bits still possible, subtrees where no bit can be reached are skipped.
+    //
+    // Supported: the combinators " ", ">", "+" and "~", selector lists with ",", "top() >", node names, type
+    // annotations with "(type)" and "()", and the accessors val(), val(n), prop(name) or just name, name() and
+    // tag() with the operators =, !=, <, <=, >, >=, ^=, $= and *=. Numbers compare by value, the ordering
+    // operators only compare numbers and ^=, $= and *= only strings. A missing value fails every operator.
+    class KDL_API Query
+    {
+    public:
+        Query() = default;
+
+    private:
+        friend class QueryCompiler;
+        friend class QueryMatcher;
+        friend class QueryWalker;
+
+        enum class Combinator : u8
+        {
+            Descendant,
+            Child,
+            NextSibling,
+            Sibling
+        };
+
+        enum class TypeMatch : u8
+        {
+            Any,
+            // "()" matches every node with a type annotation
+            Annotated,
+            Equal
+        };
+
+        enum class Accessor : u8
+        {
+            Name,
+            Tag,
+            Value,
+            Property
+        };
+
+        enum class Operator : u8
+        {
+            Exists,
+            Equal,
+            NotEqual,
+            Less,
+            LessOrEqual,
+            Greater,
+            GreaterOrEqual,
+            StartsWith,
+            EndsWith,
+            Contains
+        };
+
+        struct StringSpan
+        {
+            i32 offset = 0;
+            // -1 if there is no string
+            i32 length = -1;
+        };
+
+        struct Condition
+        {
+            Accessor accessor;
+            Operator op;
+            // Argument index for val(n)
+            i32 index = 0;
+            // Property name for prop(name)
+            StringSpan name;
+            ValueType type = ValueType::Null;
+            StringSpan text;
+            std::optional<double> number;
+        };
+
+        struct Compound
+        {
+            StringSpan name;
+            TypeMatch typeMatch = TypeMatch::Any;
+            StringSpan typeAnnotation;
+            // Bit i is set for condition i
+            u64 conditions = 0;
+        };
+
+        [[nodiscard]] QStringView string(StringSpan span) const noexcept;
+
+        // The bits that a node can match, given the bits matched by its parent, by the ancestors of its
+        // parent, by its previous sibling and by all of its previous siblings
+        [[nodiscard]] u64 reachable(bool isTopLevel, u64 parent, u64 ancestors, u64 previousSibling, u64 previousSiblings) const noexcept;
+        // Whether any descendant of a node can match
+        [[nodiscard]] bool isReachableBelow(u64 matched, u64 ancestors) const noexcept;
+
+        [[nodiscard]] bool matchesNameAndType(i32 compound, QStringView name, std::optional<QStringView> typeAnnotation) const noexcept;
+        // number is only needed if the condition has a number and the value is one
+        [[nodiscard]] bool test(const Condition& condition, ValueType type, QStringView text, std::optional<double> number) const noexcept;
+
+        QString m_strings;
+        std::vector<Compound> m_compounds;
+        std::vector<Condition> m_conditions;
+        // First and last bits of the selectors, the first bits that only match top-level nodes and the bits
+        // by the combinator in front of them
+        u64 m_first = 0;
+        u64 m_last = 0;
+        u64 m_top = 0;
+        u64 m_child = 0;
+        u64 m_descendant = 0;
+        u64 m_nextSibling = 0;
+        u64 m_sibling = 0;
+    };
+
+    struct KDL_API QueryResult
+    {
+        // Empty unless status is QueryStatus::Ok
+        Query query;
+        QueryStatus status = QueryStatus::Ok;
+        // Offset into the selector
+        i32 errorOffset = 0;
+    };
+
+    KDL_API [[nodiscard]] QueryResult CompileQuery(QStringView selector);
+
+    struct KDL_API QueryMatch
+    {
+        QString name;
+        // Source offset of the node name
+        i32 offset = 0;
+    };
+
+    // Matches the events of one document against a query, as the handler of an EventParser. A node is
+    // matched once its arguments and properties have been seen, before its children.
+    class KDL_API QueryMatcher
+    {
+    public:
+        explicit QueryMatcher(const Query& query);
+
+        void beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32 offset);
+        void argument(const EventValue& value);
+        void property(QStringView name, const EventValue& value, i32 offset);
+        void beginChildren();
+        void endChildren();
+        void endNode();
+
+        [[nodiscard]] const std::vector<QueryMatch>& matches() const noexcept;
+
+    private:
+        struct Frame
+        {
+            u64 matched = 0;
+            u64 ancestors = 0;
+            // Of the children seen so far
+            u64 previousChild = 0;
+            u64 previousChildren = 0;
+        };
+
+        void setCondition(i32 condition, bool isMet) noexcept;
+        void endEntries();
+
+        const Query& m_query;
+        std::vector<Frame> m_frames;
+        std::vector<QueryMatch> m_matches;
+
+        // The node whose arguments and properties are being reported
+        bool m_isInEntries = false;
+        u64 m_candidates = 0;
+        u64 m_pendingConditions = 0;
+        u64 m_metConditions = 0;
+        i32 m_argumentIndex = 0;
+        i32 m_offset = 0;
+        QString m_name;
+    };
+
+    struct KDL_API SelectResult
+    {
+        // Nodes are only matched up to a syntax error
+        ParseStatus status = ParseStatus::Ok;
+        i32 errorOffset = 0;
+        std::vector<QueryMatch> matches;
+    };
+
+    // Matches while parsing, no document is built
+    KDL_API [[nodiscard]] SelectResult Select(const Query& query, const QString& source);
+    KDL_API [[nodiscard]] SelectResult Select(const Query& query, const TokenBuffer& tokens);
+    // The matching nodes in document order
+    KDL_API [[nodiscard]] std::vector<Node> Select(const Query& query, const Document& document);
+}
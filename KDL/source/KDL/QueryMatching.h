@@ -0,0 +1,23 @@
+#pragma once
+
+#include <KDL/EventParser.h>
+#include <KDL/Query.h>
+
+namespace KDL
+{
+    // Parses the tokens and matches the nodes against the query, shared by the buffered and the fused selection
+    template<typename TTokens>
+    [[nodiscard]] SelectResult SelectDocument(TTokens tokens, const Query& query)
+    {
+        SelectResult result{};
+        ParseBuffers buffers{};
+        QueryMatcher matcher{ query };
+        EventParser<QueryMatcher, TTokens> parser{ tokens, matcher, buffers };
+        result.status = parser.parse();
+        if (result.status != ParseStatus::Ok)
+            result.errorOffset = parser.errorOffset();
+
+        result.matches = matcher.matches();
+        return result;
+    }
+}
@@ -0,0 +1,962 @@
+#include <KDL/Schema.h>
+#include <KDL/Document.h>
+#include <KDL/LexToken.h>
+#include <KDL/Number.h>
+#include <KDL/SchemaValidation.h>
+
+#include <QHash>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace
+{
+    using namespace KDL;
+
+    enum class Format : u8
+    {
+        Int8,
+        Int16,
+        Int32,
+        Int64,
+        UInt8,
+        UInt16,
+        UInt32,
+        UInt64,
+        Float32,
+        Float64,
+        Date,
+        Time,
+        DateTime,
+        Uuid,
+        Regex,
+        // Known to KDL Schema but not checked
+        Unchecked
+    };
+
+    struct FormatName
+    {
+        QStringView name;
+        Format format;
+    };
+
+    const FormatName FormatNames[] = {
+        { u"i8", Format::Int8 },
+        { u"i16", Format::Int16 },
+        { u"i32", Format::Int32 },
+        { u"i64", Format::Int64 },
+        { u"isize", Format::Int64 },
+        { u"u8", Format::UInt8 },
+        { u"u16", Format::UInt16 },
+        { u"u32", Format::UInt32 },
+        { u"u64", Format::UInt64 },
+        { u"usize", Format::UInt64 },
+        { u"f32", Format::Float32 },
+        { u"f64", Format::Float64 },
+        { u"date", Format::Date },
+        { u"time", Format::Time },
+        { u"date-time", Format::DateTime },
+        { u"uuid", Format::Uuid },
+        { u"regex", Format::Regex },
+        { u"duration", Format::Unchecked },
+        { u"decimal", Format::Unchecked },
+        { u"currency", Format::Unchecked },
+        { u"country-2", Format::Unchecked },
+        { u"country-3", Format::Unchecked },
+        { u"country-subdivision", Format::Unchecked },
+        { u"email", Format::Unchecked },
+        { u"idn-email", Format::Unchecked },
+        { u"hostname", Format::Unchecked },
+        { u"idn-hostname", Format::Unchecked },
+        { u"ipv4", Format::Unchecked },
+        { u"ipv6", Format::Unchecked },
+        { u"url", Format::Unchecked },
+        { u"url-reference", Format::Unchecked },
+        { u"irl", Format::Unchecked },
+        { u"irl-reference", Format::Unchecked },
+        { u"url-template", Format::Unchecked },
+        { u"kdl-query", Format::Unchecked },
+        { u"decimal64", Format::Unchecked },
+        { u"decimal128", Format::Unchecked },
+    };
+
+    [[nodiscard]] std::optional<Format> FormatOf(QStringView name) noexcept
+    {
+        for (const auto& format : FormatNames)
+        {
+            if (format.name == name)
+                return format.format;
+        }
+
+        return std::nullopt;
+    }
+
+    [[nodiscard]] constexpr u32 FormatBit(Format format) noexcept
+    {
+        return u32(1) << static_cast<u32>(format);
+    }
+
+    [[nodiscard]] constexpr u8 TypeBit(ValueType type) noexcept
+    {
+        return static_cast<u8>(1 << static_cast<u8>(type));
+    }
+
+    [[nodiscard]] bool IsNumber(ValueType type) noexcept
+    {
+        return type == ValueType::Integer || type == ValueType::Float;
+    }
+
+    [[nodiscard]] std::optional<double> NumberOf(const EventValue& value) noexcept
+    {
+        const auto result = DecodeDouble(Token{ .kind = value.kind, .stringView = value.text });
+        if (result.status != NumberStatus::Ok)
+            return std::nullopt;
+
+        return result.value;
+    }
+
+    template<typename T>
+    [[nodiscard]] bool FitsInteger(const EventValue& value) noexcept
+    {
+        if (value.type != ValueType::Integer)
+            return false;
+
+        const auto token = Token{ .kind = value.kind, .stringView = value.text };
+        if constexpr (std::is_signed_v<T>)
+        {
+            const auto result = DecodeInt64(token);
+            return result.status == NumberStatus::Ok && std::in_range<T>(result.value);
+        }
+        else
+        {
+            const auto result = DecodeUInt64(token);
+            return result.status == NumberStatus::Ok && std::in_range<T>(result.value);
+        }
+    }
+
+    // Value of count decimal digits at start, -1 if one of them isn't a digit
+    [[nodiscard]] i32 DigitsAt(QStringView text, qsizetype start, qsizetype count) noexcept
+    {
+        if (start + count > text.size())
+            return -1;
+
+        auto value = 0;
+        for (auto i = start; i < start + count; i++)
+        {
+            const auto c = text[i].unicode();
+            if (c < u'0' || c > u'9')
+                return -1;
+
+            value = value * 10 + (c - u'0');
+        }
+
+        return value;
+    }
+
+    // YYYY-MM-DD
+    [[nodiscard]] bool IsDate(QStringView text) noexcept
+    {
+        if (text.size() != 10 || text[4] != u'-' || text[7] != u'-' || DigitsAt(text, 0, 4) < 0)
+            return false;
+
+        const auto month = DigitsAt(text, 5, 2);
+        const auto day = DigitsAt(text, 8, 2);
+        return month >= 1 && month <= 12 && day >= 1 && day <= 31;
+    }
+
+    // HH:MM:SS with an optional fraction and an optional Z or +HH:MM offset
+    [[nodiscard]] bool IsTime(QStringView text) noexcept
+    {
+        if (text.size() < 8 || text[2] != u':' || text[5] != u':')
+            return false;
+
+        const auto hours = DigitsAt(text, 0, 2);
+        const auto minutes = DigitsAt(text, 3, 2);
+        const auto seconds = DigitsAt(text, 6, 2);
+        if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59 || seconds < 0 || seconds > 60)
+            return false;
+
+        auto index = qsizetype(8);
+        if (index < text.size() && text[index] == u'.')
+        {
+            const auto fractionStart = ++index;
+            while (index < text.size() && DigitsAt(text, index, 1) >= 0)
+                index++;
+
+            if (index == fractionStart)
+                return false;
+        }
+
+        if (index == text.size())
+            return true;
+        if (text[index] == u'Z' || text[index] == u'z')
+            return index + 1 == text.size();
+        if (text[index] != u'+' && text[index] != u'-')
+            return false;
+
+        const auto offset = text.sliced(index + 1);
+        return offset.size() == 5 && offset[2] == u':' && DigitsAt(offset, 0, 2) >= 0 && DigitsAt(offset, 3, 2) >= 0;
+    }
+
+    [[nodiscard]] bool IsDateTime(QStringView text) noexcept
+    {
+        return text.size() > 11 && (text[10] == u'T' || text[10] == u't') && IsDate(text.first(10)) && IsTime(text.sliced(11));
+    }
+
+    // 8-4-4-4-12 hexadecimal digits
+    [[nodiscard]] bool IsUuid(QStringView text) noexcept
+    {
+        if (text.size() != 36)
+            return false;
+
+        for (auto i = 0; i < 36; i++)
+        {
+            const auto c = text[i].unicode();
+            if (i == 8 || i == 13 || i == 18 || i == 23)
+            {
+                if (c != u'-')
+                    return false;
+            }
+            else if (!((c >= u'0' && c <= u'9') || (c >= u'a' && c <= u'f') || (c >= u'A' && c <= u'F')))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] bool MatchesFormat(Format format, const EventValue& value)
+    {
+        const auto isString = value.type == ValueType::String;
+        switch (format)
+        {
+        case Format::Int8:
+            return FitsInteger<int8_t>(value);
+        case Format::Int16:
+            return FitsInteger<int16_t>(value);
+        case Format::Int32:
+            return FitsInteger<i32>(value);
+        case Format::Int64:
+            return FitsInteger<i64>(value);
+        case Format::UInt8:
+            return FitsInteger<u8>(value);
+        case Format::UInt16:
+            return FitsInteger<u16>(value);
+        case Format::UInt32:
+            return FitsInteger<u32>(value);
+        case Format::UInt64:
+            return FitsInteger<u64>(value);
+        case Format::Float32:
+        {
+            const auto number = IsNumber(value.type) ? NumberOf(value) : std::nullopt;
+            return number && (!std::isfinite(*number) || std::abs(*number) <= std::numeric_limits<float>::max());
+        }
+        case Format::Float64:
+            return IsNumber(value.type) && NumberOf(value).has_value();
+        case Format::Date:
+            return isString && IsDate(value.text);
+        case Format::Time:
+            return isString && IsTime(value.text);
+        case Format::DateTime:
+            return isString && IsDateTime(value.text);
+        case Format::Uuid:
+            return isString && IsUuid(value.text);
+        case Format::Regex:
+            return isString && QRegularExpression(value.text.toString()).isValid();
+        case Format::Unchecked:
+            return true;
+        }
+
+        return true;
+    }
+
+    // Only the [id="..."] form of KDL Query is supported
+    [[nodiscard]] std::optional<QStringView> ReferencedId(QStringView query) noexcept
+    {
+        const auto prefix = QStringView(u"[id=\"");
+        const auto suffix = QStringView(u"\"]");
+        if (query.size() < prefix.size() + suffix.size() || !query.startsWith(prefix) || query.last(suffix.size()) != suffix)
+            return std::nullopt;
+
+        return query.sliced(prefix.size(), query.size() - prefix.size() - suffix.size());
+    }
+}
+
+namespace KDL
+{
+    QStringView Schema::string(StringSpan span) const noexcept
+    {
+        if (span.length < 0)
+            return {};
+
+        return QStringView(m_strings).sliced(span.offset, span.length);
+    }
+
+    // Turns the nodes of a schema document into the tables of a Schema. Rules with an id are compiled once,
+    // so refs to them and recursive rules share one entry.
+    class SchemaCompiler
+    {
+    public:
+        SchemaCompiler(Schema& schema, const Document& document)
+            : m_schema{ schema }
+            , m_document{ document }
+        {
+        }
+
+        [[nodiscard]] SchemaStatus compile()
+        {
+            collectIds(m_document.nodes());
+
+            for (const auto node : m_document.nodes())
+            {
+                if (node.name() != u"document")
+                    continue;
+
+                m_schema.m_topLevel = compileChildSet({ node });
+                return m_status;
+            }
+
+            return SchemaStatus::MissingDocument;
+        }
+
+        [[nodiscard]] const QString& errorName() const noexcept
+        {
+            return m_errorName;
+        }
+
+    private:
+        void collectIds(NodeRange nodes)
+        {
+            for (const auto node : nodes)
+            {
+                if (const auto id = node.property(u"id"); id && id->type() == ValueType::String)
+                {
+                    m_ids.insert(id->string().toString(), static_cast<i32>(m_identified.size()));
+                    m_identified.push_back(node);
+                }
+
+                collectIds(node.children());
+            }
+        }
+
+        bool fail(SchemaStatus status, QStringView name)
+        {
+            if (m_status == SchemaStatus::Ok)
+            {
+                m_status = status;
+                m_errorName = name.toString();
+            }
+
+            return false;
+        }
+
+        [[nodiscard]] Schema::StringSpan store(QStringView text)
+        {
+            const auto offset = static_cast<i32>(m_schema.m_strings.size());
+            m_schema.m_strings.append(text);
+            return { .offset = offset, .length = static_cast<i32>(text.size()) };
+        }
+
+        // The node a ref points to, or the node itself if it has none
+        [[nodiscard]] std::optional<Node> resolve(Node node)
+        {
+            // Refs can point to refs, a limit keeps cycles of them from hanging the compiler
+            for (auto depth = 0; depth < 64; depth++)
+            {
+                const auto ref = node.property(u"ref");
+                if (!ref)
+                    return node;
+
+                const auto id = ReferencedId(ref->string());
+                if (!id || !m_ids.contains(id->toString()))
+                {
+                    fail(SchemaStatus::UnresolvedReference, ref->string());
+                    return std::nullopt;
+                }
+
+                node = m_identified[m_ids.value(id->toString())];
+            }
+
+            fail(SchemaStatus::UnresolvedReference, node.name());
+            return std::nullopt;
+        }
+
+        [[nodiscard]] bool readCount(Node node, i32& count)
+        {
+            const auto value = node.argumentCount() > 0 ? node.argument(0).toInt64() : NumberResult<i64>{};
+            if (value.status != NumberStatus::Ok || value.value < 0 || value.value > std::numeric_limits<i32>::max())
+                return fail(SchemaStatus::InvalidRule, node.name());
+
+            count = static_cast<i32>(value.value);
+            return true;
+        }
+
+        [[nodiscard]] bool readNumber(Node node, std::optional<double>& number)
+        {
+            const auto value = node.argumentCount() > 0 ? node.argument(0).toDouble() : NumberResult<double>{};
+            if (value.status != NumberStatus::Ok)
+                return fail(SchemaStatus::InvalidRule, node.name());
+
+            number = value.value;
+            return true;
+        }
+
+        [[nodiscard]] bool readFlag(Node node, bool& flag)
+        {
+            if (node.argumentCount() == 0 || node.argument(0).type() != ValueType::Boolean)
+                return fail(SchemaStatus::InvalidRule, node.name());
+
+            flag = node.argument(0).boolean();
+            return true;
+        }
+
+        [[nodiscard]] bool readTypes(Node node, u8& types)
+        {
+            for (auto i = 0; i < node.argumentCount(); i++)
+            {
+                const auto type = node.argument(i).string();
+                if (type == u"string")
+                    types |= TypeBit(ValueType::String);
+                else if (type == u"number")
+                    types |= TypeBit(ValueType::Integer) | TypeBit(ValueType::Float);
+                else if (type == u"boolean")
+                    types |= TypeBit(ValueType::Boolean);
+                else if (type == u"null")
+                    types |= TypeBit(ValueType::Null);
+                else
+                    return fail(SchemaStatus::InvalidRule, type);
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] bool readFormats(Node node, u32& formats)
+        {
+            for (auto i = 0; i < node.argumentCount(); i++)
+            {
+                const auto format = FormatOf(node.argument(i).string());
+                if (!format)
+                    return fail(SchemaStatus::InvalidRule, node.argument(i).string());
+
+                formats |= FormatBit(*format);
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] bool readPatterns(Node node)
+        {
+            for (auto i = 0; i < node.argumentCount(); i++)
+            {
+                const auto pattern = node.argument(i).string();
+                auto expression = QRegularExpression(pattern.toString());
+                if (!expression.isValid())
+                    return fail(SchemaStatus::InvalidRule, pattern);
+
+                // Compiles the pattern now, so validating threads only ever read it
+                expression.optimize();
+                m_schema.m_patterns.push_back(std::move(expression));
+            }
+
+            return true;
+        }
+
+        // The validations of a value or prop node, the counts of a value and the required flag of a prop
+        [[nodiscard]] i32 compileCheck(Node node, i32* minValues, i32* maxValues, bool* isRequired)
+        {
+            auto check = Schema::Check{
+                .firstEnumValue = static_cast<i32>(m_schema.m_enumValues.size()),
+                .firstPattern = static_cast<i32>(m_schema.m_patterns.size())
+            };
+
+            for (const auto child : node.children())
+            {
+                const auto name = child.name();
+                auto isValid = true;
+                if (name == u"type")
+                {
+                    isValid = readTypes(child, check.types);
+                }
+                else if (name == u"enum")
+                {
+                    for (auto i = 0; i < child.argumentCount(); i++)
+                    {
+                        const auto value = child.argument(i);
+                        m_schema.m_enumValues.push_back({
+                            .type = value.type(),
+                            .text = store(value.string()),
+                            .number = IsNumber(value.type()) ? value.toDouble().value : 0.0
+                        });
+                    }
+                }
+                else if (name == u"pattern")
+                {
+                    isValid = readPatterns(child);
+                }
+                else if (name == u"min-length")
+                {
+                    isValid = readCount(child, check.minLength);
+                }
+                else if (name == u"max-length")
+                {
+                    isValid = readCount(child, check.maxLength);
+                }
+                else if (name == u"format")
+                {
+                    isValid = readFormats(child, check.formats);
+                }
+                else if (name == u"%")
+                {
+                    isValid = readNumber(child, check.multipleOf);
+                }
+                else if (name == u">")
+                {
+                    isValid = readNumber(child, check.greater);
+                }
+                else if (name == u">=")
+                {
+                    isValid = readNumber(child, check.greaterOrEqual);
+                }
+                else if (name == u"<")
+                {
+                    isValid = readNumber(child, check.less);
+                }
+                else if (name == u"<=")
+                {
+                    isValid = readNumber(child, check.lessOrEqual);
+                }
+                else if (name == u"min" && minValues != nullptr)
+                {
+                    isValid = readCount(child, *minValues);
+                }
+                else if (name == u"max" && maxValues != nullptr)
+                {
+                    isValid = readCount(child, *maxValues);
+                }
+                else if (name == u"required" && isRequired != nullptr)
+                {
+                    isValid = readFlag(child, *isRequired);
+                }
+
+                if (!isValid)
+                    return -1;
+            }
+
+            check.enumValueCount = static_cast<i32>(m_schema.m_enumValues.size()) - check.firstEnumValue;
+            check.patternCount = static_cast<i32>(m_schema.m_patterns.size()) - check.firstPattern;
+            m_schema.m_checks.push_back(check);
+            return static_cast<i32>(m_schema.m_checks.size()) - 1;
+        }
+
+        [[nodiscard]] i32 compileRule(Node node)
+        {
+            const auto target = resolve(node);
+            if (!target)
+                return -1;
+
+            const auto id = target->property(u"id");
+            const auto idText = id ? id->string().toString() : QString();
+            if (id && m_ruleIds.contains(idText))
+                return m_ruleIds.value(idText);
+
+            // The rule is registered before its children are compiled, so a rule can contain itself
+            const auto index = static_cast<i32>(m_schema.m_rules.size());
+            auto rule = Schema::NodeRule{};
+            if (target->argumentCount() > 0)
+                rule.name = store(target->argument(0).string());
+
+            m_schema.m_rules.push_back(rule);
+            if (id)
+                m_ruleIds.insert(idText, index);
+
+            std::vector<Schema::PropertyRule> properties{};
+            std::vector<Node> childBlocks{};
+            for (const auto child : target->children())
+            {
+                const auto name = child.name();
+                auto isValid = true;
+                if (name == u"min")
+                {
+                    isValid = readCount(child, rule.min);
+                }
+                else if (name == u"max")
+                {
+                    isValid = readCount(child, rule.max);
+                }
+                else if (name == u"value")
+                {
+                    const auto value = resolve(child);
+                    rule.valueCheck = value ? compileCheck(*value, &rule.minValues, &rule.maxValues, nullptr) : -1;
+                    isValid = rule.valueCheck >= 0;
+                }
+                else if (name == u"prop")
+                {
+                    const auto property = resolve(child);
+                    if (!property)
+                        return -1;
+                    if (property->argumentCount() == 0 || property->argument(0).type() != ValueType::String)
+                    {
+                        fail(SchemaStatus::InvalidRule, name);
+                        return -1;
+                    }
+
+                    auto propertyRule = Schema::PropertyRule{ .name = store(property->argument(0).string()) };
+                    propertyRule.check = compileCheck(*property, nullptr, nullptr, &propertyRule.isRequired);
+                    isValid = propertyRule.check >= 0;
+                    properties.push_back(propertyRule);
+                }
+                else if (name == u"children")
+                {
+                    childBlocks.push_back(child);
+                }
+                else if (name == u"other-props-allowed")
+                {
+                    isValid = readFlag(child, rule.otherPropertiesAllowed);
+                }
+
+                if (!isValid)
+                    return -1;
+            }
+
+            rule.firstProperty = static_cast<i32>(m_schema.m_properties.size());
+            rule.propertyCount = static_cast<i32>(properties.size());
+            m_schema.m_properties.insert(m_schema.m_properties.end(), properties.begin(), properties.end());
+
+            if (!childBlocks.empty())
+            {
+                rule.children = compileChildSet(childBlocks);
+                if (rule.children < 0)
+                    return -1;
+            }
+
+            m_schema.m_rules[index] = rule;
+            return index;
+        }
+
+        // All node rules of the children blocks, the document node counts as one for the top level
+        [[nodiscard]] i32 compileChildSet(const std::vector<Node>& blocks)
+        {
+            std::vector<Schema::Transition> transitions{};
+            std::optional<Schema::Transition> anyNode{};
+            auto otherNodesAllowed = false;
+            for (const auto& block : blocks)
+            {
+                const auto target = resolve(block);
+                if (!target)
+                    return -1;
+
+                for (const auto child : target->children())
+                {
+                    if (child.name() == u"node")
+                    {
+                        const auto rule = compileRule(child);
+                        if (rule < 0)
+                            return -1;
+
+                        const auto transition = Schema::Transition{ .name = m_schema.m_rules[rule].name, .rule = rule };
+                        if (transition.name.length < 0)
+                            anyNode = transition;
+                        else
+                            transitions.push_back(transition);
+                    }
+                    else if (child.name() == u"other-nodes-allowed" && !readFlag(child, otherNodesAllowed))
+                    {
+                        return -1;
+                    }
+                }
+            }
+
+            std::stable_sort(transitions.begin(), transitions.end(), [&](const Schema::Transition& a, const Schema::Transition& b)
+                {
+                    return m_schema.string(a.name) < m_schema.string(b.name);
+                });
+            if (anyNode)
+                transitions.push_back(*anyNode);
+
+            m_schema.m_childSets.push_back({
+                .firstTransition = static_cast<i32>(m_schema.m_transitions.size()),
+                .transitionCount = static_cast<i32>(transitions.size()),
+                .otherNodesAllowed = otherNodesAllowed
+            });
+            m_schema.m_transitions.insert(m_schema.m_transitions.end(), transitions.begin(), transitions.end());
+            return static_cast<i32>(m_schema.m_childSets.size()) - 1;
+        }
+
+        Schema& m_schema;
+        const Document& m_document;
+        // Nodes with an id property and the index of each id in it
+        std::vector<Node> m_identified;
+        QHash<QString, i32> m_ids;
+        QHash<QString, i32> m_ruleIds;
+        SchemaStatus m_status = SchemaStatus::Ok;
+        QString m_errorName;
+    };
+
+    SchemaResult CompileSchema(const QString& source)
+    {
+        const auto parsed = Parse(source);
+        if (parsed.status != ParseStatus::Ok)
+            return { .status = SchemaStatus::InvalidDocument };
+
+        SchemaResult result{};
+        SchemaCompiler compiler{ result.schema, parsed.document };
+        result.status = compiler.compile();
+        if (result.status != SchemaStatus::Ok)
+        {
+            result.schema = Schema{};
+            result.errorName = compiler.errorName();
+        }
+
+        return result;
+    }
+
+    SchemaValidator::SchemaValidator(const Schema& schema)
+        : m_schema{ schema }
+    {
+        beginFrame(-1, schema.m_topLevel, 0);
+    }
+
+    void SchemaValidator::beginNode(QStringView name, std::optional<QStringView>, i32 offset)
+    {
+        const auto parent = m_frames.back();
+        if (parent.childSet < 0)
+        {
+            beginFrame(-1, -1, offset);
+            return;
+        }
+
+        // Named transitions are sorted, the one for any name is behind them
+        const auto& set = m_schema.m_childSets[parent.childSet];
+        const auto begin = m_schema.m_transitions.begin() + set.firstTransition;
+        const auto end = begin + set.transitionCount;
+        const auto hasAnyNode = set.transitionCount > 0 && (end - 1)->name.length < 0;
+        const auto namedEnd = hasAnyNode ? end - 1 : end;
+        auto transition = std::lower_bound(begin, namedEnd, name, [&](const Schema::Transition& transition, QStringView name)
+            {
+                return m_schema.string(transition.name) < name;
+            });
+        if (transition == namedEnd || m_schema.string(transition->name) != name)
+            transition = hasAnyNode ? end - 1 : end;
+
+        if (transition == end)
+        {
+            if (!set.otherNodesAllowed)
+                report(ViolationKind::UnknownNode, name, offset);
+
+            beginFrame(-1, -1, offset);
+            return;
+        }
+
+        const auto& rule = m_schema.m_rules[transition->rule];
+        auto& count = m_counts[parent.firstCount + (transition - begin)];
+        count++;
+        if (rule.max >= 0 && count > rule.max)
+            report(ViolationKind::TooManyNodes, name, offset);
+
+        beginFrame(transition->rule, rule.children, offset);
+    }
+
+    void SchemaValidator::argument(const EventValue& value)
+    {
+        auto& frame = m_frames.back();
+        if (frame.rule < 0)
+            return;
+
+        const auto& rule = m_schema.m_rules[frame.rule];
+        frame.valueCount++;
+        if (rule.valueCheck < 0)
+            return;
+
+        const auto name = m_schema.string(rule.name);
+        if (rule.maxValues >= 0 && frame.valueCount > rule.maxValues)
+            report(ViolationKind::TooManyValues, name, value.offset);
+        else
+            check(rule.valueCheck, value, name);
+    }
+
+    void SchemaValidator::property(QStringView name, const EventValue& value, i32 offset)
+    {
+        const auto& frame = m_frames.back();
+        if (frame.rule < 0)
+            return;
+
+        const auto& rule = m_schema.m_rules[frame.rule];
+        for (auto i = 0; i < rule.propertyCount; i++)
+        {
+            const auto& propertyRule = m_schema.m_properties[rule.firstProperty + i];
+            if (m_schema.string(propertyRule.name) != name)
+                continue;
+
+            const auto transitionCount = frame.childSet >= 0 ? m_schema.m_childSets[frame.childSet].transitionCount : 0;
+            m_counts[frame.firstCount + transitionCount + i] = 1;
+            check(propertyRule.check, value, name);
+            return;
+        }
+
+        if (!rule.otherPropertiesAllowed)
+            report(ViolationKind::UnknownProperty, name, offset);
+    }
+
+    void SchemaValidator::beginChildren()
+    {
+    }
+
+    void SchemaValidator::endChildren()
+    {
+    }
+
+    void SchemaValidator::endNode()
+    {
+        endFrame(m_frames.back().offset);
+    }
+
+    void SchemaValidator::finish(i32 sourceSize)
+    {
+        if (m_frames.size() == 1)
+            endFrame(sourceSize);
+    }
+
+    const std::vector<Violation>& SchemaValidator::violations() const noexcept
+    {
+        return m_violations;
+    }
+
+    void SchemaValidator::beginFrame(i32 rule, i32 childSet, i32 offset)
+    {
+        const auto firstCount = static_cast<i32>(m_counts.size());
+        auto countCount = 0;
+        if (childSet >= 0)
+            countCount += m_schema.m_childSets[childSet].transitionCount;
+        if (rule >= 0)
+            countCount += m_schema.m_rules[rule].propertyCount;
+
+        m_counts.resize(firstCount + countCount, 0);
+        m_frames.push_back({ .rule = rule, .childSet = childSet, .firstCount = firstCount, .offset = offset });
+    }
+
+    void SchemaValidator::endFrame(i32 offset)
+    {
+        const auto frame = m_frames.back();
+        m_frames.pop_back();
+
+        auto transitionCount = 0;
+        if (frame.childSet >= 0)
+        {
+            const auto& set = m_schema.m_childSets[frame.childSet];
+            transitionCount = set.transitionCount;
+            for (auto i = 0; i < set.transitionCount; i++)
+            {
+                const auto& rule = m_schema.m_rules[m_schema.m_transitions[set.firstTransition + i].rule];
+                if (m_counts[frame.firstCount + i] < rule.min)
+                    report(ViolationKind::TooFewNodes, m_schema.string(rule.name), offset);
+            }
+        }
+
+        if (frame.rule >= 0)
+        {
+            const auto& rule = m_schema.m_rules[frame.rule];
+            for (auto i = 0; i < rule.propertyCount; i++)
+            {
+                const auto& propertyRule = m_schema.m_properties[rule.firstProperty + i];
+                if (propertyRule.isRequired && m_counts[frame.firstCount + transitionCount + i] == 0)
+                    report(ViolationKind::MissingProperty, m_schema.string(propertyRule.name), offset);
+            }
+
+            if (rule.valueCheck >= 0 && frame.valueCount < rule.minValues)
+                report(ViolationKind::TooFewValues, m_schema.string(rule.name), offset);
+        }
+
+        m_counts.resize(frame.firstCount);
+    }
+
+    void SchemaValidator::check(i32 checkIndex, const EventValue& value, QStringView name)
+    {
+        const auto& check = m_schema.m_checks[checkIndex];
+        if (check.types != 0 && (check.types & TypeBit(value.type)) == 0)
+        {
+            // The other validations don't apply to a value of the wrong type
+            report(ViolationKind::WrongType, name, value.offset);
+            return;
+        }
+
+        if (check.enumValueCount > 0)
+        {
+            const auto begin = m_schema.m_enumValues.begin() + check.firstEnumValue;
+            const auto isListed = std::any_of(begin, begin + check.enumValueCount, [&](const Schema::EnumValue& enumValue)
+                {
+                    if (IsNumber(value.type) && IsNumber(enumValue.type))
+                        return NumberOf(value) == enumValue.number;
+
+                    return value.type == enumValue.type && m_schema.string(enumValue.text) == value.text;
+                });
+            if (!isListed)
+                report(ViolationKind::NotInEnum, name, value.offset);
+        }
+
+        if (value.type == ValueType::String)
+        {
+            if (check.patternCount > 0)
+            {
+                const auto text = value.text.toString();
+                for (auto i = 0; i < check.patternCount; i++)
+                {
+                    if (!m_schema.m_patterns[check.firstPattern + i].match(text).hasMatch())
+                        report(ViolationKind::PatternMismatch, name, value.offset);
+                }
+            }
+
+            if (check.minLength >= 0 || check.maxLength >= 0)
+            {
+                // Lengths count code points
+                const auto length = std::count_if(value.text.begin(), value.text.end(), [](QChar c) { return !c.isLowSurrogate(); });
+                if (check.minLength >= 0 && length < check.minLength)
+                    report(ViolationKind::TooShort, name, value.offset);
+                if (check.maxLength >= 0 && length > check.maxLength)
+                    report(ViolationKind::TooLong, name, value.offset);
+            }
+        }
+
+        if (IsNumber(value.type) && (check.greater || check.greaterOrEqual || check.less || check.lessOrEqual || check.multipleOf))
+        {
+            const auto number = NumberOf(value).value_or(std::numeric_limits<double>::quiet_NaN());
+            if ((check.greater && !(number > *check.greater)) || (check.greaterOrEqual && !(number >= *check.greaterOrEqual))
+                || (check.less && !(number < *check.less)) || (check.lessOrEqual && !(number <= *check.lessOrEqual)))
+                report(ViolationKind::OutOfRange, name, value.offset);
+
+            if (check.multipleOf && *check.multipleOf != 0.0 && std::fmod(number, *check.multipleOf) != 0.0)
+                report(ViolationKind::NotMultiple, name, value.offset);
+        }
+
+        if (check.formats != 0 && (check.formats & FormatBit(Format::Unchecked)) == 0)
+        {
+            auto isFormatted = false;
+            for (auto format = u32(0); format < static_cast<u32>(Format::Unchecked) && !isFormatted; format++)
+            {
+                if ((check.formats & (u32(1) << format)) != 0)
+                    isFormatted = MatchesFormat(static_cast<Format>(format), value);
+            }
+
+            if (!isFormatted)
+                report(ViolationKind::InvalidFormat, name, value.offset);
+        }
+    }
+
+    void SchemaValidator::report(ViolationKind kind, QStringView name, i32 offset)
+    {
+        m_violations.push_back({ .kind = kind, .name = name.toString(), .offset = offset });
+    }
+
+    ValidationResult Validate(const Schema& schema, const QString& source)
+    {
+        return ValidateDocument(LexerDetail::LexingTokens{ source }, schema, static_cast<i32>(source.size()));
+    }
+
+    ValidationResult Validate(const Schema& schema, const TokenBuffer& tokens)
+    {
+        return ValidateDocument(BufferedTokens{ tokens }, schema, static_cast<i32>(tokens.source().size()));
+    }
+}
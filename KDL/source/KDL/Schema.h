@@ -0,0 +1,230 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/EventParser.h>
+#include <KDL/TokenBuffer.h>
+#include <Defines.h>
+
+#include <QRegularExpression>
+#include <QString>
+
+#include <optional>
+#include <vector>
+
+namespace KDL
+{
+    enum class KDL_API SchemaStatus
+    {
+        Ok,
+        // The schema isn't valid KDL
+        InvalidDocument,
+        // There is no top-level document node
+        MissingDocument,
+        // A ref that isn't of the form [id="..."] or names an id no node has
+        UnresolvedReference,
+        // A rule without the value it needs, an unknown type or format or a pattern that doesn't compile
+        InvalidRule
+    };
+
+    enum class KDL_API ViolationKind
+    {
+        // A node that no rule of its parent matches, while other nodes aren't allowed
+        UnknownNode,
+        TooFewNodes,
+        TooManyNodes,
+        // A property without a rule, while other properties aren't allowed
+        UnknownProperty,
+        MissingProperty,
+        TooFewValues,
+        TooManyValues,
+        WrongType,
+        NotInEnum,
+        PatternMismatch,
+        TooShort,
+        TooLong,
+        // A number outside of the bounds set with >, >=, < or <=
+        OutOfRange,
+        NotMultiple,
+        InvalidFormat
+    };
+
+    struct KDL_API Violation
+    {
+        ViolationKind kind;
+        // Name of the node or property, for node counts and arguments the name of the rule
+        QString name;
+        // Source offset of the node name or value token. Node counts and missing properties are reported
+        // at the name of the parent, or at the end of the source for the top level.
+        i32 offset = 0;
+    };
+
+    // A KDL Schema compiled into flat tables. Every node rule points to the set of rules its children are
+    // matched against, which makes the rules a state machine that advances on node names. Validation keeps
+    // one frame per open node and never allocates per node, except for reported violations.
+    // A compiled schema is never modified, so one schema can validate on any number of threads at once.
+    //
+    // Supported: node rules with min, max, value, prop, children and other-props-allowed, children blocks
+    // with other-nodes-allowed, refs of the form [id="..."], and the validations type, enum, pattern,
+    // min-length, max-length, format, %, >, >=, < and <=. Formats other than the integer and float types,
+    // date, time, date-time, uuid and regex are accepted without checking. Tags and name validations are
+    // ignored.
+    class KDL_API Schema
+    {
+    public:
+        Schema() = default;
+
+    private:
+        friend class SchemaCompiler;
+        friend class SchemaValidator;
+
+        struct StringSpan
+        {
+            i32 offset = 0;
+            // -1 for the name of a rule that matches any node
+            i32 length = -1;
+        };
+
+        struct EnumValue
+        {
+            ValueType type;
+            StringSpan text;
+            double number;
+        };
+
+        // The validations of one value
+        struct Check
+        {
+            // Bit i is set if ValueType i is allowed, 0 allows all types
+            u8 types = 0;
+            // Bit i is set if format i is allowed, 0 allows all values
+            u32 formats = 0;
+            i32 firstEnumValue = 0;
+            i32 enumValueCount = 0;
+            i32 firstPattern = 0;
+            i32 patternCount = 0;
+            i32 minLength = -1;
+            i32 maxLength = -1;
+            std::optional<double> greater;
+            std::optional<double> greaterOrEqual;
+            std::optional<double> less;
+            std::optional<double> lessOrEqual;
+            std::optional<double> multipleOf;
+        };
+
+        struct PropertyRule
+        {
+            StringSpan name;
+            i32 check;
+            bool isRequired = false;
+        };
+
+        struct NodeRule
+        {
+            StringSpan name;
+            i32 min = 0;
+            // -1 if there is no maximum
+            i32 max = -1;
+            // Arguments are only checked with a value rule
+            i32 valueCheck = -1;
+            i32 minValues = 0;
+            i32 maxValues = -1;
+            i32 firstProperty = 0;
+            i32 propertyCount = 0;
+            bool otherPropertiesAllowed = false;
+            // Children are only checked with a children rule
+            i32 children = -1;
+        };
+
+        // A node name and the rule it leads to, sorted by name within a set. The rule that matches any name is last.
+        struct Transition
+        {
+            StringSpan name;
+            i32 rule;
+        };
+
+        struct ChildSet
+        {
+            i32 firstTransition = 0;
+            i32 transitionCount = 0;
+            bool otherNodesAllowed = false;
+        };
+
+        [[nodiscard]] QStringView string(StringSpan span) const noexcept;
+
+        QString m_strings;
+        std::vector<EnumValue> m_enumValues;
+        // Optimized when compiled, so matching only reads them
+        std::vector<QRegularExpression> m_patterns;
+        std::vector<Check> m_checks;
+        std::vector<PropertyRule> m_properties;
+        std::vector<NodeRule> m_rules;
+        std::vector<Transition> m_transitions;
+        std::vector<ChildSet> m_childSets;
+        // The child set of the document node, for the top-level nodes
+        i32 m_topLevel = -1;
+    };
+
+    struct KDL_API SchemaResult
+    {
+        // Empty unless status is SchemaStatus::Ok
+        Schema schema;
+        SchemaStatus status = SchemaStatus::Ok;
+        // The unresolved ref or the name of the node with the invalid rule
+        QString errorName;
+    };
+
+    KDL_API [[nodiscard]] SchemaResult CompileSchema(const QString& source);
+
+    // Checks the events of one document against a schema in a single pass, as the handler of an EventParser
+    class KDL_API SchemaValidator
+    {
+    public:
+        explicit SchemaValidator(const Schema& schema);
+
+        void beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32 offset);
+        void argument(const EventValue& value);
+        void property(QStringView name, const EventValue& value, i32 offset);
+        void beginChildren();
+        void endChildren();
+        void endNode();
+
+        // Checks the top-level node counts, sourceSize is where they are reported
+        void finish(i32 sourceSize);
+
+        [[nodiscard]] const std::vector<Violation>& violations() const noexcept;
+
+    private:
+        struct Frame
+        {
+            // -1 for nodes that aren't checked
+            i32 rule;
+            i32 childSet;
+            // Node counts of the child set transitions followed by the seen flags of the properties
+            i32 firstCount;
+            i32 valueCount = 0;
+            i32 offset;
+        };
+
+        void beginFrame(i32 rule, i32 childSet, i32 offset);
+        void endFrame(i32 offset);
+        void check(i32 checkIndex, const EventValue& value, QStringView name);
+        void report(ViolationKind kind, QStringView name, i32 offset);
+
+        const Schema& m_schema;
+        std::vector<Frame> m_frames;
+        std::vector<i32> m_counts;
+        std::vector<Violation> m_violations;
+    };
+
+    struct KDL_API ValidationResult
+    {
+        // The document is only checked up to a syntax error
+        ParseStatus status = ParseStatus::Ok;
+        i32 errorOffset = 0;
+        std::vector<Violation> violations;
+    };
+
+    // Parses and validates the source in one pass without building a document
+    KDL_API [[nodiscard]] ValidationResult Validate(const Schema& schema, const QString& source);
+    KDL_API [[nodiscard]] ValidationResult Validate(const Schema& schema, const TokenBuffer& tokens);
+}
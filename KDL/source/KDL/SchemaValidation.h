@@ -0,0 +1,25 @@
+#pragma once
+
+#include <KDL/EventParser.h>
+#include <KDL/Schema.h>
+
+namespace KDL
+{
+    // Parses the tokens and checks them against the schema, shared by the buffered and the fused validation
+    template<typename TTokens>
+    [[nodiscard]] ValidationResult ValidateDocument(TTokens tokens, const Schema& schema, i32 sourceSize)
+    {
+        ValidationResult result{};
+        ParseBuffers buffers{};
+        SchemaValidator validator{ schema };
+        EventParser<SchemaValidator, TTokens> parser{ tokens, validator, buffers };
+        result.status = parser.parse();
+        if (result.status != ParseStatus::Ok)
+            result.errorOffset = parser.errorOffset();
+        else
+            validator.finish(sourceSize);
+
+        result.violations = validator.violations();
+        return result;
+    }
+}
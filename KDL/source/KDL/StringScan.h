@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Defines.h>
+
+#include <bit>
+
+#if !defined(KDL_DISABLE_SIMD)
+#  if defined(__AVX2__)
+#    define KDL_SIMD_AVX2
+#    include <immintrin.h>
+#  elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define KDL_SIMD_SSE2
+#    include <emmintrin.h>
+#  endif
+#endif
+
+namespace KDL
+{
+    // Returns the index of the first unit in [currentIndex, size) that is a quote, a backslash
+    // (only if stopAtBackslash is set) or a null character, or size if there is none.
+    // The lexer uses this to jump over the parts of string bodies that need no inspection.
+    template<typename TUnit>
+    [[nodiscard]] static inline i32 ScalarFindStringDelimiter(const TUnit* data, i32 currentIndex, i32 size, bool stopAtBackslash) noexcept
+    {
+        while (currentIndex < size)
+        {
+            const auto current = data[currentIndex];
+            if (current == TUnit('\"') || current == TUnit('\0') || (stopAtBackslash && current == TUnit('\\')))
+                return currentIndex;
+
+            currentIndex++;
+        }
+
+        return size;
+    }
+
+#if defined(KDL_SIMD_AVX2)
+    [[nodiscard]] static inline i32 FindStringDelimiter(const char16_t* data, i32 currentIndex, i32 size, bool stopAtBackslash) noexcept
+    {
+        const auto quotes = _mm256_set1_epi16(u'\"');
+        const auto backslashes = _mm256_set1_epi16(stopAtBackslash ? u'\\' : u'\"');
+        const auto zeroes = _mm256_setzero_si256();
+
+        while (currentIndex + 16 <= size)
+        {
+            const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + currentIndex));
+            const auto matches = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi16(block, quotes), _mm256_cmpeq_epi16(block, backslashes)),
+                _mm256_cmpeq_epi16(block, zeroes));
+
+            const auto mask = static_cast<u32>(_mm256_movemask_epi8(matches));
+            if (mask != 0)
+                return currentIndex + std::countr_zero(mask) / 2;
+
+            currentIndex += 16;
+        }
+
+        return ScalarFindStringDelimiter(data, currentIndex, size, stopAtBackslash);
+    }
+
+    [[nodiscard]] static inline i32 FindStringDelimiter(const u8* data, i32 currentIndex, i32 size, bool stopAtBackslash) noexcept
+    {
+        const auto quotes = _mm256_set1_epi8('\"');
+        const auto backslashes = _mm256_set1_epi8(stopAtBackslash ? '\\' : '\"');
+        const auto zeroes = _mm256_setzero_si256();
+
+        while (currentIndex + 32 <= size)
+        {
+            const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + currentIndex));
+            const auto matches = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, quotes), _mm256_cmpeq_epi8(block, backslashes)),
+                _mm256_cmpeq_epi8(block, zeroes));
+
+            const auto mask = static_cast<u32>(_mm256_movemask_epi8(matches));
+            if (mask != 0)
+                return currentIndex + std::countr_zero(mask);
+
+            currentIndex += 32;
+        }
+
+        return ScalarFindStringDelimiter(data, currentIndex, size, stopAtBackslash);
+    }
+#elif defined(KDL_SIMD_SSE2)
+    [[nodiscard]] static inline i32 FindStringDelimiter(const char16_t* data, i32 currentIndex, i32 size, bool stopAtBackslash) noexcept
+    {
+        const auto quotes = _mm_set1_epi16(u'\"');
+        const auto backslashes = _mm_set1_epi16(stopAtBackslash ? u'\\' : u'\"');
+        const auto zeroes = _mm_setzero_si128();
+
+        while (currentIndex + 8 <= size)
+        {
+            const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + currentIndex));
+            const auto matches = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi16(block, quotes), _mm_cmpeq_epi16(block, backslashes)),
+                _mm_cmpeq_epi16(block, zeroes));
+
+            const auto mask = static_cast<u32>(_mm_movemask_epi8(matches));
+            if (mask != 0)
+                return currentIndex + std::countr_zero(mask) / 2;
+
+            currentIndex += 8;
+        }
+
+        return ScalarFindStringDelimiter(data, currentIndex, size, stopAtBackslash);
+    }
+
+    [[nodiscard]] static inline i32 FindStringDelimiter(const u8* data, i32 currentIndex, i32 size, bool stopAtBackslash) noexcept
+    {
+        const auto quotes = _mm_set1_epi8('\"');
+        const auto backslashes = _mm_set1_epi8(stopAtBackslash ? '\\' : '\"');
+        const auto zeroes = _mm_setzero_si128();
+
+        while (currentIndex + 16 <= size)
+        {
+            const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + currentIndex));
+            const auto matches = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, quotes), _mm_cmpeq_epi8(block, backslashes)),
+                _mm_cmpeq_epi8(block, zeroes));
+
+            const auto mask = static_cast<u32>(_mm_movemask_epi8(matches));
+            if (mask != 0)
+                return currentIndex + std::countr_zero(mask);
+
+            currentIndex += 16;
+        }
+
+        return ScalarFindStringDelimiter(data, currentIndex, size, stopAtBackslash);
+    }
+#else
+    template<typename TUnit>
+    [[nodiscard]] static inline i32 FindStringDelimiter(const TUnit* data, i32 currentIndex, i32 size, bool stopAtBackslash) noexcept
+    {
+        return ScalarFindStringDelimiter(data, currentIndex, size, stopAtBackslash);
+    }
+#endif
+}
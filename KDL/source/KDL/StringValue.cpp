@@ -0,0 +1,392 @@
+#include <KDL/StringValue.h>
+#include <KDL/CharacterClass.h>
+#include <KDL/LexToken.h>
+
+namespace
+{
+    using namespace KDL;
+
+    // Tokens come out of the lexer, so they are decoded as the lexer decodes them. end bounds the text, a
+    // sequence cut off by it decodes as a single unit.
+    [[nodiscard]] static auto SourceOf(const char16_t* data, i32 end) noexcept
+    {
+        return LexerDetail::Utf16Source{ .Data = data, .Size = end };
+    }
+
+    [[nodiscard]] static auto SourceOf(const u8* data, i32 end) noexcept
+    {
+        return LexerDetail::Utf8Source{ .Data = data, .Size = end };
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static auto Decode(const TUnit* data, i32 index, i32 end) noexcept
+    {
+        return LexerDetail::Decode(SourceOf(data, end), index);
+    }
+
+    // Start of the code point that ends right before index
+    [[nodiscard]] static auto PreviousStart(const char16_t* data, i32 index, i32 begin) noexcept
+    {
+        if (index - 2 >= begin && QChar::isLowSurrogate(data[index - 1]) && QChar::isHighSurrogate(data[index - 2]))
+            return index - 2;
+
+        return index - 1;
+    }
+
+    [[nodiscard]] static auto PreviousStart(const u8* data, i32 index, i32 begin) noexcept
+    {
+        auto start = index - 1;
+        while (start > begin && index - start < 4 && (data[start] & 0xC0) == 0x80)
+            start--;
+
+        return start;
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static auto NewlineSize(const TUnit* data, i32 index, i32 end) noexcept
+    {
+        return static_cast<i32>(LexerDetail::IsNewline(SourceOf(data, end), index).Size);
+    }
+
+    static auto AppendUnits(QString& buffer, const char16_t* data, i32 start, i32 end) noexcept
+    {
+        buffer.append(reinterpret_cast<const QChar*>(data + start), end - start);
+    }
+
+    static auto AppendUnits(QByteArray& buffer, const u8* data, i32 start, i32 end) noexcept
+    {
+        buffer.append(reinterpret_cast<const char*>(data + start), end - start);
+    }
+
+    static auto AppendCodePoint(QString& buffer, char32_t codePoint) noexcept
+    {
+        if (QChar::requiresSurrogates(codePoint))
+        {
+            buffer.append(QChar(QChar::highSurrogate(codePoint)));
+            buffer.append(QChar(QChar::lowSurrogate(codePoint)));
+            return;
+        }
+
+        buffer.append(QChar(static_cast<char16_t>(codePoint)));
+    }
+
+    static auto AppendCodePoint(QByteArray& buffer, char32_t codePoint) noexcept
+    {
+        if (codePoint < 0x80)
+        {
+            buffer.append(static_cast<char>(codePoint));
+        }
+        else if (codePoint < 0x800)
+        {
+            buffer.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+            buffer.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else if (codePoint < 0x10000)
+        {
+            buffer.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+            buffer.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            buffer.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else
+        {
+            buffer.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+            buffer.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            buffer.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            buffer.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    // The part of a token between its delimiters
+    struct Body
+    {
+        i32 Begin = 0;
+        i32 End = 0;
+        bool IsRaw = false;
+        StringStatus Status = StringStatus::Ok;
+    };
+
+    template<typename TUnit>
+    [[nodiscard]] static auto FindBody(const TUnit* data, i32 size, TokenKind kind) noexcept -> Body
+    {
+        if (kind == TokenKind::Identifier)
+            return { .Begin = 0, .End = size };
+
+        if (kind == TokenKind::Identifier_QuotedString)
+        {
+            if (size < 2 || data[size - 1] != TUnit('\"'))
+                return { .Status = StringStatus::Unterminated };
+
+            return { .Begin = 1, .End = size - 1 };
+        }
+
+        if (kind != TokenKind::Identifier_RawString)
+            return { .Status = StringStatus::NotAString };
+
+        auto hashCount = 0;
+        while (hashCount < size && data[hashCount] == TUnit('#'))
+            hashCount++;
+
+        const auto end = size - hashCount - 1;
+        if (end <= hashCount || data[end] != TUnit('\"'))
+            return { .Status = StringStatus::Unterminated };
+
+        for (auto i = end + 1; i < size; i++)
+        {
+            if (data[i] != TUnit('#'))
+                return { .Status = StringStatus::Unterminated };
+        }
+
+        return { .Begin = hashCount + 1, .End = end, .IsRaw = true };
+    }
+
+    [[nodiscard]] static auto HexValue(char32_t unit) noexcept -> i32
+    {
+        if (unit >= U'0' && unit <= U'9')
+            return static_cast<i32>(unit - U'0');
+        if (unit >= U'a' && unit <= U'f')
+            return static_cast<i32>(unit - U'a' + 10);
+        if (unit >= U'A' && unit <= U'F')
+            return static_cast<i32>(unit - U'A' + 10);
+
+        return -1;
+    }
+
+    // Resolves the escape starting with the backslash at index and moves index past it
+    template<typename TUnit, typename TBuffer>
+    [[nodiscard]] static auto AppendEscape(const TUnit* data, i32& index, i32 end, TBuffer& buffer) noexcept
+    {
+        // A backslash right before the closing quote escapes it
+        if (index + 1 >= end)
+            return StringStatus::Unterminated;
+
+        switch (data[index + 1])
+        {
+        case TUnit('n'): AppendCodePoint(buffer, U'\n'); index += 2; return StringStatus::Ok;
+        case TUnit('r'): AppendCodePoint(buffer, U'\r'); index += 2; return StringStatus::Ok;
+        case TUnit('t'): AppendCodePoint(buffer, U'\t'); index += 2; return StringStatus::Ok;
+        case TUnit('b'): AppendCodePoint(buffer, U'\b'); index += 2; return StringStatus::Ok;
+        case TUnit('f'): AppendCodePoint(buffer, U'\f'); index += 2; return StringStatus::Ok;
+        case TUnit('s'): AppendCodePoint(buffer, U' '); index += 2; return StringStatus::Ok;
+        case TUnit('\\'): AppendCodePoint(buffer, U'\\'); index += 2; return StringStatus::Ok;
+        case TUnit('\"'): AppendCodePoint(buffer, U'\"'); index += 2; return StringStatus::Ok;
+        case TUnit('u'):
+        {
+            auto current = index + 2;
+            if (current >= end || data[current] != TUnit('{'))
+                return StringStatus::InvalidEscape;
+            current++;
+
+            char32_t codePoint = 0;
+            auto digitCount = 0;
+            while (current < end && digitCount < 6 && HexValue(data[current]) >= 0)
+            {
+                codePoint = (codePoint << 4) | static_cast<char32_t>(HexValue(data[current]));
+                current++;
+                digitCount++;
+            }
+
+            if (digitCount == 0 || current >= end || data[current] != TUnit('}'))
+                return StringStatus::InvalidEscape;
+            if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+                return StringStatus::InvalidEscape;
+
+            AppendCodePoint(buffer, codePoint);
+            index = current + 1;
+            return StringStatus::Ok;
+        }
+        default:
+            break;
+        }
+
+        // Whitespace escape, the backslash and all whitespace and newlines after it are dropped
+        auto current = index + 1;
+        while (current < end)
+        {
+            const auto codePoint = Decode(data, current, end);
+            if (!HasAny(ClassOf(codePoint.Value), CharacterClass::Space | CharacterClass::Newline))
+                break;
+
+            current += codePoint.Size;
+        }
+
+        if (current == index + 1)
+            return StringStatus::InvalidEscape;
+
+        index = current;
+        return StringStatus::Ok;
+    }
+
+    // Appends the text from index up to end, or up to the next literal newline if stopAtNewline is set
+    template<typename TUnit, typename TBuffer>
+    [[nodiscard]] static auto AppendLine(const TUnit* data, i32& index, i32 end, bool isRaw, bool stopAtNewline, TBuffer& buffer) noexcept
+    {
+        auto runStart = index;
+        while (index < end)
+        {
+            const auto unit = data[index];
+            if (unit == TUnit('\\') && !isRaw)
+            {
+                AppendUnits(buffer, data, runStart, index);
+                if (const auto status = AppendEscape(data, index, end, buffer); status != StringStatus::Ok)
+                    return status;
+
+                runStart = index;
+                continue;
+            }
+
+            if (stopAtNewline && (unit >= 0x80 || unit == TUnit('\n') || unit == TUnit('\r') || unit == TUnit('\f')))
+            {
+                if (NewlineSize(data, index, end) != 0)
+                    break;
+
+                index += Decode(data, index, end).Size;
+                continue;
+            }
+
+            index++;
+        }
+
+        AppendUnits(buffer, data, runStart, index);
+        return StringStatus::Ok;
+    }
+
+    // A multi-line string starts with a newline right after the opening quote. The first and the last
+    // newline are not part of the value, the whitespace in front of the closing quote is the indentation
+    // every other line has to start with and which is removed from them. Lines of only whitespace are empty.
+    template<typename TUnit, typename TBuffer>
+    [[nodiscard]] static auto AppendMultiLine(const TUnit* data, const Body& body, i32 first, TBuffer& buffer) noexcept
+    {
+        auto indentationStart = body.End;
+        while (indentationStart > first)
+        {
+            const auto previous = PreviousStart(data, indentationStart, first);
+            const auto characterClass = ClassOf(Decode(data, previous, body.End).Value);
+            if (HasAny(characterClass, CharacterClass::Newline))
+                break;
+            if (!HasAny(characterClass, CharacterClass::Space))
+                return StringStatus::InvalidIndentation;
+
+            indentationStart = previous;
+        }
+
+        if (indentationStart == first)
+            return StringStatus::Ok;
+
+        auto contentEnd = PreviousStart(data, indentationStart, first);
+        if (data[contentEnd] == TUnit('\n') && contentEnd > first && data[contentEnd - 1] == TUnit('\r'))
+            contentEnd--;
+
+        const auto indentationSize = body.End - indentationStart;
+        auto index = first;
+        while (true)
+        {
+            auto lineContent = index;
+            while (lineContent < contentEnd)
+            {
+                const auto codePoint = Decode(data, lineContent, contentEnd);
+                if (!HasAny(ClassOf(codePoint.Value), CharacterClass::Space))
+                    break;
+
+                lineContent += codePoint.Size;
+            }
+
+            if (lineContent < contentEnd && NewlineSize(data, lineContent, contentEnd) == 0)
+            {
+                if (lineContent - index < indentationSize)
+                    return StringStatus::InvalidIndentation;
+
+                for (auto i = 0; i < indentationSize; i++)
+                {
+                    if (data[index + i] != data[indentationStart + i])
+                        return StringStatus::InvalidIndentation;
+                }
+
+                index += indentationSize;
+                if (const auto status = AppendLine(data, index, contentEnd, body.IsRaw, true, buffer); status != StringStatus::Ok)
+                    return status;
+            }
+            else
+            {
+                index = lineContent;
+            }
+
+            if (index >= contentEnd)
+                return StringStatus::Ok;
+
+            index += NewlineSize(data, index, contentEnd);
+            AppendCodePoint(buffer, U'\n');
+        }
+    }
+
+    template<typename TUnit>
+    [[nodiscard]] static auto IsMultiLine(const TUnit* data, const Body& body) noexcept
+    {
+        return body.Begin < body.End && NewlineSize(data, body.Begin, body.End) != 0;
+    }
+
+    template<typename TUnit, typename TBuffer>
+    [[nodiscard]] static auto Decode(const TUnit* data, i32 size, TokenKind kind, bool hasEscapes, TBuffer& buffer) noexcept
+    {
+        buffer.resize(0);
+
+        const auto body = FindBody(data, size, kind);
+        if (body.Status != StringStatus::Ok)
+            return body.Status;
+
+        // The value is never longer than the text it was decoded from
+        buffer.reserve(body.End - body.Begin);
+
+        if (IsMultiLine(data, body))
+            return AppendMultiLine(data, body, body.Begin + NewlineSize(data, body.Begin, body.End), buffer);
+
+        if (!hasEscapes)
+        {
+            AppendUnits(buffer, data, body.Begin, body.End);
+            return StringStatus::Ok;
+        }
+
+        auto index = body.Begin;
+        return AppendLine(data, index, body.End, body.IsRaw, false, buffer);
+    }
+}
+
+namespace KDL
+{
+    std::optional<QStringView> StringValueView(const Token& token) noexcept
+    {
+        if (token.hasEscapes)
+            return std::nullopt;
+
+        const auto data = token.stringView.utf16();
+        const auto body = FindBody(data, static_cast<i32>(token.stringView.size()), token.kind);
+        if (body.Status != StringStatus::Ok || IsMultiLine(data, body))
+            return std::nullopt;
+
+        return token.stringView.sliced(body.Begin, body.End - body.Begin);
+    }
+
+    std::optional<QUtf8StringView> StringValueView(const Utf8Token& token) noexcept
+    {
+        if (token.hasEscapes)
+            return std::nullopt;
+
+        const auto data = reinterpret_cast<const u8*>(token.stringView.data());
+        const auto body = FindBody(data, static_cast<i32>(token.stringView.size()), token.kind);
+        if (body.Status != StringStatus::Ok || IsMultiLine(data, body))
+            return std::nullopt;
+
+        return token.stringView.sliced(body.Begin, body.End - body.Begin);
+    }
+
+    StringStatus DecodeString(const Token& token, QString& buffer) noexcept
+    {
+        const auto data = token.stringView.utf16();
+        return Decode(data, static_cast<i32>(token.stringView.size()), token.kind, token.hasEscapes, buffer);
+    }
+
+    StringStatus DecodeString(const Utf8Token& token, QByteArray& buffer) noexcept
+    {
+        const auto data = reinterpret_cast<const u8*>(token.stringView.data());
+        return Decode(data, static_cast<i32>(token.stringView.size()), token.kind, token.hasEscapes, buffer);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/Token.h>
+#include <KDL/Utf8Token.h>
+#include <Defines.h>
+
+#include <QByteArray>
+#include <QString>
+#include <optional>
+
+namespace KDL
+{
+    enum class KDL_API StringStatus
+    {
+        Ok,
+        // A backslash that isn't followed by a valid escape
+        InvalidEscape,
+        // A multi-line string line doesn't start with the indentation of the closing line
+        InvalidIndentation,
+        // The string ends without its closing quote
+        Unterminated,
+        // The token is not an identifier or a string
+        NotAString
+    };
+
+    // Value of an identifier, quoted or raw string token as a view into the source, without quotes
+    // and hashes. Strings whose value differs from their text, because they contain escapes or span
+    // multiple lines, have no view and must be decoded with DecodeString instead.
+    KDL_API [[nodiscard]] std::optional<QStringView> StringValueView(const Token& token) noexcept;
+    KDL_API [[nodiscard]] std::optional<QUtf8StringView> StringValueView(const Utf8Token& token) noexcept;
+
+    // Decode the value of an identifier, quoted or raw string token into buffer, replacing its contents.
+    // Escapes are resolved and multi-line strings dedented in a single pass, the capacity of buffer
+    // is reused so decoding many strings into the same buffer only allocates while it grows.
+    KDL_API [[nodiscard]] StringStatus DecodeString(const Token& token, QString& buffer) noexcept;
+    KDL_API [[nodiscard]] StringStatus DecodeString(const Utf8Token& token, QByteArray& buffer) noexcept;
+}
@@ -9,6 +9,8 @@ namespace  KDL
     {
         TokenKind kind = TokenKind::Unknown;
         QStringView stringView;
+        // Set on quoted strings that contain a backslash, their value has to be decoded
+        bool hasEscapes = false;
     };
 }
 
@@ -4,36 +4,69 @@ namespace KDL
 {
     TokenBuffer::TokenBuffer(const QString& source)
         : m_source{ source }
-        , m_tokenKinds{}
-        , m_startIndexes{}
-        , m_endIndexes{}
+        , m_tokens{ source.size() }
+        , m_lineIndex{}
     {
-        const auto size = source.size();
-        m_tokenKinds.reserve(size);
-        m_startIndexes.reserve(size);
-        m_endIndexes.reserve(size);
     }
 
-    void TokenBuffer::addToken(TokenKind kind, i32 start, i32 end) noexcept
+    void TokenBuffer::addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes) noexcept
     {
-        m_tokenKinds.push_back(kind);
-        m_startIndexes.push_back(start);
-        m_endIndexes.push_back(end);
+        m_tokens.addToken(kind, start, end, hasEscapes);
     }
 
     i32 TokenBuffer::size() const noexcept
     {
-        return m_tokenKinds.size();
+        return m_tokens.size();
     }
 
     Token TokenBuffer::operator[](i32 index) const noexcept
     {
-        const auto kind = m_tokenKinds.at(index);
-        const auto start = m_startIndexes.at(index);
-        const auto end = m_endIndexes.at(index);
-        const auto length = end - start;
+        const auto kind = m_tokens.kind(index);
+        const auto start = m_tokens.start(index);
+        const auto length = m_tokens.length(index);
         const auto stringView = QStringView(m_source).sliced(start, length);
 
-        return { .kind = kind, .stringView = stringView };
+        return { .kind = kind, .stringView = stringView, .hasEscapes = m_tokens.hasEscapes(index) };
+    }
+
+    i64 TokenBuffer::allocatedBytes() const noexcept
+    {
+        return m_tokens.allocatedBytes();
+    }
+
+    std::shared_ptr<const LineIndex> TokenBuffer::lineIndex() const
+    {
+        return m_lineIndex.get(QStringView(m_source));
+    }
+
+    SourceLocation TokenBuffer::location(i32 index) const
+    {
+        return lineIndex()->location(m_tokens.start(index));
+    }
+
+    const QString& TokenBuffer::source() const noexcept
+    {
+        return m_source;
+    }
+
+    const TokenStorage& TokenBuffer::storage() const noexcept
+    {
+        return m_tokens;
+    }
+
+    void TokenBuffer::appendTokens(const TokenStorage& tokens, i32 first) noexcept
+    {
+        m_tokens.append(tokens, first);
+    }
+
+    void TokenBuffer::replaceSource(i32 start, i32 end, QStringView text) noexcept
+    {
+        m_source.replace(start, end - start, text.data(), text.size());
+        m_lineIndex.reset();
+    }
+
+    void TokenBuffer::replaceTokens(i32 first, i32 last, const TokenStorage& tokens, i32 tailDelta) noexcept
+    {
+        m_tokens.replace(first, last, tokens, tailDelta);
     }
 }
\ No newline at end of file
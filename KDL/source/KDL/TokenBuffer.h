@@ -1,11 +1,13 @@
 #pragma once
 
 #include <KDL/API.h>
+#include <KDL/LineIndex.h>
 #include <KDL/TokenKind.h>
 #include <KDL/Token.h>
+#include <KDL/TokenStorage.h>
 #include <Defines.h>
 
-#include <vector>
+#include <memory>
 
 namespace KDL
 {
@@ -14,15 +16,30 @@ namespace KDL
     public:
         TokenBuffer(const QString& source);
 
-        void addToken(TokenKind kind, i32 start, i32 end) noexcept;
+        void addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes = false) noexcept;
 
         [[nodiscard]] i32 size() const noexcept;
         [[nodiscard]] Token operator[](i32 index) const noexcept;
 
+        [[nodiscard]] i64 allocatedBytes() const noexcept;
+
+        // Line starts of the source, built on the first call and shared by every later one
+        [[nodiscard]] std::shared_ptr<const LineIndex> lineIndex() const;
+        [[nodiscard]] SourceLocation location(i32 index) const;
+
+        [[nodiscard]] const QString& source() const noexcept;
+        [[nodiscard]] const TokenStorage& storage() const noexcept;
+
+        // Used by LexParallel to take over the tokens of a chunk that was lexed on its own
+        void appendTokens(const TokenStorage& tokens, i32 first) noexcept;
+
+        // Used by Relex, the source is edited first and the tokens are patched once the edit has been lexed
+        void replaceSource(i32 start, i32 end, QStringView text) noexcept;
+        void replaceTokens(i32 first, i32 last, const TokenStorage& tokens, i32 tailDelta) noexcept;
+
     private:
         QString m_source;
-        std::vector<TokenKind> m_tokenKinds;
-        std::vector<i32> m_startIndexes;
-        std::vector<i32> m_endIndexes;
+        TokenStorage m_tokens;
+        LazyLineIndex m_lineIndex;
     };
 }
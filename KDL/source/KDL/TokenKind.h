@@ -34,4 +34,29 @@ namespace KDL {
     };
 
     KDL_API [[nodiscard]] QString Stringify(TokenKind kind);
+
+    // Identifiers, quoted and raw strings
+    [[nodiscard]] constexpr bool IsStringKind(TokenKind kind) noexcept
+    {
+        return kind == TokenKind::Identifier || kind == TokenKind::Identifier_QuotedString || kind == TokenKind::Identifier_RawString;
+    }
+
+    [[nodiscard]] constexpr bool IsNumberKind(TokenKind kind) noexcept
+    {
+        return kind == TokenKind::Number_Binary
+            || kind == TokenKind::Number_Octal
+            || kind == TokenKind::Number_Hexadecimal
+            || kind == TokenKind::Number_Decimal;
+    }
+
+    // #true, #false, #nan, #inf, #-inf and #null
+    [[nodiscard]] constexpr bool IsKeywordKind(TokenKind kind) noexcept
+    {
+        return kind == TokenKind::Keyword_True
+            || kind == TokenKind::Keyword_False
+            || kind == TokenKind::Keyword_NaN
+            || kind == TokenKind::Keyword_Infinity
+            || kind == TokenKind::Keyword_NegativeInfinity
+            || kind == TokenKind::Keyword_Null;
+    }
 }
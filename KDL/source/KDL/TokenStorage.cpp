@@ -0,0 +1,116 @@
+#include <KDL/TokenStorage.h>
+
+#include <algorithm>
+
+namespace KDL 
+{
+    TokenStorage::TokenStorage(i64 sourceSize)
+        : m_tokens{}
+        , m_longTokens{}
+    {
+        m_tokens.reserve(sourceSize / EstimatedCodeUnitsPerToken + 1);
+    }
+
+    void TokenStorage::addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes) noexcept
+    {
+        const auto kindAndFlags = static_cast<u32>(kind) | (hasEscapes ? EscapesBit : 0);
+        const auto length = static_cast<u32>(end - start);
+        if (length >= MaxPackedLength)
+        {
+            m_longTokens.push_back({ .index = size(), .length = end - start });
+            m_tokens.push_back({ .start = static_cast<u32>(start), .lengthAndKind = (MaxPackedLength << KindBits) | kindAndFlags });
+            return;
+        }
+
+        m_tokens.push_back({ .start = static_cast<u32>(start), .lengthAndKind = (length << KindBits) | kindAndFlags });
+    }
+
+    i32 TokenStorage::size() const noexcept
+    {
+        return static_cast<i32>(m_tokens.size());
+    }
+
+    TokenKind TokenStorage::kind(i32 index) const noexcept
+    {
+        return static_cast<TokenKind>(m_tokens.at(index).lengthAndKind & KindMask);
+    }
+
+    bool TokenStorage::hasEscapes(i32 index) const noexcept
+    {
+        return (m_tokens.at(index).lengthAndKind & EscapesBit) != 0;
+    }
+
+    i32 TokenStorage::start(i32 index) const noexcept
+    {
+        return static_cast<i32>(m_tokens.at(index).start);
+    }
+
+    i32 TokenStorage::end(i32 index) const noexcept
+    {
+        return start(index) + length(index);
+    }
+
+    i32 TokenStorage::length(i32 index) const noexcept
+    {
+        const auto length = m_tokens.at(index).lengthAndKind >> KindBits;
+        if (length != MaxPackedLength)
+            return static_cast<i32>(length);
+
+        const auto longToken = std::lower_bound(m_longTokens.begin(), m_longTokens.end(), index,
+            [](const LongToken& token, i32 index) { return token.index < index; });
+        return longToken->length;
+    }
+
+    i32 TokenStorage::findToken(i32 position) const noexcept
+    {
+        const auto token = std::lower_bound(m_tokens.begin(), m_tokens.end(), static_cast<u32>(position),
+            [](const PackedToken& token, u32 position) { return token.start < position; });
+        return static_cast<i32>(token - m_tokens.begin());
+    }
+
+    void TokenStorage::append(const TokenStorage& tokens, i32 first) noexcept
+    {
+        const auto indexDelta = size() - first;
+        for (const auto& longToken : tokens.m_longTokens)
+        {
+            if (longToken.index >= first)
+                m_longTokens.push_back({ .index = longToken.index + indexDelta, .length = longToken.length });
+        }
+
+        m_tokens.insert(m_tokens.end(), tokens.m_tokens.begin() + first, tokens.m_tokens.end());
+    }
+
+    void TokenStorage::replace(i32 first, i32 last, const TokenStorage& tokens, i32 tailDelta) noexcept
+    {
+        for (auto i = last; i < size(); i++)
+            m_tokens[i].start = static_cast<u32>(static_cast<i32>(m_tokens[i].start) + tailDelta);
+
+        m_tokens.erase(m_tokens.begin() + first, m_tokens.begin() + last);
+        m_tokens.insert(m_tokens.begin() + first, tokens.m_tokens.begin(), tokens.m_tokens.end());
+
+        if (m_longTokens.empty() && tokens.m_longTokens.empty())
+            return;
+
+        const auto indexDelta = tokens.size() - (last - first);
+        std::vector<LongToken> longTokens{};
+        for (const auto& longToken : m_longTokens)
+        {
+            if (longToken.index < first)
+                longTokens.push_back(longToken);
+        }
+        for (const auto& longToken : tokens.m_longTokens)
+            longTokens.push_back({ .index = longToken.index + first, .length = longToken.length });
+        for (const auto& longToken : m_longTokens)
+        {
+            if (longToken.index >= last)
+                longTokens.push_back({ .index = longToken.index + indexDelta, .length = longToken.length });
+        }
+
+        m_longTokens = std::move(longTokens);
+    }
+
+    i64 TokenStorage::allocatedBytes() const noexcept
+    {
+        return static_cast<i64>(m_tokens.capacity() * sizeof(PackedToken) + m_longTokens.capacity() * sizeof(LongToken));
+    }
+}
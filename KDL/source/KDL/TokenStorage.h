@@ -0,0 +1,66 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/TokenKind.h>
+#include <Defines.h>
+
+#include <vector>
+
+namespace KDL
+{
+    // Kinds and source ranges of lexed tokens, packed into 8 bytes per token.
+    // Each entry holds a 32 bit start offset and a 24 bit length next to an 8 bit kind whose top bit
+    // marks strings with escapes, the rare token that is longer than 24 bits can express keeps its
+    // length in a side table.
+    class KDL_API TokenStorage
+    {
+    public:
+        // Average number of source code units per token, measured over Tests/Data
+        static constexpr i32 EstimatedCodeUnitsPerToken = 6;
+
+        TokenStorage() = default;
+        explicit TokenStorage(i64 sourceSize);
+
+        void addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes = false) noexcept;
+
+        [[nodiscard]] i32 size() const noexcept;
+        [[nodiscard]] TokenKind kind(i32 index) const noexcept;
+        [[nodiscard]] bool hasEscapes(i32 index) const noexcept;
+        [[nodiscard]] i32 start(i32 index) const noexcept;
+        [[nodiscard]] i32 end(i32 index) const noexcept;
+        [[nodiscard]] i32 length(i32 index) const noexcept;
+
+        // Index of the first token starting at or after position
+        [[nodiscard]] i32 findToken(i32 position) const noexcept;
+
+        // Appends the tokens [first, tokens.size()) of another storage
+        void append(const TokenStorage& tokens, i32 first) noexcept;
+
+        // Replaces the tokens [first, last) with tokens and moves the start of every later token by tailDelta
+        void replace(i32 first, i32 last, const TokenStorage& tokens, i32 tailDelta) noexcept;
+
+        // Bytes currently allocated for token data, including unused capacity
+        [[nodiscard]] i64 allocatedBytes() const noexcept;
+
+    private:
+        struct PackedToken
+        {
+            u32 start;
+            u32 lengthAndKind;
+        };
+
+        struct LongToken
+        {
+            i32 index;
+            i32 length;
+        };
+
+        static constexpr u32 KindBits = 8;
+        static constexpr u32 EscapesBit = 1u << (KindBits - 1);
+        static constexpr u32 KindMask = EscapesBit - 1;
+        static constexpr u32 MaxPackedLength = (1u << (32 - KindBits)) - 1;
+
+        std::vector<PackedToken> m_tokens;
+        std::vector<LongToken> m_longTokens;
+    };
+}
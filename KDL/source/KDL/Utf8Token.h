@@ -0,0 +1,17 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/TokenKind.h>
+#include <QUtf8StringView>
+
+namespace  KDL 
+{
+    struct KDL_API Utf8Token
+    {
+        TokenKind kind = TokenKind::Unknown;
+        QUtf8StringView stringView;
+        // Set on quoted strings that contain a backslash, their value has to be decoded
+        bool hasEscapes = false;
+    };
+}
+
@@ -0,0 +1,55 @@
+#include <KDL/Utf8TokenBuffer.h>
+
+namespace KDL 
+{
+    Utf8TokenBuffer::Utf8TokenBuffer(const QByteArray& source)
+        : m_source{ source }
+        , m_mapping{}
+        , m_tokens{ source.size() }
+        , m_lineIndex{}
+    {
+    }
+
+    Utf8TokenBuffer::Utf8TokenBuffer(const QByteArray& source, std::shared_ptr<const FileMapping> mapping)
+        : m_source{ source }
+        , m_mapping{ std::move(mapping) }
+        , m_tokens{ source.size() }
+        , m_lineIndex{}
+    {
+    }
+
+    void Utf8TokenBuffer::addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes) noexcept
+    {
+        m_tokens.addToken(kind, start, end, hasEscapes);
+    }
+
+    i32 Utf8TokenBuffer::size() const noexcept
+    {
+        return m_tokens.size();
+    }
+
+    Utf8Token Utf8TokenBuffer::operator[](i32 index) const noexcept
+    {
+        const auto kind = m_tokens.kind(index);
+        const auto start = m_tokens.start(index);
+        const auto length = m_tokens.length(index);
+        const auto stringView = QUtf8StringView(m_source.constData() + start, length);
+
+        return { .kind = kind, .stringView = stringView, .hasEscapes = m_tokens.hasEscapes(index) };
+    }
+
+    i64 Utf8TokenBuffer::allocatedBytes() const noexcept
+    {
+        return m_tokens.allocatedBytes();
+    }
+
+    std::shared_ptr<const LineIndex> Utf8TokenBuffer::lineIndex() const
+    {
+        return m_lineIndex.get(QUtf8StringView(m_source));
+    }
+
+    SourceLocation Utf8TokenBuffer::location(i32 index) const
+    {
+        return lineIndex()->location(m_tokens.start(index));
+    }
+}
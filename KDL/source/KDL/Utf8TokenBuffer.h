@@ -0,0 +1,40 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/FileMapping.h>
+#include <KDL/LineIndex.h>
+#include <KDL/TokenKind.h>
+#include <KDL/TokenStorage.h>
+#include <KDL/Utf8Token.h>
+#include <Defines.h>
+#include <QByteArray>
+
+#include <memory>
+
+namespace KDL
+{
+    class KDL_API Utf8TokenBuffer
+    {
+    public:
+        Utf8TokenBuffer(const QByteArray& source);
+        // source views mapping, which is kept alive as long as any copy of the buffer
+        Utf8TokenBuffer(const QByteArray& source, std::shared_ptr<const FileMapping> mapping);
+
+        void addToken(TokenKind kind, i32 start, i32 end, bool hasEscapes = false) noexcept;
+
+        [[nodiscard]] i32 size() const noexcept;
+        [[nodiscard]] Utf8Token operator[](i32 index) const noexcept;
+
+        [[nodiscard]] i64 allocatedBytes() const noexcept;
+
+        // Line starts of the source, built on the first call and shared by every later one
+        [[nodiscard]] std::shared_ptr<const LineIndex> lineIndex() const;
+        [[nodiscard]] SourceLocation location(i32 index) const;
+
+    private:
+        QByteArray m_source;
+        std::shared_ptr<const FileMapping> m_mapping;
+        TokenStorage m_tokens;
+        LazyLineIndex m_lineIndex;
+    };
+}
@@ -0,0 +1,600 @@
+#include <KDL/Writer.h>
+#include <KDL/CharacterClass.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    using namespace KDL;
+
+    [[nodiscard]] bool IsHighSurrogate(char16_t c) noexcept
+    {
+        return c >= 0xD800 && c <= 0xDBFF;
+    }
+
+    [[nodiscard]] bool IsLowSurrogate(char16_t c) noexcept
+    {
+        return c >= 0xDC00 && c <= 0xDFFF;
+    }
+
+    // The code point at index, advancing index past it
+    [[nodiscard]] char32_t NextCodePoint(QStringView text, qsizetype& index) noexcept
+    {
+        const auto c = text[index++].unicode();
+        if (IsHighSurrogate(c) && index < text.size() && IsLowSurrogate(text[index].unicode()))
+            return 0x10000 + ((char32_t(c) - 0xD800) << 10) + (text[index++].unicode() - 0xDC00);
+
+        return c;
+    }
+
+    void AppendUtf8(QByteArray& output, QStringView text)
+    {
+        // Resized for the worst case of 3 bytes per UTF-16 unit and shrunk to what was written
+        const auto start = output.size();
+        output.resize(start + text.size() * 3);
+        auto* out = output.data() + start;
+        for (qsizetype i = 0; i < text.size();)
+        {
+            const auto c = text[i].unicode();
+            if (c < 0x80)
+            {
+                *out++ = static_cast<char>(c);
+                i++;
+                continue;
+            }
+
+            const auto codePoint = NextCodePoint(text, i);
+            if (codePoint < 0x800)
+            {
+                *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+            }
+            else if (codePoint < 0x10000)
+            {
+                *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+                *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            }
+            else
+            {
+                *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+                *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            }
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+
+        output.resize(out - output.data());
+    }
+
+    void AppendAscii(QByteArray& output, std::string_view text)
+    {
+        output.append(text.data(), static_cast<qsizetype>(text.size()));
+    }
+
+    [[nodiscard]] bool NeedsEscape(char32_t codePoint) noexcept
+    {
+        return codePoint < 0x20 || codePoint == u'"' || codePoint == u'\\'
+            || HasAny(ClassOf(codePoint), CharacterClass::Newline | CharacterClass::DisallowedLiteralCodePoint);
+    }
+
+    void AppendEscape(QByteArray& output, char32_t codePoint)
+    {
+        switch (codePoint)
+        {
+        case u'"':
+            AppendAscii(output, "\\\"");
+            return;
+        case u'\\':
+            AppendAscii(output, "\\\\");
+            return;
+        case u'\b':
+            AppendAscii(output, "\\b");
+            return;
+        case u'\f':
+            AppendAscii(output, "\\f");
+            return;
+        case u'\n':
+            AppendAscii(output, "\\n");
+            return;
+        case u'\r':
+            AppendAscii(output, "\\r");
+            return;
+        case u'\t':
+            AppendAscii(output, "\\t");
+            return;
+        default:
+        {
+            char digits[8];
+            const auto end = std::to_chars(std::begin(digits), std::end(digits), static_cast<u32>(codePoint), 16).ptr;
+            AppendAscii(output, "\\u{");
+            output.append(digits, end - digits);
+            output.append('}');
+        }
+        }
+    }
+
+    [[nodiscard]] bool IsBareIdentifier(QStringView text) noexcept
+    {
+        for (qsizetype i = 0; i < text.size();)
+        {
+            const auto codePoint = NextCodePoint(text, i);
+            if (NeedsEscape(codePoint) || HasAny(ClassOf(codePoint), CharacterClass::IdentifierTerminator))
+                return false;
+        }
+
+        return !text.isEmpty() && IsValidIdentifier(text);
+    }
+
+    // Quoted with escapes for the characters that can't be written literally
+    void AppendQuotedString(QByteArray& output, QStringView text)
+    {
+        output.append('"');
+        qsizetype runStart = 0;
+        for (qsizetype i = 0; i < text.size();)
+        {
+            // Runs without escapes are copied as they are
+            const auto start = i;
+            const auto codePoint = NextCodePoint(text, i);
+            if (!NeedsEscape(codePoint))
+                continue;
+
+            AppendUtf8(output, text.sliced(runStart, start - runStart));
+            AppendEscape(output, codePoint);
+            runStart = i;
+        }
+
+        AppendUtf8(output, text.sliced(runStart));
+        output.append('"');
+    }
+
+    // Bare if the string is a valid identifier and quoted otherwise. ASCII strings are checked while they
+    // are copied, one character ahead of where a bare string starts, so a quote can still be put in front.
+    void AppendString(QByteArray& output, QStringView text)
+    {
+        const auto start = output.size();
+        output.resize(start + text.size() + 2);
+        auto* const begin = output.data() + start;
+        auto* out = begin + 1;
+        auto needsQuotes = text.isEmpty();
+        for (const auto c : text)
+        {
+            const auto unit = c.unicode();
+            if (unit >= 0x80 || NeedsEscape(unit))
+            {
+                output.resize(start);
+                if (IsBareIdentifier(text))
+                    AppendUtf8(output, text);
+                else
+                    AppendQuotedString(output, text);
+                return;
+            }
+
+            needsQuotes = needsQuotes || HasAny(ClassOf(unit), CharacterClass::IdentifierTerminator);
+            *out++ = static_cast<char>(unit);
+        }
+
+        if (!needsQuotes && IsValidIdentifier(text))
+        {
+            std::memmove(begin, begin + 1, static_cast<size_t>(text.size()));
+            output.resize(start + text.size());
+            return;
+        }
+
+        *begin = '"';
+        *out = '"';
+    }
+
+    [[nodiscard]] u32 DigitValue(QChar c) noexcept
+    {
+        const auto unit = c.unicode();
+        return unit <= u'9' ? unit - u'0' : (unit | 0x20) - u'a' + 10;
+    }
+
+    // Converts an integer that doesn't fit into 64 bits to decimal in parts of 9 digits, the least significant first
+    void AppendBigInteger(QByteArray& output, QStringView digits, u32 radix)
+    {
+        constexpr auto Base = u32(1'000'000'000);
+
+        std::vector<u32> value{ 0 };
+        for (const auto c : digits)
+        {
+            if (c == u'_')
+                continue;
+
+            auto carry = u64(DigitValue(c));
+            for (auto& part : value)
+            {
+                const auto product = u64(part) * radix + carry;
+                part = static_cast<u32>(product % Base);
+                carry = product / Base;
+            }
+            if (carry != 0)
+                value.push_back(static_cast<u32>(carry));
+        }
+
+        char buffer[16];
+        auto end = std::to_chars(std::begin(buffer), std::end(buffer), value.back()).ptr;
+        output.append(buffer, end - buffer);
+        for (auto part = value.rbegin() + 1; part != value.rend(); ++part)
+        {
+            end = std::to_chars(std::begin(buffer), std::end(buffer), *part).ptr;
+            output.append(9 - (end - buffer), '0');
+            output.append(buffer, end - buffer);
+        }
+    }
+
+    // Hexadecimal, octal and binary integers in decimal, decimal integers without underscores and
+    // leading zeros, and floats with an upper case E and a signed exponent
+    void AppendNumberText(QByteArray& output, QStringView text)
+    {
+        auto index = qsizetype(0);
+        if (text.startsWith(u'+') || text.startsWith(u'-'))
+            index++;
+
+        const auto isNegative = text.startsWith(u'-');
+        if (index + 1 < text.size() && text[index] == u'0' && (text[index + 1] == u'x' || text[index + 1] == u'o' || text[index + 1] == u'b'))
+        {
+            const auto radix = text[index + 1] == u'x' ? u32(16) : text[index + 1] == u'o' ? u32(8) : u32(2);
+            const auto digits = text.sliced(index + 2);
+            auto value = u64(0);
+            auto fits = true;
+            for (const auto c : digits)
+            {
+                if (c == u'_')
+                    continue;
+
+                const auto digit = u64(DigitValue(c));
+                if (value > (std::numeric_limits<u64>::max() - digit) / radix)
+                {
+                    fits = false;
+                    break;
+                }
+                value = value * radix + digit;
+            }
+
+            if (isNegative && (value != 0 || !fits))
+                output.append('-');
+
+            if (fits)
+            {
+                char buffer[24];
+                const auto end = std::to_chars(std::begin(buffer), std::end(buffer), value).ptr;
+                output.append(buffer, end - buffer);
+            }
+            else
+            {
+                AppendBigInteger(output, digits, radix);
+            }
+            return;
+        }
+
+        // Decimal integers without underscores or leading zeros are already canonical
+        const auto digits = text.sliced(index);
+        if (!digits.isEmpty() && (digits[0] != u'0' || digits.size() == 1)
+            && std::all_of(digits.begin(), digits.end(), [](QChar c) { return c >= u'0' && c <= u'9'; }))
+        {
+            if (isNegative)
+                output.append('-');
+
+            const auto start = output.size();
+            output.resize(start + digits.size());
+            std::transform(digits.begin(), digits.end(), output.data() + start, [](QChar c) { return static_cast<char>(c.unicode()); });
+            return;
+        }
+
+        if (isNegative)
+            output.append('-');
+
+        auto exponent = text.indexOf(u'e', index);
+        if (exponent < 0)
+            exponent = text.indexOf(u'E', index);
+
+        const auto mantissa = text.sliced(index, (exponent < 0 ? text.size() : exponent) - index);
+        const auto isInteger = exponent < 0 && !mantissa.contains(u'.');
+        auto hasDigits = false;
+        for (const auto c : mantissa)
+        {
+            // Leading zeros are dropped from integers, the last digit is always kept
+            if (c == u'_' || (isInteger && !hasDigits && c == u'0'))
+                continue;
+
+            hasDigits = true;
+            output.append(static_cast<char>(c.unicode()));
+        }
+        if (isInteger && !hasDigits)
+            output.append('0');
+
+        if (exponent >= 0)
+        {
+            output.append('E');
+            auto exponentDigits = text.sliced(exponent + 1);
+            output.append(exponentDigits.startsWith(u'-') ? '-' : '+');
+            if (exponentDigits.startsWith(u'-') || exponentDigits.startsWith(u'+'))
+                exponentDigits = exponentDigits.sliced(1);
+
+            for (const auto c : exponentDigits)
+            {
+                if (c != u'_')
+                    output.append(static_cast<char>(c.unicode()));
+            }
+        }
+    }
+
+    void AppendTypeAnnotation(QByteArray& output, std::optional<QStringView> typeAnnotation)
+    {
+        if (!typeAnnotation)
+            return;
+
+        output.append('(');
+        AppendString(output, *typeAnnotation);
+        output.append(')');
+    }
+
+    void AppendValue(QByteArray& output, const EventValue& value)
+    {
+        AppendTypeAnnotation(output, value.typeAnnotation);
+        if (value.type == ValueType::String)
+            AppendString(output, value.text);
+        else if (value.text.startsWith(u'#'))
+            AppendUtf8(output, value.text);
+        else
+            AppendNumberText(output, value.text);
+    }
+
+    [[nodiscard]] EventValue EventValueOf(const Value& value) noexcept
+    {
+        return { .text = value.string(), .typeAnnotation = value.typeAnnotation(), .type = value.type() };
+    }
+
+    [[nodiscard]] EventValue EventValueOf(const BinaryValue& value) noexcept
+    {
+        return { .text = value.string(), .typeAnnotation = value.typeAnnotation(), .type = value.type() };
+    }
+}
+
+namespace KDL
+{
+    Writer::Writer(QByteArray& output)
+        : m_output{ &output }
+    {
+    }
+
+    Writer::Writer(QIODevice& device)
+        : m_output{ &m_chunk }
+        , m_device{ &device }
+    {
+        m_chunk.reserve(ChunkSize * 2);
+    }
+
+    void Writer::write(const Document& document)
+    {
+        for (const auto node : document.nodes())
+            writeNode(node);
+    }
+
+    void Writer::write(const BinaryDocument& document)
+    {
+        for (const auto node : document.nodes())
+            writeNode(node);
+    }
+
+    void Writer::beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32)
+    {
+        if (!m_openBlocks.empty() && !m_openBlocks.back())
+        {
+            AppendAscii(*m_output, " {\n");
+            m_openBlocks.back() = true;
+        }
+
+        m_output->append(static_cast<qsizetype>(m_openBlocks.size()) * 4, ' ');
+        AppendTypeAnnotation(*m_output, typeAnnotation);
+        AppendString(*m_output, name);
+        m_isInEntries = true;
+        m_hasNodes = true;
+    }
+
+    void Writer::argument(const EventValue& value)
+    {
+        m_output->append(' ');
+        AppendValue(*m_output, value);
+    }
+
+    void Writer::property(QStringView name, const EventValue& value, i32)
+    {
+        AppendValue(beginProperty(name), value);
+    }
+
+    void Writer::beginChildren()
+    {
+        endEntries();
+        m_openBlocks.push_back(false);
+    }
+
+    void Writer::endChildren()
+    {
+        const auto isOpen = m_openBlocks.back();
+        m_openBlocks.pop_back();
+        if (isOpen)
+        {
+            m_output->append(static_cast<qsizetype>(m_openBlocks.size()) * 4, ' ');
+            m_output->append('}');
+        }
+    }
+
+    void Writer::endNode()
+    {
+        if (m_isInEntries)
+            endEntries();
+
+        m_output->append('\n');
+        if (m_device != nullptr && m_chunk.size() >= ChunkSize)
+            flushChunk();
+    }
+
+    void Writer::argument(QStringView string)
+    {
+        m_output->append(' ');
+        AppendString(*m_output, string);
+    }
+
+    void Writer::property(QStringView name, QStringView string)
+    {
+        AppendString(beginProperty(name), string);
+    }
+
+    bool Writer::finish()
+    {
+        if (!m_hasNodes)
+            m_output->append('\n');
+
+        m_hasNodes = true;
+        if (m_device != nullptr)
+            flushChunk();
+
+        return !m_hasFailed;
+    }
+
+    void Writer::appendInteger(QByteArray& output, i64 number)
+    {
+        char buffer[24];
+        const auto end = std::to_chars(std::begin(buffer), std::end(buffer), number).ptr;
+        output.append(buffer, end - buffer);
+    }
+
+    void Writer::appendInteger(QByteArray& output, u64 number)
+    {
+        char buffer[24];
+        const auto end = std::to_chars(std::begin(buffer), std::end(buffer), number).ptr;
+        output.append(buffer, end - buffer);
+    }
+
+    void Writer::appendFloat(QByteArray& output, double number)
+    {
+        if (std::isnan(number))
+        {
+            AppendAscii(output, "#nan");
+            return;
+        }
+        if (std::isinf(number))
+        {
+            AppendAscii(output, number > 0 ? "#inf" : "#-inf");
+            return;
+        }
+
+        // The shortest text that reads back as the same double, in the same form as the parsed floats
+        char buffer[32];
+        const auto end = std::to_chars(std::begin(buffer), std::end(buffer), number).ptr;
+        const auto text = std::string_view(buffer, end - buffer);
+        const auto exponent = text.find('e');
+        const auto mantissa = text.substr(0, exponent);
+        AppendAscii(output, mantissa);
+        if (exponent == std::string_view::npos)
+        {
+            // A float has to stay a float when it is read back
+            if (mantissa.find('.') == std::string_view::npos)
+                AppendAscii(output, ".0");
+            return;
+        }
+
+        output.append('E');
+        output.append(text[exponent + 1]);
+        const auto digits = text.substr(exponent + 2);
+        AppendAscii(output, digits.substr(std::min(digits.find_first_not_of('0'), digits.size() - 1)));
+    }
+
+    QByteArray& Writer::beginProperty(QStringView name)
+    {
+        // Written once all properties are known, so they can be sorted
+        m_properties.push_back({
+            .nameOffset = static_cast<i32>(m_propertyNames.size()),
+            .nameLength = static_cast<i32>(name.size()),
+            .textOffset = static_cast<i32>(m_propertyText.size())
+            });
+        m_propertyNames.append(name);
+        m_propertyText.append(' ');
+        AppendString(m_propertyText, name);
+        m_propertyText.append('=');
+        return m_propertyText;
+    }
+
+    template<typename TNode>
+    void Writer::writeNode(const TNode& node)
+    {
+        beginNode(node.name(), node.typeAnnotation());
+        for (auto i = 0; i < node.argumentCount(); i++)
+            argument(EventValueOf(node.argument(i)));
+
+        for (auto i = 0; i < node.propertyCount(); i++)
+        {
+            const auto property = node.property(i);
+            this->property(property.name(), EventValueOf(property.value()));
+        }
+
+        if (node.childCount() > 0)
+        {
+            beginChildren();
+            for (const auto child : node.children())
+                writeNode(child);
+            endChildren();
+        }
+
+        endNode();
+    }
+
+    void Writer::endEntries()
+    {
+        m_isInEntries = false;
+        if (m_properties.empty())
+            return;
+
+        // The text of the last property ends where the buffer ends
+        for (auto i = 0; i + 1 < static_cast<i32>(m_properties.size()); i++)
+            m_properties[i].textLength = m_properties[i + 1].textOffset - m_properties[i].textOffset;
+        m_properties.back().textLength = static_cast<i32>(m_propertyText.size()) - m_properties.back().textOffset;
+
+        const auto nameOf = [this](i32 index)
+            {
+                const auto& property = m_properties[index];
+                return QStringView(m_propertyNames).sliced(property.nameOffset, property.nameLength);
+            };
+
+        // An insertion sort, nodes have few properties and it is stable without allocating
+        m_propertyOrder.clear();
+        for (auto i = 0; i < static_cast<i32>(m_properties.size()); i++)
+        {
+            auto position = static_cast<i32>(m_propertyOrder.size());
+            m_propertyOrder.push_back(i);
+            for (; position > 0 && nameOf(i) < nameOf(m_propertyOrder[position - 1]); position--)
+                m_propertyOrder[position] = m_propertyOrder[position - 1];
+            m_propertyOrder[position] = i;
+        }
+
+        for (auto i = 0; i < static_cast<i32>(m_propertyOrder.size()); i++)
+        {
+            // Of duplicates only the rightmost is written, it is the last of them after the stable sort
+            if (i + 1 < static_cast<i32>(m_propertyOrder.size()) && nameOf(m_propertyOrder[i]) == nameOf(m_propertyOrder[i + 1]))
+                continue;
+
+            const auto& property = m_properties[m_propertyOrder[i]];
+            m_output->append(m_propertyText.constData() + property.textOffset, property.textLength);
+        }
+
+        // Resized instead of cleared, which would give up their capacity
+        m_properties.clear();
+        m_propertyNames.resize(0);
+        m_propertyText.resize(0);
+    }
+
+    void Writer::flushChunk()
+    {
+        if (!m_chunk.isEmpty() && m_device->write(m_chunk) != m_chunk.size())
+            m_hasFailed = true;
+
+        m_chunk.resize(0);
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <KDL/API.h>
+#include <KDL/Binary.h>
+#include <KDL/Document.h>
+#include <KDL/EventParser.h>
+#include <Defines.h>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <concepts>
+#include <optional>
+#include <vector>
+
+namespace KDL
+{
+    // Writes canonical KDL as UTF-8, in the form of Tests/Data/Expected: no comments, 4 space indents,
+    // arguments before properties, properties sorted by name with only the rightmost of duplicates kept,
+    // children blocks only if they have children, strings bare unless they need quotes, and numbers in
+    // decimal with floats in E notation.
+    //
+    // Numbers that were parsed keep their digits, only the radix, underscores and the exponent are
+    // normalized, so no precision is lost. Numbers computed in code are written as the shortest text that
+    // reads back as the same value.
+    class KDL_API Writer
+    {
+    public:
+        // Output is collected in chunks of this size before it is written to a device
+        static constexpr i32 ChunkSize = 64 * 1024;
+
+        // Appends to output
+        explicit Writer(QByteArray& output);
+        // Writes to device in chunks, the rest is written by finish
+        explicit Writer(QIODevice& device);
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        void write(const Document& document);
+        void write(const BinaryDocument& document);
+
+        // The handler interface of EventParser, so a source can be written without building a document.
+        // Booleans and #null are written as an EventValue with their keyword as text.
+        void beginNode(QStringView name, std::optional<QStringView> typeAnnotation = std::nullopt, i32 offset = 0);
+        void argument(const EventValue& value);
+        void property(QStringView name, const EventValue& value, i32 offset = 0);
+        void beginChildren();
+        void endChildren();
+        void endNode();
+
+        void argument(QStringView string);
+        void property(QStringView name, QStringView string);
+
+        template<typename T>
+            requires (std::integral<T> || std::floating_point<T>) && (!std::same_as<T, bool>)
+        void argument(T number)
+        {
+            m_output->append(' ');
+            appendNumber(*m_output, number);
+        }
+
+        template<typename T>
+            requires (std::integral<T> || std::floating_point<T>) && (!std::same_as<T, bool>)
+        void property(QStringView name, T number)
+        {
+            appendNumber(beginProperty(name), number);
+        }
+
+        // Ends an empty document with its newline and writes what is left to the device.
+        // Returns false if the device didn't take all of the output.
+        bool finish();
+
+    private:
+        struct PendingProperty
+        {
+            // Into m_propertyNames
+            i32 nameOffset;
+            i32 nameLength;
+            // Into m_propertyText, " name=value"
+            i32 textOffset;
+            i32 textLength;
+        };
+
+        template<typename T>
+        static void appendNumber(QByteArray& output, T number)
+        {
+            if constexpr (std::floating_point<T>)
+                appendFloat(output, static_cast<double>(number));
+            else if constexpr (std::is_signed_v<T>)
+                appendInteger(output, static_cast<i64>(number));
+            else
+                appendInteger(output, static_cast<u64>(number));
+        }
+
+        static void appendInteger(QByteArray& output, i64 number);
+        static void appendInteger(QByteArray& output, u64 number);
+        static void appendFloat(QByteArray& output, double number);
+
+        // Returns the buffer to append the value to
+        [[nodiscard]] QByteArray& beginProperty(QStringView name);
+        template<typename TNode>
+        void writeNode(const TNode& node);
+        void endEntries();
+        void flushChunk();
+
+        QByteArray* m_output;
+        QIODevice* m_device = nullptr;
+        QByteArray m_chunk;
+        bool m_hasFailed = false;
+        bool m_hasNodes = false;
+
+        // Whether the " {" of each open children block has been written, it is left out for empty blocks
+        std::vector<bool> m_openBlocks;
+        bool m_isInEntries = false;
+        std::vector<PendingProperty> m_properties;
+        std::vector<i32> m_propertyOrder;
+        QString m_propertyNames;
+        QByteArray m_propertyText;
+    };
+}
@@ -1,13 +1,23 @@
 #include <AalTest.h>
+#include <AllocationCounter.h>
 
+#include <KDL/AtomTable.h>
 #include <KDL/Lexer.h>
+#include <KDL/LineIndex.h>
+#include <KDL/Number.h>
+#include <KDL/StringValue.h>
 #include <KDL/TokenKind.h>
 #include <KDL/TokenBuffer.h>
+#include <KDL/TokenStorage.h>
 
+#include <QBuffer>
 #include <QDirIterator>
 #include <QFile>
+#include <QTemporaryFile>
 
 #include <iostream>
+#include <new>
+#include <thread>
 
 namespace
 {
@@ -22,7 +32,7 @@ namespace
         const auto input = reader.readAll();
 
         const auto tokens = Lex(input);
-        for (size_t i = 0; i < tokens.size(); i++)
+        for (i32 i = 0; i < tokens.size(); i++)
         {
             const auto token = tokens[i];
             if (token.kind == TokenKind::Unknown)
@@ -103,6 +113,15 @@ namespace
         };
     }
 
+    void WhitespaceSeparatesIdentifiers(const QString& testName, const QString& source)
+    {
+        const auto utf16Source = QString("node") + source + QString("arg");
+        const auto utf8Source = utf16Source.toUtf8();
+
+        AalTest::AreEqual(3, Lex(utf16Source).size());
+        AalTest::AreEqual(3, Lex(utf8Source).size());
+    }
+
     void Compare(const QString& testName, const QString& source, TokenKind expectedKind, i32 tokenCount)
     {
         const auto tokens = Lex(source);
@@ -112,6 +131,900 @@ namespace
         AalTest::AreEqual(tokenCount, tokens.size());
     }
 
+    void CompareUtf8(const QString& testName, const QString& source, TokenKind expectedKind, i32 tokenCount)
+    {
+        const auto utf8Source = source.toUtf8();
+        const auto tokens = Lex(utf8Source);
+        const auto token = tokens[0];
+
+        AalTest::AreEqual(expectedKind, token.kind);
+        AalTest::AreEqual(tokenCount, tokens.size());
+    }
+
+    // A string literal has to pick one of the overloads for QString and UTF-8 bytes
+    void LexStringLiteral()
+    {
+        const auto tokens = Lex("node \"a\" 1");
+        const auto expected = Lex(QString("node \"a\" 1"));
+        AalTest::AreEqual(expected.size(), tokens.size());
+        for (i32 i = 0; i < expected.size(); i++)
+        {
+            AalTest::AreEqual(expected[i].kind, tokens[i].kind);
+            AalTest::IsTrue(expected[i].stringView == tokens[i].stringView);
+        }
+    }
+
+    // Both lexers have to find the same tokens in the same text
+    void CompareUtf8ToUtf16(const QByteArray& utf8Source)
+    {
+        const auto utf16Source = QString::fromUtf8(utf8Source);
+        const auto utf8Tokens = Lex(utf8Source);
+        const auto utf16Tokens = Lex(utf16Source);
+        AalTest::AreEqual(utf16Tokens.size(), utf8Tokens.size());
+        for (i32 i = 0; i < utf16Tokens.size() && i < utf8Tokens.size(); i++)
+        {
+            const auto utf8Token = utf8Tokens[i];
+            const auto utf16Token = utf16Tokens[i];
+            AalTest::AreEqual(utf16Token.kind, utf8Token.kind);
+            AalTest::IsTrue(utf8Token.stringView.toString() == utf16Token.stringView);
+        }
+    }
+
+    void Utf8MatchesUtf16(const QString& fileName, const QString& filePath)
+    {
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        auto utf8Source = file.readAll();
+        if (utf8Source.startsWith("\xEF\xBB\xBF"))
+            utf8Source.remove(0, 3);
+
+        CompareUtf8ToUtf16(utf8Source);
+    }
+
+    // Non-ASCII digits continue a number and take several bytes in UTF-8, outside of the BMP also two units in UTF-16
+    void Utf8MatchesUtf16Digits(const QString& testName, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+        CompareUtf8ToUtf16(utf8Source);
+
+        const auto tokens = Lex(utf8Source);
+        AalTest::AreEqual(TokenKind::Number_Decimal, tokens[0].kind);
+        AalTest::AreEqual(source.left(source.indexOf(u' ')), tokens[0].stringView.toString());
+    }
+
+    QList<std::tuple<QString, QString>> Utf8MatchesUtf16Digits_Data()
+    {
+        return {
+            std::make_tuple(QString("Arabic-Indic Digit"), QString::fromUtf8("1\xD9\xA1 2")),
+            std::make_tuple(QString("Vulgar Fraction"), QString::fromUtf8("3\xC2\xBD 4")),
+            std::make_tuple(QString("Mathematical Digit Outside BMP"), QString::fromUtf8("5\xF0\x9D\x9F\x8E 6")),
+            std::make_tuple(QString("Between Underscores"), QString::fromUtf8("7_\xD9\xA1_\xF0\x9D\x9F\x8E_8 9")),
+            std::make_tuple(QString("Fraction And Exponent"), QString::fromUtf8("1.\xD9\xA1" "e\xF0\x9D\x9F\x8E \xD9\xA1")),
+        };
+    }
+
+    void CompareStreamed(const QByteArray& source, i32 chunkSize)
+    {
+        const auto tokens = Lex(source);
+
+        auto device = QBuffer{};
+        device.setData(source);
+        device.open(QIODevice::ReadOnly);
+        auto lexer = Lexer{ device, chunkSize };
+
+        for (i32 i = 0; i < tokens.size(); i++)
+        {
+            const auto expected = tokens[i];
+            const auto token = lexer.nextToken();
+            AalTest::AreEqual(expected.kind, token.kind);
+            AalTest::IsTrue(expected.stringView == token.stringView);
+            AalTest::IsTrue(QByteArrayView(source).sliced(lexer.tokenOffset(), token.stringView.size()) == token.stringView);
+        }
+
+        AalTest::AreEqual(TokenKind::EndOfFile, lexer.nextToken().kind);
+    }
+
+    void StreamMatchesLex(const QString& fileName, const QString& filePath)
+    {
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        const auto source = file.readAll();
+
+        for (const auto chunkSize : { 1, 3, 64, Lexer::DefaultChunkSize })
+            CompareStreamed(source, chunkSize);
+    }
+
+    void StreamChunkBoundaries(const QString& testName, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+        for (i32 chunkSize = 1; chunkSize <= utf8Source.size(); chunkSize++)
+            CompareStreamed(utf8Source, chunkSize);
+    }
+
+    QList<std::tuple<QString, QString>> StreamChunkBoundaries_Data()
+    {
+        return {
+            { QString("Escapes"), QString("node \"a\\n\\\"b\\u{1F600}c\\   d\"") },
+            { QString("Raw String"), QString("node ##\"a\"#b\"##") },
+            { QString("Nested Block Comment"), QString("node /* a /* b */ c */ arg") },
+            { QString("Unterminated Block Comment"), QString("node /* a /* b */") },
+            { QString("Line Comment"), QString("node // comment\r\nnode2") },
+            { QString("Newlines"), QString("a\r\nb\rc\u0085d\u2028e") },
+            { QString("Multi-byte Identifier"), QString("n\u00f6de \U0001F600=\U0001F7F0") },
+            { QString("Numbers"), QString("node 1_000.5e-10 0x1f 0b101 0o17") },
+            { QString("Keywords"), QString("node #true #false #null #-inf #trueish") },
+            { QString("Line Continuation"), QString("node \\ /* comment */ // comment\n arg") },
+        };
+    }
+
+    // A large document made of many small tokens and a few huge comments
+    // must be lexed with a window of about the chunk size
+    void StreamMemoryIsBounded()
+    {
+        QByteArray source{};
+        for (auto i = 0; i < 20000; i++)
+            source.append("node \"value\\n\" 12.5 /* a /* nested */ comment */ #true // line\n");
+        source.append("/*");
+        source.append(QByteArray(4 * 1024 * 1024, 'x'));
+        source.append("*/\n//");
+        source.append(QByteArray(4 * 1024 * 1024, 'y'));
+        source.append("\nlast");
+
+        constexpr auto chunkSize = 4096;
+        auto device = QBuffer{};
+        device.setData(source);
+        device.open(QIODevice::ReadOnly);
+        auto lexer = Lexer{ device, chunkSize };
+
+        auto tokenCount = 0;
+        auto token = lexer.nextToken();
+        while (token.kind != TokenKind::EndOfFile)
+        {
+            tokenCount++;
+            token = lexer.nextToken();
+        }
+
+        AalTest::AreEqual(Lex(source).size() - 1, tokenCount);
+        AalTest::IsTrue(lexer.allocatedBytes() <= 4 * chunkSize);
+    }
+
+    // Lexing stops wherever the input runs out and continues where it stopped once more is appended
+    void PushLexerSplits(const QString& testName, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+        const auto tokens = Lex(utf8Source);
+        for (auto split = qsizetype(1); split < utf8Source.size(); split++)
+        {
+            auto lexer = PushLexer{};
+            auto index = 0;
+            const auto compareTokens = [&]()
+                {
+                    while (const auto token = lexer.nextToken())
+                    {
+                        const auto expected = tokens[index++];
+                        AalTest::AreEqual(expected.kind, token->kind);
+                        AalTest::IsTrue(expected.stringView == token->stringView);
+                        AalTest::IsTrue(QByteArrayView(utf8Source).sliced(lexer.tokenOffset(), token->stringView.size()) == token->stringView);
+                        if (token->kind == TokenKind::EndOfFile)
+                            break;
+                    }
+                };
+
+            lexer.append(QByteArrayView(utf8Source).first(split));
+            compareTokens();
+            lexer.append(QByteArrayView(utf8Source).sliced(split));
+            compareTokens();
+            AalTest::IsTrue(index < tokens.size());
+            lexer.finish();
+            compareTokens();
+            AalTest::AreEqual(tokens.size(), index);
+        }
+    }
+
+    void CompareRelexed(const QString& source, i32 editStart, i32 editEnd, const QString& newText)
+    {
+        auto tokens = Lex(source);
+        Relex(tokens, editStart, editEnd, newText);
+
+        auto editedSource = source;
+        editedSource.replace(editStart, editEnd - editStart, newText);
+        const auto expected = Lex(editedSource);
+
+        AalTest::IsTrue(tokens.source() == editedSource);
+        AalTest::AreEqual(expected.size(), tokens.size());
+        for (i32 i = 0; i < expected.size(); i++)
+        {
+            AalTest::AreEqual(expected.storage().kind(i), tokens.storage().kind(i));
+            AalTest::AreEqual(expected.storage().start(i), tokens.storage().start(i));
+            AalTest::AreEqual(expected.storage().length(i), tokens.storage().length(i));
+        }
+    }
+
+    void RelexMatchesLex(const QString& testName, const QString& source, i32 editStart, i32 editEnd, const QString& newText)
+    {
+        CompareRelexed(source, editStart, editEnd, newText);
+    }
+
+    QList<std::tuple<QString, QString, i32, i32, QString>> RelexMatchesLex_Data()
+    {
+        return {
+            { QString("Type In Identifier"), QString("node arg\nnode2 arg"), 7, 7, QString("x") },
+            { QString("Split Identifier"), QString("node arg\nnode2 arg"), 6, 6, QString(" ") },
+            { QString("Join Lines"), QString("a\nb\nc"), 1, 2, QString() },
+            { QString("Split Line"), QString("node a b\nnode2"), 6, 7, QString("\n") },
+            { QString("Complete CRLF"), QString("a\rb\nc"), 2, 2, QString("\n") },
+            { QString("Open String"), QString("node a\nnode \"b\"\nnode c\n"), 5, 5, QString("\"") },
+            { QString("Close String"), QString("node \"a\nnode b\nnode c\n"), 7, 7, QString("\"") },
+            { QString("Open Block Comment"), QString("a\nb\nc\nd"), 2, 2, QString("/*") },
+            { QString("Close Block Comment"), QString("a\n/* b\nc\nd"), 5, 5, QString("*/") },
+            { QString("Edit Inside Comment"), QString("/* a\nb */ c\nd"), 5, 6, QString("x") },
+            { QString("Edit Inside Raw String"), QString("a\nb #\"c\nd\"# e\nf"), 8, 8, QString("\"#") },
+            { QString("Append"), QString("node arg"), 8, 8, QString("2\nnode2") },
+            { QString("Prepend"), QString("node arg"), 0, 0, QString("first\n") },
+            { QString("Insert Into Empty"), QString(), 0, 0, QString("node") },
+            { QString("Delete Everything"), QString("node arg\nnode"), 0, 13, QString() },
+        };
+    }
+
+    // Edits at several places in every test file, including ones that change how the rest of the file is lexed
+    void RelexFilesMatchesLex(const QString& fileName, const QString& filePath)
+    {
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly | QIODevice::Text);
+        AalTest::IsTrue(isOpen);
+        QTextStream reader(&file);
+        const auto source = reader.readAll();
+
+        for (auto i = 0; i <= 8; i++)
+        {
+            const auto position = i32(source.size() * i / 8);
+            const auto end = std::min(position + 5, i32(source.size()));
+            CompareRelexed(source, position, position, QString("x"));
+            CompareRelexed(source, position, position, QString("\""));
+            CompareRelexed(source, position, position, QString("\n/*"));
+            CompareRelexed(source, position, end, QString());
+            CompareRelexed(source, position, end, QString("*/ node \"a\"\n"));
+        }
+    }
+
+    // Chunks of LexParallel start at newlines, the sources make those newlines fall inside strings and comments
+    void LexParallelMatchesLex(const QString& testName, const QString& prefix, const QString& line, const QString& infix)
+    {
+        constexpr auto sourceSize = 1024 * 1024;
+
+        QString source{ prefix };
+        while (source.size() < sourceSize / 2)
+            source.append(line);
+        source.append(infix);
+        while (source.size() < sourceSize)
+            source.append(line);
+
+        const auto expected = Lex(source);
+        for (const auto threadCount : { 2, 3, 8 })
+        {
+            const auto tokens = LexParallel(source, threadCount);
+            AalTest::AreEqual(expected.size(), tokens.size());
+            for (i32 i = 0; i < expected.size(); i++)
+            {
+                AalTest::AreEqual(expected.storage().kind(i), tokens.storage().kind(i));
+                AalTest::AreEqual(expected.storage().start(i), tokens.storage().start(i));
+                AalTest::AreEqual(expected.storage().length(i), tokens.storage().length(i));
+            }
+        }
+    }
+
+    QList<std::tuple<QString, QString, QString, QString>> LexParallelMatchesLex_Data()
+    {
+        return {
+            { QString("Nodes"), QString(), QString("node 1 \"a\" #true\n"), QString() },
+            { QString("Multi-line Strings"), QString(), QString("node \"a\nb\nc\\\"\n\" x\n"), QString() },
+            { QString("Raw Strings"), QString(), QString("node #\"a\n\"\nb\"#\n"), QString() },
+            { QString("Block Comments"), QString(), QString("/* a\n/* b\n*/\n*/ node\n"), QString() },
+            { QString("Opening Quote"), QString(), QString("node \"a\" b\n"), QString("\"") },
+            { QString("Opening Quote At Start"), QString("\""), QString("node \"a\" b\n"), QString() },
+            { QString("Unterminated Block Comment"), QString(), QString("node a\n"), QString("/*") },
+            { QString("Null Character"), QString(), QString("node a\n"), QString(QChar(u'\0')) },
+            { QString("Line Continuation In Raw String"), QString(), QString("node #\"a\n\\ /* \"# x */ pqr\n"), QString() },
+        };
+    }
+
+    void LexFileMatchesLex(const QString& fileName, const QString& filePath)
+    {
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        auto utf8Source = file.readAll();
+        if (utf8Source.startsWith("\xEF\xBB\xBF"))
+            utf8Source.remove(0, 3);
+        const auto expected = Lex(QString::fromUtf8(utf8Source));
+
+        const auto tokens = LexFile(filePath);
+        AalTest::IsTrue(tokens.has_value());
+        AalTest::AreEqual(expected.size(), tokens->size());
+        for (i32 i = 0; i < expected.size(); i++)
+        {
+            const auto token = (*tokens)[i];
+            AalTest::AreEqual(expected[i].kind, token.kind);
+            AalTest::IsTrue(token.stringView.toString() == expected[i].stringView);
+        }
+    }
+
+    // Large files are lexed over a memory mapping, the tokens have to stay valid after the file object is gone
+    void LexFileMapsLargeFiles()
+    {
+        QByteArray source{};
+        while (source.size() < 1024 * 1024)
+            source.append("node \"value\" 12 /* comment */ #true\n");
+
+        auto file = QTemporaryFile{};
+        AalTest::IsTrue(file.open());
+        file.write("\xEF\xBB\xBF");
+        file.write(source);
+        file.close();
+
+        auto tokens = std::optional<Utf8TokenBuffer>{};
+        {
+            const auto mappedTokens = LexFile(file.fileName());
+            AalTest::IsTrue(mappedTokens.has_value());
+            tokens = mappedTokens;
+        }
+
+        const auto expected = Lex(source);
+        AalTest::AreEqual(expected.size(), tokens->size());
+        for (i32 i = 0; i < expected.size(); i++)
+        {
+            AalTest::AreEqual(expected[i].kind, (*tokens)[i].kind);
+            AalTest::IsTrue(expected[i].stringView == (*tokens)[i].stringView);
+        }
+    }
+
+    // Batches keep many mapped buffers at once, so they can't keep their files open. Descriptors are handed
+    // out lowest first, one left open would show up as the next one.
+    void LexFileClosesMappedFiles()
+    {
+        QByteArray source{};
+        while (source.size() < 256 * 1024)
+            source.append("node \"value\" 12\n");
+
+        auto file = QTemporaryFile{};
+        AalTest::IsTrue(file.open());
+        file.write(source);
+        file.close();
+
+        const auto nextHandle = [&file]()
+        {
+            auto probe = QFile(file.fileName());
+            return probe.open(QIODevice::ReadOnly) ? probe.handle() : -1;
+        };
+
+        const auto handle = nextHandle();
+        auto buffers = std::vector<std::optional<Utf8TokenBuffer>>{};
+        for (auto i = 0; i < 16; i++)
+            buffers.push_back(LexFile(file.fileName()));
+
+        AalTest::AreEqual(handle, nextHandle());
+        for (const auto& buffer : buffers)
+            AalTest::AreEqual(Lex(source).size(), buffer->size());
+    }
+
+    void LexFileMissing()
+    {
+        AalTest::IsTrue(!LexFile(QString("../../Tests/Data/Input/does_not_exist.kdl")).has_value());
+    }
+
+    // Has to give what LexFile gives for every path, in the order of the paths
+    void LexFilesMatchesLexFile(const QString& testName, i32 threadCount, i64 maxBytesInFlight)
+    {
+        auto paths = QStringList();
+        for (const auto& [fileName, filePath] : NoUnknownTokens_Data())
+            paths.append(filePath);
+        paths.insert(paths.size() / 2, QString("../../Tests/Data/Input/does_not_exist.kdl"));
+
+        const auto results = LexFiles(paths, { .threadCount = threadCount, .maxBytesInFlight = maxBytesInFlight });
+        AalTest::AreEqual(static_cast<size_t>(paths.size()), results.size());
+        for (i32 i = 0; i < paths.size(); i++)
+        {
+            const auto expected = LexFile(paths[i]);
+            AalTest::AreEqual(expected.has_value(), results[i].has_value());
+            if (!expected)
+                continue;
+
+            AalTest::AreEqual(expected->size(), results[i]->size());
+            for (i32 token = 0; token < expected->size(); token++)
+            {
+                AalTest::AreEqual((*expected)[token].kind, (*results[i])[token].kind);
+                AalTest::IsTrue((*expected)[token].stringView == (*results[i])[token].stringView);
+            }
+        }
+    }
+
+    QList<std::tuple<QString, i32, i64>> LexFilesMatchesLexFile_Data()
+    {
+        return {
+            std::make_tuple(QString("Default Threads"), 0, BatchOptions{}.maxBytesInFlight),
+            std::make_tuple(QString("One Thread"), 1, BatchOptions{}.maxBytesInFlight),
+            std::make_tuple(QString("More Threads Than Cores"), 64, BatchOptions{}.maxBytesInFlight),
+            std::make_tuple(QString("One File At A Time"), 8, i64(1)),
+            std::make_tuple(QString("A Few Files At A Time"), 8, i64(4096)),
+        };
+    }
+
+    // Number of times token storage reserved for sourceSize has to grow to hold tokenCount tokens,
+    // assuming the smallest common growth factor of 1.5
+    i64 StorageGrowthCount(i64 sourceSize, i64 tokenCount)
+    {
+        auto capacity = sourceSize / TokenStorage::EstimatedCodeUnitsPerToken + 1;
+        auto growthCount = 0;
+        while (capacity < tokenCount)
+        {
+            capacity += std::max(capacity / 2, i64(1));
+            growthCount++;
+        }
+
+        return growthCount;
+    }
+
+    // Allocations made by fn on the calling thread
+    template<typename TFunction>
+    i64 CountAllocations(TFunction fn)
+    {
+        const auto allocationCount = AllocationCount();
+        fn();
+        return AllocationCount() - allocationCount;
+    }
+
+    // Over-aligned operator new takes memory from aligned_alloc rather than malloc, the checks have to see it too
+    void AlignedAllocationsAreCounted()
+    {
+        if (!IsCountingAllocations())
+            return;
+
+        const auto allocations = CountAllocations([]()
+            {
+                auto* memory = ::operator new(256, std::align_val_t{ 64 });
+                ::operator delete(memory, std::align_val_t{ 64 });
+            });
+        AalTest::AreEqual(i64(1), allocations);
+    }
+
+    // Lexing may only allocate what constructing the token buffer allocates plus storage growth, nothing per token
+    void LexingDoesNotAllocate(const QString& fileName, const QString& filePath)
+    {
+        if (!IsCountingAllocations())
+            return;
+
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        const auto utf8Source = file.readAll();
+        const auto utf16Source = QString::fromUtf8(utf8Source);
+
+        const auto utf16BufferAllocations = CountAllocations([&]() { TokenBuffer buffer{ utf16Source }; });
+        auto utf16TokenCount = 0;
+        const auto utf16Allocations = CountAllocations([&]() { utf16TokenCount = Lex(utf16Source).size(); });
+        AalTest::IsTrue(utf16Allocations <= utf16BufferAllocations + StorageGrowthCount(utf16Source.size(), utf16TokenCount));
+
+        const auto utf8BufferAllocations = CountAllocations([&]() { Utf8TokenBuffer buffer{ utf8Source }; });
+        auto utf8TokenCount = 0;
+        const auto utf8Allocations = CountAllocations([&]() { utf8TokenCount = Lex(utf8Source).size(); });
+        AalTest::IsTrue(utf8Allocations <= utf8BufferAllocations + StorageGrowthCount(utf8Source.size(), utf8TokenCount));
+    }
+
+    // Decodes the first token of source lexed as UTF-16 and as UTF-8, decoding must not allocate
+    template<typename T, typename TDecode>
+    void CompareDecoded(const QString& source, T expectedValue, NumberStatus expectedStatus, TDecode decode)
+    {
+        const auto utf8Source = source.toUtf8();
+        const auto utf16Tokens = Lex(source);
+        const auto utf8Tokens = Lex(utf8Source);
+
+        auto utf16Result = NumberResult<T>{};
+        auto utf8Result = NumberResult<T>{};
+        const auto allocations = CountAllocations([&]()
+            {
+                utf16Result = decode(utf16Tokens[0]);
+                utf8Result = decode(utf8Tokens[0]);
+            });
+
+        if (IsCountingAllocations())
+            AalTest::AreEqual(i64(0), allocations);
+        AalTest::AreEqual(expectedStatus, utf16Result.status);
+        AalTest::AreEqual(expectedStatus, utf8Result.status);
+        if (expectedStatus != NumberStatus::Ok)
+            return;
+
+        AalTest::AreEqual(expectedValue, utf16Result.value);
+        AalTest::AreEqual(expectedValue, utf8Result.value);
+    }
+
+    void DecodeInt64Value(const QString& testName, const QString& source, i64 expectedValue, NumberStatus expectedStatus)
+    {
+        CompareDecoded(source, expectedValue, expectedStatus, [](const auto& token) { return DecodeInt64(token); });
+    }
+
+    QList<std::tuple<QString, QString, i64, NumberStatus>> DecodeInt64_Data()
+    {
+        return {
+            { QString("Zero"), QString("0"), 0, NumberStatus::Ok },
+            { QString("Decimal"), QString("42"), 42, NumberStatus::Ok },
+            { QString("Negative"), QString("-42"), -42, NumberStatus::Ok },
+            { QString("Positive"), QString("+42"), 42, NumberStatus::Ok },
+            { QString("Underscores"), QString("1_000_000"), 1000000, NumberStatus::Ok },
+            { QString("Binary"), QString("0b1010"), 10, NumberStatus::Ok },
+            { QString("Negative Octal"), QString("-0o17"), -15, NumberStatus::Ok },
+            { QString("Hexadecimal"), QString("0xdead_BEEF"), 0xdeadbeef, NumberStatus::Ok },
+            { QString("Largest"), QString("0x7FFF_FFFF_FFFF_FFFF"), std::numeric_limits<i64>::max(), NumberStatus::Ok },
+            { QString("Smallest"), QString("-9223372036854775808"), std::numeric_limits<i64>::min(), NumberStatus::Ok },
+            { QString("Smallest Hexadecimal"), QString("-0x8000000000000000"), std::numeric_limits<i64>::min(), NumberStatus::Ok },
+            { QString("Too Large"), QString("9223372036854775808"), 0, NumberStatus::Overflow },
+            { QString("Too Large For 64 Bits"), QString("0x1_0000_0000_0000_0000"), 0, NumberStatus::Overflow },
+            { QString("Prefix Without Digits"), QString("0x_"), 0, NumberStatus::Invalid },
+            { QString("Binary Prefix Without Digits"), QString("-0b__"), 0, NumberStatus::Invalid },
+            { QString("Fraction"), QString("1.5"), 0, NumberStatus::Invalid },
+            { QString("Exponent"), QString("1e3"), 0, NumberStatus::Invalid },
+            { QString("Identifier"), QString("node"), 0, NumberStatus::Invalid },
+        };
+    }
+
+    void DecodeUInt64Value(const QString& testName, const QString& source, u64 expectedValue, NumberStatus expectedStatus)
+    {
+        CompareDecoded(source, expectedValue, expectedStatus, [](const auto& token) { return DecodeUInt64(token); });
+    }
+
+    QList<std::tuple<QString, QString, u64, NumberStatus>> DecodeUInt64_Data()
+    {
+        return {
+            { QString("Decimal"), QString("42"), 42, NumberStatus::Ok },
+            { QString("Largest"), QString("18446744073709551615"), std::numeric_limits<u64>::max(), NumberStatus::Ok },
+            { QString("Largest Hexadecimal"), QString("0xFFFF_FFFF_FFFF_FFFF"), std::numeric_limits<u64>::max(), NumberStatus::Ok },
+            { QString("Negative Zero"), QString("-0"), 0, NumberStatus::Ok },
+            { QString("Too Large"), QString("18446744073709551616"), 0, NumberStatus::Overflow },
+            { QString("Negative"), QString("-1"), 0, NumberStatus::Overflow },
+        };
+    }
+
+    void DecodeDoubleValue(const QString& testName, const QString& source, double expectedValue, NumberStatus expectedStatus)
+    {
+        CompareDecoded(source, expectedValue, expectedStatus, [](const auto& token) { return DecodeDouble(token); });
+    }
+
+    QList<std::tuple<QString, QString, double, NumberStatus>> DecodeDouble_Data()
+    {
+        return {
+            { QString("Integer"), QString("3"), 3.0, NumberStatus::Ok },
+            { QString("Fraction"), QString("1.5"), 1.5, NumberStatus::Ok },
+            { QString("Negative Exponent"), QString("-2.5e3"), -2500.0, NumberStatus::Ok },
+            { QString("Underscores"), QString("+1_000.000_1"), 1000.0001, NumberStatus::Ok },
+            { QString("Small Exponent"), QString("1.23E-10"), 1.23e-10, NumberStatus::Ok },
+            { QString("Hexadecimal"), QString("0x10"), 16.0, NumberStatus::Ok },
+            { QString("Negative Binary"), QString("-0b11"), -3.0, NumberStatus::Ok },
+            { QString("Hexadecimal Beyond 64 Bits"), QString("0xFF_FFFF_FFFF_FFFF_FFFF"), 4722366482869645213696.0, NumberStatus::Ok },
+            { QString("Infinity"), QString("#inf"), std::numeric_limits<double>::infinity(), NumberStatus::Ok },
+            { QString("Negative Infinity"), QString("#-inf"), -std::numeric_limits<double>::infinity(), NumberStatus::Ok },
+            { QString("Too Large"), QString("1e400"), 0.0, NumberStatus::Overflow },
+            { QString("Too Small"), QString("1e-400"), 0.0, NumberStatus::Ok },
+            { QString("Too Small Fraction"), QString("-0.000_001e-320"), -0.0, NumberStatus::Ok },
+            { QString("Many Digits Too Small"), QString("123456789e-400"), 0.0, NumberStatus::Ok },
+            { QString("Many Digits Too Large"), QString("0.0001e320"), 0.0, NumberStatus::Overflow },
+            { QString("Prefix Without Digits"), QString("0x_"), 0.0, NumberStatus::Invalid },
+            { QString("Two Exponents"), QString("1.23E-10E-00"), 0.0, NumberStatus::Invalid },
+            { QString("Identifier"), QString("node"), 0.0, NumberStatus::Invalid },
+        };
+    }
+
+    // Decodes the first token of source lexed as UTF-16 and as UTF-8. Strings without escapes on a single line
+    // must be available as a view, decoding into a buffer that is already large enough must not allocate.
+    void DecodeStringValue(const QString& testName, const QString& source, const QString& expectedValue, StringStatus expectedStatus, bool isView)
+    {
+        const auto utf8Source = source.toUtf8();
+        const auto utf16Tokens = Lex(source);
+        const auto utf8Tokens = Lex(utf8Source);
+        const auto utf16Token = utf16Tokens[0];
+        const auto utf8Token = utf8Tokens[0];
+
+        auto utf16View = std::optional<QStringView>{};
+        auto utf8View = std::optional<QUtf8StringView>{};
+        const auto viewAllocations = CountAllocations([&]()
+            {
+                utf16View = StringValueView(utf16Token);
+                utf8View = StringValueView(utf8Token);
+            });
+
+        if (IsCountingAllocations())
+            AalTest::AreEqual(i64(0), viewAllocations);
+        AalTest::AreEqual(isView, utf16View.has_value());
+        AalTest::AreEqual(isView, utf8View.has_value());
+        if (isView)
+        {
+            AalTest::AreEqual(expectedValue, utf16View->toString());
+            AalTest::AreEqual(expectedValue, utf8View->toString());
+        }
+
+        auto utf16Buffer = QString{};
+        auto utf8Buffer = QByteArray{};
+        AalTest::AreEqual(expectedStatus, DecodeString(utf16Token, utf16Buffer));
+        AalTest::AreEqual(expectedStatus, DecodeString(utf8Token, utf8Buffer));
+        if (expectedStatus != StringStatus::Ok)
+            return;
+
+        AalTest::AreEqual(expectedValue, utf16Buffer);
+        AalTest::AreEqual(expectedValue, QString::fromUtf8(utf8Buffer));
+
+        const auto decodeAllocations = CountAllocations([&]()
+            {
+                (void)DecodeString(utf16Token, utf16Buffer);
+                (void)DecodeString(utf8Token, utf8Buffer);
+            });
+        if (IsCountingAllocations())
+            AalTest::AreEqual(i64(0), decodeAllocations);
+    }
+
+    QList<std::tuple<QString, QString, QString, StringStatus, bool>> DecodeString_Data()
+    {
+        return {
+            { QString("Identifier"), QString("node"), QString("node"), StringStatus::Ok, true },
+            { QString("Quoted"), QString("\"hello world\""), QString("hello world"), StringStatus::Ok, true },
+            { QString("Empty"), QString("\"\""), QString(), StringStatus::Ok, true },
+            { QString("Raw"), QString("#\"C:\\path\\n\"#"), QString("C:\\path\\n"), StringStatus::Ok, true },
+            { QString("Raw With Quotes"), QString("##\"a\"#b\"##"), QString("a\"#b"), StringStatus::Ok, true },
+            { QString("Escapes"), QString("\"a\\nb\\t\\\"c\\\"\\\\\""), QString("a\nb\t\"c\"\\"), StringStatus::Ok, false },
+            { QString("Control Escapes"), QString("\"\\r\\b\\f\\s\""), QString("\r\b\f "), StringStatus::Ok, false },
+            { QString("Unicode Escape"), QString("\"\\u{41}\\u{e9}\\u{20AC}\""), QString::fromUtf8("A\xC3\xA9\xE2\x82\xAC"), StringStatus::Ok, false },
+            { QString("Unicode Escape Outside BMP"), QString("\"\\u{1F600}\""), QString::fromUtf8("\xF0\x9F\x98\x80"), StringStatus::Ok, false },
+            { QString("Whitespace Escape"), QString("\"Hello \\\n     World \\          Stuff\""), QString("Hello World Stuff"), StringStatus::Ok, false },
+            { QString("Non-ASCII"), QString::fromUtf8("\"gr\xC3\xBC\xC3\x9F \\\"dich\\\"\""), QString::fromUtf8("gr\xC3\xBC\xC3\x9F \"dich\""), StringStatus::Ok, false },
+            { QString("Invalid Escape"), QString("\"\\q\""), QString(), StringStatus::InvalidEscape, false },
+            { QString("Unicode Escape Without Braces"), QString("\"\\u0041\""), QString(), StringStatus::InvalidEscape, false },
+            { QString("Unicode Escape Too Large"), QString("\"\\u{110000}\""), QString(), StringStatus::InvalidEscape, false },
+            { QString("Unicode Escape Surrogate"), QString("\"\\u{D800}\""), QString(), StringStatus::InvalidEscape, false },
+            { QString("Unterminated"), QString("\"abc"), QString(), StringStatus::Unterminated, false },
+            { QString("Unterminated Escaped Quote"), QString("\"abc\\\""), QString(), StringStatus::Unterminated, false },
+            { QString("Unterminated Raw"), QString("##\"abc\"#"), QString(), StringStatus::Unterminated, false },
+            { QString("Number"), QString("42"), QString(), StringStatus::NotAString, false },
+            { QString("Multi-line"), QString("\"\nhey\neveryone\nhow goes?\n\""), QString("hey\neveryone\nhow goes?"), StringStatus::Ok, false },
+            { QString("Multi-line Indented"), QString("\"\n    hey\n   everyone\n     how goes?\n  \""), QString("  hey\n everyone\n   how goes?"), StringStatus::Ok, false },
+            { QString("Multi-line Raw"), QString("#\"\n    a\\nb\n    \"c\"\n    \"#"), QString("a\\nb\n\"c\""), StringStatus::Ok, false },
+            { QString("Multi-line CRLF"), QString("\"\r\n  a\r\n  b\r\n  \""), QString("a\nb"), StringStatus::Ok, false },
+            { QString("Multi-line Empty Lines"), QString("\"\n  a\n\n \n  b\n  \""), QString("a\n\n\nb"), StringStatus::Ok, false },
+            { QString("Multi-line Escapes"), QString("\"\n  a\\tb \\\n  c\n  \""), QString("a\tb c"), StringStatus::Ok, false },
+            { QString("Multi-line Empty"), QString("\"\n\""), QString(), StringStatus::Ok, false },
+            { QString("Multi-line Non-matching Prefix"), QString("\"\n  a\n\tb\n  \""), QString(), StringStatus::InvalidIndentation, false },
+            { QString("Multi-line Text Before Closing Quote"), QString("\"\n  a\n  b\""), QString(), StringStatus::InvalidIndentation, false },
+        };
+    }
+
+    void InternAssignsDenseAtoms()
+    {
+        AtomTable atoms{};
+        const auto node = atoms.intern(QStringView(u"node"));
+        const auto version = atoms.intern(QStringView(u"version"));
+
+        AalTest::AreEqual(0u, static_cast<u32>(node));
+        AalTest::AreEqual(1u, static_cast<u32>(version));
+        AalTest::IsTrue(node == atoms.intern(QStringView(u"node")));
+        AalTest::IsTrue(version == atoms.intern(QUtf8StringView("version")));
+        AalTest::AreEqual(2, atoms.size());
+        AalTest::AreEqual(QString("node"), atoms.name(node).toString());
+        AalTest::AreEqual(QString("version"), atoms.name(version).toString());
+
+        AalTest::IsTrue(atoms.find(QStringView(u"node")) == node);
+        AalTest::IsTrue(!atoms.find(QStringView(u"path")).has_value());
+        AalTest::AreEqual(2, atoms.size());
+
+        // Longer than a block, it must neither break the block nor the names stored after it
+        const auto longName = QString(40000, QChar(u'x'));
+        const auto longAtom = atoms.intern(QStringView(longName));
+        const auto path = atoms.intern(QStringView(u"path"));
+        AalTest::AreEqual(longName, atoms.name(longAtom).toString());
+        AalTest::AreEqual(QString("path"), atoms.name(path).toString());
+        AalTest::AreEqual(QString("node"), atoms.name(node).toString());
+    }
+
+    // Identifiers and strings with the same value share an atom, whether they were lexed from UTF-16 or UTF-8
+    void InternTokens()
+    {
+        const auto source = QString::fromUtf8("dependency \"dependency\" #\"dependency\"# \"dep\\u{65}ndency\" gr\xC3\xBC\xC3\x9F \"\\u{67}r\xC3\xBC\xC3\x9F\" 42");
+        const auto utf16Tokens = Lex(source);
+        const auto utf8Tokens = Lex(source.toUtf8());
+
+        AtomTable atoms{};
+        auto utf16Atoms = QList<std::optional<Atom>>{};
+        auto utf8Atoms = QList<std::optional<Atom>>{};
+        for (auto i = 0; i < utf16Tokens.size(); i++)
+        {
+            if (utf16Tokens[i].kind != TokenKind::Newline && utf16Tokens[i].kind != TokenKind::EndOfFile)
+                utf16Atoms.append(atoms.intern(utf16Tokens[i]));
+        }
+        for (auto i = 0; i < utf8Tokens.size(); i++)
+        {
+            if (utf8Tokens[i].kind != TokenKind::Newline && utf8Tokens[i].kind != TokenKind::EndOfFile)
+                utf8Atoms.append(atoms.intern(utf8Tokens[i]));
+        }
+
+        AalTest::AreEqual(qsizetype(7), utf16Atoms.size());
+        AalTest::IsTrue(utf16Atoms == utf8Atoms);
+        AalTest::AreEqual(2, atoms.size());
+        for (auto i = 1; i < 4; i++)
+            AalTest::IsTrue(utf16Atoms[i] == utf16Atoms[0]);
+        AalTest::IsTrue(utf16Atoms[5] == utf16Atoms[4]);
+        AalTest::AreEqual(QString::fromUtf8("gr\xC3\xBC\xC3\x9F"), atoms.name(*utf16Atoms[4]).toString());
+        AalTest::IsTrue(!utf16Atoms[6].has_value());
+    }
+
+    // Threads interning the same names into a shared table must agree on their atoms
+    void InternFromThreads()
+    {
+        constexpr auto NameCount = 2000;
+        constexpr auto ThreadCount = 4;
+
+        AtomTable atoms{};
+        std::vector<std::vector<Atom>> threadAtoms(ThreadCount);
+        std::vector<std::thread> threads{};
+        for (auto thread = 0; thread < ThreadCount; thread++)
+        {
+            threads.emplace_back([&atoms, &result = threadAtoms[thread], thread]()
+                {
+                    for (auto i = 0; i < NameCount; i++)
+                    {
+                        // Every thread walks the names in a different order
+                        const auto name = QString("name%1").arg((i * (thread + 1) * 7) % NameCount);
+                        result.push_back(atoms.intern(QStringView(name)));
+                    }
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        AalTest::AreEqual(NameCount, atoms.size());
+        for (auto thread = 0; thread < ThreadCount; thread++)
+        {
+            for (auto i = 0; i < NameCount; i++)
+            {
+                const auto name = QString("name%1").arg((i * (thread + 1) * 7) % NameCount);
+                AalTest::AreEqual(name, atoms.name(threadAtoms[thread][i]).toString());
+            }
+        }
+    }
+
+    // The UTF-8 column counts bytes, so it is derived from the UTF-16 one
+    void LineAndColumn(const QString& testName, const QString& source, i32 offset, i32 expectedLine, i32 expectedColumn)
+    {
+        const auto location = LineIndex(QStringView(source)).location(offset);
+        AalTest::AreEqual(expectedLine, location.line);
+        AalTest::AreEqual(expectedColumn, location.column);
+
+        const auto lineStart = offset - expectedColumn + 1;
+        const auto utf8Offset = static_cast<i32>(source.left(offset).toUtf8().size());
+        const auto utf8Column = static_cast<i32>(source.mid(lineStart, offset - lineStart).toUtf8().size()) + 1;
+        const auto utf8Source = source.toUtf8();
+        const auto utf8Location = LineIndex(QUtf8StringView(utf8Source)).location(utf8Offset);
+        AalTest::AreEqual(expectedLine, utf8Location.line);
+        AalTest::AreEqual(utf8Column, utf8Location.column);
+    }
+
+    QList<std::tuple<QString, QString, i32, i32, i32>> LineAndColumn_Data()
+    {
+        return {
+            { QString("Start"), QString("a\nb"), 0, 1, 1 },
+            { QString("Empty"), QString(""), 0, 1, 1 },
+            { QString("Column"), QString("ab\ncde"), 5, 2, 3 },
+            { QString("LF"), QString("a\nb"), 2, 2, 1 },
+            { QString("CR"), QString("a\rb"), 2, 2, 1 },
+            { QString("CRLF"), QString("a\r\nb"), 3, 2, 1 },
+            { QString("Inside CRLF"), QString("a\r\nb"), 2, 1, 3 },
+            { QString("CR CR LF"), QString("a\r\r\nb"), 4, 3, 1 },
+            { QString("FF"), QString("a\fb"), 2, 2, 1 },
+            { QString("NEL"), QString("a\u0085b"), 2, 2, 1 },
+            { QString("LS"), QString("a\u2028b"), 2, 2, 1 },
+            { QString("PS"), QString("a\u2029b"), 2, 2, 1 },
+            { QString("Multi-byte Column"), QString("\u00e4\u00f6\u00fcx\n\u00dfx"), 6, 2, 2 },
+            { QString("After Last Newline"), QString("a\n\n"), 3, 3, 1 },
+        };
+    }
+
+    // Line of every token checked against a plain scan that counts newlines up to it
+    void TokenLocations(const QString& fileName, const QString& filePath)
+    {
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        const auto utf8Source = file.readAll();
+        const auto tokens = Lex(QString::fromUtf8(utf8Source));
+        const auto utf8Tokens = Lex(utf8Source);
+        const auto& source = tokens.source();
+        AalTest::AreEqual(tokens.size(), utf8Tokens.size());
+
+        auto line = 1;
+        auto lineStart = 0;
+        auto offset = 0;
+        for (auto i = 0; i < tokens.size(); i++)
+        {
+            const auto start = static_cast<i32>(tokens[i].stringView.data() - source.data());
+            for (; offset < start; offset++)
+            {
+                const auto current = source[offset].unicode();
+                const auto isCRLF = current == u'\r' && offset + 1 < source.size() && source[offset + 1] == u'\n';
+                if (!isCRLF && (current == u'\n' || current == u'\r' || current == u'\f' || current == 0x85 || current == 0x2028 || current == 0x2029))
+                {
+                    line++;
+                    lineStart = offset + 1;
+                }
+            }
+
+            const auto location = tokens.location(i);
+            AalTest::AreEqual(line, location.line);
+            AalTest::AreEqual(start - lineStart + 1, location.column);
+            AalTest::AreEqual(line, utf8Tokens.location(i).line);
+        }
+
+        AalTest::IsTrue(tokens.lineIndex() == tokens.lineIndex());
+    }
+
+    // Every thread gets the same index, however many ask for it first at once
+    void TokenLocationsFromThreads()
+    {
+        constexpr auto ThreadCount = 8;
+
+        auto source = QString();
+        for (auto i = 0; i < 1000; i++)
+            source += QString("node%1 1 2\n").arg(i);
+        const auto tokens = Lex(source);
+        const auto utf8Tokens = Lex(source.toUtf8());
+
+        std::vector<std::shared_ptr<const LineIndex>> indexes(ThreadCount);
+        std::vector<std::shared_ptr<const LineIndex>> utf8Indexes(ThreadCount);
+        std::vector<std::thread> threads{};
+        for (auto thread = 0; thread < ThreadCount; thread++)
+        {
+            threads.emplace_back([&, thread]()
+                {
+                    indexes[thread] = tokens.lineIndex();
+                    utf8Indexes[thread] = utf8Tokens.lineIndex();
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto thread = 0; thread < ThreadCount; thread++)
+        {
+            AalTest::IsTrue(indexes[thread] == tokens.lineIndex());
+            AalTest::IsTrue(utf8Indexes[thread] == utf8Tokens.lineIndex());
+        }
+        AalTest::AreEqual(1000, tokens.location(tokens.size() - 2).line);
+        AalTest::AreEqual(1001, tokens.lineIndex()->lineCount());
+    }
+
+    void PackedTokens(const QString& testName, TokenKind kind, i32 start, i32 length)
+    {
+        TokenStorage storage{};
+        storage.addToken(TokenKind::Identifier, 0, 4);
+        storage.addToken(kind, start, start + length);
+        storage.addToken(TokenKind::EndOfFile, start + length, start + length);
+
+        AalTest::AreEqual(3, storage.size());
+        AalTest::AreEqual(kind, storage.kind(1));
+        AalTest::AreEqual(start, storage.start(1));
+        AalTest::AreEqual(length, storage.length(1));
+        AalTest::AreEqual(start + length, storage.end(1));
+        AalTest::AreEqual(TokenKind::EndOfFile, storage.kind(2));
+        AalTest::AreEqual(start + length, storage.start(2));
+        AalTest::AreEqual(0, storage.length(2));
+    }
+
+    QList<std::tuple<QString, TokenKind, i32, i32>> PackedTokens_Data()
+    {
+        return {
+            { QString("Empty"), TokenKind::Identifier_QuotedString, 4, 0 },
+            { QString("Single Character"), TokenKind::OpenBracket, 5, 1 },
+            { QString("Last Kind"), TokenKind::EndOfFile, 5, 0 },
+            { QString("Largest Packed Length"), TokenKind::Identifier_RawString, 7, 0xFFFFFE },
+            { QString("Smallest Long Length"), TokenKind::Identifier_RawString, 7, 0xFFFFFF },
+            { QString("Long Length"), TokenKind::Identifier_QuotedString, 0x7FFF0000, 0x1000005 - 0x10000 },
+        };
+    }
+
     QList<std::tuple<QString, QString, TokenKind, i32>> SingleCharacter_Data()
     {
         return {
@@ -161,6 +1074,12 @@ namespace
         return {
             { QString("-"), QString("-"), TokenKind::Identifier, 2 },
             { QString("+"), QString("+"), TokenKind::Identifier, 2 },
+            { QString("+1"), QString("+1"), TokenKind::Number_Decimal, 2 },
+            { QString("-1"), QString("-1"), TokenKind::Number_Decimal, 2 },
+            { QString("-1.5e3"), QString("-1.5e3"), TokenKind::Number_Decimal, 2 },
+            { QString("-0x10"), QString("-0x10"), TokenKind::Number_Hexadecimal, 2 },
+            { QString("+0b1"), QString("+0b1"), TokenKind::Number_Binary, 2 },
+            { QString("-0o7"), QString("-0o7"), TokenKind::Number_Octal, 2 },
         };
     }
 
@@ -252,6 +1171,23 @@ namespace
         };
     }
 
+    QList<std::tuple<QString, QString, TokenKind, i32>> LongString_Data()
+    {
+        QList<std::tuple<QString, QString, TokenKind, i32>> data{};
+        for (auto length : { 7, 8, 15, 16, 17, 31, 32, 33, 100 })
+        {
+            const auto body = QString(length, QChar(u'a'));
+            const auto name = QString::number(length);
+            data.append({ name, QString("\"%1\"").arg(body), TokenKind::Identifier_QuotedString, 2 });
+            data.append({ name + QString(" Escaped Quote"), QString("\"%1\\\"%1\"").arg(body), TokenKind::Identifier_QuotedString, 2 });
+            data.append({ name + QString(" Unicode"), QString("\"%1\u00e4\U0001f600%1\"").arg(body), TokenKind::Identifier_QuotedString, 2 });
+            data.append({ name + QString(" Raw"), QString("#\"%1\\\"%1\"#").arg(body), TokenKind::Identifier_RawString, 2 });
+            data.append({ name + QString(" Raw Hash"), QString("##\"%1\"#%1\"##").arg(body), TokenKind::Identifier_RawString, 2 });
+            data.append({ name + QString(" Unterminated"), QString("\"%1").arg(body), TokenKind::Identifier_QuotedString, 2 });
+        }
+        return data;
+    }
+
     QList<std::tuple<QString, QString, TokenKind, i32>> LineComment_Data()
     {
         return {
@@ -306,6 +1242,8 @@ AalTest::TestSuite LexerTestsSuite()
     AalTest::TestSuite suite{};
     suite.add(QString("NoUnknownTokens"), NoUnknownTokens, NoUnknownTokens_Data);
     suite.add(QString("Whitespace"), QtHandlesWhitespace, Whitespace_Data);
+    suite.add(QString("WhitespaceSeparatesIdentifiers"), WhitespaceSeparatesIdentifiers, Whitespace_Data);
+    suite.add(QString("PackedTokens"), PackedTokens, PackedTokens_Data);
     suite.add(QString("SingleCharacter"), Compare, SingleCharacter_Data);
     suite.add(QString("Equal"), Compare, Equal_Data);
     suite.add(QString("Newline"), Compare, Newline_Data);
@@ -313,13 +1251,47 @@ AalTest::TestSuite LexerTestsSuite()
     suite.add(QString("Sign"), Compare, Sign_Data);
     suite.add(QString("Keywords"), Compare, Keywords_Data);
     suite.add(QString("Number"), Compare, Number_Data);
+    suite.add(QString("DecodeInt64"), DecodeInt64Value, DecodeInt64_Data);
+    suite.add(QString("DecodeUInt64"), DecodeUInt64Value, DecodeUInt64_Data);
+    suite.add(QString("DecodeDouble"), DecodeDoubleValue, DecodeDouble_Data);
+    suite.add(QString("DecodeString"), DecodeStringValue, DecodeString_Data);
+    suite.add(QString("InternAssignsDenseAtoms"), InternAssignsDenseAtoms);
+    suite.add(QString("InternTokens"), InternTokens);
+    suite.add(QString("InternFromThreads"), InternFromThreads);
+    suite.add(QString("LineAndColumn"), LineAndColumn, LineAndColumn_Data);
+    suite.add(QString("TokenLocations"), TokenLocations, NoUnknownTokens_Data);
+    suite.add(QString("TokenLocationsFromThreads"), TokenLocationsFromThreads);
     suite.add(QString("Identifier"), Compare, Identifier_Data);
     suite.add(QString("QuotedString"), Compare, QuotedString_Data);
     suite.add(QString("RawString"), Compare, RawString_Data);
+    suite.add(QString("LongString"), Compare, LongString_Data);
+    suite.add(QString("Utf8LongString"), CompareUtf8, LongString_Data);
     suite.add(QString("LineComment"), Compare, LineComment_Data);
     suite.add(QString("BlockComment"), Compare, BlockComment_Data);
     suite.add(QString("LineContinuation"), Compare, LineContinuation_Data);
     suite.add(QString("IsDisallowedLiteralCodePoints"), Compare, IsDisallowedLiteralCodePoints_Data);
+    suite.add(QString("Utf8Equal"), CompareUtf8, Equal_Data);
+    suite.add(QString("Utf8Newline"), CompareUtf8, Newline_Data);
+    suite.add(QString("Utf8Identifier"), CompareUtf8, Identifier_Data);
+    suite.add(QString("Utf8QuotedString"), CompareUtf8, QuotedString_Data);
+    suite.add(QString("Utf8IsDisallowedLiteralCodePoints"), CompareUtf8, IsDisallowedLiteralCodePoints_Data);
+    suite.add(QString("Utf8MatchesUtf16"), Utf8MatchesUtf16, NoUnknownTokens_Data);
+    suite.add(QString("Utf8MatchesUtf16Digits"), Utf8MatchesUtf16Digits, Utf8MatchesUtf16Digits_Data);
+    suite.add(QString("LexStringLiteral"), LexStringLiteral);
+    suite.add(QString("LexFileMatchesLex"), LexFileMatchesLex, NoUnknownTokens_Data);
+    suite.add(QString("LexFileMapsLargeFiles"), LexFileMapsLargeFiles);
+    suite.add(QString("LexFileClosesMappedFiles"), LexFileClosesMappedFiles);
+    suite.add(QString("LexFileMissing"), LexFileMissing);
+    suite.add(QString("LexFilesMatchesLexFile"), LexFilesMatchesLexFile, LexFilesMatchesLexFile_Data);
+    suite.add(QString("LexParallelMatchesLex"), LexParallelMatchesLex, LexParallelMatchesLex_Data);
+    suite.add(QString("AlignedAllocationsAreCounted"), AlignedAllocationsAreCounted);
+    suite.add(QString("LexingDoesNotAllocate"), LexingDoesNotAllocate, NoUnknownTokens_Data);
+    suite.add(QString("RelexMatchesLex"), RelexMatchesLex, RelexMatchesLex_Data);
+    suite.add(QString("RelexFilesMatchesLex"), RelexFilesMatchesLex, NoUnknownTokens_Data);
+    suite.add(QString("StreamMatchesLex"), StreamMatchesLex, NoUnknownTokens_Data);
+    suite.add(QString("StreamChunkBoundaries"), StreamChunkBoundaries, StreamChunkBoundaries_Data);
+    suite.add(QString("StreamMemoryIsBounded"), StreamMemoryIsBounded);
+    suite.add(QString("PushLexerSplits"), PushLexerSplits, StreamChunkBoundaries_Data);
 
     return suite;
 }
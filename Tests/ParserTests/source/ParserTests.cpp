@@ -1,15 +1,229 @@
 #include "ParserTests.h"
 
 #include <AalTest.h>
+#include <KDL/AsyncParser.h>
+#include <KDL/Binary.h>
+#include <KDL/BinaryFormat.h>
+#include <KDL/Binding.h>
+#include <KDL/Document.h>
+#include <KDL/EventParser.h>
+#include <KDL/Lexer.h>
+#include <KDL/ParseCache.h>
+#include <KDL/Query.h>
+#include <KDL/Schema.h>
+#include <KDL/Writer.h>
 
+#include <QBuffer>
+#include <QDateTime>
 #include <QDirIterator>
 #include <QFile>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
 
 namespace
 {
+    struct Endpoint
+    {
+        QString path;
+        std::vector<QString> methods;
+        bool isPublic = false;
+    };
+
+    struct ServerConfig
+    {
+        QString host;
+        u16 port = 0;
+        std::optional<double> timeout;
+        std::vector<i32> retries;
+        std::vector<Endpoint> endpoints;
+    };
+}
+
+template<>
+struct KDL::Binding<Endpoint>
+{
+    static constexpr auto fields = std::tuple{
+        KDL_REQUIRED_FIELD(Endpoint, path),
+        KDL_FIELD(Endpoint, methods),
+        KDL::Field<Endpoint, bool>{ u"public", &Endpoint::isPublic },
+    };
+};
+
+template<>
+struct KDL::Binding<ServerConfig>
+{
+    static constexpr auto fields = std::tuple{
+        KDL_REQUIRED_FIELD(ServerConfig, host),
+        KDL_FIELD(ServerConfig, port),
+        KDL_FIELD(ServerConfig, timeout),
+        KDL_FIELD(ServerConfig, retries),
+        KDL::Field<ServerConfig, std::vector<Endpoint>>{ u"endpoint", &ServerConfig::endpoints },
+    };
+};
+
+namespace
+{
+    using namespace KDL;
+
+    QString ReadFile(const QString& filePath)
+    {
+        auto file = QFile(filePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        QTextStream reader(&file);
+        return reader.readAll();
+    }
+
+    int DigitValue(QChar c)
+    {
+        if (c >= u'a')
+            return c.unicode() - u'a' + 10;
+        if (c >= u'A')
+            return c.unicode() - u'A' + 10;
+
+        return c.unicode() - u'0';
+    }
+
+    // Numbers are compared by value, so 0x10 equals 16 and 1e10 equals 1.0E+10
+    QString CanonicalNumber(const Value& value)
+    {
+        auto text = value.string().toString().remove(u'_');
+        auto isNegative = false;
+        if (text.startsWith(u'+') || text.startsWith(u'-'))
+        {
+            isNegative = text.startsWith(u'-');
+            text.remove(0, 1);
+        }
+
+        auto digits = std::vector<int>{};
+        auto exponent = 0;
+        const auto base = text.startsWith(u"0b") ? 2 : text.startsWith(u"0o") ? 8 : text.startsWith(u"0x") ? 16 : 10;
+        if (base != 10)
+        {
+            // Converts to decimal digits one input digit at a time, least significant digit first
+            for (auto i = 2; i < text.size(); i++)
+            {
+                auto carry = DigitValue(text[i]);
+                for (auto& digit : digits)
+                {
+                    carry += digit * base;
+                    digit = carry % 10;
+                    carry /= 10;
+                }
+                for (; carry > 0; carry /= 10)
+                    digits.push_back(carry % 10);
+            }
+            std::reverse(digits.begin(), digits.end());
+        }
+        else
+        {
+            const auto exponentStart = std::max(text.indexOf(u'e'), text.indexOf(u'E'));
+            if (exponentStart >= 0)
+            {
+                exponent = text.sliced(exponentStart + 1).toInt();
+                text.truncate(exponentStart);
+            }
+            if (const auto point = text.indexOf(u'.'); point >= 0)
+            {
+                exponent -= static_cast<int>(text.size() - point - 1);
+                text.remove(point, 1);
+            }
+            for (auto i = 0; i < text.size(); i++)
+                digits.push_back(DigitValue(text[i]));
+        }
+
+        while (!digits.empty() && digits.back() == 0)
+        {
+            digits.pop_back();
+            exponent++;
+        }
+        const auto first = std::find_if(digits.begin(), digits.end(), [](int digit) { return digit != 0; });
+        if (first == digits.end())
+            return QString("0");
+
+        auto result = QString(isNegative ? "-" : "");
+        for (auto digit = first; digit != digits.end(); ++digit)
+            result += QString::number(*digit);
+
+        return result + u'e' + QString::number(exponent);
+    }
+
+    bool AreEqual(const Value& left, const Value& right)
+    {
+        if (left.type() != right.type() || left.typeAnnotation() != right.typeAnnotation())
+            return false;
+
+        if (left.type() == ValueType::Integer || (left.type() == ValueType::Float && !left.string().startsWith(u'#')))
+            return CanonicalNumber(left) == CanonicalNumber(right);
+
+        return left.string() == right.string();
+    }
+
+    bool AreEqual(const Node& left, const Node& right)
+    {
+        if (left.name() != right.name() || left.typeAnnotation() != right.typeAnnotation()
+            || left.argumentCount() != right.argumentCount() || left.propertyCount() != right.propertyCount()
+            || left.childCount() != right.childCount())
+            return false;
+
+        for (auto i = 0; i < left.argumentCount(); i++)
+        {
+            if (!AreEqual(left.argument(i), right.argument(i)))
+                return false;
+        }
+
+        // Expected files list properties in alphabetical order
+        for (auto i = 0; i < left.propertyCount(); i++)
+        {
+            const auto property = left.property(i);
+            const auto expected = right.property(property.name());
+            if (!expected || !AreEqual(property.value(), *expected))
+                return false;
+        }
+
+        auto rightChild = right.children().begin();
+        for (const auto leftChild : left.children())
+        {
+            if (!AreEqual(leftChild, *rightChild))
+                return false;
+
+            ++rightChild;
+        }
+
+        return true;
+    }
+
     void FileTests(const QString& fileName, const QString& inputFilePath, const QString& expectedFilePath)
     {
-        AalTest::Fail();
+        const auto result = Parse(ReadFile(inputFilePath));
+        if (!QFile::exists(expectedFilePath))
+        {
+            AalTest::IsTrue(result.status != ParseStatus::Ok);
+            return;
+        }
+
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+        const auto expected = Parse(ReadFile(expectedFilePath));
+        AalTest::AreEqual(ParseStatus::Ok, expected.status);
+        AalTest::AreEqual(expected.document.nodeCount(), result.document.nodeCount());
+
+        auto expectedNode = expected.document.nodes().begin();
+        for (const auto node : result.document.nodes())
+        {
+            AalTest::IsTrue(AreEqual(node, *expectedNode));
+            ++expectedNode;
+        }
     }
 
     QList<std::tuple<QString, QString, QString>> FileTests_Data()
@@ -34,9 +248,1377 @@ namespace
         return data;
     }
 
+    // Writing a parsed input has to give the text of its expected file
+    void WriteFiles(const QString& fileName, const QString& inputFilePath, const QString& expectedFilePath)
+    {
+        if (!QFile::exists(expectedFilePath))
+            return;
+
+        auto expectedFile = QFile(expectedFilePath);
+        AalTest::IsTrue(expectedFile.open(QIODevice::ReadOnly));
+        const auto expected = expectedFile.readAll();
+
+        const auto source = ReadFile(inputFilePath);
+        const auto result = Parse(source);
+        auto output = QByteArray();
+        auto writer = Writer{ output };
+        writer.write(result.document);
+        AalTest::IsTrue(writer.finish());
+        AalTest::AreEqual(expected, output);
+
+        // Written from the events, without a document
+        const auto tokens = Lex(source);
+        auto streamed = QByteArray();
+        auto streamWriter = Writer{ streamed };
+        auto buffers = ParseBuffers{};
+        auto parser = EventParser{ tokens, streamWriter, buffers };
+        AalTest::AreEqual(ParseStatus::Ok, parser.parse());
+        AalTest::IsTrue(streamWriter.finish());
+        AalTest::AreEqual(expected, streamed);
+    }
+
+    void WriteNumbers(const QString& expected, double number)
+    {
+        auto output = QByteArray();
+        auto writer = Writer{ output };
+        writer.beginNode(u"node");
+        writer.argument(number);
+        writer.endNode();
+        AalTest::AreEqual(QByteArray("node ") + expected.toUtf8() + QByteArray("\n"), output);
+
+        // The written text reads back as the same double
+        const auto parsed = Parse(QString::fromUtf8(output));
+        AalTest::AreEqual(ParseStatus::Ok, parsed.status);
+        const auto value = (*parsed.document.nodes().begin()).argument(0);
+        if (!std::isnan(number))
+            AalTest::AreEqual(number, value.toDouble().value);
+    }
+
+    QList<std::tuple<QString, double>> WriteNumbers_Data()
+    {
+        return {
+            std::make_tuple(QString("1.0"), 1.0),
+            std::make_tuple(QString("-2.5"), -2.5),
+            std::make_tuple(QString("0.1"), 0.1),
+            std::make_tuple(QString("1E+100"), 1e100),
+            std::make_tuple(QString("1.2345E-7"), 1.2345e-7),
+            std::make_tuple(QString("123456789.0"), 123456789.0),
+            std::make_tuple(QString("1.7976931348623157E+308"), 1.7976931348623157e308),
+            std::make_tuple(QString("#inf"), std::numeric_limits<double>::infinity()),
+            std::make_tuple(QString("#-inf"), -std::numeric_limits<double>::infinity()),
+            std::make_tuple(QString("#nan"), std::numeric_limits<double>::quiet_NaN()),
+        };
+    }
+
+    void WriteValues()
+    {
+        auto output = QByteArray();
+        auto writer = Writer{ output };
+        writer.beginNode(u"node", u"type");
+        writer.argument(-42);
+        writer.argument(std::numeric_limits<u64>::max());
+        writer.argument(u"needs \"quotes\"");
+        writer.argument(u"bare");
+        writer.argument(u"true");
+        writer.property(u"z", 1.5f);
+        writer.property(u"a", u"x");
+        writer.property(u"z", u"last");
+        writer.beginChildren();
+        writer.endChildren();
+        writer.endNode();
+        AalTest::IsTrue(writer.finish());
+        AalTest::AreEqual(QByteArray("(type)node -42 18446744073709551615 \"needs \\\"quotes\\\"\" bare \"true\" a=x z=last\n"), output);
+    }
+
+    // Chunks are written to the device as they fill up, the last one by finish
+    void WriteToDevice()
+    {
+        auto source = QString();
+        for (auto i = 0; i < 10000; i++)
+            source += QString("node %1 name=\"item %1\" { child; }\n").arg(i);
+
+        const auto result = Parse(source);
+        auto expected = QByteArray();
+        auto bufferWriter = Writer{ expected };
+        bufferWriter.write(result.document);
+
+        auto device = QBuffer();
+        AalTest::IsTrue(device.open(QIODevice::WriteOnly));
+        auto writer = Writer{ device };
+        writer.write(result.document);
+        AalTest::IsTrue(device.data().size() > 0);
+        AalTest::IsTrue(writer.finish());
+        AalTest::AreEqual(expected, device.data());
+    }
+
+    // Parsing while lexing has to give the same result as parsing the token buffer
+    void FusedParse(const QString& fileName, const QString& inputFilePath, const QString& expectedFilePath)
+    {
+        const auto source = ReadFile(inputFilePath);
+        const auto fused = Parse(source);
+        const auto buffered = Parse(Lex(source));
+
+        AalTest::AreEqual(buffered.status, fused.status);
+        AalTest::AreEqual(buffered.errorOffset, fused.errorOffset);
+        AalTest::AreEqual(buffered.document.nodeCount(), fused.document.nodeCount());
+
+        auto bufferedNode = buffered.document.nodes().begin();
+        for (const auto node : fused.document.nodes())
+        {
+            AalTest::IsTrue(AreEqual(node, *bufferedNode));
+            ++bufferedNode;
+        }
+    }
+
+    // Writes every event as text: nodes as "(type)name", entries after a space, children in braces and ";" for a node end
+    struct TraceHandler
+    {
+        QString trace;
+        // Appends "@offset" to names and values
+        bool tracesOffsets = false;
+
+        void appendOffset(i32 offset)
+        {
+            if (tracesOffsets)
+                trace += QString("@") + QString::number(offset);
+        }
+
+        void beginNode(QStringView name, std::optional<QStringView> typeAnnotation, i32 offset)
+        {
+            if (typeAnnotation)
+                trace += QString("(") + typeAnnotation->toString() + QString(")");
+
+            trace += name.toString();
+            appendOffset(offset);
+        }
+
+        void appendValue(const EventValue& value)
+        {
+            if (value.typeAnnotation)
+                trace += QString("(") + value.typeAnnotation->toString() + QString(")");
+
+            trace += value.text.toString();
+            appendOffset(value.offset);
+        }
+
+        void argument(const EventValue& value)
+        {
+            trace += QString(" ");
+            appendValue(value);
+        }
+
+        void property(QStringView name, const EventValue& value, i32 offset)
+        {
+            trace += QString(" ") + name.toString();
+            appendOffset(offset);
+            trace += QString("=");
+            appendValue(value);
+        }
+
+        void beginChildren()
+        {
+            trace += QString(" {");
+        }
+
+        void endChildren()
+        {
+            trace += QString("}");
+        }
+
+        void endNode()
+        {
+            trace += QString(";");
+        }
+    };
+
+    void Events(const QString& source, const QString& expectedTrace)
+    {
+        const auto tokens = Lex(source);
+        auto handler = TraceHandler{};
+        auto buffers = ParseBuffers{};
+        auto parser = EventParser{ tokens, handler, buffers };
+
+        AalTest::AreEqual(ParseStatus::Ok, parser.parse());
+        AalTest::AreEqual(expectedTrace, handler.trace);
+    }
+
+    QList<std::tuple<QString, QString>> Events_Data()
+    {
+        return {
+            std::make_tuple(QString("node 1 key=#true"), QString("node 1 key=#true;")),
+            std::make_tuple(QString("(type)node (u8)1 \"a\\nb\""), QString("(type)node (u8)1 a\nb;")),
+            std::make_tuple(QString("node /-1 2"), QString("node 2;")),
+            std::make_tuple(QString("node /- key=1 2"), QString("node 2;")),
+            std::make_tuple(QString("/-node 1\nother"), QString("other;")),
+            std::make_tuple(QString("/-node { child { grandchild } }\nnext"), QString("next;")),
+            std::make_tuple(QString("node /-{ a } { b }"), QString("node {b;};")),
+            std::make_tuple(QString("node { a } /-{ b }"), QString("node {a;};")),
+            std::make_tuple(QString("parent {\n    /-child\n    kept\n}"), QString("parent {kept;};")),
+            std::make_tuple(QString("a; b\n/-\n\nc\nd"), QString("a;b;d;")),
+        };
+    }
+
+    // Joins random fragments that start and end line continuations, comments and strings in every combination
+    QString GeneratedSource(std::mt19937& random)
+    {
+        static const QString Fragments[] = {
+            QString(" "), QString("\t"), QString("\n"), QString("\r\n"), QString("\\"), QString("\\ "),
+            QString("\\\n"), QString("// c\n"), QString("/*"), QString("*/"), QString("/* x */"), QString("/-"),
+            QString("\""), QString("\"a b\""), QString("\"\\\"\""), QString("#\""), QString("\"#"),
+            QString("#\"r\"#"), QString("\"\"\"\n"), QString("{"), QString("}"), QString(";"), QString("="),
+            QString("(t)"), QString("node"), QString("a"), QString("1"), QString("0x1F"), QString("1.5e3"),
+            QString("#true"), QString::fromUtf8("\xC3\xBC"), QString("key=1"),
+        };
+
+        auto fragment = std::uniform_int_distribution<i32>{ 0, static_cast<i32>(std::size(Fragments)) - 1 };
+        const auto fragmentCount = std::uniform_int_distribution<i32>{ 1, 60 }(random);
+        auto source = QString();
+        for (auto i = 0; i < fragmentCount; i++)
+            source += Fragments[fragment(random)];
+
+        return source;
+    }
+
+    // The fused parse lexes as it goes, line continuations, comments and strings have to end the same way as
+    // when they are lexed up front
+    void FusedGeneratedSources()
+    {
+        auto random = std::mt19937{ 2024 };
+        for (auto i = 0; i < 5000; i++)
+        {
+            const auto source = GeneratedSource(random);
+            const auto fused = Parse(source);
+            const auto buffered = Parse(Lex(source));
+            AalTest::AreEqual(buffered.status, fused.status);
+            AalTest::AreEqual(buffered.errorOffset, fused.errorOffset);
+        }
+    }
+
+    void BindFields()
+    {
+        const auto source = QString(
+            "host \"example.com\"\n"
+            "port 8080\n"
+            "retries 1 2\n"
+            "retries 3\n"
+            "endpoint path=\"/health\" public=#true\n"
+            "endpoint {\n"
+            "    path \"/users\"\n"
+            "    methods GET POST\n"
+            "}\n");
+
+        auto config = ServerConfig{};
+        const auto result = Bind(source, config);
+
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+        AalTest::AreEqual(std::size_t(0), result.errors.size());
+        AalTest::AreEqual(QString("example.com"), config.host);
+        AalTest::AreEqual(u16(8080), config.port);
+        AalTest::IsTrue(!config.timeout.has_value());
+        AalTest::IsTrue(config.retries == std::vector<i32>{ 1, 2, 3 });
+        AalTest::AreEqual(std::size_t(2), config.endpoints.size());
+        AalTest::AreEqual(QString("/health"), config.endpoints[0].path);
+        AalTest::IsTrue(config.endpoints[0].isPublic);
+        AalTest::AreEqual(QString("/users"), config.endpoints[1].path);
+        AalTest::IsTrue(config.endpoints[1].methods == std::vector<QString>{ QString("GET"), QString("POST") });
+
+        // The buffered tokens have to bind the same way
+        auto buffered = ServerConfig{};
+        const auto bufferedResult = Bind(Lex(source), buffered);
+        AalTest::AreEqual(std::size_t(0), bufferedResult.errors.size());
+        AalTest::AreEqual(config.host, buffered.host);
+        AalTest::AreEqual(config.endpoints.size(), buffered.endpoints.size());
+    }
+
+    // Errors are written as "status name offset" separated by ", "
+    void BindErrors(const QString& source, const QString& expectedErrors)
+    {
+        static constexpr const char* StatusNames[] = { "UnknownField", "MissingField", "TypeMismatch" };
+
+        auto config = ServerConfig{};
+        const auto result = Bind(source, config);
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+
+        auto errors = QString();
+        for (const auto& error : result.errors)
+        {
+            if (!errors.isEmpty())
+                errors += QString(", ");
+
+            errors += QString(StatusNames[static_cast<i32>(error.status)]) + QString(" ") + error.name + QString(" ")
+                + QString::number(error.offset);
+        }
+
+        AalTest::AreEqual(expectedErrors, errors);
+    }
+
+    QList<std::tuple<QString, QString>> BindErrors_Data()
+    {
+        return {
+            std::make_tuple(QString("host \"a\"\nname \"b\""), QString("UnknownField name 9")),
+            std::make_tuple(QString("port 1"), QString("MissingField host 6")),
+            std::make_tuple(QString("host \"a\"; port \"80\""), QString("TypeMismatch port 15")),
+            std::make_tuple(QString("host \"a\"; port 65536"), QString("TypeMismatch port 15")),
+            std::make_tuple(QString("host \"a\"; port 1 2"), QString("TypeMismatch port 17")),
+            std::make_tuple(QString("host \"a\"; port"), QString("TypeMismatch port 10")),
+            std::make_tuple(QString("host \"a\"; timeout 1.5; retries 1 #null"), QString("TypeMismatch retries 33")),
+            std::make_tuple(QString("host \"a\"; endpoint methods=GET"), QString("MissingField path 10")),
+            std::make_tuple(QString("host \"a\"; endpoint path=\"/\" other=1 { unknown { deep 1 } }"),
+                QString("UnknownField other 28, UnknownField unknown 38")),
+            std::make_tuple(QString("host \"a\"; endpoint 1 path=\"/\""), QString("TypeMismatch endpoint 19")),
+            std::make_tuple(QString("host \"a\"; /-port \"x\"; port 2 { child }"), QString("UnknownField child 31")),
+        };
+    }
+
+    const QString ServerSchema = QString(R"(
+        document {
+            node server {
+                min 1
+                max 1
+                value { type string; pattern "^[a-z.]+$"; min 1; max 1 }
+                prop port { type number; format u16; required #true }
+                prop mode { enum fast safe }
+                children {
+                    node timeout { max 1; value { type number; > 0; "<=" 60; min 1 } }
+                    node tag { value { type string; min-length 2; max-length 5 } }
+                    node id { value { format uuid } }
+                }
+            }
+            node plugin {
+                other-props-allowed #true
+                children { other-nodes-allowed #true }
+            }
+        })");
+
+    // Violations are written as "kind name offset" separated by ", "
+    QString ViolationTrace(const std::vector<Violation>& violations)
+    {
+        static constexpr const char* KindNames[] = {
+            "UnknownNode", "TooFewNodes", "TooManyNodes", "UnknownProperty", "MissingProperty", "TooFewValues",
+            "TooManyValues", "WrongType", "NotInEnum", "PatternMismatch", "TooShort", "TooLong", "OutOfRange",
+            "NotMultiple", "InvalidFormat"
+        };
+
+        auto trace = QString();
+        for (const auto& violation : violations)
+        {
+            if (!trace.isEmpty())
+                trace += QString(", ");
+
+            trace += QString(KindNames[static_cast<i32>(violation.kind)]) + QString(" ") + violation.name + QString(" ")
+                + QString::number(violation.offset);
+        }
+
+        return trace;
+    }
+
+    void SchemaViolations(const QString& source, const QString& expectedViolations)
+    {
+        const auto compiled = CompileSchema(ServerSchema);
+        AalTest::AreEqual(SchemaStatus::Ok, compiled.status);
+
+        const auto result = Validate(compiled.schema, source);
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+        AalTest::AreEqual(expectedViolations, ViolationTrace(result.violations));
+
+        const auto buffered = Validate(compiled.schema, Lex(source));
+        AalTest::AreEqual(expectedViolations, ViolationTrace(buffered.violations));
+    }
+
+    QList<std::tuple<QString, QString>> SchemaViolations_Data()
+    {
+        return {
+            std::make_tuple(QString("server \"a.b\" port=80 mode=safe"), QString("")),
+            std::make_tuple(QString("server \"a\" port=80 mode=slow"), QString("NotInEnum mode 24")),
+            std::make_tuple(QString("server \"A\" port=80"), QString("PatternMismatch server 7")),
+            std::make_tuple(QString("server \"a\" port=70000"), QString("InvalidFormat port 16")),
+            std::make_tuple(QString("server \"a\""), QString("MissingProperty port 0")),
+            std::make_tuple(QString("server \"a\" port=1 color=1"), QString("UnknownProperty color 18")),
+            std::make_tuple(QString("other"), QString("UnknownNode other 0, TooFewNodes server 5")),
+            std::make_tuple(QString("server \"a\" port=1\nserver \"b\" port=2"), QString("TooManyNodes server 18")),
+            std::make_tuple(QString("server \"a\" \"b\" port=1"), QString("TooManyValues server 11")),
+            std::make_tuple(QString("server 1 port=1"), QString("WrongType server 7")),
+            std::make_tuple(QString("server \"a\" port=1 { timeout 0; timeout 61; }"),
+                QString("OutOfRange timeout 28, TooManyNodes timeout 31, OutOfRange timeout 39")),
+            std::make_tuple(QString("server \"a\" port=1 { timeout; }"), QString("TooFewValues timeout 20")),
+            std::make_tuple(QString("server \"a\" port=1 { tag x; tag toolong; }"), QString("TooShort tag 24, TooLong tag 31")),
+            std::make_tuple(QString("server \"a\" port=1 { id \"123\"; id \"123e4567-e89b-12d3-a456-426614174000\"; }"),
+                QString("InvalidFormat id 23")),
+            std::make_tuple(QString("plugin x=1 { anything { deeper 1 } }\nserver \"a\" port=1"), QString("")),
+        };
+    }
+
+    // The schema describes itself, so it has to validate against its own compiled form
+    void SchemaValidatesItself()
+    {
+        const auto source = ReadFile(QString("../../Tests/Data/Examples/kdl-schema.kdl"));
+        const auto compiled = CompileSchema(source);
+        AalTest::AreEqual(SchemaStatus::Ok, compiled.status);
+
+        const auto result = Validate(compiled.schema, source);
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+        AalTest::AreEqual(QString(""), ViolationTrace(result.violations));
+    }
+
+    void SchemaFromThreads()
+    {
+        constexpr auto ThreadCount = 4;
+
+        const auto compiled = CompileSchema(ServerSchema);
+        const auto source = QString("server \"A\" port=1 mode=slow { tag x; timeout 61 }");
+        const auto expected = ViolationTrace(Validate(compiled.schema, source).violations);
+
+        std::vector<QString> traces(ThreadCount);
+        std::vector<std::thread> threads{};
+        for (auto thread = 0; thread < ThreadCount; thread++)
+        {
+            threads.emplace_back([&compiled, &source, &trace = traces[thread]]()
+                {
+                    for (auto i = 0; i < 100; i++)
+                        trace = ViolationTrace(Validate(compiled.schema, source).violations);
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        for (const auto& trace : traces)
+            AalTest::AreEqual(expected, trace);
+    }
+
+    void SchemaErrors(const QString& source, const QString& expectedError)
+    {
+        static constexpr const char* StatusNames[] = {
+            "Ok", "InvalidDocument", "MissingDocument", "UnresolvedReference", "InvalidRule"
+        };
+
+        const auto result = CompileSchema(source);
+        AalTest::AreEqual(expectedError, QString(StatusNames[static_cast<i32>(result.status)]) + QString(" ") + result.errorName);
+    }
+
+    QList<std::tuple<QString, QString>> SchemaErrors_Data()
+    {
+        return {
+            std::make_tuple(QString("document { node a"), QString("InvalidDocument ")),
+            std::make_tuple(QString("node a"), QString("MissingDocument ")),
+            std::make_tuple(QString("document { node ref=\"[id=\\\"b\\\"]\" }"), QString("UnresolvedReference [id=\"b\"]")),
+            std::make_tuple(QString("document { node a { value { type text } } }"), QString("InvalidRule text")),
+            std::make_tuple(QString("document { node a { max many } }"), QString("InvalidRule max")),
+            std::make_tuple(QString("document { node a { prop p { pattern \"(\" } } }"), QString("InvalidRule (")),
+            std::make_tuple(QString("document { node a id=a { children { node ref=\"[id=\\\"a\\\"]\" } } }"), QString("Ok ")),
+        };
+    }
+
+    const auto QuerySource = QString(R"(package "kdl" version=2 {
+    (dep)lib "qt" version="6.5" optional=#true
+    lib "aal"
+    (dep)tool "cmake" min=3.20
+}
+package "app" {
+    lib "kdl"
+    group { lib "deep"; }
+}
+config mode=fast mode=safe)");
+
+    // Matches are written as "name offset" separated by ", "
+    QString MatchTrace(const std::vector<QueryMatch>& matches)
+    {
+        auto trace = QString();
+        for (const auto& match : matches)
+        {
+            if (!trace.isEmpty())
+                trace += QString(", ");
+
+            trace += match.name + QString(" ") + QString::number(match.offset);
+        }
+
+        return trace;
+    }
+
+    void QuerySelect(const QString& selector, const QString& expectedMatches)
+    {
+        const auto compiled = CompileQuery(selector);
+        AalTest::AreEqual(QueryStatus::Ok, compiled.status);
+
+        const auto result = Select(compiled.query, QuerySource);
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+        AalTest::AreEqual(expectedMatches, MatchTrace(result.matches));
+
+        const auto buffered = Select(compiled.query, Lex(QuerySource));
+        AalTest::AreEqual(expectedMatches, MatchTrace(buffered.matches));
+
+        // The document walk finds the same nodes in the same order
+        const auto parsed = Parse(QuerySource);
+        const auto nodes = Select(compiled.query, parsed.document);
+        AalTest::AreEqual(static_cast<i32>(result.matches.size()), static_cast<i32>(nodes.size()));
+        for (auto i = 0; i < static_cast<i32>(nodes.size()) && i < static_cast<i32>(result.matches.size()); i++)
+            AalTest::AreEqual(result.matches[i].name, nodes[i].name().toString());
+    }
+
+    QList<std::tuple<QString, QString>> QuerySelect_Data()
+    {
+        return {
+            std::make_tuple(QString("lib"), QString("lib 35, lib 77, lib 140, lib 162")),
+            std::make_tuple(QString("package > lib"), QString("lib 35, lib 77, lib 140")),
+            std::make_tuple(QString("package lib"), QString("lib 35, lib 77, lib 140, lib 162")),
+            std::make_tuple(QString("top() > lib"), QString("")),
+            std::make_tuple(QString("top() > package > group > lib"), QString("lib 162")),
+            std::make_tuple(QString("top() > package"), QString("package 0, package 120")),
+            std::make_tuple(QString("(dep)"), QString("lib 35, tool 96")),
+            std::make_tuple(QString("()lib"), QString("lib 35")),
+            std::make_tuple(QString("lib + tool"), QString("tool 96")),
+            std::make_tuple(QString("(dep)lib + tool"), QString("")),
+            std::make_tuple(QString("(dep)lib ~ tool"), QString("tool 96")),
+            std::make_tuple(QString("(dep)lib ~ lib"), QString("lib 77")),
+            std::make_tuple(QString("[val() = \"kdl\"]"), QString("package 0, lib 140")),
+            std::make_tuple(QString("package[version >= 2]"), QString("package 0")),
+            std::make_tuple(QString("package[version < 2]"), QString("")),
+            std::make_tuple(QString("lib[optional]"), QString("lib 35")),
+            std::make_tuple(QString("lib[prop(optional) = #true]"), QString("lib 35")),
+            std::make_tuple(QString("[val() ^= a]"), QString("lib 77, package 120")),
+            std::make_tuple(QString("[val() $= t]"), QString("lib 35")),
+            std::make_tuple(QString("[val() *= ee]"), QString("lib 162")),
+            std::make_tuple(QString("[val() != kdl]"), QString("lib 35, lib 77, tool 96, package 120, lib 162")),
+            std::make_tuple(QString("[name() = group] lib"), QString("lib 162")),
+            std::make_tuple(QString("[tag() = dep][val(0) = cmake]"), QString("tool 96")),
+            std::make_tuple(QString("config[mode = safe]"), QString("config 178")),
+            std::make_tuple(QString("config[mode = fast]"), QString("")),
+            std::make_tuple(QString("lib[val(1)]"), QString("")),
+            std::make_tuple(QString("tool[min > 3.1]"), QString("tool 96")),
+            std::make_tuple(QString("lib[version = \"6.5\"]"), QString("lib 35")),
+            std::make_tuple(QString("tool, group"), QString("tool 96, group 154")),
+            std::make_tuple(QString("package > lib, lib"), QString("lib 35, lib 77, lib 140, lib 162")),
+        };
+    }
+
+    void QueryErrors(const QString& selector, const QString& expectedError)
+    {
+        static constexpr const char* StatusNames[] = {
+            "Ok", "UnexpectedCharacter", "InvalidValue", "UnsupportedAccessor", "TooComplex"
+        };
+
+        const auto result = CompileQuery(selector);
+        AalTest::AreEqual(expectedError, QString(StatusNames[static_cast<i32>(result.status)]) + QString(" ")
+            + QString::number(result.errorOffset));
+    }
+
+    QList<std::tuple<QString, QString>> QueryErrors_Data()
+    {
+        auto tooComplex = QString("a");
+        for (auto i = 0; i < 64; i++)
+            tooComplex += QString(" a");
+
+        return {
+            std::make_tuple(QString("lib["), QString("UnexpectedCharacter 4")),
+            std::make_tuple(QString("lib[values()]"), QString("UnsupportedAccessor 4")),
+            std::make_tuple(QString("lib[val() > \"a\"]"), QString("InvalidValue 12")),
+            std::make_tuple(QString("lib[val() ^= 1]"), QString("InvalidValue 13")),
+            std::make_tuple(QString("lib[val() = 1 2]"), QString("UnexpectedCharacter 14")),
+            std::make_tuple(QString("lib[val() = \"a]"), QString("InvalidValue 12")),
+            std::make_tuple(QString("lib[val() = true]"), QString("InvalidValue 12")),
+            std::make_tuple(QString("top() lib"), QString("UnexpectedCharacter 6")),
+            std::make_tuple(QString("a,,b"), QString("UnexpectedCharacter 2")),
+            std::make_tuple(QString("lib > > x"), QString("UnexpectedCharacter 6")),
+            std::make_tuple(tooComplex, QString("TooComplex 128")),
+            std::make_tuple(QString("(dep)lib[val(1) = #true][\"long name\" = #\"raw\"#]"), QString("Ok 0")),
+        };
+    }
+
+    // The binary form has to write the same text as the parsed document, and fail where parsing fails
+    void BinaryFiles(const QString& fileName, const QString& inputFilePath, const QString& expectedFilePath)
+    {
+        const auto source = ReadFile(inputFilePath);
+        const auto encoded = EncodeBinary(source);
+        const auto buffered = EncodeBinary(Lex(source));
+        AalTest::AreEqual(buffered.status, encoded.status);
+        AalTest::AreEqual(buffered.bytes, encoded.bytes);
+
+        if (!QFile::exists(expectedFilePath))
+        {
+            AalTest::IsTrue(encoded.status != ParseStatus::Ok);
+            AalTest::IsTrue(encoded.bytes.isEmpty());
+            return;
+        }
+
+        auto expectedFile = QFile(expectedFilePath);
+        AalTest::IsTrue(expectedFile.open(QIODevice::ReadOnly));
+        const auto expected = expectedFile.readAll();
+
+        AalTest::AreEqual(ParseStatus::Ok, encoded.status);
+        const auto opened = OpenBinary(encoded.bytes);
+        AalTest::AreEqual(BinaryStatus::Ok, opened.status);
+
+        auto output = QByteArray();
+        auto writer = Writer{ output };
+        writer.write(opened.document);
+        AalTest::IsTrue(writer.finish());
+        AalTest::AreEqual(expected, output);
+    }
+
+    void BinaryValues()
+    {
+        const auto source = QString(
+            "(cfg)config (u8)7 \"a\\tb\" #true #null big=0xFFFF_FFFF_FFFF_FFFF neg=-5 huge=123456789012345678901234567890 "
+            "pi=3.5 max=1e1000 dup=1 dup=2 {\n"
+            "    child 1 { grand; grand; }\n"
+            "    child 2\n"
+            "}\n"
+            "next\n");
+        const auto encoded = EncodeBinary(source);
+        AalTest::AreEqual(ParseStatus::Ok, encoded.status);
+        const auto opened = OpenBinary(encoded.bytes);
+        AalTest::AreEqual(BinaryStatus::Ok, opened.status);
+
+        const auto& document = opened.document;
+        AalTest::AreEqual(2, document.nodeCount());
+        auto it = document.nodes().begin();
+        const auto config = *it;
+        AalTest::AreEqual(QString("config"), config.name().toString());
+        AalTest::AreEqual(QString("cfg"), config.typeAnnotation()->toString());
+
+        AalTest::AreEqual(4, config.argumentCount());
+        AalTest::AreEqual(QString("u8"), config.argument(0).typeAnnotation()->toString());
+        AalTest::AreEqual(i64(7), config.argument(0).toInt64().value);
+        AalTest::AreEqual(QString("a\tb"), config.argument(1).string().toString());
+        AalTest::IsTrue(!config.argument(1).typeAnnotation());
+        AalTest::IsTrue(config.argument(2).boolean());
+        AalTest::AreEqual(ValueType::Null, config.argument(3).type());
+
+        // Only the rightmost duplicate is kept
+        AalTest::AreEqual(6, config.propertyCount());
+        AalTest::AreEqual(i64(2), config.property(u"dup")->toInt64().value);
+        AalTest::IsTrue(!config.property(u"missing"));
+
+        const auto big = *config.property(u"big");
+        AalTest::AreEqual(std::numeric_limits<u64>::max(), big.toUInt64().value);
+        AalTest::AreEqual(NumberStatus::Overflow, big.toInt64().status);
+        AalTest::AreEqual(QString("0xFFFF_FFFF_FFFF_FFFF"), big.string().toString());
+
+        const auto negative = *config.property(u"neg");
+        AalTest::AreEqual(i64(-5), negative.toInt64().value);
+        AalTest::AreEqual(-5.0, negative.toDouble().value);
+        AalTest::AreEqual(NumberStatus::Overflow, negative.toUInt64().status);
+
+        const auto huge = *config.property(u"huge");
+        AalTest::AreEqual(NumberStatus::Overflow, huge.toInt64().status);
+        AalTest::AreEqual(NumberStatus::Overflow, huge.toUInt64().status);
+        AalTest::AreEqual(1.2345678901234568e29, huge.toDouble().value);
+
+        AalTest::AreEqual(3.5, config.property(u"pi")->toDouble().value);
+        AalTest::AreEqual(NumberStatus::Invalid, config.property(u"pi")->toInt64().status);
+        AalTest::AreEqual(NumberStatus::Overflow, config.property(u"max")->toDouble().status);
+
+        // Iterating jumps over the children of each node
+        AalTest::AreEqual(2, config.childCount());
+        auto children = QStringList();
+        for (const auto child : config.children())
+            children.append(child.name().toString() + QString::number(child.childCount()));
+        AalTest::AreEqual(QStringList{ QString("child2"), QString("child0") }, children);
+
+        ++it;
+        AalTest::AreEqual(QString("next"), (*it).name().toString());
+        ++it;
+        AalTest::IsTrue(it == document.nodes().end());
+    }
+
+    void BinaryErrors()
+    {
+        const auto encoded = EncodeBinary(QString("node 1 { child; }\n"));
+        AalTest::AreEqual(ParseStatus::Ok, encoded.status);
+        AalTest::AreEqual(BinaryStatus::Ok, OpenBinary(encoded.bytes).status);
+
+        AalTest::AreEqual(BinaryStatus::InvalidHeader, OpenBinary(QByteArray()).status);
+        AalTest::AreEqual(BinaryStatus::InvalidHeader, OpenBinary(QByteArray("node 1 { child; }\n")).status);
+        AalTest::AreEqual(BinaryStatus::Truncated, OpenBinary(encoded.bytes.left(encoded.bytes.size() - 4)).status);
+
+        auto version = encoded.bytes;
+        version[4] = 2;
+        AalTest::AreEqual(BinaryStatus::UnsupportedVersion, OpenBinary(version).status);
+
+        // The header is followed by the record of "node", its argument and the record of "child"
+        const auto corrupt = [&](u64 offset, u32 value)
+            {
+                auto bytes = encoded.bytes;
+                std::memcpy(bytes.data() + offset, &value, sizeof(value));
+                return OpenBinary(bytes).status;
+            };
+        BinaryFormat::Header header;
+        std::memcpy(&header, encoded.bytes.data(), sizeof(header));
+        auto firstString = u32(0);
+        std::memcpy(&firstString, encoded.bytes.data() + header.stringTable, sizeof(firstString));
+        const auto node = sizeof(BinaryFormat::Header);
+        const auto argument = node + sizeof(BinaryFormat::NodeRecord);
+        const auto child = argument + sizeof(BinaryFormat::ValueRecord);
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(offsetof(BinaryFormat::Header, nodeCount), 2));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(offsetof(BinaryFormat::Header, firstNode), 0));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(header.stringTable, header.size));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(firstString, header.size));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(node + offsetof(BinaryFormat::NodeRecord, name), header.stringCount));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(node + offsetof(BinaryFormat::NodeRecord, argumentCount), 1000));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(node + offsetof(BinaryFormat::NodeRecord, childCount), 2));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(node + offsetof(BinaryFormat::NodeRecord, end), 0xFFFFFFF0));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(argument + offsetof(BinaryFormat::ValueRecord, text), 1000));
+        AalTest::AreEqual(BinaryStatus::Corrupted, corrupt(child + offsetof(BinaryFormat::NodeRecord, end), static_cast<u32>(child)));
+        AalTest::AreEqual(BinaryStatus::Ok, OpenBinaryUnchecked(encoded.bytes).status);
+
+        const auto invalid = EncodeBinary(QString("node {"));
+        AalTest::IsTrue(invalid.status != ParseStatus::Ok);
+        AalTest::IsTrue(invalid.bytes.isEmpty());
+
+        // An empty document still has a header
+        const auto empty = EncodeBinary(QString());
+        const auto opened = OpenBinary(empty.bytes);
+        AalTest::AreEqual(BinaryStatus::Ok, opened.status);
+        AalTest::AreEqual(0, opened.document.nodeCount());
+        AalTest::IsTrue(opened.document.nodes().begin() == opened.document.nodes().end());
+        AalTest::AreEqual(0, BinaryDocument().nodeCount());
+    }
+
+    [[nodiscard]] QByteArray WriteBinary(const BinaryDocument& document)
+    {
+        auto output = QByteArray();
+        auto writer = Writer{ output };
+        writer.write(document);
+        (void)writer.finish();
+        return output;
+    }
+
+    // Any byte of a document can be damaged, what opens has to be readable without reading out of bounds
+    void BinaryDamagedBytes()
+    {
+        const auto encoded = EncodeBinary(QString("(t)node 1 \"two\" key=(u)#true { child 0x10; - #null }\n"));
+        AalTest::AreEqual(ParseStatus::Ok, encoded.status);
+        for (auto i = qsizetype(0); i < encoded.bytes.size(); i++)
+        {
+            for (const auto mask : { 0x01, 0x80, 0xFF })
+            {
+                auto bytes = encoded.bytes;
+                bytes[i] = static_cast<char>(bytes[i] ^ mask);
+                const auto opened = OpenBinary(bytes);
+                if (opened.status == BinaryStatus::Ok)
+                    (void)WriteBinary(opened.document);
+            }
+        }
+    }
+
+    // Damage anywhere past the header, to values as well as to offsets, makes the entry a miss
+    void ParseCacheDamagedEntries()
+    {
+        auto directory = QTemporaryDir();
+        AalTest::IsTrue(directory.isValid());
+        auto cache = ParseCache{ directory.path() };
+
+        const auto source = QByteArray("config (u8)7 name=\"a b\" {\n    child 0xFF 1.5 #true\n}\n");
+        const auto expected = WriteBinary(OpenBinary(EncodeBinary(QString::fromUtf8(source)).bytes).document);
+        AalTest::IsTrue(!cache.parse(source).isCached);
+
+        const auto entries = QDir(directory.path()).entryInfoList({ QString("*.kdlb") }, QDir::Files);
+        AalTest::AreEqual(1, static_cast<i32>(entries.size()));
+        auto file = QFile(entries.first().absoluteFilePath());
+        AalTest::IsTrue(file.open(QIODevice::ReadOnly));
+        const auto entry = file.readAll();
+        file.close();
+
+        for (auto i = qsizetype(sizeof(BinaryFormat::Header)); i < entry.size(); i++)
+        {
+            auto damaged = entry;
+            damaged[i] = static_cast<char>(damaged[i] ^ 0x01);
+            AalTest::IsTrue(file.open(QIODevice::WriteOnly));
+            file.write(damaged);
+            file.close();
+
+            const auto result = cache.parse(source);
+            AalTest::IsTrue(!result.isCached);
+            AalTest::AreEqual(expected, WriteBinary(result.document));
+            AalTest::IsTrue(cache.parse(source).isCached);
+        }
+    }
+
+    void ParseCacheHits()
+    {
+        auto directory = QTemporaryDir();
+        AalTest::IsTrue(directory.isValid());
+        auto cache = ParseCache{ directory.path() };
+
+        const auto source = QByteArray("config (u8)7 name=\"a b\" {\n    child 0xFF 1.5\n}\n");
+        const auto expected = WriteBinary(OpenBinary(EncodeBinary(QString::fromUtf8(source)).bytes).document);
+
+        const auto parsed = cache.parse(source);
+        AalTest::AreEqual(ParseStatus::Ok, parsed.status);
+        AalTest::IsTrue(!parsed.isCached);
+        AalTest::AreEqual(expected, WriteBinary(parsed.document));
+        AalTest::IsTrue(cache.size() > 0);
+
+        const auto cached = cache.parse(source);
+        AalTest::IsTrue(cached.isCached);
+        AalTest::AreEqual(expected, WriteBinary(cached.document));
+
+        // A new cache over the same directory finds the entry, as another process would
+        auto otherCache = ParseCache{ directory.path() };
+        AalTest::AreEqual(cache.size(), otherCache.size());
+        AalTest::IsTrue(otherCache.parse(source).isCached);
+
+        // Loaded entries stay mapped without staying open. Descriptors are handed out lowest first, one left
+        // open would show up as the next one.
+        const auto entryPath = QDir(directory.path()).entryInfoList({ QString("*.kdlb") }, QDir::Files).first().absoluteFilePath();
+        const auto nextHandle = [&entryPath]()
+        {
+            auto probe = QFile(entryPath);
+            return probe.open(QIODevice::ReadOnly) ? probe.handle() : -1;
+        };
+
+        const auto handle = nextHandle();
+        auto loaded = std::vector<ParseCacheResult>{};
+        for (auto i = 0; i < 16; i++)
+            loaded.push_back(cache.parse(source));
+        AalTest::AreEqual(handle, nextHandle());
+        for (const auto& result : loaded)
+            AalTest::AreEqual(expected, WriteBinary(result.document));
+
+        // Any change is another key
+        AalTest::IsTrue(!cache.parse(QByteArray("config (u8)8 name=\"a b\" {\n    child 0xFF 1.5\n}\n")).isCached);
+
+        // Errors are reported and not cached
+        const auto invalid = QByteArray("config {");
+        for (auto i = 0; i < 2; i++)
+        {
+            const auto result = cache.parse(invalid);
+            AalTest::IsTrue(result.status != ParseStatus::Ok);
+            AalTest::IsTrue(!result.isCached);
+        }
+
+        // A damaged entry is parsed and written again
+        for (const auto& entry : QDir(directory.path()).entryInfoList({ QString("*.kdlb") }, QDir::Files))
+        {
+            auto file = QFile(entry.absoluteFilePath());
+            AalTest::IsTrue(file.open(QIODevice::WriteOnly));
+            file.write(QByteArray("damaged"));
+        }
+        AalTest::IsTrue(!cache.parse(source).isCached);
+        AalTest::IsTrue(cache.parse(source).isCached);
+
+        // Files are read with a byte order mark skipped, and found under the key of their source
+        const auto path = directory.filePath(QString("source.kdl"));
+        auto file = QFile(path);
+        AalTest::IsTrue(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray("\xEF\xBB\xBF") + source);
+        file.close();
+        const auto fromFile = cache.parseFile(path);
+        AalTest::IsTrue(fromFile.has_value());
+        AalTest::IsTrue(fromFile->isCached);
+        AalTest::AreEqual(expected, WriteBinary(fromFile->document));
+        AalTest::IsTrue(!cache.parseFile(directory.filePath(QString("missing.kdl"))).has_value());
+    }
+
+    // The least recently used entries are removed first, loading an entry counts as using it
+    void ParseCacheTrim()
+    {
+        auto directory = QTemporaryDir();
+        AalTest::IsTrue(directory.isValid());
+
+        const auto sourceOf = [](i32 i) { return QString("node%1 1 2 3 name=value\n").arg(i).toUtf8(); };
+        // The document followed by its hash
+        const auto entrySize = EncodeBinary(QString::fromUtf8(sourceOf(0))).bytes.size() + qsizetype(sizeof(u64));
+        auto cache = ParseCache{ directory.path(), entrySize * 4 + entrySize / 2 };
+
+        // Each new entry is dated an hour after the one before it
+        const auto now = QDateTime::currentDateTime();
+        const auto age = [&](i32 hours)
+            {
+                for (const auto& entry : QDir(directory.path()).entryInfoList({ QString("*.kdlb") }, QDir::Files))
+                {
+                    if (entry.lastModified() < now.addSecs(-1800))
+                        continue;
+
+                    auto file = QFile(entry.absoluteFilePath());
+                    AalTest::IsTrue(file.open(QIODevice::ReadOnly));
+                    AalTest::IsTrue(file.setFileTime(now.addSecs(-3600 * hours), QFileDevice::FileModificationTime));
+                }
+            };
+
+        for (auto i = 0; i < 3; i++)
+        {
+            AalTest::IsTrue(!cache.parse(sourceOf(i)).isCached);
+            age(3 - i);
+        }
+        AalTest::AreEqual(i64(entrySize * 3), cache.size());
+
+        AalTest::IsTrue(cache.parse(sourceOf(0)).isCached);
+        AalTest::IsTrue(!cache.parse(sourceOf(3)).isCached);
+        AalTest::IsTrue(!cache.parse(sourceOf(4)).isCached);
+        AalTest::AreEqual(i64(entrySize * 3), cache.size());
+        AalTest::AreEqual(3, static_cast<i32>(QDir(directory.path()).entryInfoList({ QString("*.kdlb") }, QDir::Files).size()));
+
+        AalTest::IsTrue(cache.parse(sourceOf(0)).isCached);
+        AalTest::IsTrue(cache.parse(sourceOf(4)).isCached);
+        AalTest::IsTrue(!cache.parse(sourceOf(1)).isCached);
+    }
+
+    // Several caches over one directory, as in several processes, with several threads each
+    void ParseCacheFromThreads()
+    {
+        constexpr auto ThreadCount = 4;
+        constexpr auto SourceCount = 50;
+
+        auto directory = QTemporaryDir();
+        AalTest::IsTrue(directory.isValid());
+        auto firstCache = ParseCache{ directory.path() };
+        auto secondCache = ParseCache{ directory.path() };
+
+        std::vector<QByteArray> sources{};
+        std::vector<QByteArray> expected{};
+        for (auto i = 0; i < SourceCount; i++)
+        {
+            sources.push_back(QString("record %1 name=\"item %1\" { tags a b c; }\n").arg(i).toUtf8());
+            expected.push_back(WriteBinary(OpenBinary(EncodeBinary(QString::fromUtf8(sources.back())).bytes).document));
+        }
+
+        std::vector<i32> mismatches(ThreadCount);
+        std::vector<std::thread> threads{};
+        for (auto thread = 0; thread < ThreadCount; thread++)
+        {
+            auto& cache = thread % 2 == 0 ? firstCache : secondCache;
+            threads.emplace_back([&, thread, &cache = cache]()
+                {
+                    for (auto round = 0; round < 3; round++)
+                    {
+                        for (auto i = 0; i < SourceCount; i++)
+                        {
+                            const auto result = cache.parse(sources[i]);
+                            if (result.status != ParseStatus::Ok || WriteBinary(result.document) != expected[i])
+                                mismatches[thread]++;
+                        }
+                    }
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        for (const auto mismatchCount : mismatches)
+            AalTest::AreEqual(0, mismatchCount);
+        for (const auto& source : sources)
+            AalTest::IsTrue(firstCache.parse(source).isCached);
+    }
+
+    void HashBytesValues()
+    {
+        AalTest::AreEqual(u64(0xEF46DB3751D8E999), HashBytes(QByteArray()));
+        AalTest::AreEqual(u64(0x44BC2CF5AD770999), HashBytes(QByteArray("abc")));
+
+        // Every tail length after the 32 byte stripes
+        auto bytes = QByteArray();
+        std::vector<u64> hashes{};
+        for (auto i = 0; i < 80; i++)
+        {
+            hashes.push_back(HashBytes(bytes));
+            bytes.append(static_cast<char>(i));
+        }
+        std::sort(hashes.begin(), hashes.end());
+        AalTest::IsTrue(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    }
+
+    // Has to give what Parse gives for every file, in the order of the paths
+    void ParseFilesMatchesParse()
+    {
+        auto paths = QStringList();
+        for (const auto& [fileName, inputFilePath, expectedFilePath] : FileTests_Data())
+            paths.append(inputFilePath);
+        paths.insert(paths.size() / 2, QString("../../Tests/Data/Input/does_not_exist.kdl"));
+
+        auto atoms = AtomTable();
+        const auto results = ParseFiles(paths, { .threadCount = 8, .maxBytesInFlight = 4096 }, &atoms);
+        AalTest::AreEqual(static_cast<size_t>(paths.size()), results.size());
+        for (i32 i = 0; i < paths.size(); i++)
+        {
+            const auto& result = results[i];
+            if (!QFile::exists(paths[i]))
+            {
+                AalTest::IsTrue(!result.isRead);
+                continue;
+            }
+
+            const auto expected = Parse(ReadFile(paths[i]));
+            AalTest::IsTrue(result.isRead);
+            AalTest::AreEqual(expected.status, result.status);
+            AalTest::AreEqual(expected.errorOffset, result.errorOffset);
+
+            auto expectedText = QByteArray();
+            Writer{ expectedText }.write(expected.document);
+            auto text = QByteArray();
+            Writer{ text }.write(result.document);
+            AalTest::AreEqual(expectedText, text);
+            for (const auto node : result.document.nodes())
+                AalTest::IsTrue(node.nameAtom().has_value());
+        }
+    }
+
+    // What parsing all of source at once reports, the async parse has to report the same
+    AsyncParseResult ParseAtOnce(const QByteArray& source, TraceHandler& handler)
+    {
+        const auto tokens = Lex(QString::fromUtf8(source));
+        auto buffers = ParseBuffers{};
+        auto parser = EventParser{ tokens, handler, buffers };
+        const auto status = parser.parse();
+        if (status != ParseStatus::Ok)
+            return { .status = status, .errorOffset = parser.errorOffset() };
+
+        return {};
+    }
+
+    // Feeds source to an async parse in pieces that end at splits
+    void CompareAsync(const QByteArray& source, const QList<qsizetype>& splits)
+    {
+        auto expected = TraceHandler{ .tracesOffsets = true };
+        const auto expectedResult = ParseAtOnce(source, expected);
+
+        auto handler = TraceHandler{ .tracesOffsets = true };
+        auto input = AsyncInput{};
+        auto task = ParseAsync(input, handler);
+        auto start = qsizetype(0);
+        for (const auto split : splits)
+        {
+            input.feed(QByteArrayView(source).sliced(start, split - start));
+            start = split;
+        }
+        input.feed(QByteArrayView(source).sliced(start));
+
+        // Only the end of the input ends a document that has no errors
+        AalTest::IsTrue(expectedResult.status != ParseStatus::Ok || !task.isDone());
+        input.finish();
+        AalTest::IsTrue(task.isDone());
+
+        AalTest::AreEqual(expectedResult.status, task.result().status);
+        AalTest::AreEqual(expectedResult.errorOffset, task.result().errorOffset);
+        AalTest::AreEqual(expected.trace, handler.trace);
+    }
+
+    void AsyncFiles(const QString& fileName, const QString& inputFilePath, const QString& expectedFilePath)
+    {
+        auto file = QFile(inputFilePath);
+        const auto isOpen = file.open(QIODevice::ReadOnly);
+        AalTest::IsTrue(isOpen);
+        const auto source = file.readAll();
+
+        for (const auto pieceSize : { 1, 7, 64 })
+        {
+            auto splits = QList<qsizetype>();
+            for (auto split = qsizetype(pieceSize); split < source.size(); split += pieceSize)
+                splits.append(split);
+            CompareAsync(source, splits);
+        }
+    }
+
+    // The input runs out at every byte once, inside of strings, escapes and comments
+    void AsyncSplits(const QString& testName, const QString& source)
+    {
+        const auto utf8Source = source.toUtf8();
+        for (auto split = qsizetype(1); split < utf8Source.size(); split++)
+            CompareAsync(utf8Source, { split });
+    }
+
+    // Generated sources fed all at once and one byte at a time
+    void AsyncGeneratedSources()
+    {
+        auto random = std::mt19937{ 2025 };
+        for (auto i = 0; i < 1000; i++)
+        {
+            const auto source = GeneratedSource(random).toUtf8();
+            CompareAsync(source, {});
+
+            auto splits = QList<qsizetype>();
+            for (auto split = qsizetype(1); split < source.size(); split++)
+                splits.append(split);
+            CompareAsync(source, splits);
+        }
+    }
+
+    QList<std::tuple<QString, QString>> AsyncSplits_Data()
+    {
+        return {
+            std::make_tuple(QString("Escapes"), QString("node \"a\\n\\\"b\\u{1F600}c\\   d\" key=\"\\\\\"\nnext")),
+            std::make_tuple(QString("Raw Strings"), QString("node #\"a\"b\"# ##\"c\"#d\"## key=#\"\"#\nnext")),
+            std::make_tuple(QString("Multi-line String"), QString("node \"\"\"\n    a \"quoted\" line\n    \"\"\"\nnext")),
+            std::make_tuple(QString("Block Comments"), QString("node /* a /* b */ c */ 1 /*\n*/ 2\n/* between\n nodes */\nnext")),
+            std::make_tuple(QString("Line Comments"), QString("node 1 // comment\r\n// another\nnext 2")),
+            std::make_tuple(QString("Children"), QString("parent {\n    child 1; other { grandchild }\n}\nnext { }")),
+            std::make_tuple(QString("Slash-dash"), QString("/-\n\nnode 1\n/-node {\n    child\n}\nkept /-{ a } { b }")),
+            std::make_tuple(QString("Line Continuation"), QString("node \\ // comment\n    1 \\\n    2\nnext")),
+            std::make_tuple(QString("Line Continuation Error First"), QString("\\ \\\nnode\n")),
+            std::make_tuple(QString("Line Continuation Into Comment"), QString("\\ /*\n*/ node 1\n")),
+            std::make_tuple(QString("Line Continuation Into Quote"), QString("\\ /* \"# */ pqr\n")),
+            std::make_tuple(QString("Terminators"), QString("a; b;\nc;; d")),
+            std::make_tuple(QString("Multi-byte"), QString("n\u00f6de \"\U0001F600\" \u00e9=1\n\U0001F7F0 2")),
+            std::make_tuple(QString("Byte Order Marks"), QString("\uFEFFnode\n\uFEFFnext")),
+            std::make_tuple(QString("Unterminated Children"), QString("node 1\nparent {\n    child")),
+            std::make_tuple(QString("Unterminated String"), QString("node 1\nnext \"abc")),
+            std::make_tuple(QString("Unterminated Comment"), QString("node 1\nnext /* a")),
+            std::make_tuple(QString("Invalid Number"), QString("node 1\nnext 0x\nlast")),
+        };
+    }
+
+    ParseTask AwaitParse(ParseTask& task, i32& resumeCount)
+    {
+        const auto result = co_await task;
+        resumeCount++;
+        co_return result;
+    }
+
+    // A coroutine awaiting a parse is resumed once the parse is done
+    void AsyncAwait()
+    {
+        auto handler = TraceHandler{};
+        auto input = AsyncInput{};
+        auto task = ParseAsync(input, handler);
+        auto resumeCount = 0;
+        auto awaiting = AwaitParse(task, resumeCount);
+
+        input.feed("node 1\nnext \"a");
+        AalTest::IsTrue(!awaiting.isDone());
+        AalTest::AreEqual(QString("node 1;"), handler.trace);
+
+        input.feed("b\" {");
+        input.finish();
+        AalTest::IsTrue(awaiting.isDone());
+        AalTest::AreEqual(1, resumeCount);
+        AalTest::AreEqual(ParseStatus::UnterminatedChildren, awaiting.result().status);
+        AalTest::AreEqual(task.result().errorOffset, awaiting.result().errorOffset);
+        AalTest::AreEqual(QString("node 1;next ab {"), handler.trace);
+    }
+
+    // A suspended parse that is destroyed must not be resumed by its input
+    void AsyncDestroyed()
+    {
+        auto handler = TraceHandler{};
+        auto input = AsyncInput{};
+        {
+            auto task = ParseAsync(input, handler);
+            input.feed("node \"a");
+        }
+
+        input.feed("\"\n");
+        input.finish();
+        AalTest::AreEqual(QString(""), handler.trace);
+    }
+
+    // Feeds source to an async parse that may keep at most maxTokenBytes, eight bytes at a time
+    AsyncParseResult ParseInPieces(const QByteArray& source, i64 maxTokenBytes)
+    {
+        auto handler = TraceHandler{};
+        auto input = AsyncInput{};
+        auto task = ParseAsync(input, handler, maxTokenBytes);
+        for (auto start = qsizetype(0); start < source.size(); start += 8)
+            input.feed(QByteArrayView(source).sliced(start, std::min(qsizetype(8), source.size() - start)));
+        input.finish();
+
+        AalTest::IsTrue(task.isDone());
+        return task.result();
+    }
+
+    // Only the token being received counts towards the limit, not the node or the document around it
+    void AsyncTokenTooLarge()
+    {
+        auto smallNodes = QByteArray();
+        for (auto i = 0; i < 100; i++)
+            smallNodes += QByteArray("node ") + QByteArray::number(i) + QByteArray("\n");
+
+        AalTest::AreEqual(ParseStatus::Ok, ParseInPieces(smallNodes, 64).status);
+
+        const auto largeNode = smallNodes + QByteArray("parent {\n") + QByteArray("    child 1\n").repeated(1000) + QByteArray("}\n");
+        AalTest::AreEqual(ParseStatus::Ok, ParseInPieces(largeNode, 64).status);
+
+        const auto longString = ParseInPieces(smallNodes + QByteArray("parent { child \"") + QByteArray(100, 'a') + QByteArray("\"; }\n"), 64);
+        AalTest::AreEqual(ParseStatus::TokenTooLarge, longString.status);
+        AalTest::AreEqual(static_cast<i32>(smallNodes.size()) + 15, longString.errorOffset);
+    }
+
+    // Events are reported as the tokens arrive, a node doesn't have to end first
+    void AsyncInsideNodes()
+    {
+        auto handler = TraceHandler{};
+        auto input = AsyncInput{};
+        auto task = ParseAsync(input, handler);
+
+        input.feed("root {\n    child 1 key=");
+        AalTest::AreEqual(QString("root {child 1"), handler.trace);
+        input.feed("\"a\"\n    /-skipped { grandchild }\n    (t)other");
+        AalTest::AreEqual(QString("root {child 1 key=a;"), handler.trace);
+        input.feed(" {\n        grandchild\n    }\n");
+        AalTest::AreEqual(QString("root {child 1 key=a;(t)other {grandchild;}"), handler.trace);
+        AalTest::IsTrue(!task.isDone());
+
+        input.feed("}");
+        input.finish();
+        AalTest::IsTrue(task.isDone());
+        AalTest::AreEqual(ParseStatus::Ok, task.result().status);
+        AalTest::AreEqual(QString("root {child 1 key=a;(t)other {grandchild;};};"), handler.trace);
+    }
+
+    // Every document is sent over its own loopback connection in small writes that take turns. All of them
+    // are parsed on this thread, each parse waits while its connection has nothing to read.
+    void AsyncSockets()
+    {
+        const auto documents = QList<QByteArray>{
+            QByteArray("server {\n    host \"example.com\"\n    port 8080 /* not\n 443 */\n}\nendpoint \"/a\\nb\" public=#true\n"),
+            QByteArray("(log)entry #\"raw \"quoted\" text\"# level=3; entry \"\"\"\n    multi\n    line\n    \"\"\"\n/-skipped { child }\nlast 1.5e3"),
+            QByteArray("node 1\nbroken { child\n"),
+        };
+
+        auto server = QTcpServer();
+        AalTest::IsTrue(server.listen(QHostAddress::LocalHost));
+
+        struct Connection
+        {
+            QTcpSocket client;
+            QTcpSocket* socket = nullptr;
+            AsyncInput input;
+            TraceHandler handler{ .tracesOffsets = true };
+            std::optional<ParseTask> task;
+            qsizetype sentBytes = 0;
+            qsizetype receivedBytes = 0;
+        };
+
+        auto connections = std::vector<std::unique_ptr<Connection>>();
+        for (auto i = 0; i < documents.size(); i++)
+        {
+            auto connection = std::make_unique<Connection>();
+            connection->client.connectToHost(QHostAddress::LocalHost, server.serverPort());
+            AalTest::IsTrue(connection->client.waitForConnected(5000));
+            AalTest::IsTrue(server.waitForNewConnection(5000));
+            connection->socket = server.nextPendingConnection();
+            AalTest::IsTrue(connection->socket != nullptr);
+            connection->task = ParseAsync(connection->input, connection->handler);
+            connections.push_back(std::move(connection));
+        }
+
+        constexpr auto WriteSize = qsizetype(5);
+        auto isSending = true;
+        while (isSending)
+        {
+            isSending = false;
+            for (auto i = 0; i < documents.size(); i++)
+            {
+                auto& connection = *connections[i];
+                const auto& document = documents[i];
+                if (connection.sentBytes == document.size())
+                    continue;
+
+                isSending = true;
+                const auto size = std::min(WriteSize, document.size() - connection.sentBytes);
+                connection.client.write(document.constData() + connection.sentBytes, size);
+                connection.client.flush();
+                connection.sentBytes += size;
+
+                while (connection.receivedBytes < connection.sentBytes)
+                {
+                    if (connection.socket->bytesAvailable() == 0 && !connection.socket->waitForReadyRead(5000))
+                    {
+                        AalTest::Fail();
+                        return;
+                    }
+
+                    const auto bytes = connection.socket->readAll();
+                    connection.receivedBytes += bytes.size();
+                    connection.input.feed(bytes);
+                }
+            }
+        }
+
+        for (auto i = 0; i < documents.size(); i++)
+        {
+            auto& connection = *connections[i];
+            connection.input.finish();
+            AalTest::IsTrue(connection.task->isDone());
+
+            auto expected = TraceHandler{ .tracesOffsets = true };
+            const auto expectedResult = ParseAtOnce(documents[i], expected);
+            AalTest::AreEqual(expectedResult.status, connection.task->result().status);
+            AalTest::AreEqual(expectedResult.errorOffset, connection.task->result().errorOffset);
+            AalTest::AreEqual(expected.trace, connection.handler.trace);
+        }
+    }
+
+    // Nesting beyond MaxNestingDepth is an error for every entry point, it must not run out of stack
+    // Properties of the nodes and all their children in document order, as node.name=value
+    template<typename TNodes>
+    void AppendProperties(const TNodes& nodes, QStringList& properties)
+    {
+        for (const auto node : nodes)
+        {
+            for (auto i = 0; i < node.propertyCount(); i++)
+            {
+                const auto property = node.property(i);
+                properties.append(node.name().toString() + QString(".") + property.name().toString() + QString("=")
+                    + property.value().string().toString());
+            }
+
+            AppendProperties(node.children(), properties);
+        }
+    }
+
+    // Only the last property of each name is kept, in its place, by both builders
+    void DuplicateProperties(const QString& source, const QString& expected)
+    {
+        const auto parsed = Parse(source);
+        AalTest::AreEqual(ParseStatus::Ok, parsed.status);
+        auto parsedProperties = QStringList();
+        AppendProperties(parsed.document.nodes(), parsedProperties);
+        AalTest::AreEqual(expected, parsedProperties.join(QString(" ")));
+
+        const auto encoded = EncodeBinary(source);
+        AalTest::AreEqual(ParseStatus::Ok, encoded.status);
+        auto encodedProperties = QStringList();
+        AppendProperties(OpenBinary(encoded.bytes).document.nodes(), encodedProperties);
+        AalTest::AreEqual(expected, encodedProperties.join(QString(" ")));
+    }
+
+    QList<std::tuple<QString, QString>> DuplicateProperties_Data()
+    {
+        return {
+            std::make_tuple(QString("node a=1 b=2 a=3"), QString("node.b=2 node.a=3")),
+            std::make_tuple(QString("node p0=0 p1=1 p2=2 p3=3 p4=4 p5=5 p6=6 p7=7 p8=8 p9=9 p0=10 p5=11 p10=12"),
+                QString("node.p1=1 node.p2=2 node.p3=3 node.p4=4 node.p6=6 node.p7=7 node.p8=8 node.p9=9 node.p0=10 node.p5=11 node.p10=12")),
+            std::make_tuple(QString("node a=1 a=2 {\n    child b=1 c=1 b=2\n}\nnext c=1 c=2 c=3"),
+                QString("node.a=2 child.c=1 child.b=2 next.c=3")),
+            std::make_tuple(QString("node a=1 /- a=2 b=1 a=3 {}"), QString("node.b=1 node.a=3")),
+        };
+    }
+
+    void DeepNesting()
+    {
+        const auto nested = [](i32 depth) { return QString("a {").repeated(depth) + QString("}").repeated(depth); };
+        AalTest::AreEqual(ParseStatus::Ok, Parse(nested(MaxNestingDepth)).status);
+        const auto tooDeep = Parse(nested(MaxNestingDepth + 1));
+        AalTest::AreEqual(ParseStatus::TooDeep, tooDeep.status);
+        AalTest::AreEqual(MaxNestingDepth * 3 + 2, tooDeep.errorOffset);
+        AalTest::AreEqual(ParseStatus::TooDeep, Parse(QString("a /-{").repeated(MaxNestingDepth + 1)).status);
+
+        const auto source = nested(100000);
+        AalTest::AreEqual(ParseStatus::TooDeep, Parse(source).status);
+        AalTest::AreEqual(ParseStatus::TooDeep, Parse(Lex(source)).status);
+        AalTest::AreEqual(ParseStatus::TooDeep, EncodeBinary(source).status);
+        AalTest::AreEqual(ParseStatus::TooDeep, Validate(CompileSchema(ServerSchema).schema, source).status);
+        AalTest::AreEqual(ParseStatus::TooDeep, Select(CompileQuery(QString("a")).query, source).status);
+        auto config = ServerConfig{};
+        AalTest::AreEqual(ParseStatus::TooDeep, Bind(source, config).status);
+
+        auto directory = QTemporaryDir();
+        AalTest::IsTrue(directory.isValid());
+        AalTest::AreEqual(ParseStatus::TooDeep, ParseCache{ directory.path() }.parse(source.toUtf8()).status);
+
+        auto handler = TraceHandler{};
+        auto input = AsyncInput{};
+        auto task = ParseAsync(input, handler);
+        input.feed(source.toUtf8());
+        input.finish();
+        AalTest::IsTrue(task.isDone());
+        AalTest::AreEqual(ParseStatus::TooDeep, task.result().status);
+        AalTest::AreEqual(tooDeep.errorOffset, task.result().errorOffset);
+    }
+
     void Examples(const QString& fileName, const QString& inputFilePath)
     {
-        AalTest::Fail();
+        const auto result = Parse(ReadFile(inputFilePath));
+        AalTest::AreEqual(ParseStatus::Ok, result.status);
+        AalTest::IsTrue(result.document.nodeCount() > 0);
     }
 
     QList<std::tuple<QString, QString>> Examples_Data()
@@ -63,8 +1645,43 @@ AalTest::TestSuite ParserTestsSuite()
 {
     AalTest::TestSuite suite{};
 
+    suite.add(QString("AsyncAwait"), AsyncAwait);
+    suite.add(QString("AsyncDestroyed"), AsyncDestroyed);
+    suite.add(QString("AsyncFiles"), AsyncFiles, FileTests_Data);
+    suite.add(QString("AsyncGeneratedSources"), AsyncGeneratedSources);
+    suite.add(QString("AsyncInsideNodes"), AsyncInsideNodes);
+    suite.add(QString("AsyncSockets"), AsyncSockets);
+    suite.add(QString("AsyncSplits"), AsyncSplits, AsyncSplits_Data);
+    suite.add(QString("AsyncTokenTooLarge"), AsyncTokenTooLarge);
+    suite.add(QString("BinaryDamagedBytes"), BinaryDamagedBytes);
+    suite.add(QString("BinaryErrors"), BinaryErrors);
+    suite.add(QString("BinaryFiles"), BinaryFiles, FileTests_Data);
+    suite.add(QString("BinaryValues"), BinaryValues);
+    suite.add(QString("BindErrors"), BindErrors, BindErrors_Data);
+    suite.add(QString("BindFields"), BindFields);
+    suite.add(QString("DeepNesting"), DeepNesting);
+    suite.add(QString("DuplicateProperties"), DuplicateProperties, DuplicateProperties_Data);
+    suite.add(QString("Events"), Events, Events_Data);
     suite.add(QString("Examples"), Examples, Examples_Data);
     suite.add(QString("FileTests"), FileTests, FileTests_Data);
+    suite.add(QString("FusedGeneratedSources"), FusedGeneratedSources);
+    suite.add(QString("FusedParse"), FusedParse, FileTests_Data);
+    suite.add(QString("HashBytesValues"), HashBytesValues);
+    suite.add(QString("ParseCacheDamagedEntries"), ParseCacheDamagedEntries);
+    suite.add(QString("ParseCacheFromThreads"), ParseCacheFromThreads);
+    suite.add(QString("ParseCacheHits"), ParseCacheHits);
+    suite.add(QString("ParseCacheTrim"), ParseCacheTrim);
+    suite.add(QString("ParseFilesMatchesParse"), ParseFilesMatchesParse);
+    suite.add(QString("QueryErrors"), QueryErrors, QueryErrors_Data);
+    suite.add(QString("QuerySelect"), QuerySelect, QuerySelect_Data);
+    suite.add(QString("SchemaErrors"), SchemaErrors, SchemaErrors_Data);
+    suite.add(QString("SchemaFromThreads"), SchemaFromThreads);
+    suite.add(QString("SchemaValidatesItself"), SchemaValidatesItself);
+    suite.add(QString("SchemaViolations"), SchemaViolations, SchemaViolations_Data);
+    suite.add(QString("WriteFiles"), WriteFiles, FileTests_Data);
+    suite.add(QString("WriteNumbers"), WriteNumbers, WriteNumbers_Data);
+    suite.add(QString("WriteToDevice"), WriteToDevice);
+    suite.add(QString("WriteValues"), WriteValues);
 
     return suite;
 }
@@ -0,0 +1,123 @@
+#include <AllocationCounter.h>
+
+#include <cerrno>
+#include <cstdlib>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+namespace
+{
+    // Per thread, so a pool thread that is still winding down never shows up in a count
+    thread_local i64 allocationCount = 0;
+}
+
+#if defined(__GLIBC__)
+
+// Every library of the process, Qt and the KDL library included, binds malloc to these. They forward to
+// glibc's own functions, which never call back into them.
+extern "C"
+{
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t count, std::size_t size);
+    void* __libc_realloc(void* memory, std::size_t size);
+    void* __libc_memalign(std::size_t alignment, std::size_t size);
+    void __libc_free(void* memory);
+
+    void* malloc(std::size_t size)
+    {
+        allocationCount++;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size)
+    {
+        allocationCount++;
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* memory, std::size_t size)
+    {
+        allocationCount++;
+        return __libc_realloc(memory, size);
+    }
+
+    // Over-aligned operator new and aligned containers come through these, glibc has no __libc_ function for
+    // the last two so they check their arguments as glibc does and take memory from memalign
+    void* memalign(std::size_t alignment, std::size_t size)
+    {
+        allocationCount++;
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(std::size_t alignment, std::size_t size)
+    {
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        {
+            errno = EINVAL;
+            return nullptr;
+        }
+
+        allocationCount++;
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** memory, std::size_t alignment, std::size_t size)
+    {
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        allocationCount++;
+        auto* allocated = __libc_memalign(alignment, size);
+        if (allocated == nullptr)
+            return ENOMEM;
+
+        *memory = allocated;
+        return 0;
+    }
+
+    void free(void* memory)
+    {
+        __libc_free(memory);
+    }
+}
+
+bool IsCountingAllocations() noexcept
+{
+    return true;
+}
+
+#elif defined(_MSC_VER) && defined(_DEBUG)
+
+namespace
+{
+    // The debug CRT is shared by the test, the KDL DLL and the debug Qt DLLs, so its hook sees all of them
+    int CountAllocation(int allocationType, void*, size_t, int, long, const unsigned char*, int)
+    {
+        if (allocationType == _HOOK_ALLOC || allocationType == _HOOK_REALLOC)
+            allocationCount++;
+        return TRUE;
+    }
+
+    const auto previousHook = _CrtSetAllocHook(CountAllocation);
+}
+
+bool IsCountingAllocations() noexcept
+{
+    return true;
+}
+
+#else
+
+bool IsCountingAllocations() noexcept
+{
+    return false;
+}
+
+#endif
+
+i64 AllocationCount() noexcept
+{
+    return allocationCount;
+}
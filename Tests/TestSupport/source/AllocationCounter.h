@@ -0,0 +1,12 @@
+#pragma once
+
+#include <Defines.h>
+
+// Whether AllocationCount sees every heap allocation of the process. It does with glibc, where malloc is
+// replaced for the whole process, and with the debug CRT on Windows, which reports to an allocation hook.
+// Elsewhere nothing is counted and the checks that rely on it are skipped.
+[[nodiscard]] bool IsCountingAllocations() noexcept;
+
+// Allocations made on the calling thread since it started, including those of Qt containers and those made
+// inside the KDL library
+[[nodiscard]] i64 AllocationCount() noexcept;